@@ -0,0 +1,144 @@
+#include "scenes.hpp"
+#include <elasty/constraint-set.hpp>
+#include <elasty/particle-set.hpp>
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // The constraints of a type over the 0.10 cloth, whose predicted
+    // positions are perturbed so that every constraint has some work to do
+    struct ConstraintScene
+    {
+        ConstraintScene()
+        {
+            const std::shared_ptr<elasty::ClothSimObject> cloth = bench::loadCloth(2, particles, elasty::ClothSimObject::Strategy::IsometricBending);
+            constraints.append(cloth->m_constraints);
+
+            // The bending constraints of the other strategy on the same particles
+            elasty::ParticleSet other_particles;
+            const std::shared_ptr<elasty::ClothSimObject> other_cloth = bench::loadCloth(2, other_particles, elasty::ClothSimObject::Strategy::Bending);
+            for (const auto& constraint : other_cloth->m_constraints.get<elasty::BendingConstraint>())
+            {
+                constraints.add(constraint);
+            }
+
+            const auto& distance_constraints = constraints.get<elasty::DistanceConstraint>();
+            const auto& isometric_bending_constraints = constraints.get<elasty::IsometricBendingConstraint>();
+
+            for (unsigned int i = 0; i < particles.size(); ++ i)
+            {
+                const elasty::Vector3& x = particles.x[i];
+
+                constraints.add(elasty::FixedPointConstraint(particles, i, 1.0, x));
+                constraints.add(elasty::EnvironmentalCollisionConstraint(particles, i, 1.0, elasty::Vector3::UnitY(), x.y() + 0.01));
+                constraints.add(elasty::LongRangeAttachmentConstraint(particles, i, 1.0, particles.x[0], 0.9 * (x - particles.x[0]).norm()));
+            }
+            for (const auto& constraint : distance_constraints)
+            {
+                const auto& indices = constraint.getIndices();
+                const elasty::Scalar d = (particles.x[indices[0]] - particles.x[indices[1]]).norm();
+                constraints.add(elasty::ParticleCollisionConstraint(particles, indices[0], indices[1], 1.0, 1.5 * d));
+            }
+            for (unsigned int t = 0; t < cloth->m_triangle_list.rows(); ++ t)
+            {
+                // The stretching constraints of the triangle strategies
+                const unsigned int p_0 = cloth->m_particle_offset + cloth->m_triangle_list(t, 0);
+                const unsigned int p_1 = cloth->m_particle_offset + cloth->m_triangle_list(t, 1);
+                const unsigned int p_2 = cloth->m_particle_offset + cloth->m_triangle_list(t, 2);
+
+                const elasty::TriangleStrainConstraint strain_constraint(particles, p_0, p_1, p_2, 1.0);
+                constraints.add(strain_constraint);
+                constraints.add(elasty::TriangleAreaConstraint(particles, p_0, p_1, p_2, 1.0, strain_constraint.getRestArea()));
+            }
+            for (const auto& constraint : isometric_bending_constraints)
+            {
+                // The wing particle of each pair of adjacent triangles against the other triangle
+                const auto& indices = constraint.getIndices();
+                constraints.add(elasty::PointTriangleCollisionConstraint(particles, indices[3], indices[0], indices[1], indices[2], 1.0, 1.0, elasty::Vector3::Constant(1.0 / 3.0), 1.0));
+            }
+
+            std::mt19937 random_engine(0);
+            std::normal_distribution<elasty::Scalar> distribution(0.0, 0.01);
+            for (elasty::Vector3& p : particles.p)
+            {
+                p += elasty::Vector3(distribution(random_engine), distribution(random_engine), distribution(random_engine));
+            }
+            predicted_positions = particles.p;
+        }
+
+        elasty::ParticleSet particles;
+        elasty::ConstraintSet constraints;
+        std::vector<elasty::Vector3> predicted_positions;
+    };
+
+    const ConstraintScene& getScene()
+    {
+        static const ConstraintScene scene;
+        return scene;
+    }
+
+    // One pass of projectParticles over all the constraints of the type,
+    // starting from the same perturbed positions in every iteration
+    template <typename Type>
+    void BM_ProjectParticles(benchmark::State& state)
+    {
+        const ConstraintScene& scene = getScene();
+        const std::vector<Type>& constraints = scene.constraints.get<Type>();
+        elasty::ParticleSet particles = scene.particles;
+
+        for (auto _ : state)
+        {
+            particles.p = scene.predicted_positions;
+            for (const Type& constraint : constraints)
+            {
+                constraint.projectParticles(particles);
+            }
+            benchmark::ClobberMemory();
+        }
+
+        state.SetItemsProcessed(state.iterations() * constraints.size());
+    }
+
+    template <typename Type>
+    void BM_CalculateGrad(benchmark::State& state)
+    {
+        const ConstraintScene& scene = getScene();
+        const std::vector<Type>& constraints = scene.constraints.get<Type>();
+
+        typename Type::Correction grad_C;
+        for (auto _ : state)
+        {
+            for (const Type& constraint : constraints)
+            {
+                constraint.calculateGrad(scene.particles, grad_C.data());
+                benchmark::DoNotOptimize(grad_C);
+            }
+        }
+
+        state.SetItemsProcessed(state.iterations() * constraints.size());
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_ProjectParticles, elasty::DistanceConstraint);
+BENCHMARK_TEMPLATE(BM_ProjectParticles, elasty::BendingConstraint);
+BENCHMARK_TEMPLATE(BM_ProjectParticles, elasty::IsometricBendingConstraint);
+BENCHMARK_TEMPLATE(BM_ProjectParticles, elasty::FixedPointConstraint);
+BENCHMARK_TEMPLATE(BM_ProjectParticles, elasty::EnvironmentalCollisionConstraint);
+BENCHMARK_TEMPLATE(BM_ProjectParticles, elasty::ParticleCollisionConstraint);
+BENCHMARK_TEMPLATE(BM_ProjectParticles, elasty::PointTriangleCollisionConstraint);
+BENCHMARK_TEMPLATE(BM_ProjectParticles, elasty::LongRangeAttachmentConstraint);
+BENCHMARK_TEMPLATE(BM_ProjectParticles, elasty::TriangleStrainConstraint);
+BENCHMARK_TEMPLATE(BM_ProjectParticles, elasty::TriangleAreaConstraint);
+
+BENCHMARK_TEMPLATE(BM_CalculateGrad, elasty::DistanceConstraint);
+BENCHMARK_TEMPLATE(BM_CalculateGrad, elasty::BendingConstraint);
+BENCHMARK_TEMPLATE(BM_CalculateGrad, elasty::IsometricBendingConstraint);
+BENCHMARK_TEMPLATE(BM_CalculateGrad, elasty::FixedPointConstraint);
+BENCHMARK_TEMPLATE(BM_CalculateGrad, elasty::EnvironmentalCollisionConstraint);
+BENCHMARK_TEMPLATE(BM_CalculateGrad, elasty::ParticleCollisionConstraint);
+BENCHMARK_TEMPLATE(BM_CalculateGrad, elasty::PointTriangleCollisionConstraint);
+BENCHMARK_TEMPLATE(BM_CalculateGrad, elasty::LongRangeAttachmentConstraint);
+BENCHMARK_TEMPLATE(BM_CalculateGrad, elasty::TriangleStrainConstraint);
+BENCHMARK_TEMPLATE(BM_CalculateGrad, elasty::TriangleAreaConstraint);
@@ -0,0 +1,101 @@
+#include "scenes.hpp"
+#include <benchmark/benchmark.h>
+#include <string>
+
+namespace
+{
+    enum class Solver
+    {
+        Pbd,
+        Xpbd,
+        PbdVectorized,
+        PbdJacobi,
+        ProjectiveDynamics,
+    };
+
+    constexpr const char* solver_names[] = { "Pbd", "Xpbd", "PbdVectorized", "PbdJacobi", "ProjectiveDynamics" };
+    constexpr const char* strategy_names[] = { "Bending", "IsometricBending", "Cross" };
+    constexpr const char* particle_order_names[] = { "Obj", "Morton", "ReverseCuthillMcKee" };
+
+    void configure(elasty::Engine& engine, const Solver solver)
+    {
+        switch (solver)
+        {
+            case Solver::Pbd:
+                break;
+            case Solver::Xpbd:
+                engine.m_framework = elasty::Framework::Xpbd;
+                break;
+            case Solver::PbdVectorized:
+                engine.m_use_vectorized_kernels = true;
+                break;
+            case Solver::PbdJacobi:
+                engine.m_projection_scheme = elasty::ProjectionScheme::Jacobi;
+                engine.m_jacobi_relaxation = 1.5;
+                break;
+            case Solver::ProjectiveDynamics:
+                engine.m_framework = elasty::Framework::ProjectiveDynamics;
+                break;
+        }
+    }
+
+    // Full steps of the cloth-alembic scene, by the resolution of the cloth,
+    // the bending strategy, and the solver
+    void BM_StepTime(benchmark::State& state)
+    {
+        const int resolution = static_cast<int>(state.range(0));
+        const auto strategy = static_cast<elasty::ClothSimObject::Strategy>(state.range(1));
+        const auto solver = static_cast<Solver>(state.range(2));
+
+        bench::ClothEngine engine(resolution, strategy);
+        engine.initializeScene();
+        configure(engine, solver);
+
+        // The first step also builds the coloring, the batches, or the factorization
+        engine.stepTime();
+
+        for (auto _ : state)
+        {
+            engine.stepTime();
+        }
+
+        state.SetLabel(std::string(bench::cloth_resolutions[resolution]) + "/" + strategy_names[state.range(1)] + "/" + solver_names[state.range(2)]);
+        state.counters["particles"] = double(engine.m_particles.size());
+        state.SetItemsProcessed(state.iterations() * engine.m_particles.size());
+    }
+
+    // Full steps of the same scene by the order of the particles, with the
+    // isometric bending and the (single-threaded Gauss-Seidel) PBD solver
+    void BM_StepTimeByParticleOrder(benchmark::State& state)
+    {
+        const int resolution = static_cast<int>(state.range(0));
+        const auto particle_order = static_cast<elasty::ClothSimObject::ParticleOrder>(state.range(1));
+
+        bench::ClothEngine engine(resolution, elasty::ClothSimObject::Strategy::IsometricBending, particle_order);
+        engine.initializeScene();
+
+        engine.stepTime();
+
+        for (auto _ : state)
+        {
+            engine.stepTime();
+        }
+
+        state.SetLabel(std::string(bench::cloth_resolutions[resolution]) + "/" + particle_order_names[state.range(1)]);
+        state.counters["particles"] = double(engine.m_particles.size());
+        state.SetItemsProcessed(state.iterations() * engine.m_particles.size());
+    }
+}
+
+BENCHMARK(BM_StepTime)
+    ->ArgNames({ "resolution", "strategy", "solver" })
+    ->ArgsProduct({ benchmark::CreateDenseRange(0, bench::num_cloth_resolutions - 1, 1),
+                    benchmark::CreateDenseRange(0, 2, 1),
+                    benchmark::CreateDenseRange(0, 4, 1) })
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_StepTimeByParticleOrder)
+    ->ArgNames({ "resolution", "order" })
+    ->ArgsProduct({ benchmark::CreateDenseRange(0, bench::num_cloth_resolutions - 1, 1),
+                    benchmark::CreateDenseRange(0, 2, 1) })
+    ->Unit(benchmark::kMillisecond);
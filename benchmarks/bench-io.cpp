@@ -0,0 +1,87 @@
+#include "scenes.hpp"
+#include <elasty/particle-set.hpp>
+#include <elasty/utils.hpp>
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <filesystem>
+
+namespace
+{
+    std::string getTemporaryPath(const std::string& file_name)
+    {
+        return (std::filesystem::temp_directory_path() / file_name).string();
+    }
+
+    // Loading a cloth from the OBJ file, including building its constraints
+    void BM_LoadObj(benchmark::State& state)
+    {
+        const int resolution = static_cast<int>(state.range(0));
+
+        std::size_t num_particles = 0;
+        for (auto _ : state)
+        {
+            elasty::ParticleSet particles;
+            benchmark::DoNotOptimize(bench::loadCloth(resolution, particles));
+            num_particles = particles.size();
+        }
+
+        state.SetLabel(bench::cloth_resolutions[resolution]);
+        state.SetItemsProcessed(state.iterations() * num_particles);
+    }
+
+    // Loading the same cloth from its binary cache
+    void BM_ReadCache(benchmark::State& state)
+    {
+        const int resolution = static_cast<int>(state.range(0));
+        const std::string cache_path = getTemporaryPath("elasty-bench-cloth.cache");
+
+        elasty::ParticleSet source_particles;
+        bench::loadCloth(resolution, source_particles)->writeCache(cache_path, source_particles);
+
+        for (auto _ : state)
+        {
+            elasty::ParticleSet particles;
+            benchmark::DoNotOptimize(elasty::ClothSimObject::readCache(cache_path, particles));
+        }
+
+        std::remove(cache_path.c_str());
+
+        state.SetLabel(bench::cloth_resolutions[resolution]);
+        state.SetItemsProcessed(state.iterations() * source_particles.size());
+    }
+
+    // Writing an archive of 60 frames of a cloth, including opening and
+    // closing it, without simulating
+    void BM_AlembicExport(benchmark::State& state)
+    {
+        constexpr unsigned int num_frames = 60;
+
+        const int resolution = static_cast<int>(state.range(0));
+        const std::string archive_path = getTemporaryPath("elasty-bench-cloth.abc");
+
+        elasty::ParticleSet particles;
+        const auto cloth = bench::loadCloth(resolution, particles);
+
+        for (auto _ : state)
+        {
+            const auto alembic_manager = elasty::createAlembicManager(archive_path, cloth, particles, 1.0 / 60.0);
+            for (unsigned int frame = 0; frame < num_frames; ++ frame)
+            {
+                // Move the cloth so that no two frames are the same
+                for (elasty::Vector3& x : particles.x) { x.y() -= 0.001; }
+                elasty::submitCurrentStatus(alembic_manager);
+            }
+            elasty::closeAlembicManager(alembic_manager);
+        }
+
+        std::remove(archive_path.c_str());
+
+        state.SetLabel(bench::cloth_resolutions[resolution]);
+        state.SetItemsProcessed(state.iterations() * num_frames);
+        state.SetBytesProcessed(state.iterations() * num_frames * particles.size() * 3 * sizeof(float));
+    }
+}
+
+BENCHMARK(BM_LoadObj)->DenseRange(0, bench::num_cloth_resolutions - 1)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ReadCache)->DenseRange(0, bench::num_cloth_resolutions - 1)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_AlembicExport)->DenseRange(0, bench::num_cloth_resolutions - 1)->Unit(benchmark::kMillisecond);
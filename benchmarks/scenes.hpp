@@ -0,0 +1,92 @@
+#ifndef scenes_hpp
+#define scenes_hpp
+
+#include <elasty/cloth-sim-object.hpp>
+#include <elasty/constraint.hpp>
+#include <elasty/engine.hpp>
+#include <memory>
+#include <string>
+
+namespace bench
+{
+    // The cloth meshes in models/cloths, from the coarsest (i.e., of the fewest particles)
+    constexpr const char* cloth_resolutions[] = { "0.01", "0.05", "0.10", "0.20", "0.40" };
+    constexpr int num_cloth_resolutions = sizeof(cloth_resolutions) / sizeof(cloth_resolutions[0]);
+
+    inline std::string getClothPath(const int resolution)
+    {
+        return std::string(ELASTY_MODELS_DIR) + "/cloths/" + cloth_resolutions[resolution] + ".obj";
+    }
+
+    inline std::shared_ptr<elasty::ClothSimObject> loadCloth(const int resolution,
+                                                             elasty::ParticleSet& particles,
+                                                             const elasty::ClothSimObject::Strategy strategy = elasty::ClothSimObject::Strategy::IsometricBending,
+                                                             const elasty::ClothSimObject::ParticleOrder particle_order = elasty::ClothSimObject::ParticleOrder::Obj)
+    {
+        const Eigen::Affine3d transform = Eigen::Affine3d(Eigen::Translation3d(0.0, 2.0, 1.0));
+        return std::make_shared<elasty::ClothSimObject>(getClothPath(resolution), particles, 0.95, 0.03, transform, strategy,
+                                                        elasty::ClothSimObject::StretchStrategy::Distance, particle_order);
+    }
+
+    // The scene of the cloth-alembic example: a cloth pinned at two of its
+    // corners falling onto the ground
+    class ClothEngine final : public elasty::Engine
+    {
+    public:
+
+        ClothEngine(const int resolution,
+                    const elasty::ClothSimObject::Strategy strategy,
+                    const elasty::ClothSimObject::ParticleOrder particle_order = elasty::ClothSimObject::ParticleOrder::Obj) :
+        m_resolution(resolution),
+        m_strategy(strategy),
+        m_particle_order(particle_order)
+        {
+        }
+
+        void initializeScene() override
+        {
+            m_cloth_sim_object = loadCloth(m_resolution, m_particles, m_strategy, m_particle_order);
+            m_constraints.append(m_cloth_sim_object->m_constraints);
+
+            for (unsigned int i = 0; i < m_particles.size(); ++ i)
+            {
+                const elasty::Vector3& x = m_particles.x[i];
+                if ((x - elasty::Vector3(+ 1.0, 2.0, 0.0)).norm() < 0.1 || (x - elasty::Vector3(- 1.0, 2.0, 0.0)).norm() < 0.1)
+                {
+                    m_constraints.add(elasty::FixedPointConstraint(m_particles, i, 1.0, x));
+                }
+            }
+        }
+
+        void setExternalForces() override
+        {
+            for (unsigned int i = 0; i < m_particles.size(); ++ i)
+            {
+                m_particles.f[i] = m_particles.m[i] * elasty::Vector3(0.0, - 9.8, 0.0);
+            }
+        }
+
+        void generateCollisionConstraints() override
+        {
+            for (unsigned int i = 0; i < m_particles.size(); ++ i)
+            {
+                if (m_particles.p[i].y() < 0.0)
+                {
+                    emplaceInstantConstraint<elasty::EnvironmentalCollisionConstraint>(m_particles, i, 1.0, elasty::Vector3::UnitY(), 0.0);
+                }
+            }
+        }
+
+        void updateVelocities() override {}
+
+        std::shared_ptr<elasty::ClothSimObject> m_cloth_sim_object;
+
+    private:
+
+        const int m_resolution;
+        const elasty::ClothSimObject::Strategy m_strategy;
+        const elasty::ClothSimObject::ParticleOrder m_particle_order;
+    };
+}
+
+#endif /* scenes_hpp */
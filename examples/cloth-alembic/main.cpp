@@ -1,8 +1,9 @@
 #include <elasty/cloth-sim-object.hpp>
 #include <elasty/constraint.hpp>
 #include <elasty/engine.hpp>
-#include <elasty/particle.hpp>
+#include <elasty/particle-set.hpp>
 #include <elasty/utils.hpp>
+#include <iostream>
 #include <timer.hpp>
 
 class SimpleEngine final : public elasty::Engine
@@ -14,8 +15,8 @@ public:
         m_num_iterations = 40;
 
         // Instantiate a cloth object
-        const double cloth_distance_stiffness = 0.95;
-        const double cloth_bending_stiffness = 0.03;
+        const elasty::Scalar cloth_distance_stiffness = 0.95;
+        const elasty::Scalar cloth_bending_stiffness = 0.03;
         const std::string cloth_obj_path = "./models/cloths/0.20.obj";
 #if 0 // Drape
         const Eigen::Affine3d cloth_import_transform = Eigen::Translation3d(0.0, 1.0, 0.0) * Eigen::AngleAxisd(0.5 * elasty::pi(), Eigen::Vector3d::UnitX());
@@ -23,41 +24,39 @@ public:
         const Eigen::Affine3d cloth_import_transform = Eigen::Affine3d(Eigen::Translation3d(0.0, 2.0, 1.0));
 #endif
         m_cloth_sim_object = std::make_shared<elasty::ClothSimObject>(cloth_obj_path,
+                                                                      m_particles,
                                                                       cloth_distance_stiffness,
                                                                       cloth_bending_stiffness,
                                                                       cloth_import_transform,
                                                                       elasty::ClothSimObject::Strategy::IsometricBending);
 
-        // Register the cloth object
-        std::copy(m_cloth_sim_object->m_particles.begin(),
-                  m_cloth_sim_object->m_particles.end(),
-                  std::back_inserter(m_particles));
-        std::copy(m_cloth_sim_object->m_constraints.begin(),
-                  m_cloth_sim_object->m_constraints.end(),
-                  std::back_inserter(m_constraints));
+        // Register the cloth object (its particles are already in m_particles)
+        m_constraints.append(m_cloth_sim_object->m_constraints);
 
         // Pin two of the corners of the cloth
-        constexpr double range_radius = 0.1;
-        for (const auto& particle : m_particles)
+        constexpr elasty::Scalar range_radius = 0.1;
+        for (unsigned int i = 0; i < m_particles.size(); ++ i)
         {
-            if ((particle->x - Eigen::Vector3d(+ 1.0, 2.0, 0.0)).norm() < range_radius)
+            const elasty::Vector3& x = m_particles.x[i];
+
+            if ((x - elasty::Vector3(+ 1.0, 2.0, 0.0)).norm() < range_radius)
             {
-                m_constraints.push_back(std::make_shared<elasty::FixedPointConstraint>(particle, 1.0, particle->x));
+                m_constraints.add(elasty::FixedPointConstraint(m_particles, i, 1.0, x));
             }
-            if ((particle->x - Eigen::Vector3d(- 1.0, 2.0, 0.0)).norm() < range_radius)
+            if ((x - elasty::Vector3(- 1.0, 2.0, 0.0)).norm() < range_radius)
             {
-                m_constraints.push_back(std::make_shared<elasty::FixedPointConstraint>(particle, 1.0, particle->x));
+                m_constraints.add(elasty::FixedPointConstraint(m_particles, i, 1.0, x));
             }
         }
     }
 
     void setExternalForces() override
     {
-        const Eigen::Vector3d gravity = Eigen::Vector3d(0.0, - 9.8, 0.0);
+        const elasty::Vector3 gravity = elasty::Vector3(0.0, - 9.8, 0.0);
 
-        for (auto particle : m_particles)
+        for (unsigned int i = 0; i < m_particles.size(); ++ i)
         {
-            particle->f = particle->m * gravity;
+            m_particles.f[i] = m_particles.m[i] * gravity;
         }
     }
 
@@ -72,14 +71,25 @@ int main(int argc, char** argv)
     SimpleEngine engine;
     engine.initializeScene();
 
-    auto alembic_manager = elasty::createAlembicManager("./cloth.abc", engine.m_cloth_sim_object, engine.m_dt);
+    auto alembic_manager = elasty::createAlembicManager("./cloth.abc", engine.m_cloth_sim_object, engine.m_particles, engine.m_dt);
 
     for (unsigned int frame = 0; frame < 300; ++ frame)
     {
         timer::Timer t(std::to_string(frame));
+        engine.synchronizeParticles();
         elasty::submitCurrentStatus(alembic_manager);
         engine.stepTime();
     }
 
+    elasty::closeAlembicManager(alembic_manager);
+
+#if defined(ELASTY_PROFILING)
+    for (const auto& [name, duration] : engine.m_profiler.calculateTotalDurations())
+    {
+        std::cout << name << ": " << duration << " ms" << std::endl;
+    }
+    engine.m_profiler.writeChromeTrace("./trace.json");
+#endif
+
     return 0;
 }
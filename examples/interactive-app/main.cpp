@@ -10,9 +10,10 @@
 #include <bigger/primitives/plane-primitive.hpp>
 #include <bigger/primitives/sphere-primitive.hpp>
 #include <elasty/cloth-sim-object.hpp>
+#include <elasty/cloth-vertex-buffer.hpp>
 #include <elasty/constraint.hpp>
 #include <elasty/engine.hpp>
-#include <elasty/particle.hpp>
+#include <elasty/particle-set.hpp>
 #include <elasty/utils.hpp>
 #include <string-util.hpp>
 
@@ -21,7 +22,7 @@
 
 namespace
 {
-    inline glm::vec3 eigen2glm(const Eigen::Vector3d& eigen)
+    inline glm::vec3 eigen2glm(const elasty::Vector3& eigen)
     {
         return glm::vec3(eigen.x(), eigen.y(), eigen.z());
     }
@@ -35,76 +36,69 @@ public:
     {
         // Rod
         constexpr unsigned int num_particles = 20;
-        constexpr double total_length = 2.0;
-        constexpr double segment_length = total_length / double(num_particles - 1);
+        constexpr elasty::Scalar total_length = 2.0;
+        constexpr elasty::Scalar segment_length = total_length / elasty::Scalar(num_particles - 1);
 
-        std::shared_ptr<elasty::Particle> last_particle = nullptr;
+        unsigned int last_particle = 0;
 
         for (unsigned int i = 0; i < num_particles; ++ i)
         {
-            const Eigen::Vector3d x = Eigen::Vector3d(- 1.0, 1.0 + segment_length * double(i), 0.0);
-            const Eigen::Vector3d v = 50.0 * Eigen::Vector3d::Random();
-            const double m = 1.0;
+            const elasty::Vector3 x = elasty::Vector3(- 1.0, 1.0 + segment_length * elasty::Scalar(i), 0.0);
+            const elasty::Vector3 v = 50.0 * elasty::Vector3::Random();
+            const elasty::Scalar m = 1.0;
 
-            auto particle = std::make_shared<elasty::Particle>(x, v, m);
+            const unsigned int particle = m_particles.addParticle(x, v, m);
 
-            m_particles.push_back(particle);
-
-            if (last_particle != nullptr)
+            if (i != 0)
             {
-                addConstraint(std::make_shared<elasty::DistanceConstraint>(last_particle, particle, 0.5, segment_length));
+                addConstraint(elasty::DistanceConstraint(m_particles, last_particle, particle, 0.5, segment_length));
             }
 
             last_particle = particle;
         }
 
-        addConstraint(std::make_shared<elasty::FixedPointConstraint>(last_particle, 1.0, last_particle->x));
+        addConstraint(elasty::FixedPointConstraint(m_particles, last_particle, 1.0, m_particles.x[last_particle]));
 
-        // Register the cloth object
-        std::copy(m_cloth_sim_object->m_particles.begin(),
-                  m_cloth_sim_object->m_particles.end(),
-                  std::back_inserter(m_particles));
-        std::copy(m_cloth_sim_object->m_constraints.begin(),
-                  m_cloth_sim_object->m_constraints.end(),
-                  std::back_inserter(m_constraints));
+        // Register the cloth object (its particles are already in m_particles)
+        m_constraints.append(m_cloth_sim_object->m_constraints);
 
         // Pin two of the corners of the cloth
-        elasty::generateFixedPointConstraints(Eigen::Vector3d(+ 1.0 + 1.0, + 2.0, 0.0),
-                                              Eigen::Vector3d(+ 1.0 + 1.0, 3.0, 0.0),
-                                              m_cloth_sim_object->m_particles,
+        elasty::generateFixedPointConstraints(elasty::Vector3(+ 1.0 + 1.0, + 2.0, 0.0),
+                                              elasty::Vector3(+ 1.0 + 1.0, 3.0, 0.0),
+                                              m_particles,
                                               m_constraints);
-        elasty::generateFixedPointConstraints(Eigen::Vector3d(- 1.0 + 1.0, + 2.0, 0.0),
-                                              Eigen::Vector3d(- 1.0 + 1.0, 3.0, 0.0),
-                                              m_cloth_sim_object->m_particles,
+        elasty::generateFixedPointConstraints(elasty::Vector3(- 1.0 + 1.0, + 2.0, 0.0),
+                                              elasty::Vector3(- 1.0 + 1.0, 3.0, 0.0),
+                                              m_particles,
                                               m_constraints);
     }
 
     void setExternalForces() override
     {
-        const Eigen::Vector3d gravity = Eigen::Vector3d(0.0, - 9.8, 0.0);
+        const elasty::Vector3 gravity = elasty::Vector3(0.0, - 9.8, 0.0);
 
-        for (auto particle : m_particles)
+        for (unsigned int i = 0; i < m_particles.size(); ++ i)
         {
-            particle->f = particle->m * gravity;
+            m_particles.f[i] = m_particles.m[i] * gravity;
         }
     }
 
     void generateCollisionConstraints() override
     {
-        for (const auto particle : m_particles)
+        for (unsigned int i = 0; i < m_particles.size(); ++ i)
         {
-            if (particle->p.y() < 0.0)
+            if (m_particles.p[i].y() < 0.0)
             {
-                addInstantConstraint(std::make_shared<elasty::EnvironmentalCollisionConstraint>(particle, 1.0, Eigen::Vector3d(0.0, 1.0, 0.0), 0.0));
+                emplaceInstantConstraint<elasty::EnvironmentalCollisionConstraint>(m_particles, i, 1.0, elasty::Vector3(0.0, 1.0, 0.0), 0.0);
             }
         }
     }
 
     void updateVelocities() override
     {
-        for (auto particle : m_particles)
+        for (auto& v : m_particles.v)
         {
-            particle->v *= 0.999;
+            v *= 0.999;
         }
     }
 
@@ -129,8 +123,8 @@ public:
 
 private:
 
-    const double cloth_distance_stiffness = 0.95;
-    const double cloth_bending_stiffness = 0.05;
+    const elasty::Scalar cloth_distance_stiffness = 0.95;
+    const elasty::Scalar cloth_bending_stiffness = 0.05;
     const std::string cloth_obj_path = "./models/cloths/0.10.obj";
     const Eigen::Affine3d cloth_import_transform = Eigen::Translation3d(1.0, 1.0, 0.0) * Eigen::AngleAxisd(0.5 * glm::pi<double>(), Eigen::Vector3d::UnitX());
 
@@ -155,12 +149,20 @@ class ClothObject final : public bigger::SceneObject
 {
 public:
 
-    ClothObject(std::shared_ptr<elasty::ClothSimObject> cloth_sim_object,
+    ClothObject(std::shared_ptr<SimpleEngine> engine,
+                std::shared_ptr<elasty::ClothSimObject> cloth_sim_object,
                 std::shared_ptr<bigger::BlinnPhongMaterial> material) :
     bigger::SceneObject(material),
+    m_engine(engine),
     m_cloth_sim_object(cloth_sim_object)
     {
-        std::vector<bigger::PositionNormalVertex> vertex_data = generateVertexData();
+        // The engine fills the buffer at the end of each step
+        m_vertex_buffer = std::make_shared<elasty::ClothVertexBuffer>(cloth_sim_object);
+        m_vertex_buffer->update(m_engine->m_particles);
+        m_engine->m_cloth_vertex_buffers.push_back(m_vertex_buffer);
+
+        m_vertex_data.resize(m_vertex_buffer->getNumVertices());
+        updateVertexData();
 
         std::vector<uint16_t> triangle_list;
         for (unsigned int i = 0; i < cloth_sim_object->m_triangle_list.rows(); ++ i)
@@ -170,10 +172,10 @@ public:
             triangle_list.push_back(cloth_sim_object->m_triangle_list(i, 2));
         }
 
-        m_dynamic_mesh_primitive = std::make_unique<bigger::DynamicMeshPrimitive>(vertex_data, triangle_list);
+        m_dynamic_mesh_primitive = std::make_unique<bigger::DynamicMeshPrimitive>(m_vertex_data, triangle_list);
 
 #ifdef EXPORT_ALEMBIC
-        m_alembic_manager = elasty::createAlembicManager("./cloth.abc", m_cloth_sim_object, 1.0 / 60.0);
+        m_alembic_manager = elasty::createAlembicManager("./cloth.abc", m_cloth_sim_object, m_engine->m_particles, 1.0 / 60.0);
         elasty::submitCurrentStatus(m_alembic_manager);
 #endif
     }
@@ -190,8 +192,12 @@ public:
     {
         m_material->submitUniforms();
 
-        const std::vector<bigger::PositionNormalVertex> vertex_data = generateVertexData();
-        m_dynamic_mesh_primitive->updateVertexData(vertex_data);
+        // Upload only the frames that have not been uploaded yet
+        if (m_uploaded_revision != m_vertex_buffer->getRevision())
+        {
+            updateVertexData();
+            m_dynamic_mesh_primitive->updateVertexData(m_vertex_data);
+        }
 
         // Do not cull back-facing triangles
         bgfx::setState(BGFX_STATE_DEFAULT & (~ BGFX_STATE_CULL_CW));
@@ -199,6 +205,7 @@ public:
         m_dynamic_mesh_primitive->submitPrimitive(m_material->m_program);
     }
 
+    std::shared_ptr<SimpleEngine> m_engine;
     std::shared_ptr<elasty::ClothSimObject> m_cloth_sim_object;
 
 private:
@@ -209,45 +216,25 @@ private:
 
     std::unique_ptr<bigger::DynamicMeshPrimitive> m_dynamic_mesh_primitive;
 
-    std::vector<bigger::PositionNormalVertex> generateVertexData() const
+    std::shared_ptr<elasty::ClothVertexBuffer> m_vertex_buffer;
+    std::vector<bigger::PositionNormalVertex> m_vertex_data;
+    unsigned long m_uploaded_revision = 0;
+
+    void updateVertexData()
     {
-        std::vector<bigger::PositionNormalVertex> vertex_data(m_cloth_sim_object->m_particles.size());
-        for (unsigned int i = 0; i < m_cloth_sim_object->m_particles.size(); ++ i)
+        const float* positions = m_vertex_buffer->getPositions();
+        const float* normals = m_vertex_buffer->getNormals();
+
+        for (std::size_t i = 0; i < m_vertex_data.size(); ++ i)
         {
-            vertex_data[i] =
+            m_vertex_data[i] =
             {
-                {
-                    m_cloth_sim_object->m_particles[i]->x(0),
-                    m_cloth_sim_object->m_particles[i]->x(1),
-                    m_cloth_sim_object->m_particles[i]->x(2)
-                },
-                glm::vec3(0.0f)
+                { positions[3 * i + 0], positions[3 * i + 1], positions[3 * i + 2] },
+                { normals[3 * i + 0], normals[3 * i + 1], normals[3 * i + 2] }
             };
         }
 
-        for (unsigned int i = 0; i < m_cloth_sim_object->m_triangle_list.rows(); ++ i)
-        {
-            const auto& i_0 = m_cloth_sim_object->m_triangle_list(i, 0);
-            const auto& i_1 = m_cloth_sim_object->m_triangle_list(i, 1);
-            const auto& i_2 = m_cloth_sim_object->m_triangle_list(i, 2);
-
-            const glm::vec3& x_0 = vertex_data[i_0].position;
-            const glm::vec3& x_1 = vertex_data[i_1].position;
-            const glm::vec3& x_2 = vertex_data[i_2].position;
-
-            const glm::vec3 area_scaled_face_normal = glm::cross(x_1 - x_0, x_2 - x_0);
-
-            vertex_data[i_0].normal += area_scaled_face_normal;
-            vertex_data[i_1].normal += area_scaled_face_normal;
-            vertex_data[i_2].normal += area_scaled_face_normal;
-        }
-
-        for (unsigned int i = 0; i < m_cloth_sim_object->m_particles.size(); ++ i)
-        {
-            vertex_data[i].normal = glm::normalize(vertex_data[i].normal);
-        }
-
-        return vertex_data;
+        m_uploaded_revision = m_vertex_buffer->getRevision();
     }
 };
 
@@ -268,9 +255,9 @@ public:
     {
         m_material->submitUniforms();
 
-        for (auto& particle : m_engine->m_particles)
+        for (const auto& x : m_engine->m_particles.x)
         {
-            const glm::mat4 translate_matrix = glm::translate(eigen2glm(particle->x));
+            const glm::mat4 translate_matrix = glm::translate(eigen2glm(x));
             const glm::mat4 scale_matrix = glm::scale(glm::vec3(scale));
 
             const glm::mat4 transform = parent_transform_matrix * translate_matrix * scale_matrix;
@@ -347,12 +334,12 @@ void SimpleApp::initialize(int argc, char** argv)
     m_plane_primitive = std::make_shared<bigger::PlanePrimitive>();
 
     m_engine = std::make_unique<SimpleEngine>();
-    m_engine->m_cloth_sim_object = std::make_shared<elasty::ClothSimObject>(cloth_obj_path, cloth_distance_stiffness, cloth_bending_stiffness, cloth_import_transform);
+    m_engine->m_cloth_sim_object = std::make_shared<elasty::ClothSimObject>(cloth_obj_path, m_engine->m_particles, cloth_distance_stiffness, cloth_bending_stiffness, cloth_import_transform);
     m_engine->initializeScene();
 
     addSceneObject(std::make_shared<ParticlesObject>(m_engine, m_sphere_primitive, m_default_material));
     addSceneObject(std::make_shared<CheckerBoardObject>(m_plane_primitive, m_checker_white_material, m_checker_black_material));
-    addSceneObject(std::make_shared<ClothObject>(m_engine->m_cloth_sim_object, m_default_material), "cloth");
+    addSceneObject(std::make_shared<ClothObject>(m_engine, m_engine->m_cloth_sim_object, m_default_material), "cloth");
 }
 
 void SimpleApp::onReset()
@@ -382,16 +369,16 @@ void SimpleApp::updateApp()
     {
         if (ImGui::Button("Reset"))
         {
-            // Clear
+            // Clear (which also unregisters the vertex buffer of the old cloth)
             m_engine->m_cloth_sim_object = nullptr;
             m_engine->clearScene();
 
             // Init
-            m_engine->m_cloth_sim_object = std::make_shared<elasty::ClothSimObject>(cloth_obj_path, cloth_distance_stiffness, cloth_bending_stiffness, cloth_import_transform);
+            m_engine->m_cloth_sim_object = std::make_shared<elasty::ClothSimObject>(cloth_obj_path, m_engine->m_particles, cloth_distance_stiffness, cloth_bending_stiffness, cloth_import_transform);
             m_engine->initializeScene();
 
             // Re-register
-            m_scene_objects["cloth"] = std::make_shared<ClothObject>(m_engine->m_cloth_sim_object, m_default_material);
+            m_scene_objects["cloth"] = std::make_shared<ClothObject>(m_engine, m_engine->m_cloth_sim_object, m_default_material);
         }
     }
     ImGui::End();
@@ -407,6 +394,9 @@ void SimpleApp::updateApp()
 
     // Physics
     m_engine->stepTime();
+
+    // The rendering and the export read the particles on the host
+    m_engine->synchronizeParticles();
 }
 
 void SimpleApp::releaseSharedResources()
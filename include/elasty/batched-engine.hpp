@@ -0,0 +1,124 @@
+#ifndef batched_engine_hpp
+#define batched_engine_hpp
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <vector>
+#include <Eigen/Core>
+#include <elasty/colliders.hpp>
+#include <elasty/constraint-set.hpp>
+#include <elasty/particle-set.hpp>
+#include <elasty/thread-pool.hpp>
+
+namespace elasty
+{
+    /// \brief Simulation of many instances of the same scene with different
+    /// stiffness values (e.g., for a parameter sweep), stepped together.
+    /// \details The constraints (i.e., the topology and the rest data), the
+    /// masses, and the colliders are shared by all the instances and never
+    /// modified, so each instance only stores the positions and the velocities
+    /// of its particles (in one contiguous allocation for all the instances)
+    /// and its stiffness overrides. The instances are independent of each
+    /// other, so they are stepped in parallel, one contiguous range of
+    /// instances per thread, each thread using its own working buffers of the
+    /// predicted positions and the collision constraints (kept between the
+    /// steps, so that stepping does not allocate once they have grown); an
+    /// instance gives the same result regardless of the number of threads.
+    ///
+    /// Each (sub)step does the same as a single-threaded Engine with PBD and
+    /// the Gauss-Seidel scheme, with the scene hooks replaced by the uniform
+    /// gravity, the colliders, and the velocity damping below.
+    class BatchedEngine
+    {
+    public:
+
+        /// \param particles the particles of the scene in its initial state,
+        /// which all the instances start from
+        /// \param constraints the constraints of the scene, which are copied
+        /// once and shared by all the instances
+        BatchedEngine(const ParticleSet& particles, const ConstraintSet& constraints, const std::size_t num_instances);
+
+        void stepTime();
+
+        std::size_t getNumInstances() const { return m_num_instances; }
+        std::size_t getNumParticles() const { return m_particles.size(); }
+
+        /// \brief Override the stiffness of all the constraints of the type in
+        /// the instance.
+        template <typename Type>
+        void setStiffness(const std::size_t instance, const Scalar stiffness)
+        {
+            m_stiffness_overrides[instance][ConstraintSet::getTypeIndex<Type>()] = stiffness;
+        }
+
+        /// \brief Positions of the particles of the instance, in the order of
+        /// the particle set given to the constructor.
+        const Vector3* getPositions(const std::size_t instance) const { return m_positions.data() + instance * m_particles.size(); }
+        const Vector3* getVelocities(const std::size_t instance) const { return m_velocities.data() + instance * m_particles.size(); }
+
+        /// \brief Copy the state of the instance to a particle set of the same
+        /// layout as the one given to the constructor (e.g., for exporting the
+        /// instance with AlembicManager).
+        void copyInstance(const std::size_t instance, ParticleSet& particles) const;
+
+        Scalar m_dt = 1.0 / 60.0;
+        unsigned int m_num_iterations = 10;
+        unsigned int m_num_substeps = 1;
+
+        Vector3 m_gravity = Vector3(0.0, - 9.8, 0.0);
+
+        /// \brief Fraction of the velocities removed at the end of each
+        /// (sub)step.
+        Scalar m_velocity_damping = 0.0;
+
+        /// \brief Colliders shared by all the instances, from which collision
+        /// constraints are generated in each (sub)step.
+        ColliderSet m_colliders;
+
+        /// \brief Number of threads over which the instances are distributed.
+        unsigned int m_num_threads = 1;
+
+    private:
+
+        // The buffers of a thread, which are kept between the steps so that
+        // stepping allocates nothing once they have grown
+        struct WorkingBuffers
+        {
+            // Holds the predicted positions of the instance being stepped (and
+            // the masses for the constraints)
+            ParticleSet particles;
+            ConstraintSet instant_constraints;
+
+            // A copy of the shared colliders, as the contact generation uses
+            // per-particle scratch buffers
+            ColliderSet colliders;
+        };
+
+        // Step the instances in [begin, end) with the working buffers of a thread
+        void stepInstances(const std::size_t begin, const std::size_t end, WorkingBuffers& buffers);
+
+        void solveConstraints(const std::size_t instance, ParticleSet& working_particles, const ConstraintSet& instant_constraints) const;
+
+        std::size_t m_num_instances;
+
+        // The initial state and the masses of the scene
+        ParticleSet m_particles;
+
+        std::shared_ptr<const ConstraintSet> m_constraints;
+
+        // Instance-major arrays, i.e., the particles of the first instance, then those of the second one, ...
+        std::vector<Vector3> m_positions;
+        std::vector<Vector3> m_velocities;
+
+        std::vector<std::array<std::optional<Scalar>, ConstraintSet::num_types>> m_stiffness_overrides;
+
+        std::unique_ptr<ThreadPool> m_thread_pool;
+
+        // One per thread
+        std::vector<WorkingBuffers> m_working_buffers;
+    };
+}
+
+#endif /* batched_engine_hpp */
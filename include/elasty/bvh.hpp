@@ -0,0 +1,86 @@
+#ifndef bvh_hpp
+#define bvh_hpp
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <Eigen/Core>
+#include <elasty/mesh-topology.hpp>
+#include <elasty/scalar.hpp>
+
+namespace elasty
+{
+    /// \brief Bounding volume hierarchy (a binary tree of axis-aligned boxes)
+    /// over the triangles of a static mesh, for closest-point queries.
+    /// \details The tree is built top-down by splitting the triangles at the
+    /// median of their centroids along the longest axis of the box. The nodes
+    /// are stored in a flat array in depth-first order, and each leaf refers
+    /// to a contiguous range of the reordered triangle indices.
+    class TriangleBvh
+    {
+    public:
+
+        /// \brief Region of the triangle where its closest point lies.
+        enum class Feature
+        {
+            Face,
+            Edge,
+            Vertex
+        };
+
+        struct ClosestPoint
+        {
+            /// \brief Index of the closest triangle, or -1 if none has been
+            /// found within the maximum distance.
+            int32_t triangle;
+            Vector3 point;
+            Vector3 barycentric_coords;
+            Scalar squared_distance;
+
+            /// \brief The face, the edge (opposite to the vertex whose
+            /// barycentric coordinate is zero), or the vertex (whose
+            /// barycentric coordinate is one) of the closest point.
+            Feature feature;
+            int32_t feature_index;
+        };
+
+        void build(const std::vector<Vector3>& vertices, const MeshTopology::TriangleList& triangles);
+
+        /// \brief Find the point on the mesh closest to the query point.
+        /// \details The subtrees farther than the maximum distance (or than
+        /// the closest point found so far) are skipped.
+        ClosestPoint findClosestPoint(const Vector3& point,
+                                      const Scalar max_distance = std::numeric_limits<Scalar>::infinity()) const;
+
+        const std::vector<Vector3>& getVertices() const { return m_vertices; }
+        const MeshTopology::TriangleList& getTriangles() const { return m_triangles; }
+
+        Vector3 getBoxMin() const { return m_nodes.empty() ? Vector3::Zero() : m_nodes[0].box_min; }
+        Vector3 getBoxMax() const { return m_nodes.empty() ? Vector3::Zero() : m_nodes[0].box_max; }
+
+    private:
+
+        struct Node
+        {
+            Vector3 box_min;
+            Vector3 box_max;
+
+            // For a leaf, the range of m_triangle_indices; for an inner node,
+            // the index of the second child (the first one follows the node)
+            int32_t first;
+            int32_t count;
+
+            bool isLeaf() const { return count > 0; }
+        };
+
+        int32_t buildNode(const int32_t begin, const int32_t end, const std::vector<Vector3>& centroids);
+
+        std::vector<Vector3> m_vertices;
+        MeshTopology::TriangleList m_triangles;
+
+        std::vector<Node> m_nodes;
+        std::vector<int32_t> m_triangle_indices;
+    };
+}
+
+#endif /* bvh_hpp */
@@ -0,0 +1,109 @@
+#ifndef cloth_hierarchy_hpp
+#define cloth_hierarchy_hpp
+
+#include <array>
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <elasty/constraint-set.hpp>
+
+namespace elasty
+{
+    class ClothSimObject;
+    struct ParticleSet;
+
+    /// \brief Coarser meshes of a cloth whose distance constraints are
+    /// projected before those of the cloth itself, so that stretching is
+    /// removed at the scale of the whole cloth in a few iterations
+    /// [Muller 2008].
+    /// \details Each level is a lower-resolution mesh of the same cloth in its
+    /// rest shape (e.g., models/cloths/0.10.obj for 0.40.obj). Each vertex of
+    /// a level is embedded in the closest triangle of the next finer level
+    /// (for restriction), and each vertex of the finer level in the closest
+    /// triangle of the level (for prolongation), using barycentric
+    /// coordinates computed in the rest shapes. In each projection:
+    ///
+    /// 1. the positions of all the levels are restricted from the predicted
+    ///    positions of the cloth, from the finest level to the coarsest,
+    /// 2. starting from the coarsest level, the distance constraints of the
+    ///    level are projected, and the resulting position changes are
+    ///    interpolated to the next finer level, and
+    /// 3. the changes of the finest coarse level are added to the predicted
+    ///    positions of the cloth, whose own constraints are then projected
+    ///    by the engine as usual.
+    ///
+    /// The distance constraints of the coarse levels are unilateral (i.e.,
+    /// they only resist stretching), so that the coarse levels do not
+    /// prevent the fine-scale folds that they cannot represent. The coarse
+    /// vertices embedded near the pinned particles of the cloth (i.e.,
+    /// having zero inverse masses or fixed-point constraints) are fixed.
+    class ClothHierarchy
+    {
+    public:
+
+        /// \param coarse_obj_paths the OBJ files of the coarse levels, from
+        /// the finest to the coarsest
+        /// \param transform the transform applied to the coarse meshes, which
+        /// should be the same as the one used for building the cloth
+        /// \details The particles of the cloth are assumed to be in the rest
+        /// shape when this is called.
+        ClothHierarchy(const ClothSimObject& cloth,
+                       const ParticleSet& particles,
+                       const ConstraintSet& constraints,
+                       const std::vector<std::string>& coarse_obj_paths,
+                       const Eigen::Affine3d& transform = Eigen::Affine3d::Identity());
+
+        /// \brief Project the coarse levels and apply the resulting position
+        /// changes to the predicted positions of the cloth.
+        /// \details Throws std::runtime_error if the particle set no longer
+        /// contains the particles of the cloth (e.g., after the scene has
+        /// been cleared).
+        void project(ParticleSet& particles);
+
+        std::size_t getNumLevels() const { return m_levels.size(); }
+
+        /// \brief Number of the projection iterations per coarse level.
+        unsigned int m_num_iterations = 10;
+
+        /// \brief Stiffness of the distance constraints of the coarse levels.
+        Scalar m_stiffness = 1.0;
+
+    private:
+
+        // Barycentric coordinates w.r.t. a triangle of another level
+        struct Embedding
+        {
+            std::array<unsigned int, 3> vertices;
+            Vector3 coords;
+        };
+
+        struct Level
+        {
+            std::vector<Vector3> positions;
+            std::vector<Vector3> initial_positions;
+            std::vector<Scalar> inverse_masses;
+
+            std::vector<std::array<unsigned int, 2>> edges;
+            std::vector<Scalar> rest_lengths;
+
+            // Each vertex of this level in the triangles of the finer level
+            std::vector<Embedding> restriction;
+
+            // Each vertex of the finer level in the triangles of this level
+            std::vector<Embedding> prolongation;
+        };
+
+        void projectLevel(Level& level) const;
+
+        unsigned int m_particle_offset;
+        unsigned int m_num_particles;
+
+        // Whether each particle of the cloth is pinned
+        std::vector<bool> m_is_pinned;
+
+        std::vector<Level> m_levels;
+    };
+}
+
+#endif /* cloth_hierarchy_hpp */
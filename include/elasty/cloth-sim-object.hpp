@@ -1,13 +1,19 @@
 #ifndef cloth_sim_object_hpp
 #define cloth_sim_object_hpp
 
+#include <elasty/mesh-topology.hpp>
+#include <elasty/scalar.hpp>
 #include <elasty/sim-object.hpp>
+#include <memory>
 #include <string>
+#include <vector>
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 
 namespace elasty
 {
+    struct ParticleSet;
+
     class ClothSimObject : public SimObject
     {
     public:
@@ -19,15 +25,95 @@ namespace elasty
             Cross,
         };
 
-        using TriangleList = Eigen::Matrix<int32_t, Eigen::Dynamic, 3, Eigen::RowMajor>;
+        /// \brief Model of the in-plane stretching of the cloth.
+        /// \details Distance puts a single distance constraint on each edge.
+        /// As an edge shared by two triangles used to get one constraint per
+        /// triangle, the stiffness of the shared edges is raised to
+        /// 1 - (1 - distance_stiffness)^2, which is what two Gauss-Seidel
+        /// projections of an isolated edge give. This is only an
+        /// approximation of the former stiffness in a mesh, where the
+        /// neighboring constraints interact (e.g., a hanging cloth stretches
+        /// slightly more), so the results of existing scenes change.
+        /// DistancePerTriangle reproduces the former behavior exactly, i.e.,
+        /// three distance constraints per triangle with distance_stiffness.
+        /// TriangleStrain puts a single TriangleStrainConstraint on each
+        /// triangle instead, which also resists shearing, and
+        /// TriangleStrainAndArea additionally conserves the area of each
+        /// triangle with a TriangleAreaConstraint. The triangle constraints
+        /// use distance_stiffness as their stiffness.
+        enum class StretchStrategy
+        {
+            Distance,
+            DistancePerTriangle,
+            TriangleStrain,
+            TriangleStrainAndArea,
+        };
+
+        /// \brief Order of the particles of the cloth in the particle set.
+        /// \details Obj keeps the order of the vertices in the OBJ file.
+        /// Morton sorts the particles along the Z-order curve of their rest
+        /// positions, and ReverseCuthillMcKee by the reverse Cuthill-McKee
+        /// traversal of the mesh, so that the particles of a constraint (and
+        /// of the constraints next to each other in an array) are close in
+        /// memory. With either of them, the triangles are also sorted by their
+        /// smallest vertex, and the constraints of each type by their first
+        /// particle. m_obj_vertex_indices keeps the mapping back to the OBJ
+        /// vertices.
+        enum class ParticleOrder
+        {
+            Obj,
+            Morton,
+            ReverseCuthillMcKee,
+        };
+
+        using TriangleList = MeshTopology::TriangleList;
 
+        /// \brief Load a cloth mesh and build its particles and constraints.
+        /// \details The particles are appended to the passed particle set, and
+        /// the constraints refer to them by their indices in that set. The
+        /// triangle list, in contrast, uses the local indices of this object
+        /// (which are the OBJ vertex indices unless the particles are
+        /// reordered by particle_order).
         ClothSimObject(const std::string& obj_path,
-                       const double distance_stiffness = 0.90,
-                       const double bending_stiffness = 0.50,
+                       ParticleSet& particles,
+                       const Scalar distance_stiffness = 0.90,
+                       const Scalar bending_stiffness = 0.50,
                        const Eigen::Affine3d& transform = Eigen::Affine3d::Identity(),
-                       const Strategy strategy = Strategy::IsometricBending);
+                       const Strategy strategy = Strategy::IsometricBending,
+                       const StretchStrategy stretch_strategy = StretchStrategy::Distance,
+                       const ParticleOrder particle_order = ParticleOrder::Obj);
+
+        /// \brief Write the particles, the triangle list, the mapping to the
+        /// OBJ vertices, and the built constraints of this object to a binary cache file.
+        /// \details The file has a versioned header followed by flat
+        /// sections (at 8-byte aligned offsets) of fixed-layout little-endian
+        /// records, so it can also be memory-mapped by other tools. The
+        /// particle indices are stored relative to the first particle of
+        /// this object.
+        void writeCache(const std::string& cache_path, const ParticleSet& particles) const;
+
+        /// \brief Load an object from a cache written by writeCache, without
+        /// parsing the OBJ file or recomputing the constraint parameters.
+        /// \details The particles are appended to the passed particle set, as
+        /// in the constructor. The topology is rebuilt from the triangle
+        /// list. Throws std::runtime_error if the file is missing, of another
+        /// version, truncated, or corrupted (e.g., a particle index out of
+        /// range), in which case the particle set is left untouched.
+        static std::shared_ptr<ClothSimObject> readCache(const std::string& cache_path, ParticleSet& particles);
 
         TriangleList m_triangle_list;
+
+        /// \brief Adjacency of m_triangle_list (in the local indices).
+        MeshTopology m_topology;
+
+        /// \brief Index of the OBJ vertex of each particle of this object (in
+        /// the local indices), e.g., for exporting the mesh in the original
+        /// vertex order.
+        std::vector<unsigned int> m_obj_vertex_indices;
+
+    private:
+
+        ClothSimObject() = default;
     };
 }
 
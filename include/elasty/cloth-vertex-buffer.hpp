@@ -0,0 +1,72 @@
+#ifndef cloth_vertex_buffer_hpp
+#define cloth_vertex_buffer_hpp
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace elasty
+{
+    class ClothSimObject;
+    class ThreadPool;
+    struct ParticleSet;
+
+    /// \brief Single-precision positions (and optionally area-weighted vertex
+    /// normals) of a cloth, laid out for uploading to a renderer or writing
+    /// to an exporter as they are.
+    /// \details The arrays are allocated once at construction and are
+    /// overwritten in place by update, which the engine calls at the end of
+    /// each step for the buffers in Engine::m_cloth_vertex_buffers (and after
+    /// synchronizeParticles with a device backend), so that reading them
+    /// needs no copy or allocation per frame. The normals are accumulated per
+    /// vertex from the face normals of the triangles around it (by the
+    /// vertex-to-triangle adjacency of the topology), so that both passes
+    /// run in parallel without atomics when a thread pool is given.
+    class ClothVertexBuffer
+    {
+    public:
+
+        /// \param cloth the cloth, which needs to outlive this buffer
+        /// \param has_normals whether the vertex normals are also computed
+        ClothVertexBuffer(std::shared_ptr<const ClothSimObject> cloth, const bool has_normals = true);
+
+        /// \brief Fill the arrays from the current positions of the particles.
+        /// \param thread_pool the pool used for parallelizing the update; it
+        /// can be null
+        /// \details Throws std::runtime_error if the particle set no longer
+        /// contains the particles of the cloth (e.g., after the scene has
+        /// been cleared).
+        void update(const ParticleSet& particles, ThreadPool* thread_pool = nullptr);
+
+        std::size_t getNumVertices() const { return m_positions.size() / 3; }
+
+        /// \brief The 3 * N values x_0, y_0, z_0, x_1, y_1, z_1, ... of the
+        /// positions of the N particles of the cloth.
+        const float* getPositions() const { return m_positions.data(); }
+
+        /// \brief The 3 * N values of the unit vertex normals, in the same
+        /// layout as getPositions, or null if the normals are not computed.
+        const float* getNormals() const { return m_has_normals ? m_normals.data() : nullptr; }
+
+        /// \brief Number of the updates so far, which lets a reader skip
+        /// uploading a frame that it has already uploaded.
+        unsigned long getRevision() const { return m_revision; }
+
+    private:
+
+        void updateNormals(ThreadPool* thread_pool);
+
+        std::shared_ptr<const ClothSimObject> m_cloth;
+        bool m_has_normals;
+
+        std::vector<float> m_positions;
+        std::vector<float> m_normals;
+
+        // Area-scaled normals of the triangles
+        std::vector<float> m_face_normals;
+
+        unsigned long m_revision = 0;
+    };
+}
+
+#endif /* cloth_vertex_buffer_hpp */
@@ -0,0 +1,141 @@
+#ifndef colliders_hpp
+#define colliders_hpp
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <elasty/constraint-set.hpp>
+#include <elasty/mesh-topology.hpp>
+
+namespace elasty
+{
+    struct ParticleSet;
+    class ThreadPool;
+
+    struct SphereCollider
+    {
+        Vector3 center;
+        Scalar radius;
+
+        Scalar calculateSignedDistance(const Vector3& point, Vector3& normal) const;
+    };
+
+    /// \brief Set of the points within the radius from the segment between
+    /// the two end points.
+    struct CapsuleCollider
+    {
+        Vector3 end_0;
+        Vector3 end_1;
+        Scalar radius;
+
+        Scalar calculateSignedDistance(const Vector3& point, Vector3& normal) const;
+    };
+
+    /// \brief Oriented box, which is the axis-aligned box
+    /// [-half_extents, half_extents] moved by the rigid transform.
+    struct BoxCollider
+    {
+        Isometry3 transform;
+        Vector3 half_extents;
+
+        Scalar calculateSignedDistance(const Vector3& point, Vector3& normal) const;
+    };
+
+    /// \brief Static triangle mesh represented by the signed distances
+    /// sampled on a regular grid.
+    /// \details The distances are computed once at build time by querying a
+    /// TriangleBvh of the mesh at each grid node (in parallel if a thread pool
+    /// is given), and the signs are determined by the angle-weighted pseudo
+    /// normals [Baerentzen and Aanaes 2005], so the mesh should be closed and
+    /// consistently oriented (counter-clockwise when seen from outside). At
+    /// run time, a query is a trilinear interpolation of the eight nearest
+    /// samples, whose gradient gives the normal.
+    class SdfCollider
+    {
+    public:
+
+        /// \param cell_size the spacing of the grid nodes
+        /// \param margin the distance by which the grid extends beyond the
+        /// bounding box of the mesh, which should be larger than the
+        /// thickness used for the contacts
+        void build(const std::vector<Vector3>& vertices,
+                   const MeshTopology::TriangleList& triangles,
+                   const Scalar cell_size,
+                   const Scalar margin,
+                   ThreadPool* thread_pool = nullptr);
+
+        /// \brief Build the grid from the mesh in an OBJ file, after moving it
+        /// by the transform.
+        void build(const std::string& obj_path,
+                   const Eigen::Affine3d& transform,
+                   const Scalar cell_size,
+                   const Scalar margin,
+                   ThreadPool* thread_pool = nullptr);
+
+        /// \brief Signed distance (positive outside) and its gradient at the
+        /// point; infinity if the point is outside the grid.
+        Scalar calculateSignedDistance(const Vector3& point, Vector3& normal) const;
+
+        const Vector3& getBoxMin() const { return m_box_min; }
+        Vector3 getBoxMax() const { return m_box_min + m_cell_size * (m_resolution.cast<Scalar>() - Vector3::Ones()); }
+
+    private:
+
+        Scalar getValue(const int i, const int j, const int k) const
+        {
+            return m_values[(k * m_resolution(1) + j) * m_resolution(0) + i];
+        }
+
+        Vector3 m_box_min;
+        Scalar m_cell_size = 1.0;
+
+        // The number of the grid nodes along each axis
+        Eigen::Vector3i m_resolution = Eigen::Vector3i::Zero();
+
+        std::vector<Scalar> m_values;
+    };
+
+    /// \brief Set of the static colliders of a scene, which generates
+    /// environmental collision constraints for the particles touching them.
+    /// \details The colliders are stored in per-type arrays, so that the
+    /// contact generation runs a tight loop over the particles for each
+    /// collider (in parallel if a thread pool is given) instead of making a
+    /// virtual call per particle. Each contact is an
+    /// EnvironmentalCollisionConstraint against the tangent plane of the
+    /// collider at the predicted position, offset by the thickness. This is
+    /// intended to be called from Engine::generateCollisionConstraints to
+    /// fill the instant constraints.
+    class ColliderSet
+    {
+    public:
+
+        void generateConstraints(const ParticleSet& particles, ConstraintSet& constraints, ThreadPool* thread_pool = nullptr);
+
+        void clear();
+
+        std::vector<SphereCollider> m_spheres;
+        std::vector<CapsuleCollider> m_capsules;
+        std::vector<BoxCollider> m_boxes;
+        std::vector<std::shared_ptr<const SdfCollider>> m_sdfs;
+
+        Scalar m_thickness = 0.0;
+        Scalar m_stiffness = 1.0;
+
+    private:
+
+        template <typename Collider>
+        void generateConstraintsForCollider(const Collider& collider,
+                                            const ParticleSet& particles,
+                                            ConstraintSet& constraints,
+                                            ThreadPool* thread_pool);
+
+        // Per-particle buffers reused in every step
+        std::vector<Scalar> m_signed_distances;
+        std::vector<Vector3> m_normals;
+    };
+}
+
+#endif /* colliders_hpp */
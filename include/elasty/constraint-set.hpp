@@ -0,0 +1,148 @@
+#ifndef constraint_set_hpp
+#define constraint_set_hpp
+
+#include <algorithm>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <elasty/constraint.hpp>
+
+namespace elasty
+{
+    /// \brief A collection of constraints stored in per-type flat arrays.
+    /// \details Each constraint type has its own contiguous array of values,
+    /// so that a solver can iterate over each array in a tight loop whose
+    /// calls are resolved at compile time. The arrays are visited in the order
+    /// of the template arguments.
+    template <typename... Types>
+    class TypedConstraintSet
+    {
+    public:
+
+        static constexpr std::size_t num_types = sizeof...(Types);
+
+        /// \brief Index of the constraint type in the order of forEachBatch.
+        template <typename Type>
+        static constexpr std::size_t getTypeIndex()
+        {
+            constexpr bool is_same[] = { std::is_same<Type, Types>::value... };
+            for (std::size_t i = 0; i < num_types; ++ i)
+            {
+                if (is_same[i]) { return i; }
+            }
+            return num_types;
+        }
+
+        template <typename Type>
+        void add(const Type& constraint)
+        {
+            get<Type>().push_back(constraint);
+        }
+
+        /// \brief Construct a constraint in place at the end of its array.
+        /// \details Together with clear, which keeps the capacity, this lets
+        /// per-step constraints (e.g., contacts) be generated without any
+        /// memory allocation once the arrays have grown large enough.
+        template <typename Type, typename... Args>
+        Type& emplace(Args&&... args)
+        {
+            return get<Type>().emplace_back(std::forward<Args>(args)...);
+        }
+
+        /// \brief Reserve the capacity of the array of the constraint type.
+        template <typename Type>
+        void reserve(const std::size_t capacity)
+        {
+            get<Type>().reserve(capacity);
+        }
+
+        /// \brief Append all the constraints of another set.
+        void append(const TypedConstraintSet& other)
+        {
+            (appendBatch(get<Types>(), other.template get<Types>()), ...);
+        }
+
+        template <typename Type>
+        std::vector<Type>& get() { return std::get<std::vector<Type>>(m_batches); }
+
+        template <typename Type>
+        const std::vector<Type>& get() const { return std::get<std::vector<Type>>(m_batches); }
+
+        /// \brief Call the function with each of the per-type arrays.
+        template <typename Function>
+        void forEachBatch(Function&& function)
+        {
+            std::apply([&](auto&... batches) { (function(batches), ...); }, m_batches);
+        }
+
+        template <typename Function>
+        void forEachBatch(Function&& function) const
+        {
+            std::apply([&](const auto&... batches) { (function(batches), ...); }, m_batches);
+        }
+
+        std::size_t size() const
+        {
+            return std::apply([](const auto&... batches) { return (std::size_t(0) + ... + batches.size()); }, m_batches);
+        }
+
+        bool empty() const { return size() == 0; }
+
+        /// \brief Number of the constraints in each array (in the order of
+        /// forEachBatch).
+        std::vector<std::size_t> getBatchSizes() const
+        {
+            return std::apply([](const auto&... batches) { return std::vector<std::size_t>{ batches.size()... }; }, m_batches);
+        }
+
+        /// \brief Sort the constraints of each array by their first particles.
+        /// \details With the particles in a local order (see
+        /// ClothSimObject::ParticleOrder), this makes a pass over an array
+        /// access the particles almost sequentially. The sort is stable, and
+        /// the coloring keeps the relative order within each color, so the
+        /// constraints of a color stay sorted as well.
+        void sortByFirstParticle()
+        {
+            forEachBatch([](auto& batch)
+            {
+                std::stable_sort(batch.begin(), batch.end(), [](const auto& a, const auto& b) { return a.getIndices()[0] < b.getIndices()[0]; });
+            });
+        }
+
+        /// \brief Remove all the constraints.
+        /// \details The allocated capacity of each array is kept, so refilling
+        /// the set (e.g., with collision constraints in every step) does not
+        /// allocate memory again.
+        void clear()
+        {
+            std::apply([](auto&... batches) { (batches.clear(), ...); }, m_batches);
+        }
+
+    private:
+
+        template <typename Type>
+        static void appendBatch(std::vector<Type>& batch, const std::vector<Type>& other)
+        {
+            batch.insert(batch.end(), other.begin(), other.end());
+        }
+
+        std::tuple<std::vector<Types>...> m_batches;
+    };
+
+    using ConstraintSet = TypedConstraintSet<DistanceConstraint,
+                                             BendingConstraint,
+                                             IsometricBendingConstraint,
+                                             FixedPointConstraint,
+                                             EnvironmentalCollisionConstraint,
+                                             ParticleCollisionConstraint,
+                                             PointTriangleCollisionConstraint,
+                                             LongRangeAttachmentConstraint,
+                                             TriangleStrainConstraint,
+                                             TriangleAreaConstraint,
+                                             TetrahedronStrainConstraint,
+                                             VolumeConstraint>;
+}
+
+#endif /* constraint_set_hpp */
@@ -1,165 +1,640 @@
 #ifndef constraint_hpp
 #define constraint_hpp
 
-#include <memory>
-#include <vector>
+#include <array>
+#include <cassert>
+#include <elasty/particle-set.hpp>
+#include <elasty/profiler.hpp>
 #include <Eigen/Core>
 
 namespace elasty
 {
-    struct Particle;
-
     enum class ConstraintType { Bilateral, Unilateral };
 
+    /// \brief Common base of the constraint types.
+    /// \details Constraints are not polymorphic: the engine stores them by
+    /// value in per-type arrays (see ConstraintSet) and calls the methods of
+    /// each concrete type directly, without virtual dispatch.
     class Constraint
     {
     public:
 
-        Constraint(const std::vector<std::shared_ptr<Particle>>& particles,
-                   const double stiffness) :
-        m_stiffness(stiffness),
-        m_particles(particles)
+        Constraint(const Scalar stiffness) :
+        m_stiffness(stiffness)
+        {
+        }
+
+        /// \brief Stiffness of this constraint, which should be in [0, 1].
+        /// \details This is used by PBD and ignored by XPBD.
+        Scalar m_stiffness;
+
+        /// \brief Compliance (i.e., inverse stiffness) of this constraint,
+        /// which should be non-negative.
+        /// \details This is used by XPBD and ignored by PBD. Zero means an
+        /// infinitely stiff constraint.
+        Scalar m_compliance = 0.0;
+
+        /// \brief Accumulated Lagrange multiplier of this constraint in the
+        /// current (sub)step, which is updated by XPBD.
+        Scalar m_lambda = 0.0;
+    };
+
+    /// \brief Base class of the constraints whose number of associated
+    /// particles is known at compile time.
+    /// \details The number of particles is (in most cases) solely determined in
+    /// each constraint. For example, a distance constraint need to have exactly
+    /// two particles. Some special constraints (e.g., shape-matching
+    /// constraint) could have a variable number of particles; they should
+    /// be given their own base instead.
+    ///
+    /// The projection methods are implemented here once for all the
+    /// constraint types, using the following methods that each derived type
+    /// (Derived) provides:
+    ///
+    /// - Scalar calculateValue(const ParticleSet& particles) const
+    ///   calculates the constraint function value C(x).
+    /// - void calculateGrad(const ParticleSet& particles, Scalar* grad_C) const
+    ///   calculates the derivative of the constraint function grad C(x). As
+    ///   constraints can have different vector sizes, it will store the result
+    ///   to the passed raw buffer that should be allocated in the caller,
+    ///   rather than returning a dynamically allocated variable-length vector.
+    ///   This method does not check whether the buffer is adequately
+    ///   allocated, or not.
+    /// - static constexpr ConstraintType getType() returns the constraint
+    ///   type (i.e., either unilateral or bilateral).
+    ///
+    /// A derived type may also provide
+    ///
+    /// - Scalar calculateValueAndGrad(const ParticleSet& particles, Scalar* grad_C) const
+    ///   calculates both of the above at once, sharing the intermediate
+    ///   results (e.g., the normals of a bending constraint). The default
+    ///   calls the two methods one after the other. Bilateral constraints
+    ///   are evaluated with this, while unilateral ones skip the gradient
+    ///   when they are inactive.
+    template <typename Derived, int Num>
+    class FixedNumConstraint : public Constraint
+    {
+    public:
+
+        FixedNumConstraint(const ParticleSet& particles,
+                           const std::array<unsigned int, Num>& indices,
+                           const Scalar stiffness) :
+        Constraint(stiffness),
+        m_indices(indices)
         {
+            for (unsigned int j = 0; j < Num; ++ j)
+            {
+                m_inv_M.template segment<3>(3 * j).setConstant(particles.w[indices[j]]);
+            }
+        }
+
+        static constexpr unsigned int num_particles = Num;
+
+        /// \brief Position corrections of the associated particles.
+        using Correction = Eigen::Matrix<Scalar, Num * 3, 1>;
+
+        /// \brief Indices of the associated particles in the particle set.
+        const std::array<unsigned int, Num>& getIndices() const { return m_indices; }
+
+        /// \brief Diagonal of the inverse mass matrix of the associated
+        /// particles.
+        const Correction& getInverseMasses() const { return m_inv_M; }
+
+        /// \brief Calculate the PBD corrections of the predicted positions of
+        /// the associated particles (scaled by the stiffness), without
+        /// applying them.
+        /// \param value if not null, receives the value of the constraint
+        /// (i.e., C) at the predicted positions before the correction, which
+        /// is calculated anyway (e.g., for monitoring the convergence)
+        /// \return false when the constraint does not need to move the
+        /// particles (e.g., an inactive unilateral constraint)
+        /// \details This is intended to be used in a Jacobi-style solver.
+        bool calculateCorrection(const ParticleSet& particles, Correction& delta_x, Scalar* value = nullptr) const
+        {
+            if (!calculateProjection(particles, delta_x, value)) { return false; }
+
+            // Scale $\Delta x$ by the stiffness
+            delta_x *= m_stiffness;
+
+            return true;
+        }
+
+        /// \brief Calculate the corrections that move the predicted positions
+        /// of the associated particles onto the constraint manifold (i.e., the
+        /// PBD corrections without the stiffness scaling).
+        /// \details This is the local step of projective dynamics (see
+        /// ProjectiveDynamicsSolver).
+        bool calculateProjection(const ParticleSet& particles, Correction& delta_x, Scalar* value = nullptr) const
+        {
+            Scalar C;
+            Correction grad_C;
+            const bool is_active = evaluate(particles, C, grad_C);
+            if (value != nullptr) { *value = C; }
+            if (!is_active) { return false; }
+
+            // Calculate $s$
+            const Scalar s = C / (grad_C.transpose() * m_inv_M.asDiagonal() * grad_C);
+
+            // Calculate $\Delta x$
+            delta_x = - s * m_inv_M.asDiagonal() * grad_C;
+            assert(!delta_x.hasNaN());
+
+            return true;
+        }
+
+        /// \brief Calculate the XPBD corrections of the predicted positions of
+        /// the associated particles, without applying them, and accumulate
+        /// the Lagrange multiplier [Macklin et al. 2016].
+        /// \param dt the time step (of the substep) used for scaling the
+        /// compliance
+        bool calculateXpbdCorrection(const ParticleSet& particles, const Scalar dt, Correction& delta_x, Scalar* value = nullptr)
+        {
+            Scalar C;
+            Correction grad_C;
+            const bool is_active = evaluate(particles, C, grad_C);
+            if (value != nullptr) { *value = C; }
+            if (!is_active) { return false; }
+
+            const Scalar alpha_tilde = m_compliance / (dt * dt);
+
+            const Scalar delta_lambda = (- C - alpha_tilde * m_lambda) / (grad_C.transpose() * m_inv_M.asDiagonal() * grad_C + alpha_tilde);
+
+            delta_x = delta_lambda * m_inv_M.asDiagonal() * grad_C;
+            assert(!delta_x.hasNaN());
+
+            m_lambda += delta_lambda;
+
+            return true;
         }
 
-        /// \brief Calculates the constraint function value C(x).
-        virtual double calculateValue() = 0;
+        /// \brief Calculate the constraint value and its gradient at once.
+        Scalar calculateValueAndGrad(const ParticleSet& particles, Scalar* grad_C) const
+        {
+            derived().calculateGrad(particles, grad_C);
+            return derived().calculateValue(particles);
+        }
 
-        /// \brief Calculate the derivative of the constraint function
-        /// grad C(x).
-        /// \details As constraints can have different vector sizes, it will
-        /// store the result to the passed raw buffer that should be allocated
-        /// in the caller, rather than returning a dynamically allocated
-        /// variable-length vector. This method does not check whether the
-        /// buffer is adequately allocated, or not.
-        virtual void calculateGrad(double* grad_C) = 0;
+        /// \brief Add the corrections to the predicted positions of the
+        /// associated particles.
+        void applyCorrection(const Correction& delta_x, ParticleSet& particles) const
+        {
+            for (unsigned int j = 0; j < Num; ++ j)
+            {
+                particles.p[m_indices[j]] += delta_x.template segment<3>(3 * j);
+            }
+        }
 
         /// \brief Manipulate the associated particles by projecting them to the
-        /// constraint manifold.
+        /// constraint manifold with PBD.
         /// \details This method should be called by the core engine. As this
         /// method directly updates the predicted positions of the associated
         /// particles, it is intended to be used in a Gauss-Seidel-style solver.
-        virtual void projectParticles() = 0;
-
-        /// \brief Return the constraint type (i.e., either unilateral or
-        /// bilateral).
-        virtual ConstraintType getType() = 0;
+        void projectParticles(ParticleSet& particles, Scalar* value = nullptr) const
+        {
+            Correction delta_x;
+            if (calculateCorrection(particles, delta_x, value)) { applyCorrection(delta_x, particles); }
+        }
 
-        /// \brief Stiffness of this constraint, which should be in [0, 1].
-        double m_stiffness;
+        /// \brief XPBD counterpart of projectParticles.
+        void projectParticlesXpbd(ParticleSet& particles, const Scalar dt, Scalar* value = nullptr)
+        {
+            Correction delta_x;
+            if (calculateXpbdCorrection(particles, dt, delta_x, value)) { applyCorrection(delta_x, particles); }
+        }
 
     protected:
 
-        /// \brief Associated particles.
-        /// \details The number of particles is (in most cases) solely
-        /// determined in each constraint. For example, a distance constraint
-        /// need to have exactly two particles. Some special constraints
-        /// (e.g., shape-matching constraint) could have a variable number of
-        /// particles.
-        std::vector<std::shared_ptr<Particle>> m_particles;
+        std::array<unsigned int, Num> m_indices;
+        Eigen::Matrix<Scalar, Num * 3, 1> m_inv_M;
+
+    private:
+
+        const Derived& derived() const { return static_cast<const Derived&>(*this); }
+
+        /// \brief Evaluate the constraint value and its gradient.
+        /// \return false when the particles need not (or cannot) be moved,
+        /// i.e., when a unilateral constraint is satisfied or when the
+        /// gradient is sufficiently small
+        bool evaluate(const ParticleSet& particles, Scalar& C, Correction& grad_C) const
+        {
+            if (Derived::getType() == ConstraintType::Unilateral)
+            {
+                C = derived().calculateValue(particles);
+
+                if (C >= 0.0)
+                {
+                    ELASTY_PROFILE_COUNT(InactiveConstraints, 1);
+                    return false;
+                }
+
+                derived().calculateGrad(particles, grad_C.data());
+            }
+            else
+            {
+                C = derived().calculateValueAndGrad(particles, grad_C.data());
+            }
+
+            // Skip if the gradient is sufficiently small
+            if (grad_C.isApprox(Correction::Zero()))
+            {
+                ELASTY_PROFILE_COUNT(DegenerateConstraints, 1);
+                return false;
+            }
+
+            ELASTY_PROFILE_COUNT(ProjectedConstraints, 1);
+            return true;
+        }
+    };
+
+    class BendingConstraint final : public FixedNumConstraint<BendingConstraint, 4>
+    {
+    public:
+
+        BendingConstraint(const ParticleSet& particles,
+                          const unsigned int index_0,
+                          const unsigned int index_1,
+                          const unsigned int index_2,
+                          const unsigned int index_3,
+                          const Scalar stiffness,
+                          const Scalar dihedral_angle);
+
+        Scalar calculateValue(const ParticleSet& particles) const;
+        void calculateGrad(const ParticleSet& particles, Scalar* grad_C) const;
+        Scalar calculateValueAndGrad(const ParticleSet& particles, Scalar* grad_C) const;
+        static constexpr ConstraintType getType() { return ConstraintType::Bilateral; }
+
+        Scalar getDihedralAngle() const { return m_dihedral_angle; }
+
+    private:
+
+        Scalar m_dihedral_angle;
+    };
+
+    class DistanceConstraint final : public FixedNumConstraint<DistanceConstraint, 2>
+    {
+    public:
+
+        DistanceConstraint(const ParticleSet& particles,
+                           const unsigned int index_0,
+                           const unsigned int index_1,
+                           const Scalar stiffness,
+                           const Scalar d);
+
+        Scalar calculateValue(const ParticleSet& particles) const;
+        void calculateGrad(const ParticleSet& particles, Scalar* grad_C) const;
+        static constexpr ConstraintType getType() { return ConstraintType::Bilateral; }
+
+        Scalar getRestLength() const { return m_d; }
+
+    private:
+
+        Scalar m_d;
     };
 
-    class BendingConstraint final : public Constraint
+    class EnvironmentalCollisionConstraint final : public FixedNumConstraint<EnvironmentalCollisionConstraint, 1>
     {
     public:
 
-        BendingConstraint(const std::shared_ptr<Particle> p_0,
-                          const std::shared_ptr<Particle> p_1,
-                          const std::shared_ptr<Particle> p_2,
-                          const std::shared_ptr<Particle> p_3,
-                          const double stiffness,
-                          const double dihedral_angle);
+        EnvironmentalCollisionConstraint(const ParticleSet& particles,
+                                         const unsigned int index_0,
+                                         const Scalar stiffness,
+                                         const Vector3& n,
+                                         const Scalar d);
+
+        Scalar calculateValue(const ParticleSet& particles) const;
+        void calculateGrad(const ParticleSet& particles, Scalar* grad_C) const;
+        static constexpr ConstraintType getType() { return ConstraintType::Unilateral; }
+
+        const Vector3& getNormal() const { return m_n; }
+        Scalar getDistance() const { return m_d; }
+
+    private:
+
+        Vector3 m_n;
+        Scalar m_d;
+    };
+
+    class FixedPointConstraint final : public FixedNumConstraint<FixedPointConstraint, 1>
+    {
+    public:
+
+        FixedPointConstraint(const ParticleSet& particles,
+                             const unsigned int index_0,
+                             const Scalar stiffness,
+                             const Vector3& point);
+
+        Scalar calculateValue(const ParticleSet& particles) const;
+        void calculateGrad(const ParticleSet& particles, Scalar* grad_C) const;
+        static constexpr ConstraintType getType() { return ConstraintType::Bilateral; }
+
+        const Vector3& getPoint() const { return m_point; }
+
+        /// \brief Move the point (e.g., for animating a pinned particle).
+        void setPoint(const Vector3& point) { m_point = point; }
+
+    private:
+
+        Vector3 m_point;
+    };
+
+    /// \brief Unilateral constraint that keeps a particle within the given
+    /// distance from an attachment point, i.e., a long-range attachment
+    /// [Kim et al. 2012].
+    /// \details The distance is typically the geodesic distance on the rest
+    /// shape from the particle to a pinned particle, whose fixed point is the
+    /// attachment point (see generateLongRangeAttachmentConstraints). Being
+    /// inactive unless the particle is farther away than that, the constraint
+    /// removes the stretching accumulated along a long chain of distance
+    /// constraints in a single projection, without affecting the motion
+    /// towards the pin.
+    class LongRangeAttachmentConstraint final : public FixedNumConstraint<LongRangeAttachmentConstraint, 1>
+    {
+    public:
+
+        LongRangeAttachmentConstraint(const ParticleSet& particles,
+                                      const unsigned int index_0,
+                                      const Scalar stiffness,
+                                      const Vector3& attachment_point,
+                                      const Scalar d);
+
+        Scalar calculateValue(const ParticleSet& particles) const;
+        void calculateGrad(const ParticleSet& particles, Scalar* grad_C) const;
+        static constexpr ConstraintType getType() { return ConstraintType::Unilateral; }
+
+        const Vector3& getAttachmentPoint() const { return m_attachment_point; }
+        Scalar getDistance() const { return m_d; }
 
-        double calculateValue() override;
-        void calculateGrad(double* grad_C) override;
-        void projectParticles() override;
-        ConstraintType getType() override { return ConstraintType::Bilateral; }
+        /// \brief Move the attachment point (e.g., together with an animated
+        /// pin).
+        void setAttachmentPoint(const Vector3& attachment_point) { m_attachment_point = attachment_point; }
 
     private:
 
-        const Eigen::Matrix<double, 12, 1> m_inv_M;
-        const double m_dihedral_angle;
+        Vector3 m_attachment_point;
+        Scalar m_d;
     };
 
-    class DistanceConstraint final : public Constraint
+    class IsometricBendingConstraint final : public FixedNumConstraint<IsometricBendingConstraint, 4>
     {
     public:
 
-        DistanceConstraint(const std::shared_ptr<Particle> p_0,
-                           const std::shared_ptr<Particle> p_1,
-                           const double stiffness,
-                           const double d);
-        
-        double calculateValue() override;
-        void calculateGrad(double* grad_C) override;
-        void projectParticles() override;
-        ConstraintType getType() override { return ConstraintType::Bilateral; }
+        IsometricBendingConstraint(const ParticleSet& particles,
+                                   const unsigned int index_0,
+                                   const unsigned int index_1,
+                                   const unsigned int index_2,
+                                   const unsigned int index_3,
+                                   const Scalar stiffness);
+
+        /// \brief Construct the constraint with the precomputed K and scale
+        /// (e.g., restored from a cache) instead of computing them from the
+        /// current positions.
+        IsometricBendingConstraint(const ParticleSet& particles,
+                                   const unsigned int index_0,
+                                   const unsigned int index_1,
+                                   const unsigned int index_2,
+                                   const unsigned int index_3,
+                                   const Scalar stiffness,
+                                   const Vector4& K,
+                                   const Scalar scale);
+
+        Scalar calculateValue(const ParticleSet& particles) const;
+        void calculateGrad(const ParticleSet& particles, Scalar* grad_C) const;
+        Scalar calculateValueAndGrad(const ParticleSet& particles, Scalar* grad_C) const;
+        static constexpr ConstraintType getType() { return ConstraintType::Bilateral; }
+
+        /// \brief Cotangent weights of the four particles, which sum to zero.
+        const Vector4& getK() const { return m_K; }
+
+        /// \brief Scale of the energy, i.e., three over the total area of the
+        /// two triangles.
+        Scalar getScale() const { return m_scale; }
+
+        /// \brief Matrix Q of the quadratic form of the energy, which is the
+        /// rank-one matrix of K scaled.
+        Matrix4 getQ() const { return m_scale * m_K * m_K.transpose(); }
 
     private:
 
-        const Eigen::Matrix<double, 6, 1> m_inv_M;
-        const double m_d;
+        /// \brief Calculate the sum of the relative positions to the first
+        /// particle weighted by K, which the value and the gradient share.
+        Vector3 calculateWeightedSum(const ParticleSet& particles) const;
+
+        Vector4 m_K;
+        Scalar m_scale;
     };
 
-    class EnvironmentalCollisionConstraint final : public Constraint
+    /// \brief Unilateral constraint that keeps two particles at least the
+    /// given distance apart (e.g., for self-collisions).
+    class ParticleCollisionConstraint final : public FixedNumConstraint<ParticleCollisionConstraint, 2>
     {
     public:
 
-        EnvironmentalCollisionConstraint(const std::shared_ptr<Particle> p_0,
-                                         const double stiffness,
-                                         const Eigen::Vector3d& n,
-                                         const double d);
+        ParticleCollisionConstraint(const ParticleSet& particles,
+                                    const unsigned int index_0,
+                                    const unsigned int index_1,
+                                    const Scalar stiffness,
+                                    const Scalar d);
+
+        Scalar calculateValue(const ParticleSet& particles) const;
+        void calculateGrad(const ParticleSet& particles, Scalar* grad_C) const;
+        static constexpr ConstraintType getType() { return ConstraintType::Unilateral; }
 
-        double calculateValue() override;
-        void calculateGrad(double* grad_C) override;
-        void projectParticles() override;
-        ConstraintType getType() override { return ConstraintType::Unilateral; }
+        Scalar getDistance() const { return m_d; }
 
     private:
 
-        const Eigen::Matrix<double, 3, 1> m_inv_M;
-        const Eigen::Vector3d m_n;
-        const double m_d;
+        Scalar m_d;
     };
 
-    class FixedPointConstraint final : public Constraint
+    /// \brief Unilateral constraint that keeps a particle (index_0) on one
+    /// side of a triangle (index_1, index_2, index_3), at least the given
+    /// thickness away from it.
+    /// \details The contact point on the triangle is fixed by the barycentric
+    /// coordinates given at construction, and the gradient treats the normal
+    /// of the triangle as constant, as is common for collision constraints.
+    class PointTriangleCollisionConstraint final : public FixedNumConstraint<PointTriangleCollisionConstraint, 4>
     {
     public:
 
-        FixedPointConstraint(const std::shared_ptr<Particle> p_0,
-                             const double stiffness,
-                             const Eigen::Vector3d& point);
+        /// \param barycentric_coords the coordinates of the contact point
+        /// w.r.t. the three vertices of the triangle
+        /// \param side +1 or -1, the side (w.r.t. the normal of the triangle
+        /// whose vertices are in the counter-clockwise order) that the
+        /// particle should be on
+        PointTriangleCollisionConstraint(const ParticleSet& particles,
+                                         const unsigned int index_0,
+                                         const unsigned int index_1,
+                                         const unsigned int index_2,
+                                         const unsigned int index_3,
+                                         const Scalar stiffness,
+                                         const Scalar thickness,
+                                         const Vector3& barycentric_coords,
+                                         const Scalar side);
+
+        Scalar calculateValue(const ParticleSet& particles) const;
+        void calculateGrad(const ParticleSet& particles, Scalar* grad_C) const;
+        static constexpr ConstraintType getType() { return ConstraintType::Unilateral; }
+
+        Scalar getThickness() const { return m_thickness; }
+        const Vector3& getBarycentricCoords() const { return m_barycentric_coords; }
+        Scalar getSide() const { return m_side; }
+
+    private:
+
+        Vector3 calculateSideNormal(const ParticleSet& particles) const;
+
+        Scalar m_thickness;
+        Vector3 m_barycentric_coords;
+        Scalar m_side;
+    };
+
+    /// \brief Strain-based stretch constraint of a tetrahedron (index_0,
+    /// index_1, index_2, index_3), as of strain based dynamics.
+    /// \details The constraint is C = sqrt(V_0) |E|_F, where E = (F^T F - I) / 2
+    /// is the Green strain of the deformation gradient F = D_s D_m^{-1} (D_s and
+    /// D_m are the matrices of the edges from the first particle at the
+    /// predicted and the rest positions) and V_0 is the rest volume, so that
+    /// (1 / 2) C^2 / compliance is the St. Venant-Kirchhoff energy without the
+    /// trace term and the compliance of XPBD does not depend on the
+    /// resolution. The inverse of D_m is computed once at construction.
+    class TetrahedronStrainConstraint final : public FixedNumConstraint<TetrahedronStrainConstraint, 4>
+    {
+    public:
 
-        double calculateValue() override;
-        void calculateGrad(double* grad_C) override;
-        void projectParticles() override;
-        ConstraintType getType() override { return ConstraintType::Bilateral; }
+        TetrahedronStrainConstraint(const ParticleSet& particles,
+                                    const unsigned int index_0,
+                                    const unsigned int index_1,
+                                    const unsigned int index_2,
+                                    const unsigned int index_3,
+                                    const Scalar stiffness);
+
+        /// \brief Construct the constraint with the precomputed inverse rest
+        /// matrix and rest volume (e.g., restored from a cache) instead of
+        /// computing them from the current positions.
+        TetrahedronStrainConstraint(const ParticleSet& particles,
+                                    const unsigned int index_0,
+                                    const unsigned int index_1,
+                                    const unsigned int index_2,
+                                    const unsigned int index_3,
+                                    const Scalar stiffness,
+                                    const Matrix3& inv_rest_matrix,
+                                    const Scalar rest_volume);
+
+        Scalar calculateValue(const ParticleSet& particles) const;
+        void calculateGrad(const ParticleSet& particles, Scalar* grad_C) const;
+        Scalar calculateValueAndGrad(const ParticleSet& particles, Scalar* grad_C) const;
+        static constexpr ConstraintType getType() { return ConstraintType::Bilateral; }
+
+        /// \brief Inverse of D_m.
+        const Matrix3& getInverseRestMatrix() const { return m_inv_rest_matrix; }
+        Scalar getRestVolume() const { return m_rest_volume; }
 
     private:
 
-        const Eigen::Matrix<double, 3, 1> m_inv_M;
-        const Eigen::Vector3d m_point;
+        Matrix3 calculateDeformationGradient(const ParticleSet& particles) const;
+
+        Matrix3 m_inv_rest_matrix;
+        Scalar m_rest_volume;
     };
 
-    class IsometricBendingConstraint final : public Constraint
+    /// \brief Constraint that conserves the area of a triangle (index_0,
+    /// index_1, index_2), i.e., C = A - A_0.
+    class TriangleAreaConstraint final : public FixedNumConstraint<TriangleAreaConstraint, 3>
     {
     public:
 
-        IsometricBendingConstraint(const std::shared_ptr<Particle> p_0,
-                                   const std::shared_ptr<Particle> p_1,
-                                   const std::shared_ptr<Particle> p_2,
-                                   const std::shared_ptr<Particle> p_3,
-                                   const double stiffness);
+        TriangleAreaConstraint(const ParticleSet& particles,
+                               const unsigned int index_0,
+                               const unsigned int index_1,
+                               const unsigned int index_2,
+                               const Scalar stiffness,
+                               const Scalar rest_area);
+
+        Scalar calculateValue(const ParticleSet& particles) const;
+        void calculateGrad(const ParticleSet& particles, Scalar* grad_C) const;
+        Scalar calculateValueAndGrad(const ParticleSet& particles, Scalar* grad_C) const;
+        static constexpr ConstraintType getType() { return ConstraintType::Bilateral; }
+
+        Scalar getRestArea() const { return m_rest_area; }
+
+    private:
+
+        Scalar m_rest_area;
+    };
+
+    /// \brief Strain-based stretch constraint of a triangle (index_0, index_1,
+    /// index_2), which replaces the distance constraints of its three edges.
+    /// \details This is the two-dimensional counterpart of
+    /// TetrahedronStrainConstraint: D_m is the 2x2 matrix of the rest edges in
+    /// an orthonormal frame of the rest triangle, F = D_s D_m^{-1} is 3x2, and
+    /// C = sqrt(A_0) |E|_F with the rest area A_0. Unlike the distance
+    /// constraints, this also resists the shearing of the triangle, and the
+    /// three particles are projected at once.
+    class TriangleStrainConstraint final : public FixedNumConstraint<TriangleStrainConstraint, 3>
+    {
+    public:
+
+        TriangleStrainConstraint(const ParticleSet& particles,
+                                 const unsigned int index_0,
+                                 const unsigned int index_1,
+                                 const unsigned int index_2,
+                                 const Scalar stiffness);
+
+        /// \brief Construct the constraint with the precomputed inverse rest
+        /// matrix and rest area (e.g., restored from a cache) instead of
+        /// computing them from the current positions.
+        TriangleStrainConstraint(const ParticleSet& particles,
+                                 const unsigned int index_0,
+                                 const unsigned int index_1,
+                                 const unsigned int index_2,
+                                 const Scalar stiffness,
+                                 const Matrix2& inv_rest_matrix,
+                                 const Scalar rest_area);
+
+        Scalar calculateValue(const ParticleSet& particles) const;
+        void calculateGrad(const ParticleSet& particles, Scalar* grad_C) const;
+        Scalar calculateValueAndGrad(const ParticleSet& particles, Scalar* grad_C) const;
+        static constexpr ConstraintType getType() { return ConstraintType::Bilateral; }
+
+        /// \brief Inverse of D_m.
+        const Matrix2& getInverseRestMatrix() const { return m_inv_rest_matrix; }
+        Scalar getRestArea() const { return m_rest_area; }
+
+    private:
+
+        Eigen::Matrix<Scalar, 3, 2> calculateDeformationGradient(const ParticleSet& particles) const;
+
+        Matrix2 m_inv_rest_matrix;
+        Scalar m_rest_area;
+    };
+
+    /// \brief Constraint that conserves the signed volume of a tetrahedron
+    /// (index_0, index_1, index_2, index_3), i.e., C = V - V_0 with
+    /// V = (x_1 - x_0) . ((x_2 - x_0) x (x_3 - x_0)) / 6.
+    /// \details Being signed, this also keeps the tetrahedron from being
+    /// inverted.
+    class VolumeConstraint final : public FixedNumConstraint<VolumeConstraint, 4>
+    {
+    public:
+
+        VolumeConstraint(const ParticleSet& particles,
+                         const unsigned int index_0,
+                         const unsigned int index_1,
+                         const unsigned int index_2,
+                         const unsigned int index_3,
+                         const Scalar stiffness,
+                         const Scalar rest_volume);
+
+        Scalar calculateValue(const ParticleSet& particles) const;
+        void calculateGrad(const ParticleSet& particles, Scalar* grad_C) const;
+        Scalar calculateValueAndGrad(const ParticleSet& particles, Scalar* grad_C) const;
+        static constexpr ConstraintType getType() { return ConstraintType::Bilateral; }
 
-        double calculateValue() override;
-        void calculateGrad(double* grad_C) override;
-        void projectParticles() override;
-        ConstraintType getType() override { return ConstraintType::Bilateral; }
+        Scalar getRestVolume() const { return m_rest_volume; }
 
     private:
 
-        const Eigen::Matrix<double, 12, 1> m_inv_M;
-        Eigen::Matrix4d m_Q;
+        Scalar m_rest_volume;
     };
 }
 
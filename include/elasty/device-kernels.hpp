@@ -0,0 +1,705 @@
+#ifndef device_kernels_hpp
+#define device_kernels_hpp
+
+#include <cmath>
+#include <elasty/scalar.hpp>
+
+// The functions below are compiled both for the host and, by nvcc, for the
+// device, so that all the device backends share the same arithmetic
+#if defined(__CUDACC__)
+#define ELASTY_DEVICE_FUNCTION __host__ __device__ inline
+#else
+#define ELASTY_DEVICE_FUNCTION inline
+#endif
+
+namespace elasty
+{
+    class DistanceConstraint;
+    class BendingConstraint;
+    class IsometricBendingConstraint;
+    class FixedPointConstraint;
+    class EnvironmentalCollisionConstraint;
+    class ParticleCollisionConstraint;
+    class PointTriangleCollisionConstraint;
+    class LongRangeAttachmentConstraint;
+    class TriangleStrainConstraint;
+    class TriangleAreaConstraint;
+    class TetrahedronStrainConstraint;
+    class VolumeConstraint;
+
+    /// \brief Plain data and kernels of the device backends (see
+    /// DeviceSolver), which do not depend on Eigen.
+    namespace device
+    {
+        struct Vec3
+        {
+            Scalar x;
+            Scalar y;
+            Scalar z;
+        };
+
+        ELASTY_DEVICE_FUNCTION Vec3 operator+(const Vec3& a, const Vec3& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+        ELASTY_DEVICE_FUNCTION Vec3 operator-(const Vec3& a, const Vec3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+        ELASTY_DEVICE_FUNCTION Vec3 operator-(const Vec3& a) { return { - a.x, - a.y, - a.z }; }
+        ELASTY_DEVICE_FUNCTION Vec3 operator*(const Scalar s, const Vec3& a) { return { s * a.x, s * a.y, s * a.z }; }
+        ELASTY_DEVICE_FUNCTION Vec3& operator+=(Vec3& a, const Vec3& b) { a.x += b.x; a.y += b.y; a.z += b.z; return a; }
+
+        ELASTY_DEVICE_FUNCTION Scalar dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+        ELASTY_DEVICE_FUNCTION Vec3 cross(const Vec3& a, const Vec3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+        ELASTY_DEVICE_FUNCTION Scalar norm(const Vec3& a) { return std::sqrt(dot(a, a)); }
+
+        ELASTY_DEVICE_FUNCTION Scalar clamp(const Scalar value, const Scalar lower, const Scalar upper)
+        {
+            return value < lower ? lower : (value > upper ? upper : value);
+        }
+
+        // ---------------------------------------------------------------------
+        // Constraints
+        // ---------------------------------------------------------------------
+
+        /// \brief Fixed-layout copy of a constraint, which evaluates its value
+        /// and gradient from the gathered positions of its particles.
+        /// \details Each specialization provides num_particles, indices,
+        /// stiffness, compliance, and
+        /// bool evaluate(const Vec3* x, Scalar& C, Vec3* grad_C) const, which
+        /// returns false when the constraint does not move the particles
+        /// (i.e., when it is an inactive unilateral constraint or degenerate),
+        /// in the same manner as FixedNumConstraint.
+        template <typename Type>
+        struct Record;
+
+        template <>
+        struct Record<DistanceConstraint>
+        {
+            static constexpr unsigned int num_particles = 2;
+
+            unsigned int indices[2];
+            Scalar stiffness;
+            Scalar compliance;
+            Scalar rest_length;
+
+            ELASTY_DEVICE_FUNCTION bool evaluate(const Vec3* x, Scalar& C, Vec3* grad_C) const
+            {
+                const Vec3 r = x[0] - x[1];
+                const Scalar length = norm(r);
+
+                // Coincident particles are separated along an arbitrary (but
+                // deterministic) direction
+                const Vec3 n = (length > 0.0) ? (Scalar(1.0) / length) * r : Vec3{ 0.0, 1.0, 0.0 };
+
+                C = length - rest_length;
+                grad_C[0] = n;
+                grad_C[1] = - n;
+                return true;
+            }
+        };
+
+        template <>
+        struct Record<BendingConstraint>
+        {
+            static constexpr unsigned int num_particles = 4;
+
+            unsigned int indices[4];
+            Scalar stiffness;
+            Scalar compliance;
+            Scalar dihedral_angle;
+
+            ELASTY_DEVICE_FUNCTION bool evaluate(const Vec3* x, Scalar& C, Vec3* grad_C) const
+            {
+                const Vec3 p_1 = x[1] - x[0];
+                const Vec3 p_2 = x[2] - x[0];
+                const Vec3 p_3 = x[3] - x[0];
+
+                const Vec3 p_1_cross_p_2 = cross(p_1, p_2);
+                const Vec3 p_1_cross_p_3 = cross(p_1, p_3);
+
+                const Scalar p_1_cross_p_2_norm = norm(p_1_cross_p_2);
+                const Scalar p_1_cross_p_3_norm = norm(p_1_cross_p_3);
+
+                if (!(p_1_cross_p_2_norm > 0.0) || !(p_1_cross_p_3_norm > 0.0)) { return false; }
+
+                const Vec3 n_0 = (Scalar(1.0) / p_1_cross_p_2_norm) * p_1_cross_p_2;
+                const Vec3 n_1 = (Scalar(1.0) / p_1_cross_p_3_norm) * p_1_cross_p_3;
+
+                const Scalar d = clamp(dot(n_0, n_1), - 1.0, + 1.0);
+                C = std::acos(d) - dihedral_angle;
+
+                // Coplanar triangles, where the derivative of acos diverges
+                constexpr Scalar epsilon = 1e-12;
+                if (Scalar(1.0) - std::abs(d) < epsilon) { return false; }
+
+                const Scalar common_coeff = - Scalar(1.0) / std::sqrt(Scalar(1.0) - d * d);
+
+                const Vec3 q_0 = (Scalar(1.0) / p_1_cross_p_2_norm) * (n_1 - d * n_0);
+                const Vec3 q_1 = (Scalar(1.0) / p_1_cross_p_3_norm) * (n_0 - d * n_1);
+
+                grad_C[1] = common_coeff * (cross(p_2, q_0) + cross(p_3, q_1));
+                grad_C[2] = common_coeff * cross(q_0, p_1);
+                grad_C[3] = common_coeff * cross(q_1, p_1);
+                grad_C[0] = - (grad_C[1] + grad_C[2] + grad_C[3]);
+                return true;
+            }
+        };
+
+        template <>
+        struct Record<IsometricBendingConstraint>
+        {
+            static constexpr unsigned int num_particles = 4;
+
+            unsigned int indices[4];
+            Scalar stiffness;
+            Scalar compliance;
+            Scalar K[4];
+            Scalar scale;
+
+            ELASTY_DEVICE_FUNCTION bool evaluate(const Vec3* x, Scalar& C, Vec3* grad_C) const
+            {
+                const Vec3 v = K[1] * (x[1] - x[0]) + K[2] * (x[2] - x[0]) + K[3] * (x[3] - x[0]);
+                const Vec3 s_v = scale * v;
+
+                C = 0.5 * dot(s_v, v);
+                for (unsigned int i = 0; i < 4; ++ i) { grad_C[i] = K[i] * s_v; }
+                return true;
+            }
+        };
+
+        template <>
+        struct Record<FixedPointConstraint>
+        {
+            static constexpr unsigned int num_particles = 1;
+
+            unsigned int indices[1];
+            Scalar stiffness;
+            Scalar compliance;
+            Vec3 point;
+
+            ELASTY_DEVICE_FUNCTION bool evaluate(const Vec3* x, Scalar& C, Vec3* grad_C) const
+            {
+                const Vec3 r = x[0] - point;
+                C = norm(r);
+
+                if (!(C > 0.0)) { return false; }
+
+                grad_C[0] = (Scalar(1.0) / C) * r;
+                return true;
+            }
+        };
+
+        template <>
+        struct Record<EnvironmentalCollisionConstraint>
+        {
+            static constexpr unsigned int num_particles = 1;
+
+            unsigned int indices[1];
+            Scalar stiffness;
+            Scalar compliance;
+            Vec3 n;
+            Scalar d;
+
+            ELASTY_DEVICE_FUNCTION bool evaluate(const Vec3* x, Scalar& C, Vec3* grad_C) const
+            {
+                C = dot(n, x[0]) - d;
+
+                if (C >= 0.0) { return false; }
+
+                grad_C[0] = n;
+                return true;
+            }
+        };
+
+        template <>
+        struct Record<ParticleCollisionConstraint>
+        {
+            static constexpr unsigned int num_particles = 2;
+
+            unsigned int indices[2];
+            Scalar stiffness;
+            Scalar compliance;
+            Scalar distance;
+
+            ELASTY_DEVICE_FUNCTION bool evaluate(const Vec3* x, Scalar& C, Vec3* grad_C) const
+            {
+                const Vec3 r = x[0] - x[1];
+                const Scalar length = norm(r);
+
+                C = length - distance;
+
+                if (C >= 0.0) { return false; }
+
+                const Vec3 n = (length > 0.0) ? (Scalar(1.0) / length) * r : Vec3{ 0.0, 1.0, 0.0 };
+                grad_C[0] = n;
+                grad_C[1] = - n;
+                return true;
+            }
+        };
+
+        template <>
+        struct Record<PointTriangleCollisionConstraint>
+        {
+            static constexpr unsigned int num_particles = 4;
+
+            unsigned int indices[4];
+            Scalar stiffness;
+            Scalar compliance;
+            Scalar thickness;
+            Scalar barycentric_coords[3];
+            Scalar side;
+
+            ELASTY_DEVICE_FUNCTION bool evaluate(const Vec3* x, Scalar& C, Vec3* grad_C) const
+            {
+                const Vec3 normal = cross(x[2] - x[1], x[3] - x[1]);
+                const Scalar normal_norm = norm(normal);
+
+                // A degenerate triangle does not push the particle
+                if (!(normal_norm > 0.0)) { return false; }
+
+                const Vec3 n = (side / normal_norm) * normal;
+                const Vec3 contact_point = barycentric_coords[0] * x[1] + barycentric_coords[1] * x[2] + barycentric_coords[2] * x[3];
+
+                C = dot(n, x[0] - contact_point) - thickness;
+
+                if (C >= 0.0) { return false; }
+
+                grad_C[0] = n;
+                for (unsigned int i = 0; i < 3; ++ i) { grad_C[i + 1] = (- barycentric_coords[i]) * n; }
+                return true;
+            }
+        };
+
+        template <>
+        struct Record<LongRangeAttachmentConstraint>
+        {
+            static constexpr unsigned int num_particles = 1;
+
+            unsigned int indices[1];
+            Scalar stiffness;
+            Scalar compliance;
+            Vec3 attachment_point;
+            Scalar distance;
+
+            ELASTY_DEVICE_FUNCTION bool evaluate(const Vec3* x, Scalar& C, Vec3* grad_C) const
+            {
+                const Vec3 r = x[0] - attachment_point;
+                const Scalar length = norm(r);
+
+                C = distance - length;
+
+                if (C >= 0.0 || !(length > 0.0)) { return false; }
+
+                grad_C[0] = (- Scalar(1.0) / length) * r;
+                return true;
+            }
+        };
+
+        /// \brief Evaluate the strain constraint C = scale |E|_F of a simplex of
+        /// Dim + 1 particles with the inverse rest matrix (in the row-major
+        /// order), as TriangleStrainConstraint and TetrahedronStrainConstraint.
+        template <unsigned int Dim>
+        ELASTY_DEVICE_FUNCTION bool evaluateStrain(const Vec3* x, const Scalar* inv_rest_matrix, const Scalar scale, Scalar& C, Vec3* grad_C)
+        {
+            // The columns of F = D_s D_m^{-1}
+            Vec3 F[Dim];
+            for (unsigned int j = 0; j < Dim; ++ j)
+            {
+                F[j] = Vec3{ 0.0, 0.0, 0.0 };
+                for (unsigned int k = 0; k < Dim; ++ k) { F[j] += inv_rest_matrix[Dim * k + j] * (x[k + 1] - x[0]); }
+            }
+
+            Scalar E[Dim][Dim];
+            Scalar squared_norm = 0.0;
+            for (unsigned int i = 0; i < Dim; ++ i)
+            {
+                for (unsigned int j = 0; j < Dim; ++ j)
+                {
+                    E[i][j] = 0.5 * (dot(F[i], F[j]) - (i == j ? Scalar(1.0) : Scalar(0.0)));
+                    squared_norm += E[i][j] * E[i][j];
+                }
+            }
+
+            const Scalar E_norm = std::sqrt(squared_norm);
+
+            C = scale * E_norm;
+
+            if (!(E_norm > 0.0)) { return false; }
+
+            // The columns of dC/dF = scale F E / |E|_F
+            Vec3 P[Dim];
+            for (unsigned int j = 0; j < Dim; ++ j)
+            {
+                P[j] = Vec3{ 0.0, 0.0, 0.0 };
+                for (unsigned int k = 0; k < Dim; ++ k) { P[j] += ((scale / E_norm) * E[k][j]) * F[k]; }
+            }
+
+            // The columns of dC/dF D_m^{-T}, and the negative sum of them
+            grad_C[0] = Vec3{ 0.0, 0.0, 0.0 };
+            for (unsigned int i = 0; i < Dim; ++ i)
+            {
+                grad_C[i + 1] = Vec3{ 0.0, 0.0, 0.0 };
+                for (unsigned int k = 0; k < Dim; ++ k) { grad_C[i + 1] += inv_rest_matrix[Dim * i + k] * P[k]; }
+                grad_C[0] += - grad_C[i + 1];
+            }
+            return true;
+        }
+
+        template <>
+        struct Record<TriangleStrainConstraint>
+        {
+            static constexpr unsigned int num_particles = 3;
+
+            unsigned int indices[3];
+            Scalar stiffness;
+            Scalar compliance;
+
+            /// \brief Inverse of the rest matrix, in the row-major order.
+            Scalar inv_rest_matrix[4];
+            Scalar scale;
+
+            ELASTY_DEVICE_FUNCTION bool evaluate(const Vec3* x, Scalar& C, Vec3* grad_C) const
+            {
+                return evaluateStrain<2>(x, inv_rest_matrix, scale, C, grad_C);
+            }
+        };
+
+        template <>
+        struct Record<TriangleAreaConstraint>
+        {
+            static constexpr unsigned int num_particles = 3;
+
+            unsigned int indices[3];
+            Scalar stiffness;
+            Scalar compliance;
+            Scalar rest_area;
+
+            ELASTY_DEVICE_FUNCTION bool evaluate(const Vec3* x, Scalar& C, Vec3* grad_C) const
+            {
+                const Vec3 e_1 = x[1] - x[0];
+                const Vec3 e_2 = x[2] - x[0];
+
+                const Vec3 normal = cross(e_1, e_2);
+                const Scalar normal_norm = norm(normal);
+
+                C = 0.5 * normal_norm - rest_area;
+
+                if (!(normal_norm > 0.0)) { return false; }
+
+                const Vec3 n = (Scalar(1.0) / normal_norm) * normal;
+                grad_C[1] = Scalar(0.5) * cross(e_2, n);
+                grad_C[2] = Scalar(0.5) * cross(n, e_1);
+                grad_C[0] = - (grad_C[1] + grad_C[2]);
+                return true;
+            }
+        };
+
+        template <>
+        struct Record<TetrahedronStrainConstraint>
+        {
+            static constexpr unsigned int num_particles = 4;
+
+            unsigned int indices[4];
+            Scalar stiffness;
+            Scalar compliance;
+
+            /// \brief Inverse of the rest matrix, in the row-major order.
+            Scalar inv_rest_matrix[9];
+            Scalar scale;
+
+            ELASTY_DEVICE_FUNCTION bool evaluate(const Vec3* x, Scalar& C, Vec3* grad_C) const
+            {
+                return evaluateStrain<3>(x, inv_rest_matrix, scale, C, grad_C);
+            }
+        };
+
+        template <>
+        struct Record<VolumeConstraint>
+        {
+            static constexpr unsigned int num_particles = 4;
+
+            unsigned int indices[4];
+            Scalar stiffness;
+            Scalar compliance;
+            Scalar rest_volume;
+
+            ELASTY_DEVICE_FUNCTION bool evaluate(const Vec3* x, Scalar& C, Vec3* grad_C) const
+            {
+                const Vec3 e_1 = x[1] - x[0];
+                const Vec3 e_2 = x[2] - x[0];
+                const Vec3 e_3 = x[3] - x[0];
+
+                grad_C[1] = (Scalar(1.0) / Scalar(6.0)) * cross(e_2, e_3);
+                grad_C[2] = (Scalar(1.0) / Scalar(6.0)) * cross(e_3, e_1);
+                grad_C[3] = (Scalar(1.0) / Scalar(6.0)) * cross(e_1, e_2);
+                grad_C[0] = - (grad_C[1] + grad_C[2] + grad_C[3]);
+
+                C = dot(grad_C[1], e_1) - rest_volume;
+                return true;
+            }
+        };
+
+        /// \brief Calculate the PBD (or XPBD) corrections of the particles of
+        /// a constraint from the predicted positions, and accumulate its
+        /// Lagrange multiplier in the XPBD case.
+        /// \return false when the constraint does not move the particles
+        template <typename Type>
+        ELASTY_DEVICE_FUNCTION bool calculateCorrection(const Record<Type>& record,
+                                                        const Vec3* p,
+                                                        const Scalar* w,
+                                                        const bool is_xpbd,
+                                                        const Scalar dt,
+                                                        Scalar& lambda,
+                                                        Vec3* delta_x)
+        {
+            constexpr unsigned int num_particles = Record<Type>::num_particles;
+
+            Vec3 x[num_particles];
+            Scalar inv_m[num_particles];
+            for (unsigned int j = 0; j < num_particles; ++ j)
+            {
+                x[j] = p[record.indices[j]];
+                inv_m[j] = w[record.indices[j]];
+            }
+
+            Scalar C;
+            Vec3 grad_C[num_particles];
+            if (!record.evaluate(x, C, grad_C)) { return false; }
+
+            Scalar denominator = 0.0;
+            for (unsigned int j = 0; j < num_particles; ++ j) { denominator += inv_m[j] * dot(grad_C[j], grad_C[j]); }
+
+            // Also skips the constraints whose particles cannot move
+            if (!(denominator > 0.0)) { return false; }
+
+            Scalar scale;
+            if (is_xpbd)
+            {
+                const Scalar alpha_tilde = record.compliance / (dt * dt);
+                const Scalar delta_lambda = (- C - alpha_tilde * lambda) / (denominator + alpha_tilde);
+
+                lambda += delta_lambda;
+                scale = delta_lambda;
+            }
+            else
+            {
+                scale = - record.stiffness * C / denominator;
+            }
+
+            for (unsigned int j = 0; j < num_particles; ++ j) { delta_x[j] = (scale * inv_m[j]) * grad_C[j]; }
+
+            return true;
+        }
+
+        /// \brief Project a constraint and apply the corrections to the
+        /// predicted positions, which is safe to run concurrently for the
+        /// constraints of the same color.
+        template <typename Type>
+        ELASTY_DEVICE_FUNCTION void projectConstraint(const Record<Type>& record,
+                                                      Vec3* p,
+                                                      const Scalar* w,
+                                                      const bool is_xpbd,
+                                                      const Scalar dt,
+                                                      Scalar& lambda)
+        {
+            Vec3 delta_x[Record<Type>::num_particles];
+            if (!calculateCorrection(record, p, w, is_xpbd, dt, lambda, delta_x)) { return; }
+
+            for (unsigned int j = 0; j < Record<Type>::num_particles; ++ j) { p[record.indices[j]] += delta_x[j]; }
+        }
+
+        // ---------------------------------------------------------------------
+        // Colliders
+        // ---------------------------------------------------------------------
+
+        struct SphereRecord
+        {
+            Vec3 center;
+            Scalar radius;
+        };
+
+        struct CapsuleRecord
+        {
+            Vec3 end_0;
+            Vec3 end_1;
+            Scalar radius;
+        };
+
+        struct BoxRecord
+        {
+            /// \brief Rotation of the rigid transform, in the row-major order.
+            Scalar rotation[9];
+            Vec3 translation;
+            Vec3 half_extents;
+        };
+
+        ELASTY_DEVICE_FUNCTION Scalar calculateSignedDistance(const SphereRecord& sphere, const Vec3& point, Vec3& normal)
+        {
+            const Vec3 r = point - sphere.center;
+            const Scalar length = norm(r);
+
+            normal = (length > 0.0) ? (Scalar(1.0) / length) * r : Vec3{ 0.0, 1.0, 0.0 };
+
+            return length - sphere.radius;
+        }
+
+        ELASTY_DEVICE_FUNCTION Scalar calculateSignedDistance(const CapsuleRecord& capsule, const Vec3& point, Vec3& normal)
+        {
+            const Vec3 axis = capsule.end_1 - capsule.end_0;
+            const Scalar squared_length = dot(axis, axis);
+            const Scalar t = (squared_length > 0.0) ? clamp(dot(axis, point - capsule.end_0) / squared_length, 0.0, 1.0) : Scalar(0.0);
+
+            const Vec3 r = point - (capsule.end_0 + t * axis);
+            const Scalar length = norm(r);
+
+            normal = (length > 0.0) ? (Scalar(1.0) / length) * r : Vec3{ 0.0, 1.0, 0.0 };
+
+            return length - capsule.radius;
+        }
+
+        ELASTY_DEVICE_FUNCTION Scalar calculateSignedDistance(const BoxRecord& box, const Vec3& point, Vec3& normal)
+        {
+            const Scalar* R = box.rotation;
+
+            // The inverse of the rigid transform
+            const Vec3 r = point - box.translation;
+            const Scalar local_point[3] = { R[0] * r.x + R[3] * r.y + R[6] * r.z,
+                                            R[1] * r.x + R[4] * r.y + R[7] * r.z,
+                                            R[2] * r.x + R[5] * r.y + R[8] * r.z };
+            const Scalar half_extents[3] = { box.half_extents.x, box.half_extents.y, box.half_extents.z };
+
+            Scalar q[3];
+            bool is_outside = false;
+            for (int k = 0; k < 3; ++ k)
+            {
+                q[k] = std::abs(local_point[k]) - half_extents[k];
+                is_outside = is_outside || q[k] > 0.0;
+            }
+
+            Scalar local_normal[3] = { 0.0, 0.0, 0.0 };
+            Scalar signed_distance;
+
+            if (is_outside)
+            {
+                // Outside: the distance to the nearest point on the surface
+                Scalar outside[3];
+                for (int k = 0; k < 3; ++ k) { outside[k] = (q[k] > 0.0) ? q[k] : Scalar(0.0); }
+
+                signed_distance = std::sqrt(outside[0] * outside[0] + outside[1] * outside[1] + outside[2] * outside[2]);
+                for (int k = 0; k < 3; ++ k)
+                {
+                    const Scalar sign = (local_point[k] > 0.0) ? Scalar(1.0) : ((local_point[k] < 0.0) ? Scalar(- 1.0) : Scalar(0.0));
+                    local_normal[k] = outside[k] * sign / signed_distance;
+                }
+            }
+            else
+            {
+                // Inside: the distance to the nearest face
+                int axis = 0;
+                for (int k = 1; k < 3; ++ k) { if (q[k] > q[axis]) { axis = k; } }
+
+                signed_distance = q[axis];
+                local_normal[axis] = (local_point[axis] < 0.0) ? - 1.0 : 1.0;
+            }
+
+            normal = { R[0] * local_normal[0] + R[1] * local_normal[1] + R[2] * local_normal[2],
+                       R[3] * local_normal[0] + R[4] * local_normal[1] + R[5] * local_normal[2],
+                       R[6] * local_normal[0] + R[7] * local_normal[1] + R[8] * local_normal[2] };
+
+            return signed_distance;
+        }
+
+        /// \brief Contact of a particle against the tangent plane of a
+        /// collider, i.e., the EnvironmentalCollisionConstraint generated by
+        /// ColliderSet.
+        struct Contact
+        {
+            Vec3 n;
+            Scalar d;
+        };
+
+        /// \brief Maximum number of the contacts of a particle in a (sub)step;
+        /// the contacts with the colliders beyond this are dropped.
+        constexpr unsigned int max_num_contacts = 4;
+
+        struct ColliderView
+        {
+            const SphereRecord* spheres;
+            unsigned int num_spheres;
+            const CapsuleRecord* capsules;
+            unsigned int num_capsules;
+            const BoxRecord* boxes;
+            unsigned int num_boxes;
+
+            Scalar thickness;
+            Scalar stiffness;
+        };
+
+        template <typename Collider>
+        ELASTY_DEVICE_FUNCTION void addContact(const Collider& collider,
+                                               const Vec3& p,
+                                               const Scalar thickness,
+                                               Contact* contacts,
+                                               unsigned int& num_contacts)
+        {
+            Vec3 n;
+            const Scalar signed_distance = calculateSignedDistance(collider, p, n);
+
+            if (signed_distance >= thickness || num_contacts == max_num_contacts) { return; }
+
+            contacts[num_contacts ++] = { n, dot(n, p) - signed_distance + thickness };
+        }
+
+        /// \brief Generate the contacts of a particle at its predicted
+        /// position, in the order of ColliderSet::generateConstraints.
+        /// \return the number of the contacts written to contacts
+        ELASTY_DEVICE_FUNCTION unsigned int generateContacts(const ColliderView& colliders, const Vec3& p, const Scalar w, Contact* contacts)
+        {
+            unsigned int num_contacts = 0;
+
+            if (w == 0.0) { return num_contacts; }
+
+            for (unsigned int k = 0; k < colliders.num_spheres; ++ k) { addContact(colliders.spheres[k], p, colliders.thickness, contacts, num_contacts); }
+            for (unsigned int k = 0; k < colliders.num_capsules; ++ k) { addContact(colliders.capsules[k], p, colliders.thickness, contacts, num_contacts); }
+            for (unsigned int k = 0; k < colliders.num_boxes; ++ k) { addContact(colliders.boxes[k], p, colliders.thickness, contacts, num_contacts); }
+
+            return num_contacts;
+        }
+
+        /// \brief Project the contacts of a particle one after another, as
+        /// the instant constraints of Engine are.
+        ELASTY_DEVICE_FUNCTION void projectContacts(const ColliderView& colliders,
+                                                    Vec3& p,
+                                                    const bool is_xpbd,
+                                                    const Contact* contacts,
+                                                    const unsigned int num_contacts)
+        {
+            for (unsigned int k = 0; k < num_contacts; ++ k)
+            {
+                const Contact& contact = contacts[k];
+                const Scalar C = dot(contact.n, p) - contact.d;
+
+                if (C >= 0.0) { continue; }
+
+                // Contacts have no compliance, so that XPBD fully resolves them
+                const Scalar scale = is_xpbd ? - C : - colliders.stiffness * C;
+
+                p += scale * contact.n;
+            }
+        }
+
+        // ---------------------------------------------------------------------
+        // Integration
+        // ---------------------------------------------------------------------
+
+        ELASTY_DEVICE_FUNCTION void integrate(const Vec3& x, Vec3& v, const Vec3& f, const Scalar w, const Scalar dt, Vec3& p)
+        {
+            v += (dt * w) * f;
+            p = x + dt * v;
+        }
+
+        ELASTY_DEVICE_FUNCTION void updateVelocity(Vec3& x, Vec3& v, const Vec3& p, const Scalar dt, const Scalar velocity_damping)
+        {
+            v = ((Scalar(1.0) - velocity_damping) / dt) * (p - x);
+            x = p;
+        }
+    }
+}
+
+#endif /* device_kernels_hpp */
@@ -0,0 +1,146 @@
+#ifndef device_solver_hpp
+#define device_solver_hpp
+
+#include <cstddef>
+#include <memory>
+#include <tuple>
+#include <vector>
+#include <elasty/colliders.hpp>
+#include <elasty/constraint-set.hpp>
+#include <elasty/device-kernels.hpp>
+#include <elasty/graph-coloring.hpp>
+#include <elasty/particle-set.hpp>
+
+namespace elasty
+{
+    enum class Backend
+    {
+        /// \brief The solver of Engine itself on the host.
+        Cpu,
+
+        /// \brief The device solver run on the calling thread of the host,
+        /// with the same kernels and data layout as the other device
+        /// backends (e.g., for testing them, or where no GPU is available).
+        Reference,
+
+        /// \brief The device solver run by CUDA, which is available only when
+        /// the library is built with ELASTY_CUDA.
+        Cuda,
+    };
+
+    /// \brief Whether the backend is built into the library.
+    bool isBackendAvailable(const Backend backend);
+
+    /// \brief Parameters of DeviceSolver::step, which are taken from Engine.
+    struct DeviceStepSettings
+    {
+        Scalar dt;
+        unsigned int num_substeps;
+        unsigned int num_iterations;
+
+        bool is_xpbd;
+        bool is_jacobi;
+        Scalar jacobi_relaxation;
+
+        /// \brief Fraction of the velocities removed at the end of each
+        /// (sub)step.
+        Scalar velocity_damping;
+    };
+
+    /// \brief Host copy of a scene in the layout of the device backends.
+    /// \details The constraints are converted to fixed-layout records (see
+    /// device::Record) in the order of ConstraintSet, and the colliders of
+    /// the analytic types to their records, so that a backend only has to
+    /// copy the arrays to its memory.
+    struct DeviceScene
+    {
+        template <typename... Types>
+        using RecordArrays = std::tuple<std::vector<device::Record<Types>>...>;
+
+        using ConstraintRecords = RecordArrays<DistanceConstraint,
+                                               BendingConstraint,
+                                               IsometricBendingConstraint,
+                                               FixedPointConstraint,
+                                               EnvironmentalCollisionConstraint,
+                                               ParticleCollisionConstraint,
+                                               PointTriangleCollisionConstraint,
+                                               LongRangeAttachmentConstraint,
+                                               TriangleStrainConstraint,
+                                               TriangleAreaConstraint,
+                                               TetrahedronStrainConstraint,
+                                               VolumeConstraint>;
+
+        static_assert(std::tuple_size<ConstraintRecords>::value == ConstraintSet::num_types, "Device records should cover all the constraint types");
+
+        /// \param coloring the coloring of the constraints, which should be
+        /// up to date (i.e., the constraints are sorted by the colors), or
+        /// nullptr for regarding each array as a single color (e.g., for the
+        /// Jacobi scheme)
+        /// \details This throws std::runtime_error if the colliders include
+        /// a signed distance field, which the device backends do not support.
+        void build(const ParticleSet& particles,
+                   const ConstraintSet& constraints,
+                   const ConstraintColoring* coloring,
+                   const ColliderSet& colliders);
+
+        std::size_t getNumParticles() const { return x.size(); }
+
+        std::vector<device::Vec3> x;
+        std::vector<device::Vec3> v;
+        std::vector<Scalar> w;
+
+        ConstraintRecords records;
+
+        /// \brief Color offsets of each array of the records (in the order
+        /// of ConstraintSet).
+        std::vector<std::vector<std::size_t>> color_offsets;
+
+        std::vector<device::SphereRecord> spheres;
+        std::vector<device::CapsuleRecord> capsules;
+        std::vector<device::BoxRecord> boxes;
+        Scalar collider_thickness = 0.0;
+        Scalar collider_stiffness = 1.0;
+    };
+
+    /// \brief Solver that keeps the particles and the constraints resident
+    /// in the memory of a compute device, and runs the (sub)steps of Engine
+    /// there.
+    /// \details Each (sub)step integrates the external forces, generates the
+    /// contacts with the colliders at the predicted positions, projects the
+    /// constraints in the Gauss-Seidel manner over the colors (one kernel
+    /// launch per color) or in the Jacobi manner, projects the contacts
+    /// after each iteration, and updates the velocities. The particles are
+    /// copied back to the host only by download.
+    class DeviceSolver
+    {
+    public:
+
+        virtual ~DeviceSolver() = default;
+
+        /// \brief Copy the scene to the device, replacing the previous one.
+        virtual void upload(const DeviceScene& scene) = 0;
+
+        /// \brief Copy the external forces of the particles (which stay
+        /// constant over the substeps of a step) to the device.
+        virtual void uploadForces(const std::vector<Vector3>& f) = 0;
+
+        virtual void step(const DeviceStepSettings& settings) = 0;
+
+        /// \brief Copy the positions and the velocities back to the
+        /// particles, which should be of the layout of the uploaded scene;
+        /// the predicted positions are set to the positions.
+        virtual void download(ParticleSet& particles) = 0;
+    };
+
+    /// \brief Create the device solver of the backend.
+    /// \details This throws std::runtime_error if the backend is not
+    /// available or is not a device backend (i.e., Backend::Cpu).
+    std::unique_ptr<DeviceSolver> createDeviceSolver(const Backend backend);
+
+#if defined(ELASTY_CUDA)
+    /// \brief Defined in src/cuda-solver.cu.
+    std::unique_ptr<DeviceSolver> createCudaSolver();
+#endif
+}
+
+#endif /* device_solver_hpp */
@@ -0,0 +1,74 @@
+#ifndef distance_constraint_batch_hpp
+#define distance_constraint_batch_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <elasty/constraint.hpp>
+
+namespace elasty
+{
+    /// \brief Distance constraints stored in a structure-of-arrays layout for
+    /// the vectorized projection kernel.
+    /// \details The i-th entry corresponds to the i-th constraint of the array
+    /// that the batch was built from. The particle indices are stored as
+    /// offsets into the flat array of the predicted positions (i.e., three
+    /// times the particle index), so that they can be used directly for
+    /// gathering and scattering.
+    class DistanceConstraintBatch
+    {
+    public:
+
+        void build(const std::vector<DistanceConstraint>& constraints);
+
+        /// \brief Copy the stiffness and compliance values from the
+        /// constraints, and reset the Lagrange multipliers.
+        void updateParameters(const std::vector<DistanceConstraint>& constraints);
+
+        /// \brief Copy the Lagrange multipliers back to the constraints.
+        void writeLagrangeMultipliers(std::vector<DistanceConstraint>& constraints) const;
+
+        std::size_t size() const { return m_rest_lengths.size(); }
+
+        void clear();
+
+        std::vector<std::int32_t> m_offsets_0;
+        std::vector<std::int32_t> m_offsets_1;
+        std::vector<Scalar> m_rest_lengths;
+        std::vector<Scalar> m_inv_masses_0;
+        std::vector<Scalar> m_inv_masses_1;
+        std::vector<Scalar> m_stiffnesses;
+        std::vector<Scalar> m_compliances;
+        std::vector<Scalar> m_lambdas;
+
+        /// \brief Values of the constraints (i.e., C) before their last
+        /// projection, written only when requested.
+        std::vector<Scalar> m_values;
+    };
+
+    /// \brief Project the distance constraints in [begin, end) of the batch.
+    /// \param positions the flat array of the predicted positions (i.e.,
+    /// ParticleSet::p viewed as 3 * N values)
+    /// \param is_xpbd whether to use XPBD (with the time step dt) instead of
+    /// PBD
+    /// \param is_recording_values whether to write the values of the
+    /// constraints before the projection to m_values (e.g., for monitoring
+    /// the convergence)
+    /// \details The constraints in the range must not share any particle
+    /// (e.g., they are of the same graph color), because each SIMD lane
+    /// updates its particles independently. The kernel uses AVX-512 or AVX2
+    /// when the CPU supports them and NEON on ARM, and otherwise falls back to
+    /// scalar code; in a single-precision build, the lanes are of float, so
+    /// each instruction processes twice as many constraints. Unlike
+    /// DistanceConstraint::projectParticles, a constraint whose particles
+    /// coincide is skipped rather than projected in a random direction.
+    void projectDistanceConstraintBatch(DistanceConstraintBatch& batch,
+                                        const std::size_t begin,
+                                        const std::size_t end,
+                                        Scalar* positions,
+                                        const bool is_xpbd,
+                                        const Scalar dt,
+                                        const bool is_recording_values = false);
+}
+
+#endif /* distance_constraint_batch_hpp */
@@ -0,0 +1,104 @@
+#ifndef engine_snapshot_hpp
+#define engine_snapshot_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace elasty
+{
+    class Engine;
+
+    /// \brief Binary copy of the dynamic state of an engine, taken by
+    /// Engine::takeSnapshot and applied by Engine::restoreSnapshot.
+    /// \details The state consists of the positions, the velocities, the
+    /// predicted positions, the masses, and the inverse masses of the
+    /// particles, the points of the fixed-point constraints (i.e., the pin
+    /// targets), and the number of the steps. The rest of the scene (e.g.,
+    /// the other constraints and the settings of the solver) is assumed to
+    /// be the same as when the snapshot was taken. In particular, each
+    /// constraint keeps the inverse masses cached when it was constructed,
+    /// so the restored inverse masses are only seen by the integration (and
+    /// by the constraints generated afterwards, e.g., the collisions), not
+    /// by the projections of the existing constraints. The Lagrange multipliers
+    /// of XPBD are not included as they are reset in every (sub)step.
+    ///
+    /// The blob has a versioned header followed by flat sections (at 8-byte
+    /// aligned offsets) of the arrays in the native layout of the build
+    /// (i.e., of elasty::Scalar), so that taking and restoring a snapshot are
+    /// a few bulk copies, and a file written by write can also be
+    /// memory-mapped by other tools. A snapshot cannot be restored by a
+    /// build of the other precision.
+    class EngineSnapshot
+    {
+    public:
+
+        bool empty() const { return m_data.empty(); }
+
+        /// \brief Number of the steps of the engine when the snapshot was
+        /// taken, or zero for an empty snapshot.
+        std::uint64_t getNumSteps() const;
+
+        std::size_t getNumParticles() const;
+
+        /// \brief The blob, which can be stored anywhere (e.g., sent to
+        /// another process) and loaded back by setData.
+        const std::vector<char>& getData() const { return m_data; }
+
+        /// \details This throws std::runtime_error if the data is not a
+        /// snapshot of this build.
+        void setData(std::vector<char> data);
+
+        void write(const std::string& file_path) const;
+
+        /// \details This throws std::runtime_error if the file is missing,
+        /// truncated, or not a snapshot of this build.
+        static EngineSnapshot read(const std::string& file_path);
+
+    private:
+
+        friend class Engine;
+
+        std::vector<char> m_data;
+    };
+
+    /// \brief Ring of the snapshots of the last steps, for scrubbing and
+    /// rolling back an interactive simulation.
+    /// \details A push overwrites the oldest snapshot once the ring is full,
+    /// reusing its memory, so that keeping the checkpoints allocates nothing
+    /// after the ring has been filled (as long as the scene keeps its size).
+    class SnapshotRing
+    {
+    public:
+
+        explicit SnapshotRing(const std::size_t capacity);
+
+        /// \brief Take a snapshot of the engine as the newest one.
+        void push(Engine& engine);
+
+        /// \brief Restore the newest snapshot taken at or before the step, and
+        /// discard the snapshots after it, so that the simulation continues
+        /// from there.
+        /// \return false (leaving the engine untouched) if there is no such
+        /// snapshot
+        bool rollBack(Engine& engine, const std::uint64_t num_steps);
+
+        void clear();
+
+        std::size_t size() const { return m_size; }
+        std::size_t capacity() const { return m_snapshots.size(); }
+
+        /// \brief The i-th snapshot, from the oldest (0) to the newest
+        /// (size() - 1).
+        const EngineSnapshot& getSnapshot(const std::size_t i) const;
+
+    private:
+
+        std::vector<EngineSnapshot> m_snapshots;
+        std::size_t m_front = 0;
+        std::size_t m_size = 0;
+    };
+}
+
+#endif /* engine_snapshot_hpp */
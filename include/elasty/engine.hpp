@@ -1,18 +1,92 @@
 #ifndef engine_hpp
 #define engine_hpp
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <memory>
 #include <vector>
+#include <elasty/colliders.hpp>
+#include <elasty/constraint-set.hpp>
+#include <elasty/device-solver.hpp>
+#include <elasty/distance-constraint-batch.hpp>
+#include <elasty/engine-snapshot.hpp>
+#include <elasty/graph-coloring.hpp>
+#include <elasty/jacobi-projection.hpp>
+#include <elasty/particle-set.hpp>
+#include <elasty/profiler.hpp>
+#include <elasty/projective-dynamics.hpp>
+#include <elasty/sleeping-islands.hpp>
 
 namespace elasty
 {
-    class Constraint;
-    struct Particle;
+    class ClothHierarchy;
+    class ClothVertexBuffer;
+
+    enum class Framework
+    {
+        /// \brief Position-based dynamics [Muller et al. 2007], where each
+        /// constraint is weighted by its stiffness.
+        Pbd,
+
+        /// \brief Extended position-based dynamics [Macklin et al. 2016],
+        /// where each constraint is weighted by its compliance, so that the
+        /// effective stiffness does not depend on the number of iterations
+        /// or the time step.
+        Xpbd,
+
+        /// \brief Projective dynamics [Bouaziz et al. 2014], where each
+        /// constraint is weighted by its stiffness multiplied by
+        /// m_projective_dynamics_weight_scale, and each iteration projects
+        /// all the constraints independently and then solves a prefactorized
+        /// linear system (see ProjectiveDynamicsSolver).
+        ProjectiveDynamics,
+    };
+
+    enum class ProjectionScheme
+    {
+        /// \brief Each constraint updates the predicted positions immediately
+        /// (optionally in parallel over graph colors).
+        GaussSeidel,
+
+        /// \brief All the constraints calculate their corrections from the
+        /// same predicted positions, and the averaged corrections are applied
+        /// together (see JacobiProjection).
+        Jacobi,
+    };
+
+    enum class ResidualNorm
+    {
+        /// \brief The maximum of the absolute values of the constraints.
+        Max,
+
+        /// \brief The root mean square of the values of the constraints.
+        Rms,
+    };
+
+    enum class Acceleration
+    {
+        /// \brief The iterations are used as they are.
+        None,
+
+        /// \brief Each iteration moves the predicted positions by its
+        /// displacement multiplied by m_over_relaxation.
+        OverRelaxation,
+
+        /// \brief Chebyshev semi-iterative method [Wang 2015], which
+        /// extrapolates each iteration from the one before the previous one
+        /// by a weight growing with the iterations, given an estimate of the
+        /// spectral radius of the iterations (m_chebyshev_spectral_radius).
+        Chebyshev,
+    };
 
     class Engine
     {
     public:
 
+        Engine();
+        virtual ~Engine();
+
         void stepTime();
 
         virtual void initializeScene() = 0;
@@ -21,20 +95,321 @@ namespace elasty
         virtual void generateCollisionConstraints() = 0;
         virtual void updateVelocities() = 0;
 
+        /// \brief Remove the particles and the constraints, together with the
+        /// cloth hierarchies and the vertex buffers built on them.
         void clearScene();
 
-        std::vector<std::shared_ptr<Particle>> m_particles;
+        ParticleSet m_particles;
+
+        ConstraintSet m_constraints;
+        ConstraintSet m_instant_constraints;
 
-        std::vector<std::shared_ptr<Constraint>> m_constraints;
-        std::vector<std::shared_ptr<Constraint>> m_instant_constraints;
+        Scalar m_dt = 1.0 / 60.0;
 
-        double m_dt = 1.0 / 60.0;
+        /// \brief Number of solver iterations per (sub)step, or the maximum
+        /// number of them when m_residual_tolerance is positive.
         unsigned int m_num_iterations = 10;
 
+        /// \brief Residual of the bilateral constraints in m_constraints
+        /// below which the iterations of a (sub)step stop early, or zero for
+        /// always running m_num_iterations iterations.
+        /// \details In the Gauss-Seidel scheme, the residual is of the values
+        /// that the constraints calculate anyway when they are projected
+        /// (i.e., the residual at the start of each iteration, with the
+        /// corrections of the constraints projected earlier in the iteration
+        /// already applied), so monitoring it costs almost nothing. In the
+        /// Jacobi scheme and projective dynamics, the constraints are
+        /// evaluated again after each iteration; note that projective
+        /// dynamics converges to a compromise of the constraints whose
+        /// residual does not vanish. Note also that the values are of
+        /// different units for different constraint types (e.g., lengths for
+        /// distance constraints and angles for bending constraints).
+        Scalar m_residual_tolerance = 0.0;
+
+        ResidualNorm m_residual_norm = ResidualNorm::Max;
+
+        /// \brief Number of iterations run before the residual is checked.
+        unsigned int m_min_num_iterations = 1;
+
+        Framework m_framework = Framework::Pbd;
+
+        /// \brief Number of substeps per time step.
+        /// \details Each substep advances the time by m_dt / m_num_substeps
+        /// and runs m_num_iterations solver iterations. The scene hooks (i.e.,
+        /// setExternalForces, generateCollisionConstraints, and
+        /// updateVelocities) are called in every substep. Using many substeps
+        /// with a single iteration each, together with XPBD, is the "small
+        /// steps" strategy [Macklin et al. 2019], which reaches a given
+        /// accuracy with far fewer projections than many iterations.
+        unsigned int m_num_substeps = 1;
+
+        /// \brief Scheme for projecting the constraints in m_constraints.
+        /// \details Instant constraints are always projected in the
+        /// Gauss-Seidel manner after the constraints in m_constraints.
+        ProjectionScheme m_projection_scheme = ProjectionScheme::GaussSeidel;
+
+        /// \brief Over-relaxation factor of the Jacobi scheme, which is
+        /// typically in [1, 2].
+        Scalar m_jacobi_relaxation = 1.0;
+
+        /// \brief Scale of the weights of the constraints in projective
+        /// dynamics.
+        /// \details The weights are energies per squared length, to be
+        /// compared with the masses divided by the squared time step; so, the
+        /// larger this is, the stiffer the constraints get, while the number
+        /// of iterations needed does not grow as it does with PBD. The system
+        /// is factorized at the first step after the constraints have been set
+        /// up, and again whenever the numbers of the constraints, their
+        /// stiffness values, the inverse masses, the time step, or this scale
+        /// change. The projection scheme is ignored, and instant constraints
+        /// (e.g., contacts) are projected in the Gauss-Seidel manner after
+        /// each global step so as not to change the system.
+        Scalar m_projective_dynamics_weight_scale = 1e+03;
+
+        /// \brief Acceleration of the convergence of the iterations.
+        /// \details This is applied to the predicted positions after the
+        /// constraints in m_constraints have been projected in each iteration
+        /// (by any of the frameworks and the schemes), and before the instant
+        /// constraints are, so that the contacts are resolved at the
+        /// accelerated positions. Too large a factor, or an overestimated
+        /// spectral radius, makes the iterations oscillate or diverge.
+        Acceleration m_acceleration = Acceleration::None;
+
+        /// \brief Factor of Acceleration::OverRelaxation, which is typically
+        /// in [1, 2].
+        Scalar m_over_relaxation = 1.5;
+
+        /// \brief Estimated spectral radius of the iterations for
+        /// Acceleration::Chebyshev, which is in (0, 1) and depends on the
+        /// scene, the framework, and the scheme.
+        Scalar m_chebyshev_spectral_radius = 0.9;
+
+        /// \brief Number of the first iterations that Acceleration::Chebyshev
+        /// leaves as they are, which are often too far from the linear
+        /// convergence that the method assumes.
+        unsigned int m_chebyshev_delay = 2;
+
+        /// \brief Number of threads used for projecting the constraints.
+        /// \details In the Gauss-Seidel scheme, when this is more than one,
+        /// the constraints in m_constraints are graph-colored, so that no two
+        /// constraints of the same color share a particle, and the constraints
+        /// of each color are projected in parallel. The coloring is computed
+        /// at the first step after the constraints have been set up, which
+        /// reorders the arrays in m_constraints, and is reused as long as the
+        /// number of constraints does not change. In the Jacobi scheme, both
+        /// of its passes are run in parallel. Instant constraints are always
+        /// projected serially.
+        unsigned int m_num_threads = 1;
+
+        /// \brief Whether to project the distance constraints with the
+        /// vectorized kernel (see projectDistanceConstraintBatch).
+        /// \details This applies to the Gauss-Seidel scheme, where the
+        /// constraints are then graph-colored even with a single thread, so
+        /// that the distance constraints of each color can be projected
+        /// several at a time. The stiffness and compliance values of the
+        /// distance constraints are copied to the kernel in every (sub)step.
+        bool m_use_vectorized_kernels = false;
+
+        /// \brief Whether to put the islands of the particles that have come
+        /// to rest to sleep (see SleepingIslands).
+        /// \details A sleeping particle is not integrated, and the constraints
+        /// whose particles are all asleep (or have zero inverse masses) are
+        /// not projected, except by the vectorized distance kernel, after
+        /// which the sleeping particles are put back. The islands are computed
+        /// at the first step after the constraints have been set up, and the
+        /// sleep states are updated at the end of each step.
+        bool m_is_sleeping_enabled = false;
+
+        /// \brief Speed below which a particle is regarded as at rest.
+        Scalar m_sleep_speed_threshold = 0.01;
+
+        /// \brief Number of consecutive steps for which all the particles of
+        /// an island should be at rest before it falls asleep.
+        unsigned int m_num_steps_to_sleep = 30;
+
+        /// \brief Violation of an instant constraint (e.g., the penetration
+        /// depth of a contact) that wakes up the sleeping islands it touches.
+        Scalar m_wake_up_tolerance = 1e-04;
+
+        const SleepingIslands& getSleepingIslands() const { return m_sleeping_islands; }
+
+        /// \brief Timers of the phases of each (sub)step, the counters, and
+        /// the residuals of the (sub)steps (see Profiler).
+        /// \details This is filled only when the library is built with
+        /// ELASTY_PROFILING, in which case the residual of the bilateral
+        /// constraints is also calculated at the end of each (sub)step.
+        Profiler m_profiler;
+
+        /// \brief Calculate the error of the bilateral constraints in
+        /// m_constraints at the predicted positions.
+        ResidualStatistics calculateResidualStatistics() const;
+
+        /// \brief Number of iterations run in the last (sub)step.
+        unsigned int getLastNumIterations() const { return m_last_num_iterations; }
+
+        /// \brief Residual (of m_residual_norm) last measured for the early
+        /// stop, or zero when m_residual_tolerance is zero.
+        Scalar getLastResidual() const { return m_last_residual; }
+
+        /// \brief Coarse levels of cloths, which are projected in each
+        /// (sub)step before the iterations over the constraints (see
+        /// ClothHierarchy).
+        std::vector<std::shared_ptr<ClothHierarchy>> m_cloth_hierarchies;
+
+        /// \brief Buffers of cloths for renderers and exporters, which are
+        /// updated at the end of each step (see ClothVertexBuffer).
+        std::vector<std::shared_ptr<ClothVertexBuffer>> m_cloth_vertex_buffers;
+
+        /// \brief Backend that runs the (sub)steps (see DeviceSolver).
+        /// \details With a device backend, the scene is set up on the host as
+        /// usual (i.e., by initializeScene), and is copied to the device at
+        /// the first step and whenever the numbers of the particles or the
+        /// constraints change, or after invalidateDeviceScene. From then on,
+        /// the particles stay on the device, and m_particles is outdated
+        /// until synchronizeParticles copies them back (e.g., before
+        /// exporting a frame or rendering). setExternalForces is called on
+        /// the host once per step and the forces are uploaded; the contacts
+        /// are generated on the device from m_device_colliders instead of by
+        /// generateCollisionConstraints, and updateVelocities is replaced by
+        /// m_device_velocity_damping. The device backends support PBD and
+        /// XPBD with both of the projection schemes, and ignore the other
+        /// options of the solver (e.g., sleeping, the cloth hierarchies, the
+        /// acceleration, and the adaptive iterations); projective dynamics
+        /// throws std::runtime_error. The Lagrange multipliers of XPBD stay on
+        /// the device.
+        Backend m_backend = Backend::Cpu;
+
+        /// \brief Static colliders of the device backends, which stand in
+        /// for generateCollisionConstraints there (signed distance fields are
+        /// not supported).
+        ColliderSet m_device_colliders;
+
+        /// \brief Fraction of the velocities removed at the end of each
+        /// (sub)step on the device backends, which stands in for
+        /// updateVelocities there.
+        Scalar m_device_velocity_damping = 0.0;
+
+        /// \brief Copy the particles back from the device (and update
+        /// m_cloth_vertex_buffers from them), if they have been stepped there
+        /// since the last call; nothing happens with Backend::Cpu.
+        void synchronizeParticles();
+
+        /// \brief Mark the scene on the device as outdated, so that it is
+        /// copied again at the next step, after the particles or the
+        /// constraints have been modified on the host (e.g., a fixed point
+        /// moved). The particles should have been synchronized before they
+        /// are modified.
+        void invalidateDeviceScene() { m_is_device_scene_outdated = true; }
+
+        /// \brief Copy the dynamic state of the engine to the snapshot (see
+        /// EngineSnapshot), reusing the memory of the snapshot.
+        /// \details With a device backend, the particles are synchronized
+        /// first. Defined in src/engine-snapshot.cpp.
+        void takeSnapshot(EngineSnapshot& snapshot);
+        EngineSnapshot takeSnapshot();
+
+        /// \brief Put the engine back into the state of the snapshot, so that
+        /// the following steps are the same as those after the snapshot was
+        /// taken.
+        /// \details This throws std::runtime_error if the numbers of the
+        /// particles or of the fixed-point constraints differ from those of
+        /// the snapshot. The sleeping islands (if enabled) are rebuilt awake,
+        /// and the scene on the device (if any) is uploaded again at the next
+        /// step.
+        void restoreSnapshot(const EngineSnapshot& snapshot);
+
+        std::uint64_t getNumSteps() const { return m_num_steps; }
+
     protected:
 
-        void addConstraint(std::shared_ptr<Constraint> constraint);
-        void addInstantConstraint(std::shared_ptr<Constraint> constraint);
+        template <typename Type>
+        void addConstraint(const Type& constraint) { m_constraints.add(constraint); }
+
+        template <typename Type>
+        void addInstantConstraint(const Type& constraint) { m_instant_constraints.add(constraint); }
+
+        /// \brief Construct an instant constraint in place.
+        /// \details The instant constraints are cleared at the end of each
+        /// (sub)step without releasing their memory, so contacts generated
+        /// in every step reuse the same storage.
+        template <typename Type, typename... Args>
+        Type& emplaceInstantConstraint(Args&&... args)
+        {
+            return m_instant_constraints.emplace<Type>(std::forward<Args>(args)...);
+        }
+
+        /// \brief The thread pool of m_num_threads threads shared by the
+        /// solver, which can also be used in the scene hooks (e.g., for
+        /// collision detection); null when m_num_threads is one.
+        ThreadPool* getThreadPool();
+
+    private:
+
+        // Running statistics of the values of constraints
+        struct ResidualAccumulator
+        {
+            Scalar max = 0.0;
+            Scalar sum_of_squares = 0.0;
+            std::size_t num_constraints = 0;
+
+            void add(const Scalar C)
+            {
+                max = std::max(max, std::abs(C));
+                sum_of_squares += C * C;
+                ++ num_constraints;
+            }
+
+            void merge(const ResidualAccumulator& other)
+            {
+                max = std::max(max, other.max);
+                sum_of_squares += other.sum_of_squares;
+                num_constraints += other.num_constraints;
+            }
+
+            ResidualStatistics getStatistics() const
+            {
+                const Scalar rms = (num_constraints != 0) ? std::sqrt(sum_of_squares / Scalar(num_constraints)) : Scalar(0.0);
+                return { max, rms, num_constraints };
+            }
+        };
+
+        void prepareProjection(const Scalar dt);
+
+        /// \brief Apply m_acceleration to the predicted positions resulting
+        /// from the given (zero-based) iteration.
+        void accelerateIteration(const unsigned int iteration, Scalar& chebyshev_weight);
+
+        void solveConstraints(const Scalar dt);
+
+        void stepTimeOnDevice();
+
+        void updateVertexBuffers();
+
+        template <typename ProjectFunction>
+        void projectConstraintsByColor(ProjectFunction&& project, const Scalar dt, ResidualAccumulator* residual);
+
+        // The predicted positions of the previous iteration, and of the one
+        // before it, for the acceleration
+        std::vector<Vector3> m_previous_positions;
+        std::vector<Vector3> m_older_positions;
+
+        std::uint64_t m_num_steps = 0;
+        unsigned int m_last_num_iterations = 0;
+        Scalar m_last_residual = 0.0;
+
+        std::unique_ptr<DeviceSolver> m_device_solver;
+        Backend m_device_solver_backend = Backend::Cpu;
+        std::vector<std::size_t> m_device_batch_sizes;
+        std::size_t m_num_device_particles = 0;
+        bool m_is_device_scene_outdated = true;
+        bool m_are_particles_on_device_newer = false;
+
+        std::unique_ptr<ThreadPool> m_thread_pool;
+        ConstraintColoring m_coloring;
+        DistanceConstraintBatch m_distance_batch;
+        JacobiProjection m_jacobi_projection;
+        ProjectiveDynamicsSolver m_projective_dynamics_solver;
+        SleepingIslands m_sleeping_islands;
     };
 }
 
@@ -0,0 +1,116 @@
+#ifndef graph_coloring_hpp
+#define graph_coloring_hpp
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace elasty
+{
+    /// \brief Assign a color to each constraint so that no two constraints
+    /// of the same color share a particle.
+    /// \param indices the particle indices of the constraints, stored with a
+    /// stride of num_particles_per_constraint
+    /// \return the color of each constraint; colors are numbered from zero
+    /// without gaps
+    /// \details This is a greedy coloring, where each constraint takes the
+    /// smallest color that is not used by any of its particles yet.
+    std::vector<unsigned int> calculateGreedyColoring(const std::vector<unsigned int>& indices,
+                                                      const unsigned int num_particles_per_constraint,
+                                                      const std::size_t num_particles);
+
+    /// \brief Reorder the constraints so that the constraints of each color
+    /// are stored contiguously.
+    /// \return the offsets of the colors; the constraints of the c-th color
+    /// are stored in [offsets[c], offsets[c + 1])
+    /// \details The relative order of the constraints within each color is
+    /// kept.
+    template <typename Constraint>
+    std::vector<std::size_t> sortConstraintsByColor(std::vector<Constraint>& constraints,
+                                                    const std::size_t num_particles)
+    {
+        constexpr unsigned int num_particles_per_constraint = Constraint::num_particles;
+
+        std::vector<unsigned int> indices;
+        indices.reserve(num_particles_per_constraint * constraints.size());
+        for (const auto& constraint : constraints)
+        {
+            indices.insert(indices.end(), constraint.getIndices().begin(), constraint.getIndices().end());
+        }
+
+        const std::vector<unsigned int> colors = calculateGreedyColoring(indices, num_particles_per_constraint, num_particles);
+
+        // Counting sort by colors
+        std::vector<std::size_t> offsets(1, 0);
+        for (const unsigned int color : colors)
+        {
+            if (color + 2 > offsets.size()) { offsets.resize(color + 2, 0); }
+            ++ offsets[color + 1];
+        }
+        for (std::size_t c = 1; c < offsets.size(); ++ c)
+        {
+            offsets[c] += offsets[c - 1];
+        }
+
+        std::vector<std::size_t> positions(offsets.begin(), offsets.end() - 1);
+        std::vector<Constraint> sorted_constraints;
+        sorted_constraints.reserve(constraints.size());
+        std::vector<std::size_t> sorted_indices(constraints.size());
+        for (std::size_t i = 0; i < constraints.size(); ++ i)
+        {
+            sorted_indices[positions[colors[i]] ++] = i;
+        }
+        for (const std::size_t i : sorted_indices)
+        {
+            sorted_constraints.push_back(constraints[i]);
+        }
+        constraints = std::move(sorted_constraints);
+
+        return offsets;
+    }
+
+    /// \brief Colorings of all the per-type arrays of a constraint set.
+    /// \details A coloring is computed once for a set of constraints whose
+    /// topology does not change, and is reused over time steps. It is
+    /// regarded as outdated when the number of constraints in any array has
+    /// changed since it was computed.
+    class ConstraintColoring
+    {
+    public:
+
+        /// \brief Reorder the constraints of each array by color and record
+        /// the color offsets.
+        template <typename Set>
+        void build(Set& constraints, const std::size_t num_particles)
+        {
+            m_color_offsets.clear();
+
+            constraints.forEachBatch([&](auto& batch)
+            {
+                m_color_offsets.push_back(sortConstraintsByColor(batch, num_particles));
+            });
+
+            m_batch_sizes = constraints.getBatchSizes();
+        }
+
+        template <typename Set>
+        bool isUpToDate(const Set& constraints) const { return m_batch_sizes == constraints.getBatchSizes(); }
+
+        void clear()
+        {
+            m_batch_sizes.clear();
+            m_color_offsets.clear();
+        }
+
+        /// \brief Color offsets of the batch_index-th array (in the order of
+        /// ConstraintSet::forEachBatch).
+        const std::vector<std::size_t>& getColorOffsets(const std::size_t batch_index) const { return m_color_offsets[batch_index]; }
+
+    private:
+
+        std::vector<std::size_t> m_batch_sizes;
+        std::vector<std::vector<std::size_t>> m_color_offsets;
+    };
+}
+
+#endif /* graph_coloring_hpp */
@@ -0,0 +1,147 @@
+#ifndef jacobi_projection_hpp
+#define jacobi_projection_hpp
+
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <vector>
+#include <Eigen/Core>
+#include <elasty/particle-set.hpp>
+#include <elasty/thread-pool.hpp>
+
+namespace elasty
+{
+    /// \brief Jacobi-style projection of a constraint set.
+    /// \details In each iteration, every constraint calculates its position
+    /// corrections from the same predicted positions and writes them to its
+    /// own slots. Then every particle gathers the corrections in its slots,
+    /// averages them over the number of the active constraints, and applies
+    /// the result scaled by the over-relaxation factor [Macklin et al. 2014].
+    /// Both of the passes write to disjoint memory, so they run in parallel
+    /// without atomic operations. The slot layout is computed once for a set
+    /// of constraints whose topology does not change, in the same manner as
+    /// ConstraintColoring.
+    class JacobiProjection
+    {
+    public:
+
+        template <typename Set>
+        void build(const Set& constraints, const std::size_t num_particles)
+        {
+            std::vector<unsigned int> slot_particles;
+
+            m_batch_slot_offsets.clear();
+            constraints.forEachBatch([&](const auto& batch)
+            {
+                m_batch_slot_offsets.push_back(slot_particles.size());
+                for (const auto& constraint : batch)
+                {
+                    slot_particles.insert(slot_particles.end(), constraint.getIndices().begin(), constraint.getIndices().end());
+                }
+            });
+
+            buildSlotAdjacency(slot_particles, num_particles);
+
+            m_batch_sizes = constraints.getBatchSizes();
+        }
+
+        template <typename Set>
+        bool isUpToDate(const Set& constraints, const std::size_t num_particles) const
+        {
+            return m_batch_sizes == constraints.getBatchSizes() && m_particle_slot_offsets.size() == num_particles + 1;
+        }
+
+        void clear();
+
+        /// \param relaxation the over-relaxation factor, which is typically
+        /// in [1, 2]
+        /// \param thread_pool a thread pool for the parallel loops, or nullptr
+        /// for running them on the calling thread
+        /// \param calculate_correction a function called as
+        /// calculate_correction(constraint, delta_x), which calculates the
+        /// corrections of a constraint (e.g., by its calculateCorrection or
+        /// calculateXpbdCorrection) and returns whether it is active
+        template <typename Set, typename CorrectionFunction>
+        void project(Set& constraints,
+                     ParticleSet& particles,
+                     const Scalar relaxation,
+                     ThreadPool* thread_pool,
+                     CorrectionFunction&& calculate_correction)
+        {
+            auto parallel_for = [&](const std::size_t begin, const std::size_t end, const std::function<void(std::size_t, std::size_t)>& function)
+            {
+                if (thread_pool != nullptr) { thread_pool->parallelFor(begin, end, function); } else { function(begin, end); }
+            };
+
+            // Calculate the corrections of all the constraints
+            std::size_t batch_index = 0;
+            constraints.forEachBatch([&](auto& batch)
+            {
+                using Constraint = typename std::decay<decltype(batch)>::type::value_type;
+                constexpr unsigned int num_particles_per_constraint = Constraint::num_particles;
+
+                const std::size_t slot_offset = m_batch_slot_offsets[batch_index ++];
+
+                parallel_for(0, batch.size(), [&](const std::size_t begin, const std::size_t end)
+                {
+                    for (std::size_t i = begin; i < end; ++ i)
+                    {
+                        const std::size_t slot = slot_offset + num_particles_per_constraint * i;
+
+                        // Zero-initialized, as the compilers cannot see that
+                        // an inactive correction is never read
+                        typename Constraint::Correction delta_x = Constraint::Correction::Zero();
+                        const bool is_active = calculate_correction(batch[i], delta_x);
+
+                        for (unsigned int j = 0; j < num_particles_per_constraint; ++ j)
+                        {
+                            m_is_slot_active[slot + j] = is_active;
+                            if (is_active) { m_slot_corrections[slot + j] = delta_x.template segment<3>(3 * j); }
+                        }
+                    }
+                });
+            });
+
+            // Gather and apply the averaged corrections
+            parallel_for(0, particles.size(), [&](const std::size_t begin, const std::size_t end)
+            {
+                for (std::size_t i = begin; i < end; ++ i)
+                {
+                    Vector3 sum = Vector3::Zero();
+                    unsigned int num_active_constraints = 0;
+
+                    for (std::size_t k = m_particle_slot_offsets[i]; k < m_particle_slot_offsets[i + 1]; ++ k)
+                    {
+                        const std::size_t slot = m_particle_slots[k];
+                        if (!m_is_slot_active[slot]) { continue; }
+
+                        sum += m_slot_corrections[slot];
+                        ++ num_active_constraints;
+                    }
+
+                    if (num_active_constraints != 0)
+                    {
+                        particles.p[i] += (relaxation / Scalar(num_active_constraints)) * sum;
+                    }
+                }
+            });
+        }
+
+    private:
+
+        void buildSlotAdjacency(const std::vector<unsigned int>& slot_particles, const std::size_t num_particles);
+
+        std::vector<std::size_t> m_batch_sizes;
+        std::vector<std::size_t> m_batch_slot_offsets;
+
+        // Per-slot correction buffers
+        std::vector<Vector3> m_slot_corrections;
+        std::vector<unsigned char> m_is_slot_active;
+
+        // The slots of the i-th particle are m_particle_slots[m_particle_slot_offsets[i]] ... m_particle_slots[m_particle_slot_offsets[i + 1] - 1]
+        std::vector<std::size_t> m_particle_slot_offsets;
+        std::vector<std::size_t> m_particle_slots;
+    };
+}
+
+#endif /* jacobi_projection_hpp */
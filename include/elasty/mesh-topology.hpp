@@ -0,0 +1,71 @@
+#ifndef mesh_topology_hpp
+#define mesh_topology_hpp
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <Eigen/Core>
+
+namespace elasty
+{
+    class ThreadPool;
+
+    /// \brief Edge and vertex adjacency of a manifold triangle mesh.
+    /// \details The edges are found by sorting the keys of the three edges of
+    /// every triangle, instead of inserting them into an ordered map, so that
+    /// building the topology of a large mesh takes a few linear passes, a
+    /// sort, and no allocation per edge. The key generation and the sort can
+    /// be run in parallel over triangles.
+    class MeshTopology
+    {
+    public:
+
+        using TriangleList = Eigen::Matrix<int32_t, Eigen::Dynamic, 3, Eigen::RowMajor>;
+
+        static constexpr unsigned int invalid_index = std::numeric_limits<unsigned int>::max();
+
+        struct Edge
+        {
+            /// \brief The two vertices of this edge, in the ascending order.
+            std::array<unsigned int, 2> vertices;
+
+            /// \brief The triangles sharing this edge, in the ascending order;
+            /// the second one is invalid_index for a boundary edge.
+            std::array<unsigned int, 2> triangles;
+
+            /// \brief The vertex of each triangle that is not on this edge.
+            std::array<unsigned int, 2> opposite_vertices;
+
+            bool isBoundary() const { return triangles[1] == invalid_index; }
+        };
+
+        /// \param thread_pool the pool used for parallelizing the build; it
+        /// can be null
+        void build(const TriangleList& triangles, const unsigned int num_vertices, ThreadPool* thread_pool = nullptr);
+
+        void clear();
+
+        /// \brief The edges sorted by their vertices.
+        const std::vector<Edge>& getEdges() const { return m_edges; }
+
+        /// \brief Indices of the three edges of the triangle, where the k-th
+        /// edge is the one opposite to the k-th vertex.
+        const std::array<unsigned int, 3>& getTriangleEdges(const unsigned int triangle) const { return m_triangle_edges[triangle]; }
+
+        /// \brief Offsets of the vertex-to-triangle adjacency; the triangles
+        /// around the vertex v are getVertexTriangles()[i] for i in
+        /// [getVertexTriangleOffsets()[v], getVertexTriangleOffsets()[v + 1]).
+        const std::vector<unsigned int>& getVertexTriangleOffsets() const { return m_vertex_triangle_offsets; }
+        const std::vector<unsigned int>& getVertexTriangles() const { return m_vertex_triangles; }
+
+    private:
+
+        std::vector<Edge> m_edges;
+        std::vector<std::array<unsigned int, 3>> m_triangle_edges;
+        std::vector<unsigned int> m_vertex_triangle_offsets;
+        std::vector<unsigned int> m_vertex_triangles;
+    };
+}
+
+#endif /* mesh_topology_hpp */
@@ -0,0 +1,64 @@
+#ifndef particle_set_hpp
+#define particle_set_hpp
+
+#include <cstddef>
+#include <vector>
+#include <Eigen/Core>
+#include <elasty/scalar.hpp>
+
+namespace elasty
+{
+    /// \brief A set of particles stored in a structure-of-arrays layout.
+    /// \details Each attribute is kept in its own contiguous array, and a
+    /// particle is identified by its index into these arrays. Sim objects and
+    /// constraints refer to particles by index, so that the per-particle loops
+    /// in the engine stream through memory instead of chasing pointers.
+    struct ParticleSet
+    {
+        /// \brief Append a particle and return its index.
+        unsigned int addParticle(const Vector3& position,
+                                 const Vector3& velocity,
+                                 const Scalar mass)
+        {
+            x.push_back(position);
+            v.push_back(velocity);
+            p.push_back(position);
+            f.push_back(Vector3::Zero());
+            m.push_back(mass);
+            w.push_back(1.0 / mass);
+
+            return static_cast<unsigned int>(m.size() - 1);
+        }
+
+        std::size_t size() const { return m.size(); }
+
+        void reserve(const std::size_t num_particles)
+        {
+            x.reserve(num_particles);
+            v.reserve(num_particles);
+            p.reserve(num_particles);
+            f.reserve(num_particles);
+            m.reserve(num_particles);
+            w.reserve(num_particles);
+        }
+
+        void clear()
+        {
+            x.clear();
+            v.clear();
+            p.clear();
+            f.clear();
+            m.clear();
+            w.clear();
+        }
+
+        std::vector<Vector3> x;
+        std::vector<Vector3> v;
+        std::vector<Vector3> p;
+        std::vector<Vector3> f;
+        std::vector<Scalar> m;
+        std::vector<Scalar> w;
+    };
+}
+
+#endif /* particle_set_hpp */
@@ -0,0 +1,173 @@
+#ifndef profiler_hpp
+#define profiler_hpp
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include <elasty/scalar.hpp>
+
+namespace elasty
+{
+    /// \brief Error of a set of constraints, i.e., the statistics of the
+    /// absolute values of C over them.
+    struct ResidualStatistics
+    {
+        Scalar max = 0.0;
+        Scalar rms = 0.0;
+        std::size_t num_constraints = 0;
+    };
+
+    /// \brief Timers, counters, and per-(sub)step statistics of the solver.
+    /// \details The instrumentation (i.e., the ELASTY_PROFILE_SCOPE and
+    /// ELASTY_PROFILE_COUNT macros placed in the solver) is compiled only when
+    /// the library is built with ELASTY_PROFILING (the CMake option of the
+    /// same name); otherwise the macros expand to nothing and a profiler
+    /// stays empty. A scoped timer records an event of its name, start time,
+    /// and duration, and the events of nested scopes nest in the same manner
+    /// in the Chrome trace. Timers are intended to be placed around the
+    /// phases run on the calling thread (not inside parallel loops).
+    ///
+    /// The counters are incremented from anywhere, including inside parallel
+    /// loops and the constraint kernels, which have no access to an engine,
+    /// so they are process-wide relaxed atomics; Engine takes and resets them
+    /// at the end of each (sub)step. When several engines are stepped
+    /// concurrently, their counts are mixed.
+    class Profiler
+    {
+    public:
+
+        enum class Counter
+        {
+            /// \brief Constraints whose corrections have been calculated,
+            /// including those projected by the vectorized kernel.
+            ProjectedConstraints,
+
+            /// \brief Unilateral constraints skipped as they are satisfied.
+            InactiveConstraints,
+
+            /// \brief Constraints skipped as their gradients are
+            /// (approximately) zero.
+            DegenerateConstraints,
+
+            /// \brief Instant constraints generated by the scene hooks.
+            Contacts,
+        };
+
+        static constexpr std::size_t num_counters = 4;
+
+        using Counts = std::array<std::uint64_t, num_counters>;
+
+        struct Event
+        {
+            const char* name;
+            std::int64_t begin;    // in nanoseconds since the profiler has been created or cleared
+            std::int64_t duration; // in nanoseconds
+        };
+
+        struct StepRecord
+        {
+            std::uint64_t step;
+            unsigned int substep;
+            std::int64_t begin;
+            std::int64_t duration;
+            Counts counts;
+
+            /// \brief Error of the bilateral constraints of the engine at the
+            /// end of the (sub)step.
+            ResidualStatistics residual;
+        };
+
+        Profiler() { clear(); }
+
+        void clear();
+
+        /// \brief Whether to record events and steps, which can be switched
+        /// off at runtime (e.g., apart from the frames of interest).
+        bool m_is_enabled = true;
+
+        void recordEvent(const char* name, const std::chrono::steady_clock::time_point begin, const std::chrono::steady_clock::time_point end);
+        void recordStep(const StepRecord& record) { m_steps.push_back(record); }
+
+        const std::vector<Event>& getEvents() const { return m_events; }
+        const std::vector<StepRecord>& getSteps() const { return m_steps; }
+
+        /// \brief Total durations of the events in milliseconds, by name.
+        std::map<std::string, double> calculateTotalDurations() const;
+
+        /// \brief Write the events as complete ("X") events and the counters
+        /// and the residuals of the steps as counter ("C") events in the
+        /// Chrome trace event format, which can be viewed with, e.g.,
+        /// chrome://tracing or Perfetto.
+        void writeChromeTrace(const std::string& path) const;
+
+        std::int64_t getTimestamp(const std::chrono::steady_clock::time_point time) const
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(time - m_origin).count();
+        }
+
+        static void count(const Counter counter, const std::uint64_t n)
+        {
+            s_counts[static_cast<std::size_t>(counter)].fetch_add(n, std::memory_order_relaxed);
+        }
+
+        /// \brief Take the process-wide counts accumulated since the last
+        /// call, resetting them to zero.
+        static Counts takeCounts();
+
+        static const char* getCounterName(const Counter counter);
+
+    private:
+
+        std::chrono::steady_clock::time_point m_origin;
+
+        std::vector<Event> m_events;
+        std::vector<StepRecord> m_steps;
+
+        static inline std::array<std::atomic<std::uint64_t>, num_counters> s_counts = {};
+    };
+
+    /// \brief Record an event of the lifetime of this object to a profiler.
+    class ScopedTimer
+    {
+    public:
+
+        ScopedTimer(Profiler& profiler, const char* name) :
+        m_profiler(profiler),
+        m_name(name),
+        m_begin(std::chrono::steady_clock::now())
+        {
+        }
+
+        ~ScopedTimer()
+        {
+            if (m_profiler.m_is_enabled) { m_profiler.recordEvent(m_name, m_begin, std::chrono::steady_clock::now()); }
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+
+        Profiler& m_profiler;
+        const char* m_name;
+        std::chrono::steady_clock::time_point m_begin;
+    };
+}
+
+#define ELASTY_PROFILE_CONCATENATE_IMPL(a, b) a##b
+#define ELASTY_PROFILE_CONCATENATE(a, b) ELASTY_PROFILE_CONCATENATE_IMPL(a, b)
+
+#if defined(ELASTY_PROFILING)
+#define ELASTY_PROFILE_SCOPE(profiler, name) const elasty::ScopedTimer ELASTY_PROFILE_CONCATENATE(elasty_scoped_timer_, __LINE__)(profiler, name)
+#define ELASTY_PROFILE_COUNT(counter, n) elasty::Profiler::count(elasty::Profiler::Counter::counter, n)
+#else
+#define ELASTY_PROFILE_SCOPE(profiler, name) static_cast<void>(0)
+#define ELASTY_PROFILE_COUNT(counter, n) static_cast<void>(0)
+#endif
+
+#endif /* profiler_hpp */
@@ -0,0 +1,237 @@
+#ifndef projective_dynamics_hpp
+#define projective_dynamics_hpp
+
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/SparseCholesky>
+#include <elasty/particle-set.hpp>
+#include <elasty/thread-pool.hpp>
+
+namespace elasty
+{
+    /// \brief Projective dynamics solver of a constraint set [Bouaziz et al.
+    /// 2014].
+    /// \details Each constraint c of n particles is given the quadratic energy
+    ///
+    /// $$ \frac{w_c}{2} \| A (q_c - t_c) \|^2, $$
+    ///
+    /// where q_c is the positions of its particles, t_c is their projection
+    /// onto the constraint manifold (see FixedNumConstraint::calculateProjection),
+    /// and A is the centering matrix $I - \frac{1}{n} 1 1^T$ (or the identity
+    /// for a single particle), so that the energy does not depend on the
+    /// translation of the particles. Each iteration consists of
+    ///
+    /// 1. the local step, which projects all the constraints independently
+    ///    (in parallel) from the current positions, and
+    /// 2. the global step, which minimizes the sum of the energies and the
+    ///    inertial term $\frac{1}{2 h^2} \| M^{1/2} (q - s) \|^2$, where s is
+    ///    the inertial (i.e., predicted) positions, by solving a linear
+    ///    system.
+    ///
+    /// The system matrix $M / h^2 + \sum_c w_c S_c^T A S_c$ depends only on
+    /// the topology, the weights, the masses, and the time step, so it is
+    /// factorized once by the sparse Cholesky (LDLT) decomposition and only
+    /// the right-hand side is updated in each iteration. The matrix acts on
+    /// the three coordinates in the same way, so it is of the size of the
+    /// number of the particles and the coordinates are solved as three
+    /// right-hand sides. The particles with zero inverse masses are not
+    /// unknowns; they stay at their predicted positions.
+    ///
+    /// The global step is always in double, even in a single-precision build,
+    /// since the system of large weights is ill-conditioned and its
+    /// factorization would lose much of the accuracy of float; only the local
+    /// step and the positions are in Scalar.
+    class ProjectiveDynamicsSolver
+    {
+    public:
+
+        /// \param weight_scale the scale of the weights, i.e., the weight of
+        /// each constraint is its stiffness multiplied by this
+        template <typename Set>
+        void build(const Set& constraints, const ParticleSet& particles, const Scalar dt, const Scalar weight_scale)
+        {
+            std::vector<unsigned int> slot_particles;
+            std::vector<Scalar> slot_weights;
+            std::vector<unsigned int> slot_sizes;
+
+            m_batch_slot_offsets.clear();
+            constraints.forEachBatch([&](const auto& batch)
+            {
+                m_batch_slot_offsets.push_back(slot_particles.size());
+                for (const auto& constraint : batch)
+                {
+                    for (const unsigned int index : constraint.getIndices())
+                    {
+                        slot_particles.push_back(index);
+                        slot_weights.push_back(weight_scale * constraint.m_stiffness);
+                        slot_sizes.push_back(static_cast<unsigned int>(constraint.getIndices().size()));
+                    }
+                }
+            });
+
+            factorize(slot_particles, slot_weights, slot_sizes, particles, dt);
+
+            m_batch_sizes = constraints.getBatchSizes();
+            m_stiffnesses = collectStiffnesses(constraints);
+            m_inverse_masses = particles.w;
+            m_dt = dt;
+            m_weight_scale = weight_scale;
+        }
+
+        /// \brief Whether the factorization is still valid, i.e., neither the
+        /// numbers of the constraints, their stiffness values, the inverse
+        /// masses, the time step, nor the weight scale have changed.
+        /// \details This is called in every (sub)step, so the stored values
+        /// are compared in place (without allocating), returning at the first
+        /// mismatch.
+        template <typename Set>
+        bool isUpToDate(const Set& constraints, const ParticleSet& particles, const Scalar dt, const Scalar weight_scale) const
+        {
+            if (m_dt != dt || m_weight_scale != weight_scale || m_inverse_masses != particles.w) { return false; }
+
+            bool is_up_to_date = true;
+            std::size_t batch_index = 0;
+            std::size_t stiffness_index = 0;
+            constraints.forEachBatch([&](const auto& batch)
+            {
+                if (!is_up_to_date) { return; }
+                if (batch_index == m_batch_sizes.size() || batch.size() != m_batch_sizes[batch_index ++])
+                {
+                    is_up_to_date = false;
+                    return;
+                }
+                for (const auto& constraint : batch)
+                {
+                    if (constraint.m_stiffness != m_stiffnesses[stiffness_index ++])
+                    {
+                        is_up_to_date = false;
+                        return;
+                    }
+                }
+            });
+
+            return is_up_to_date && batch_index == m_batch_sizes.size();
+        }
+
+        void clear();
+
+        /// \brief Store the predicted positions as the inertial positions of
+        /// the (sub)step, which should be called before the iterations.
+        void setInertialPositions(const ParticleSet& particles);
+
+        /// \brief Run a local step and a global step, updating the predicted
+        /// positions.
+        /// \param thread_pool a thread pool for the local step, or nullptr for
+        /// running it on the calling thread
+        template <typename Set>
+        void project(const Set& constraints, ParticleSet& particles, ThreadPool* thread_pool)
+        {
+            auto parallel_for = [&](const std::size_t begin, const std::size_t end, const std::function<void(std::size_t, std::size_t)>& function)
+            {
+                if (thread_pool != nullptr) { thread_pool->parallelFor(begin, end, function); } else { function(begin, end); }
+            };
+
+            // Local step: the weighted, centered projections of all the constraints
+            std::size_t batch_index = 0;
+            constraints.forEachBatch([&](const auto& batch)
+            {
+                using Constraint = typename std::decay<decltype(batch)>::type::value_type;
+                constexpr unsigned int num_particles_per_constraint = Constraint::num_particles;
+
+                const std::size_t slot_offset = m_batch_slot_offsets[batch_index ++];
+
+                parallel_for(0, batch.size(), [&](const std::size_t begin, const std::size_t end)
+                {
+                    for (std::size_t i = begin; i < end; ++ i)
+                    {
+                        const std::size_t slot = slot_offset + num_particles_per_constraint * i;
+                        const auto& indices = batch[i].getIndices();
+
+                        // An inactive constraint is at its projection
+                        typename Constraint::Correction delta_x;
+                        if (!batch[i].calculateProjection(particles, delta_x)) { delta_x.setZero(); }
+
+                        // The targets, from which the fixed particles are
+                        // subtracted as they are not unknowns
+                        Eigen::Matrix<Scalar, 3, num_particles_per_constraint> targets;
+                        for (unsigned int j = 0; j < num_particles_per_constraint; ++ j)
+                        {
+                            targets.col(j) = delta_x.template segment<3>(3 * j);
+                            if (particles.w[indices[j]] != 0.0) { targets.col(j) += particles.p[indices[j]]; }
+                        }
+
+                        const Scalar weight = m_slot_weights[slot];
+                        if constexpr (num_particles_per_constraint == 1)
+                        {
+                            m_slot_values[slot] = weight * targets.col(0);
+                        }
+                        else
+                        {
+                            const Vector3 mean = targets.rowwise().mean();
+                            for (unsigned int j = 0; j < num_particles_per_constraint; ++ j)
+                            {
+                                m_slot_values[slot + j] = weight * (targets.col(j) - mean);
+                            }
+                        }
+                    }
+                });
+            });
+
+            solveGlobalStep(particles, thread_pool);
+        }
+
+        std::size_t getNumUnknowns() const { return m_unknown_particles.size(); }
+
+    private:
+
+        template <typename Set>
+        static std::vector<Scalar> collectStiffnesses(const Set& constraints)
+        {
+            std::vector<Scalar> stiffnesses;
+            constraints.forEachBatch([&](const auto& batch)
+            {
+                for (const auto& constraint : batch) { stiffnesses.push_back(constraint.m_stiffness); }
+            });
+            return stiffnesses;
+        }
+
+        void factorize(const std::vector<unsigned int>& slot_particles,
+                       const std::vector<Scalar>& slot_weights,
+                       const std::vector<unsigned int>& slot_sizes,
+                       const ParticleSet& particles,
+                       const Scalar dt);
+
+        void solveGlobalStep(ParticleSet& particles, ThreadPool* thread_pool);
+
+        std::vector<std::size_t> m_batch_sizes;
+        std::vector<Scalar> m_stiffnesses;
+        std::vector<Scalar> m_inverse_masses;
+        Scalar m_dt = 0.0;
+        Scalar m_weight_scale = 0.0;
+
+        std::vector<std::size_t> m_batch_slot_offsets;
+        std::vector<Scalar> m_slot_weights;
+        std::vector<Vector3> m_slot_values;
+
+        // The slots of the i-th unknown are m_unknown_slots[m_unknown_slot_offsets[i]] ... m_unknown_slots[m_unknown_slot_offsets[i + 1] - 1]
+        std::vector<std::size_t> m_unknown_slot_offsets;
+        std::vector<std::size_t> m_unknown_slots;
+
+        // The particle of each unknown, i.e., each particle of nonzero inverse mass
+        std::vector<unsigned int> m_unknown_particles;
+
+        // The diagonal of $M / h^2$ and the inertial term $M s / h^2$ of the right-hand side
+        Eigen::VectorXd m_inertia;
+        Eigen::Matrix<double, Eigen::Dynamic, 3> m_inertial_rhs;
+
+        Eigen::Matrix<double, Eigen::Dynamic, 3> m_rhs;
+        Eigen::Matrix<double, Eigen::Dynamic, 3> m_solution;
+
+        Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> m_ldlt;
+    };
+}
+
+#endif /* projective_dynamics_hpp */
@@ -0,0 +1,31 @@
+#ifndef scalar_hpp
+#define scalar_hpp
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+namespace elasty
+{
+    /// \brief Floating-point type of the simulation.
+    /// \details This is float when the library is built with
+    /// ELASTY_SINGLE_PRECISION (the CMake option of the same name), which
+    /// halves the memory traffic of the solver and doubles the SIMD width of
+    /// the vectorized kernels, and double otherwise. Scene setup (e.g., the
+    /// import transforms of meshes) and file formats (e.g., the binary cache
+    /// of cloth objects) stay in double in both cases.
+#if defined(ELASTY_SINGLE_PRECISION)
+    using Scalar = float;
+#else
+    using Scalar = double;
+#endif
+
+    using Vector3 = Eigen::Matrix<Scalar, 3, 1>;
+    using Vector4 = Eigen::Matrix<Scalar, 4, 1>;
+    using VectorX = Eigen::Matrix<Scalar, Eigen::Dynamic, 1>;
+    using Matrix2 = Eigen::Matrix<Scalar, 2, 2>;
+    using Matrix3 = Eigen::Matrix<Scalar, 3, 3>;
+    using Matrix4 = Eigen::Matrix<Scalar, 4, 4>;
+    using Isometry3 = Eigen::Transform<Scalar, 3, Eigen::Isometry>;
+}
+
+#endif /* scalar_hpp */
@@ -0,0 +1,92 @@
+#ifndef self_collision_hpp
+#define self_collision_hpp
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <elasty/constraint-set.hpp>
+#include <elasty/mesh-topology.hpp>
+#include <elasty/spatial-hash.hpp>
+
+namespace elasty
+{
+    struct ParticleSet;
+    class ThreadPool;
+
+    /// \brief Detector of the self-collisions of the particles and of the
+    /// registered triangle meshes, using a spatial hash rebuilt in every
+    /// step.
+    /// \details This is intended to be called from
+    /// Engine::generateCollisionConstraints, after the predicted positions
+    /// have been calculated, to fill the instant constraints:
+    ///
+    /// - a ParticleCollisionConstraint for each pair of particles closer than
+    ///   the thickness (except for the pairs sharing a registered triangle),
+    ///   and
+    /// - a PointTriangleCollisionConstraint for each particle right above or
+    ///   below a registered triangle that is closer than the thickness to its
+    ///   plane, or that has crossed it during the step (except for the
+    ///   particles sharing an edge with a vertex of the triangle). The side to keep the particle on is the one it was on at
+    ///   the beginning of the step. Since the spatial hash is built over the
+    ///   predicted positions, a particle that has moved by much more than a
+    ///   triangle during a single step may be missed.
+    ///
+    /// A pair that is already closer than the thickness at the beginning of
+    /// the step is only kept from getting closer, instead of being pushed back
+    /// to the thickness at once. The thickness should be well below the edge
+    /// lengths of the meshes (e.g., less than a half); otherwise, the contacts
+    /// between nearby particles of a folded mesh conflict with its distance
+    /// constraints.
+    ///
+    /// The detection is run in parallel over particles and triangles when a
+    /// thread pool is given; the constraints are added in the same order
+    /// regardless of the number of threads.
+    class SelfCollisionDetector
+    {
+    public:
+
+        SelfCollisionDetector(const Scalar thickness = 0.01, const Scalar stiffness = 1.0);
+
+        /// \brief Register the triangles of an object whose first particle is
+        /// particle_offset (e.g., a ClothSimObject).
+        void addTriangles(const MeshTopology::TriangleList& triangle_list, const unsigned int particle_offset);
+
+        void clear();
+
+        void generateConstraints(const ParticleSet& particles, ConstraintSet& constraints, ThreadPool* thread_pool = nullptr);
+
+        Scalar m_thickness;
+        Scalar m_stiffness;
+
+        bool m_is_particle_collision_enabled = true;
+        bool m_is_triangle_collision_enabled = true;
+
+    private:
+
+        struct ChunkResult
+        {
+            std::size_t begin;
+            std::vector<ParticleCollisionConstraint> particle_collisions;
+            std::vector<PointTriangleCollisionConstraint> triangle_collisions;
+        };
+
+        template <typename Function>
+        void runInChunks(ThreadPool* thread_pool, const std::size_t num_elements, Function&& function);
+
+        bool isExcludedPair(const unsigned int index_0, const unsigned int index_1) const;
+
+        std::vector<std::array<unsigned int, 3>> m_triangles;
+
+        // Sorted keys of the pairs of particles sharing a triangle
+        std::vector<std::uint64_t> m_excluded_pairs;
+
+        SpatialHash m_spatial_hash;
+
+        std::mutex m_mutex;
+        std::vector<ChunkResult> m_chunk_results;
+        std::size_t m_num_chunk_results = 0;
+    };
+}
+
+#endif /* self_collision_hpp */
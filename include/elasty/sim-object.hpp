@@ -1,20 +1,25 @@
 #ifndef sim_object_hpp
 #define sim_object_hpp
 
-#include <memory>
-#include <vector>
+#include <elasty/constraint-set.hpp>
 
 namespace elasty
 {
-    struct Particle;
-    class Constraint;
-
     class SimObject
     {
     public:
 
-        std::vector<std::shared_ptr<Particle>> m_particles;
-        std::vector<std::shared_ptr<Constraint>> m_constraints;
+        /// \brief Index of the first particle of this object in the particle
+        /// set that the object was built into.
+        /// \details The particles of an object are stored contiguously, so
+        /// the i-th particle of this object is found at the index
+        /// (m_particle_offset + i) of the particle set.
+        unsigned int m_particle_offset = 0;
+
+        /// \brief Number of the particles of this object.
+        unsigned int m_num_particles = 0;
+
+        ConstraintSet m_constraints;
     };
 }
 
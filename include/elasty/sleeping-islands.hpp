@@ -0,0 +1,112 @@
+#ifndef sleeping_islands_hpp
+#define sleeping_islands_hpp
+
+#include <cstdint>
+#include <vector>
+#include <Eigen/Core>
+#include <elasty/constraint-set.hpp>
+#include <elasty/particle-set.hpp>
+
+namespace elasty
+{
+    /// \brief Islands of the particles connected by constraints, which are put
+    /// to sleep when they come to rest and woken up when they are disturbed.
+    /// \details An island is a connected component of the graph whose nodes
+    /// are the dynamic particles (i.e., whose inverse masses are nonzero) and
+    /// whose edges are the constraints; particles with zero inverse masses do
+    /// not connect islands, as they are not moved by the constraints. An
+    /// island falls asleep when the speeds of all its particles have stayed
+    /// below a threshold for a number of consecutive steps, and then keeps
+    /// its particles still (with zero velocities) until it is woken up by
+    ///
+    /// - an instant constraint (e.g., a contact) touching both the island and
+    ///   a moving particle, or violated by more than a tolerance,
+    /// - a FixedPointConstraint of the island whose point has been moved, or
+    /// - a particle with a zero inverse mass, constrained together with the
+    ///   island, whose position has been moved (i.e., a kinematic particle).
+    class SleepingIslands
+    {
+    public:
+
+        bool isUpToDate(const ConstraintSet& constraints, const ParticleSet& particles) const
+        {
+            return m_batch_sizes == constraints.getBatchSizes() && m_particle_islands.size() == particles.size();
+        }
+
+        /// \brief Compute the islands of the constraints, all of which start
+        /// awake.
+        void build(const ConstraintSet& constraints, const ParticleSet& particles);
+
+        void clear();
+
+        /// \brief Wake up the islands disturbed by the scene since the last
+        /// call, which is intended to be called after the instant constraints
+        /// have been generated in each (sub)step.
+        void wakeUp(const ConstraintSet& constraints,
+                    const ConstraintSet& instant_constraints,
+                    const ParticleSet& particles,
+                    const Scalar tolerance);
+
+        /// \brief Update the sleep counters from the velocities at the end of
+        /// a step, and put the islands that have been at rest for long enough
+        /// to sleep (setting the velocities of their particles to zero).
+        void update(ParticleSet& particles, const Scalar speed_threshold, const unsigned int num_steps_to_sleep);
+
+        bool isParticleAsleep(const unsigned int index) const
+        {
+            const int32_t island = m_particle_islands[index];
+            return island >= 0 && m_is_island_asleep[island];
+        }
+
+        /// \brief Whether every particle of the constraint is either asleep or
+        /// not movable, i.e., whether projecting it can be skipped.
+        template <typename Constraint>
+        bool isConstraintAsleep(const Constraint& constraint) const
+        {
+            for (const unsigned int index : constraint.getIndices())
+            {
+                if (m_is_particle_resting[index] == 0) { return false; }
+            }
+            return true;
+        }
+
+        bool hasSleepingIsland() const { return m_num_sleeping_islands > 0; }
+        bool areAllIslandsAsleep() const { return m_num_sleeping_islands == m_is_island_asleep.size(); }
+
+        std::size_t getNumIslands() const { return m_is_island_asleep.size(); }
+        std::size_t getNumSleepingIslands() const { return m_num_sleeping_islands; }
+
+        /// \brief Island of each particle, or -1 for a particle with a zero
+        /// inverse mass.
+        const std::vector<int32_t>& getParticleIslands() const { return m_particle_islands; }
+
+    private:
+
+        void setIslandAsleep(const int32_t island, const bool is_asleep, const std::vector<Scalar>& inverse_masses);
+
+        std::vector<std::size_t> m_batch_sizes;
+
+        std::vector<int32_t> m_particle_islands;
+
+        // Either asleep or having a zero inverse mass (one byte per particle
+        // for the lookups in the solver loops)
+        std::vector<std::uint8_t> m_is_particle_resting;
+
+        // The particles of each island, in the CSR format
+        std::vector<std::size_t> m_island_offsets;
+        std::vector<unsigned int> m_island_particles;
+
+        std::vector<std::uint8_t> m_is_island_asleep;
+        std::vector<unsigned int> m_num_resting_steps;
+        std::size_t m_num_sleeping_islands = 0;
+
+        // Kinematic particles and the islands constrained together with them
+        std::vector<std::pair<unsigned int, int32_t>> m_kinematic_neighbors;
+        std::vector<Vector3> m_kinematic_positions;
+
+        // The points of the fixed-point constraints when last checked
+        std::vector<Vector3> m_fixed_points;
+    };
+}
+
+#endif /* sleeping_islands_hpp */
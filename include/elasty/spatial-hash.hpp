@@ -0,0 +1,102 @@
+#ifndef spatial_hash_hpp
+#define spatial_hash_hpp
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <Eigen/Core>
+#include <elasty/scalar.hpp>
+
+namespace elasty
+{
+    class ThreadPool;
+
+    /// \brief Uniform grid over a set of points, stored in a hash table of
+    /// fixed size.
+    /// \details The grid is meant to be rebuilt in every step: the points are
+    /// counting-sorted by the hash of their cells, so that the points of each
+    /// cell are contiguous in memory (together with their positions) and
+    /// building the grid does not allocate once the arrays have grown. The
+    /// hash of each point is calculated in parallel when a thread pool is
+    /// given.
+    class SpatialHash
+    {
+    public:
+
+        /// \param cell_size the edge length of the cells, which should be at
+        /// least the typical query radius
+        void build(const std::vector<Vector3>& positions, const Scalar cell_size, ThreadPool* thread_pool = nullptr);
+
+        Scalar getCellSize() const { return m_cell_size; }
+
+        /// \brief Call function(index, position) for every point in the cells
+        /// overlapping the axis-aligned box [box_min, box_max].
+        /// \details Each point is visited at most once. The points outside the
+        /// box but in the overlapping cells are visited as well, so the caller
+        /// should apply its own exact test.
+        template <typename Function>
+        void forEachPointInBox(const Vector3& box_min, const Vector3& box_max, Function&& function) const
+        {
+            if (m_sorted_indices.empty()) { return; }
+
+            const Cell cell_min = calculateCell(box_min);
+            const Cell cell_max = calculateCell(box_max);
+
+            for (int32_t i = cell_min[0]; i <= cell_max[0]; ++ i)
+            {
+                for (int32_t j = cell_min[1]; j <= cell_max[1]; ++ j)
+                {
+                    for (int32_t k = cell_min[2]; k <= cell_max[2]; ++ k)
+                    {
+                        const Cell cell = { i, j, k };
+                        const std::uint32_t hash = calculateHash(cell);
+
+                        for (std::uint32_t l = m_bucket_offsets[hash]; l < m_bucket_offsets[hash + 1]; ++ l)
+                        {
+                            // Skip the points of other cells that share the bucket
+                            if (m_sorted_cells[l] != cell) { continue; }
+
+                            function(m_sorted_indices[l], m_sorted_positions[l]);
+                        }
+                    }
+                }
+            }
+        }
+
+    private:
+
+        using Cell = std::array<int32_t, 3>;
+
+        Cell calculateCell(const Vector3& position) const
+        {
+            return
+            {
+                static_cast<int32_t>(std::floor(position(0) * m_inv_cell_size)),
+                static_cast<int32_t>(std::floor(position(1) * m_inv_cell_size)),
+                static_cast<int32_t>(std::floor(position(2) * m_inv_cell_size))
+            };
+        }
+
+        std::uint32_t calculateHash(const Cell& cell) const
+        {
+            const std::uint32_t hash = (std::uint32_t(cell[0]) * 73856093u) ^ (std::uint32_t(cell[1]) * 19349663u) ^ (std::uint32_t(cell[2]) * 83492791u);
+            return hash & (m_num_buckets - 1);
+        }
+
+        Scalar m_cell_size = 1.0;
+        Scalar m_inv_cell_size = 1.0;
+        std::uint32_t m_num_buckets = 0;
+
+        std::vector<std::uint32_t> m_bucket_offsets;
+        std::vector<std::uint32_t> m_point_hashes;
+        std::vector<Cell> m_point_cells;
+
+        // The points sorted by their buckets
+        std::vector<std::uint32_t> m_sorted_indices;
+        std::vector<Cell> m_sorted_cells;
+        std::vector<Vector3> m_sorted_positions;
+    };
+}
+
+#endif /* spatial_hash_hpp */
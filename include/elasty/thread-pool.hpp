@@ -0,0 +1,63 @@
+#ifndef thread_pool_hpp
+#define thread_pool_hpp
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace elasty
+{
+    /// \brief A fixed-size pool of worker threads for data-parallel loops.
+    /// \details The calling thread also takes part in the work, so a pool
+    /// with N threads spawns N - 1 workers. The workers are kept alive between
+    /// loops so that launching a loop only costs a wake-up.
+    class ThreadPool
+    {
+    public:
+
+        /// \param num_threads the total number of threads including the
+        /// calling one; zero means the number of hardware threads
+        explicit ThreadPool(const unsigned int num_threads = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        unsigned int getNumThreads() const { return static_cast<unsigned int>(m_workers.size()) + 1; }
+
+        /// \brief Split [begin, end) into contiguous chunks, one per thread,
+        /// and call function(chunk_begin, chunk_end) for each of them.
+        /// \param min_range the length of the range below which it is
+        /// processed on the calling thread only, as the work is not worth
+        /// waking up the workers; a coarse-grained loop (e.g., over whole
+        /// simulations) can lower this
+        /// \details This call blocks until all the chunks have been processed.
+        void parallelFor(const std::size_t begin,
+                         const std::size_t end,
+                         const std::function<void(std::size_t, std::size_t)>& function,
+                         const std::size_t min_range = 64);
+
+    private:
+
+        void processChunk(const unsigned int thread_index);
+        void work(const unsigned int thread_index);
+
+        std::vector<std::thread> m_workers;
+
+        std::mutex m_mutex;
+        std::condition_variable m_start_condition;
+        std::condition_variable m_done_condition;
+
+        const std::function<void(std::size_t, std::size_t)>* m_function = nullptr;
+        std::size_t m_begin = 0;
+        std::size_t m_end = 0;
+        unsigned long m_generation = 0;
+        unsigned int m_num_pending_workers = 0;
+        bool m_is_terminating = false;
+    };
+}
+
+#endif /* thread_pool_hpp */
@@ -4,40 +4,137 @@
 #include <memory>
 #include <string>
 #include <vector>
+#include <elasty/constraint-set.hpp>
 #include <Eigen/Core>
 
 namespace elasty
 {
-    struct Particle;
-    class Constraint;
+    struct ParticleSet;
     class ClothSimObject;
     class AlembicManager;
+    class ThreadPool;
 
-    constexpr double pi() { return 3.14159265358979323846264338327950288; }
+    constexpr Scalar pi() { return 3.14159265358979323846264338327950288; }
 
-    /// \param particles an array of N particles
+    /// \param particles a particle set
+    /// \param offset the index of the first particle to pack
+    /// \param num_particles the number of particles to pack (N)
     /// \return an array of 3 * N values:
     /// std::vector<float>
     /// {
-    ///     p[0].x, p[0].y, p[0].z,
-    ///     p[1].x, p[1].y, p[1].z,
+    ///     p[offset + 0].x, p[offset + 0].y, p[offset + 0].z,
+    ///     p[offset + 1].x, p[offset + 1].y, p[offset + 1].z,
     ///     ...
     /// }
-    std::vector<float> packParticlePositions(const std::vector<std::shared_ptr<Particle>>& particles);
+    std::vector<float> packParticlePositions(const ParticleSet& particles,
+                                             const unsigned int offset,
+                                             const unsigned int num_particles);
 
-    void setRandomVelocities(const std::vector<std::shared_ptr<Particle>>& particles,
-                             const double scale = 1.0);
+    /// \brief Same as above, but writes the 3 * N values to a preallocated
+    /// buffer instead of allocating an array.
+    void packParticlePositions(const ParticleSet& particles,
+                               const unsigned int offset,
+                               const unsigned int num_particles,
+                               float* verts);
 
-    void generateFixedPointConstraints(const Eigen::Vector3d& search_position,
-                                       const Eigen::Vector3d& fixed_position,
-                                       const std::vector<std::shared_ptr<Particle>>& particles,
-                                       std::vector<std::shared_ptr<Constraint>>& constraints);
+    struct AlembicExportOptions
+    {
+        /// \brief Number of frames that can wait to be written before
+        /// submitCurrentStatus blocks.
+        unsigned int num_buffers = 4;
 
+        /// \brief Write only every Nth submitted step (the first one
+        /// included); the time sampling of the archive is scaled accordingly.
+        unsigned int sample_interval = 1;
+
+        /// \brief If positive, the positions are rounded to multiples of
+        /// this value, so that the samples of slowly moving objects become
+        /// identical and are stored only once.
+        Scalar quantization_step = 0.0;
+
+        /// \brief If positive, an object whose vertices have all moved less
+        /// than this value since its last written sample is considered at
+        /// rest, and its last sample is repeated (which is stored only once).
+        Scalar rest_threshold = 0.0;
+    };
+
+    void setRandomVelocities(ParticleSet& particles,
+                             const Scalar scale = 1.0);
+
+    void generateFixedPointConstraints(const Vector3& search_position,
+                                       const Vector3& fixed_position,
+                                       const ParticleSet& particles,
+                                       ConstraintSet& constraints);
+
+    enum class AttachmentDistance
+    {
+        /// \brief Straight-line distances in the rest shape, which are exact
+        /// for a flat cloth whose pins are visible from every particle.
+        Euclidean,
+
+        /// \brief Shortest-path distances along the edges of the mesh in the
+        /// rest shape (computed by Dijkstra's algorithm), which follow the
+        /// surface of a curved cloth but slightly overestimate the true
+        /// geodesic distances.
+        Geodesic,
+    };
+
+    /// \brief Generate long-range attachment constraints from the particles
+    /// of the cloth object to its pins.
+    /// \details The pins are the particles of the cloth that have zero
+    /// inverse masses or fixed-point constraints in the constraint set, and
+    /// the pins connected by edges are grouped into a single pinned region.
+    /// Each of the other particles is attached to the nearest pin of each
+    /// region, at its fixed point (or its position), with the rest distance
+    /// between them as the maximum distance. The cloth is assumed to be in
+    /// its rest shape. The distances are computed in parallel over the
+    /// particles (Euclidean) or the regions (geodesic) when a thread pool is
+    /// given.
+    void generateLongRangeAttachmentConstraints(const ClothSimObject& cloth_sim_object,
+                                                const ParticleSet& particles,
+                                                ConstraintSet& constraints,
+                                                const AttachmentDistance distance = AttachmentDistance::Geodesic,
+                                                const Scalar stiffness = 1.0,
+                                                ThreadPool* thread_pool = nullptr);
+
+    /// \param particles the particle set that the cloth object was built
+    /// into, which needs to outlive the returned manager
+    /// \param num_buffers the number of frames that can wait to be written
+    /// before submitCurrentStatus blocks
+    /// \details The archive is written by a background thread of the
+    /// manager, so that the simulation and the disk I/O overlap. The archive
+    /// is complete once closeAlembicManager has been called or the manager
+    /// has been destroyed.
     std::shared_ptr<AlembicManager> createAlembicManager(const std::string& file_path,
                                                          const std::shared_ptr<ClothSimObject> cloth_sim_object,
-                                                         const double dt);
+                                                         const ParticleSet& particles,
+                                                         const double dt,
+                                                         const unsigned int num_buffers = 4);
+
+    /// \brief Create a manager that writes several cloth objects to one
+    /// archive, as the meshes "cloth_0", "cloth_1", ... (or "cloth" if there
+    /// is only one).
+    /// \param particles the particle set that all the cloth objects were
+    /// built into
+    std::shared_ptr<AlembicManager> createAlembicManager(const std::string& file_path,
+                                                         const std::vector<std::shared_ptr<ClothSimObject>>& cloth_sim_objects,
+                                                         const ParticleSet& particles,
+                                                         const double dt,
+                                                         const AlembicExportOptions& options = AlembicExportOptions());
 
+    /// \brief Copy the current positions of the cloths and queue them to be
+    /// written (unless the step is skipped by the sample interval).
+    /// \details This blocks only when all the buffers are queued. An error
+    /// that occurred in the writer thread is rethrown here, and by every later
+    /// call (including the flush and the close), as the writer has stopped.
     void submitCurrentStatus(const std::shared_ptr<AlembicManager> alembic_manager);
+
+    /// \brief Block until all the submitted frames have been written.
+    void flushAlembicManager(const std::shared_ptr<AlembicManager> alembic_manager);
+
+    /// \brief Write all the submitted frames and close the archive; the
+    /// manager cannot be used after this.
+    void closeAlembicManager(const std::shared_ptr<AlembicManager> alembic_manager);
 }
 
 #endif /* elasty_utils_hpp */
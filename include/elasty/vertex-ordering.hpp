@@ -0,0 +1,35 @@
+#ifndef vertex_ordering_hpp
+#define vertex_ordering_hpp
+
+#include <elasty/scalar.hpp>
+#include <vector>
+
+namespace elasty
+{
+    class MeshTopology;
+
+    /// \brief Calculate the order of the vertices along the Z-order (Morton)
+    /// curve of their positions.
+    /// \return the permutation from the new indices to the original ones,
+    /// i.e., the i-th vertex of the new order is the order[i]-th one
+    /// \details Each coordinate is quantized to 21 bits within the bounding
+    /// box of the vertices, and the vertices of the same code keep their
+    /// relative order.
+    std::vector<unsigned int> calculateMortonOrder(const std::vector<Vector3>& positions);
+
+    /// \brief Calculate the reverse Cuthill-McKee order of the vertices over
+    /// the edges of a mesh, which keeps the index distance between adjacent
+    /// vertices (i.e., the bandwidth) small.
+    /// \return the permutation from the new indices to the original ones, as
+    /// in calculateMortonOrder
+    /// \details Each connected component is traversed breadth first from a
+    /// vertex of the smallest degree, visiting the neighbors in the ascending
+    /// order of their degrees. The vertices on no edge are also included.
+    std::vector<unsigned int> calculateReverseCuthillMcKeeOrder(const MeshTopology& topology, const unsigned int num_vertices);
+
+    /// \brief Invert a permutation, e.g., to obtain the new index of each
+    /// original vertex from an order.
+    std::vector<unsigned int> invertPermutation(const std::vector<unsigned int>& permutation);
+}
+
+#endif /* vertex_ordering_hpp */
@@ -0,0 +1,152 @@
+#include <elasty/batched-engine.hpp>
+#include <algorithm>
+#include <cassert>
+#include <type_traits>
+
+elasty::BatchedEngine::BatchedEngine(const ParticleSet& particles, const ConstraintSet& constraints, const std::size_t num_instances) :
+m_num_instances(num_instances),
+m_particles(particles),
+m_constraints(std::make_shared<const ConstraintSet>(constraints))
+{
+    const std::size_t num_particles = particles.size();
+
+    m_positions.resize(num_instances * num_particles);
+    m_velocities.resize(num_instances * num_particles);
+    for (std::size_t k = 0; k < num_instances; ++ k)
+    {
+        std::copy(particles.x.begin(), particles.x.end(), m_positions.begin() + k * num_particles);
+        std::copy(particles.v.begin(), particles.v.end(), m_velocities.begin() + k * num_particles);
+    }
+
+    m_stiffness_overrides.resize(num_instances);
+
+    m_working_buffers.resize(1, WorkingBuffers{ particles, {}, {} });
+}
+
+void elasty::BatchedEngine::stepTime()
+{
+    assert(m_num_substeps > 0);
+
+    const unsigned int num_threads = std::max(m_num_threads, 1u);
+    if (m_working_buffers.size() != num_threads) { m_working_buffers.resize(num_threads, WorkingBuffers{ m_particles, {}, {} }); }
+
+    // The colliders may have been edited since the last step (the copy reuses
+    // the storage of the previous one)
+    for (auto& buffers : m_working_buffers) { buffers.colliders = m_colliders; }
+
+    if (num_threads == 1)
+    {
+        stepInstances(0, m_num_instances, m_working_buffers.front());
+        return;
+    }
+
+    if (m_thread_pool == nullptr || m_thread_pool->getNumThreads() != num_threads)
+    {
+        m_thread_pool = std::make_unique<ThreadPool>(num_threads);
+    }
+
+    // Split the instances into contiguous ranges, one per thread, so that
+    // each range is stepped with the working buffers of its own; an instance
+    // is worth a thread by itself
+    m_thread_pool->parallelFor(0, num_threads, [&](const std::size_t thread_begin, const std::size_t thread_end)
+    {
+        for (std::size_t thread = thread_begin; thread < thread_end; ++ thread)
+        {
+            stepInstances((m_num_instances * thread) / num_threads, (m_num_instances * (thread + 1)) / num_threads, m_working_buffers[thread]);
+        }
+    }, 1);
+}
+
+void elasty::BatchedEngine::copyInstance(const std::size_t instance, ParticleSet& particles) const
+{
+    const std::size_t num_particles = m_particles.size();
+    assert(particles.size() == num_particles);
+
+    std::copy(getPositions(instance), getPositions(instance) + num_particles, particles.x.begin());
+    std::copy(getVelocities(instance), getVelocities(instance) + num_particles, particles.v.begin());
+    std::copy(getPositions(instance), getPositions(instance) + num_particles, particles.p.begin());
+}
+
+void elasty::BatchedEngine::stepInstances(const std::size_t begin, const std::size_t end, WorkingBuffers& buffers)
+{
+    const Scalar dt = m_dt / Scalar(m_num_substeps);
+    const std::size_t num_particles = m_particles.size();
+
+    // Only the predicted positions of the working particles are written, so
+    // they are refreshed from the instance state below
+    ParticleSet& working_particles = buffers.particles;
+    ConstraintSet& instant_constraints = buffers.instant_constraints;
+    ColliderSet& colliders = buffers.colliders;
+
+    for (std::size_t instance = begin; instance < end; ++ instance)
+    {
+        Vector3* x = m_positions.data() + instance * num_particles;
+        Vector3* v = m_velocities.data() + instance * num_particles;
+
+        for (unsigned int substep = 0; substep < m_num_substeps; ++ substep)
+        {
+            // Apply the gravity and calculate predicted positions
+            for (std::size_t i = 0; i < num_particles; ++ i)
+            {
+                if (working_particles.w[i] != 0.0) { v[i] = v[i] + dt * working_particles.w[i] * (working_particles.m[i] * m_gravity); }
+
+                working_particles.p[i] = x[i] + dt * v[i];
+            }
+
+            // Generate collision constraints
+            colliders.generateConstraints(working_particles, instant_constraints);
+
+            solveConstraints(instance, working_particles, instant_constraints);
+
+            // Apply the results
+            for (std::size_t i = 0; i < num_particles; ++ i)
+            {
+                v[i] = (working_particles.p[i] - x[i]) * (1.0 / dt);
+                x[i] = working_particles.p[i];
+            }
+
+            if (m_velocity_damping != 0.0)
+            {
+                for (std::size_t i = 0; i < num_particles; ++ i) { v[i] *= 1.0 - m_velocity_damping; }
+            }
+
+            instant_constraints.clear();
+        }
+    }
+}
+
+void elasty::BatchedEngine::solveConstraints(const std::size_t instance, ParticleSet& working_particles, const ConstraintSet& instant_constraints) const
+{
+    const auto& stiffness_overrides = m_stiffness_overrides[instance];
+
+    auto project_batch = [&](const auto& constraints)
+    {
+        for (const auto& constraint : constraints) { constraint.projectParticles(working_particles); }
+    };
+
+    for (unsigned int iteration = 0; iteration < m_num_iterations; ++ iteration)
+    {
+        std::size_t batch_index = 0;
+        m_constraints->forEachBatch([&](const auto& constraints)
+        {
+            const std::optional<Scalar>& stiffness = stiffness_overrides[batch_index ++];
+
+            if (!stiffness)
+            {
+                project_batch(constraints);
+                return;
+            }
+
+            for (const auto& constraint : constraints)
+            {
+                typename std::decay_t<decltype(constraint)>::Correction delta_x;
+                if (!constraint.calculateProjection(working_particles, delta_x)) { continue; }
+
+                delta_x *= *stiffness;
+                constraint.applyCorrection(delta_x, working_particles);
+            }
+        });
+
+        instant_constraints.forEachBatch(project_batch);
+    }
+}
@@ -0,0 +1,222 @@
+#include <elasty/bvh.hpp>
+#include <algorithm>
+#include <array>
+#include <numeric>
+
+namespace
+{
+    constexpr int32_t max_leaf_size = 4;
+
+    // Squared distance from the point to the axis-aligned box (zero inside)
+    inline elasty::Scalar calculateSquaredDistanceToBox(const elasty::Vector3& p, const elasty::Vector3& box_min, const elasty::Vector3& box_max)
+    {
+        const elasty::Vector3 delta = (box_min - p).cwiseMax(p - box_max).cwiseMax(0.0);
+        return delta.squaredNorm();
+    }
+
+    // Barycentric coordinates of the point on the triangle (a, b, c) closest
+    // to the point p [Ericson 2004, Section 5.1.5]
+    elasty::Vector3 calculateClosestPointBarycentricCoords(const elasty::Vector3& p,
+                                                           const elasty::Vector3& a,
+                                                           const elasty::Vector3& b,
+                                                           const elasty::Vector3& c)
+    {
+        const elasty::Vector3 ab = b - a;
+        const elasty::Vector3 ac = c - a;
+        const elasty::Vector3 ap = p - a;
+
+        const elasty::Scalar d_1 = ab.dot(ap);
+        const elasty::Scalar d_2 = ac.dot(ap);
+        if (d_1 <= 0.0 && d_2 <= 0.0) { return elasty::Vector3(1.0, 0.0, 0.0); }
+
+        const elasty::Vector3 bp = p - b;
+        const elasty::Scalar d_3 = ab.dot(bp);
+        const elasty::Scalar d_4 = ac.dot(bp);
+        if (d_3 >= 0.0 && d_4 <= d_3) { return elasty::Vector3(0.0, 1.0, 0.0); }
+
+        const elasty::Scalar v_c = d_1 * d_4 - d_3 * d_2;
+        if (v_c <= 0.0 && d_1 >= 0.0 && d_3 <= 0.0)
+        {
+            const elasty::Scalar v = d_1 / (d_1 - d_3);
+            return elasty::Vector3(1.0 - v, v, 0.0);
+        }
+
+        const elasty::Vector3 cp = p - c;
+        const elasty::Scalar d_5 = ab.dot(cp);
+        const elasty::Scalar d_6 = ac.dot(cp);
+        if (d_6 >= 0.0 && d_5 <= d_6) { return elasty::Vector3(0.0, 0.0, 1.0); }
+
+        const elasty::Scalar v_b = d_5 * d_2 - d_1 * d_6;
+        if (v_b <= 0.0 && d_2 >= 0.0 && d_6 <= 0.0)
+        {
+            const elasty::Scalar w = d_2 / (d_2 - d_6);
+            return elasty::Vector3(1.0 - w, 0.0, w);
+        }
+
+        const elasty::Scalar v_a = d_3 * d_6 - d_5 * d_4;
+        if (v_a <= 0.0 && (d_4 - d_3) >= 0.0 && (d_5 - d_6) >= 0.0)
+        {
+            const elasty::Scalar w = (d_4 - d_3) / ((d_4 - d_3) + (d_5 - d_6));
+            return elasty::Vector3(0.0, 1.0 - w, w);
+        }
+
+        const elasty::Scalar denom = 1.0 / (v_a + v_b + v_c);
+        const elasty::Scalar v = v_b * denom;
+        const elasty::Scalar w = v_c * denom;
+        return elasty::Vector3(1.0 - v - w, v, w);
+    }
+}
+
+void elasty::TriangleBvh::build(const std::vector<Vector3>& vertices, const MeshTopology::TriangleList& triangles)
+{
+    m_vertices = vertices;
+    m_triangles = triangles;
+
+    m_nodes.clear();
+    m_triangle_indices.resize(triangles.rows());
+    std::iota(m_triangle_indices.begin(), m_triangle_indices.end(), 0);
+
+    if (triangles.rows() == 0) { return; }
+
+    std::vector<Vector3> centroids(triangles.rows());
+    for (int32_t t = 0; t < triangles.rows(); ++ t)
+    {
+        centroids[t] = (vertices[triangles(t, 0)] + vertices[triangles(t, 1)] + vertices[triangles(t, 2)]) / 3.0;
+    }
+
+    m_nodes.reserve(2 * (triangles.rows() / max_leaf_size + 1));
+    buildNode(0, static_cast<int32_t>(triangles.rows()), centroids);
+}
+
+int32_t elasty::TriangleBvh::buildNode(const int32_t begin, const int32_t end, const std::vector<Vector3>& centroids)
+{
+    const int32_t node_index = static_cast<int32_t>(m_nodes.size());
+    m_nodes.push_back(Node{ Vector3::Constant(std::numeric_limits<Scalar>::infinity()),
+                            Vector3::Constant(- std::numeric_limits<Scalar>::infinity()),
+                            begin,
+                            end - begin });
+
+    Vector3 box_min = m_nodes[node_index].box_min;
+    Vector3 box_max = m_nodes[node_index].box_max;
+    Vector3 centroid_min = box_min;
+    Vector3 centroid_max = box_max;
+    for (int32_t i = begin; i < end; ++ i)
+    {
+        const int32_t t = m_triangle_indices[i];
+        for (int32_t k = 0; k < 3; ++ k)
+        {
+            box_min = box_min.cwiseMin(m_vertices[m_triangles(t, k)]);
+            box_max = box_max.cwiseMax(m_vertices[m_triangles(t, k)]);
+        }
+        centroid_min = centroid_min.cwiseMin(centroids[t]);
+        centroid_max = centroid_max.cwiseMax(centroids[t]);
+    }
+    m_nodes[node_index].box_min = box_min;
+    m_nodes[node_index].box_max = box_max;
+
+    if (end - begin <= max_leaf_size) { return node_index; }
+
+    int axis;
+    (centroid_max - centroid_min).maxCoeff(&axis);
+
+    const int32_t middle = begin + (end - begin) / 2;
+    std::nth_element(m_triangle_indices.begin() + begin,
+                     m_triangle_indices.begin() + middle,
+                     m_triangle_indices.begin() + end,
+                     [&](const int32_t a, const int32_t b) { return centroids[a](axis) < centroids[b](axis); });
+
+    buildNode(begin, middle, centroids);
+    const int32_t second_child = buildNode(middle, end, centroids);
+
+    m_nodes[node_index].first = second_child;
+    m_nodes[node_index].count = 0;
+
+    return node_index;
+}
+
+elasty::TriangleBvh::ClosestPoint elasty::TriangleBvh::findClosestPoint(const Vector3& point, const Scalar max_distance) const
+{
+    ClosestPoint result{ -1, Vector3::Zero(), Vector3::Zero(), max_distance * max_distance, Feature::Face, 0 };
+
+    if (m_nodes.empty()) { return result; }
+
+    // The tree is balanced, so its depth is logarithmic in the number of
+    // triangles and a small fixed-size stack is enough
+    std::array<int32_t, 64> stack;
+    int32_t stack_size = 0;
+    stack[stack_size ++] = 0;
+
+    while (stack_size > 0)
+    {
+        const Node& node = m_nodes[stack[-- stack_size]];
+
+        if (calculateSquaredDistanceToBox(point, node.box_min, node.box_max) >= result.squared_distance) { continue; }
+
+        if (node.isLeaf())
+        {
+            for (int32_t i = node.first; i < node.first + node.count; ++ i)
+            {
+                const int32_t t = m_triangle_indices[i];
+
+                const Vector3& a = m_vertices[m_triangles(t, 0)];
+                const Vector3& b = m_vertices[m_triangles(t, 1)];
+                const Vector3& c = m_vertices[m_triangles(t, 2)];
+
+                const Vector3 barycentric_coords = calculateClosestPointBarycentricCoords(point, a, b, c);
+                const Vector3 closest_point = barycentric_coords(0) * a + barycentric_coords(1) * b + barycentric_coords(2) * c;
+                const Scalar squared_distance = (point - closest_point).squaredNorm();
+
+                if (squared_distance < result.squared_distance)
+                {
+                    result.triangle = t;
+                    result.point = closest_point;
+                    result.barycentric_coords = barycentric_coords;
+                    result.squared_distance = squared_distance;
+                }
+            }
+            continue;
+        }
+
+        // Visit the nearer child first so that the farther one is more likely to be culled
+        const int32_t first_child = static_cast<int32_t>(&node - m_nodes.data()) + 1;
+        const int32_t second_child = node.first;
+
+        const Scalar squared_distance_first = calculateSquaredDistanceToBox(point, m_nodes[first_child].box_min, m_nodes[first_child].box_max);
+        const Scalar squared_distance_second = calculateSquaredDistanceToBox(point, m_nodes[second_child].box_min, m_nodes[second_child].box_max);
+
+        if (squared_distance_first < squared_distance_second)
+        {
+            stack[stack_size ++] = second_child;
+            stack[stack_size ++] = first_child;
+        }
+        else
+        {
+            stack[stack_size ++] = first_child;
+            stack[stack_size ++] = second_child;
+        }
+    }
+
+    if (result.triangle >= 0)
+    {
+        const Vector3& coords = result.barycentric_coords;
+        const int num_zeros = int(coords(0) == 0.0) + int(coords(1) == 0.0) + int(coords(2) == 0.0);
+
+        if (num_zeros == 0)
+        {
+            result.feature = Feature::Face;
+            result.feature_index = 0;
+        }
+        else if (num_zeros == 1)
+        {
+            result.feature = Feature::Edge;
+            result.feature_index = (coords(0) == 0.0) ? 0 : ((coords(1) == 0.0) ? 1 : 2);
+        }
+        else
+        {
+            result.feature = Feature::Vertex;
+            result.feature_index = (coords(0) != 0.0) ? 0 : ((coords(1) != 0.0) ? 1 : 2);
+        }
+    }
+
+    return result;
+}
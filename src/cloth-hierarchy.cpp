@@ -0,0 +1,219 @@
+#include <elasty/cloth-hierarchy.hpp>
+#include <elasty/bvh.hpp>
+#include <elasty/cloth-sim-object.hpp>
+#include <elasty/mesh-topology.hpp>
+#include <elasty/particle-set.hpp>
+#include <iostream>
+#include <stdexcept>
+#include <tiny_obj_loader.h>
+
+namespace
+{
+    void loadMesh(const std::string& obj_path,
+                  const Eigen::Affine3d& transform,
+                  std::vector<elasty::Vector3>& vertices,
+                  elasty::MeshTopology::TriangleList& triangles)
+    {
+        tinyobj::attrib_t attrib;
+        std::vector<tinyobj::shape_t> shapes;
+        std::vector<tinyobj::material_t> materials;
+
+        std::string warn;
+        std::string err;
+        const bool return_value = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, obj_path.c_str());
+
+        if (!warn.empty()) { std::cerr << warn << std::endl; }
+        if (!err.empty()) { std::cerr << err << std::endl; }
+        if (!return_value || shapes.empty()) { throw std::runtime_error(""); }
+
+        vertices.resize(attrib.vertices.size() / 3);
+        for (std::size_t i = 0; i < vertices.size(); ++ i)
+        {
+            vertices[i] = (transform * Eigen::Vector3d(attrib.vertices[3 * i + 0], attrib.vertices[3 * i + 1], attrib.vertices[3 * i + 2])).cast<elasty::Scalar>();
+        }
+
+        const auto& indices = shapes[0].mesh.indices;
+        triangles.resize(indices.size() / 3, 3);
+        for (std::size_t i = 0; i < indices.size() / 3; ++ i)
+        {
+            triangles(i, 0) = indices[3 * i + 0].vertex_index;
+            triangles(i, 1) = indices[3 * i + 1].vertex_index;
+            triangles(i, 2) = indices[3 * i + 2].vertex_index;
+        }
+    }
+
+    template <typename Embedding>
+    std::vector<Embedding> calculateEmbeddings(const std::vector<elasty::Vector3>& points, const elasty::TriangleBvh& bvh)
+    {
+        std::vector<Embedding> embeddings(points.size());
+        for (std::size_t i = 0; i < points.size(); ++ i)
+        {
+            const elasty::TriangleBvh::ClosestPoint closest_point = bvh.findClosestPoint(points[i]);
+            const auto& triangles = bvh.getTriangles();
+
+            embeddings[i].vertices = { static_cast<unsigned int>(triangles(closest_point.triangle, 0)),
+                                       static_cast<unsigned int>(triangles(closest_point.triangle, 1)),
+                                       static_cast<unsigned int>(triangles(closest_point.triangle, 2)) };
+            embeddings[i].coords = closest_point.barycentric_coords;
+        }
+        return embeddings;
+    }
+}
+
+elasty::ClothHierarchy::ClothHierarchy(const ClothSimObject& cloth,
+                                       const ParticleSet& particles,
+                                       const ConstraintSet& constraints,
+                                       const std::vector<std::string>& coarse_obj_paths,
+                                       const Eigen::Affine3d& transform) :
+m_particle_offset(cloth.m_particle_offset),
+m_num_particles(cloth.m_num_particles)
+{
+    // The pinned particles of the cloth
+    m_is_pinned.assign(m_num_particles, false);
+    for (unsigned int i = 0; i < m_num_particles; ++ i)
+    {
+        if (particles.w[m_particle_offset + i] == 0.0) { m_is_pinned[i] = true; }
+    }
+    for (const auto& constraint : constraints.get<FixedPointConstraint>())
+    {
+        const unsigned int index = constraint.getIndices()[0];
+        if (index >= m_particle_offset && index < m_particle_offset + m_num_particles) { m_is_pinned[index - m_particle_offset] = true; }
+    }
+
+    // The finer level of the first coarse level is the cloth itself
+    std::vector<Vector3> finer_vertices(particles.x.begin() + m_particle_offset, particles.x.begin() + m_particle_offset + m_num_particles);
+    MeshTopology::TriangleList finer_triangles = cloth.m_triangle_list;
+    std::vector<bool> finer_is_pinned = m_is_pinned;
+
+    for (const std::string& obj_path : coarse_obj_paths)
+    {
+        std::vector<Vector3> vertices;
+        MeshTopology::TriangleList triangles;
+        loadMesh(obj_path, transform, vertices, triangles);
+
+        Level level;
+
+        TriangleBvh finer_bvh;
+        finer_bvh.build(finer_vertices, finer_triangles);
+        level.restriction = calculateEmbeddings<Embedding>(vertices, finer_bvh);
+
+        TriangleBvh bvh;
+        bvh.build(vertices, triangles);
+        level.prolongation = calculateEmbeddings<Embedding>(finer_vertices, bvh);
+
+        MeshTopology topology;
+        topology.build(triangles, static_cast<unsigned int>(vertices.size()));
+        for (const auto& edge : topology.getEdges())
+        {
+            level.edges.push_back({ edge.vertices[0], edge.vertices[1] });
+            level.rest_lengths.push_back((vertices[edge.vertices[0]] - vertices[edge.vertices[1]]).norm());
+        }
+
+        // A vertex is fixed if it is embedded (with a nonzero weight) on a pinned vertex of the finer level
+        std::vector<bool> is_pinned(vertices.size(), false);
+        level.inverse_masses.resize(vertices.size());
+        for (std::size_t i = 0; i < vertices.size(); ++ i)
+        {
+            for (unsigned int k = 0; k < 3; ++ k)
+            {
+                if (level.restriction[i].coords(k) > 0.0 && finer_is_pinned[level.restriction[i].vertices[k]]) { is_pinned[i] = true; }
+            }
+            level.inverse_masses[i] = is_pinned[i] ? 0.0 : 1.0;
+        }
+
+        level.positions = vertices;
+        level.initial_positions = vertices;
+
+        m_levels.push_back(std::move(level));
+
+        finer_vertices = std::move(vertices);
+        finer_triangles = std::move(triangles);
+        finer_is_pinned = std::move(is_pinned);
+    }
+}
+
+void elasty::ClothHierarchy::projectLevel(Level& level) const
+{
+    for (unsigned int iteration = 0; iteration < m_num_iterations; ++ iteration)
+    {
+        for (std::size_t e = 0; e < level.edges.size(); ++ e)
+        {
+            const unsigned int i_0 = level.edges[e][0];
+            const unsigned int i_1 = level.edges[e][1];
+
+            const Scalar w_0 = level.inverse_masses[i_0];
+            const Scalar w_1 = level.inverse_masses[i_1];
+
+            if (w_0 + w_1 == 0.0) { continue; }
+
+            const Vector3 r = level.positions[i_0] - level.positions[i_1];
+            const Scalar length = r.norm();
+
+            // Only stretching is resisted
+            const Scalar C = length - level.rest_lengths[e];
+            if (C <= 0.0) { continue; }
+
+            const Vector3 correction = (m_stiffness * C / ((w_0 + w_1) * length)) * r;
+
+            level.positions[i_0] -= w_0 * correction;
+            level.positions[i_1] += w_1 * correction;
+        }
+    }
+}
+
+void elasty::ClothHierarchy::project(ParticleSet& particles)
+{
+    if (m_levels.empty()) { return; }
+
+    if (m_particle_offset + m_num_particles > particles.size()) { throw std::runtime_error("The particles of the cloth are not in the particle set"); }
+
+    // Restriction, from the finest level to the coarsest
+    for (std::size_t l = 0; l < m_levels.size(); ++ l)
+    {
+        Level& level = m_levels[l];
+
+        for (std::size_t i = 0; i < level.restriction.size(); ++ i)
+        {
+            const Embedding& embedding = level.restriction[i];
+
+            Vector3 position = Vector3::Zero();
+            for (unsigned int k = 0; k < 3; ++ k)
+            {
+                const unsigned int index = embedding.vertices[k];
+                position += embedding.coords(k) * ((l == 0) ? particles.p[m_particle_offset + index] : m_levels[l - 1].positions[index]);
+            }
+
+            level.positions[i] = position;
+            level.initial_positions[i] = position;
+        }
+    }
+
+    // Projection and prolongation, from the coarsest level to the finest
+    for (std::size_t l = m_levels.size(); l -- > 0;)
+    {
+        Level& level = m_levels[l];
+
+        projectLevel(level);
+
+        for (std::size_t i = 0; i < level.prolongation.size(); ++ i)
+        {
+            const Embedding& embedding = level.prolongation[i];
+
+            Vector3 delta = Vector3::Zero();
+            for (unsigned int k = 0; k < 3; ++ k)
+            {
+                const unsigned int index = embedding.vertices[k];
+                delta += embedding.coords(k) * (level.positions[index] - level.initial_positions[index]);
+            }
+
+            if (l > 0)
+            {
+                if (m_levels[l - 1].inverse_masses[i] != 0.0) { m_levels[l - 1].positions[i] += delta; }
+            }
+            else if (!m_is_pinned[i])
+            {
+                particles.p[m_particle_offset + i] += delta;
+            }
+        }
+    }
+}
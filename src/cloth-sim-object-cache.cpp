@@ -0,0 +1,516 @@
+#include <elasty/cloth-sim-object.hpp>
+#include <elasty/constraint.hpp>
+#include <elasty/particle-set.hpp>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+    constexpr char cache_magic[8] = { 'E', 'L', 'A', 'S', 'T', 'Y', 'C', 'C' };
+    constexpr std::uint32_t cache_version = 6;
+    constexpr std::uint32_t cache_byte_order_mark = 0x01020304;
+
+    // The records below cover these constraint types; adding a type to
+    // ConstraintSet needs a new record and a new version
+    static_assert(elasty::ConstraintSet::num_types == 12, "Cache records should cover all the constraint types");
+
+    struct CacheHeader
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t byte_order_mark;
+        std::uint64_t num_particles;
+        std::uint64_t num_triangles;
+
+        // In the order of ConstraintSet
+        std::uint64_t num_constraints[elasty::ConstraintSet::num_types];
+    };
+
+    static_assert(sizeof(CacheHeader) == 128, "The cache header should not have padding");
+
+    // Fixed-layout records of the constraints; each type specializes this with
+    // the conversion from and to the constraint
+    template <typename Type>
+    struct CacheRecord;
+
+    template <>
+    struct CacheRecord<elasty::DistanceConstraint>
+    {
+        std::uint32_t indices[2];
+        double stiffness;
+        double compliance;
+        double rest_length;
+
+        static CacheRecord make(const elasty::DistanceConstraint& constraint)
+        {
+            return { {}, constraint.m_stiffness, constraint.m_compliance, constraint.getRestLength() };
+        }
+
+        elasty::DistanceConstraint restore(const elasty::ParticleSet& particles, const unsigned int offset) const
+        {
+            return elasty::DistanceConstraint(particles, offset + indices[0], offset + indices[1], stiffness, rest_length);
+        }
+    };
+
+    template <>
+    struct CacheRecord<elasty::BendingConstraint>
+    {
+        std::uint32_t indices[4];
+        double stiffness;
+        double compliance;
+        double dihedral_angle;
+
+        static CacheRecord make(const elasty::BendingConstraint& constraint)
+        {
+            return { {}, constraint.m_stiffness, constraint.m_compliance, constraint.getDihedralAngle() };
+        }
+
+        elasty::BendingConstraint restore(const elasty::ParticleSet& particles, const unsigned int offset) const
+        {
+            return elasty::BendingConstraint(particles, offset + indices[0], offset + indices[1], offset + indices[2], offset + indices[3], stiffness, dihedral_angle);
+        }
+    };
+
+    template <>
+    struct CacheRecord<elasty::IsometricBendingConstraint>
+    {
+        std::uint32_t indices[4];
+        double stiffness;
+        double compliance;
+        double K[4];
+        double scale;
+
+        static CacheRecord make(const elasty::IsometricBendingConstraint& constraint)
+        {
+            CacheRecord record = { {}, constraint.m_stiffness, constraint.m_compliance, {}, constraint.getScale() };
+            Eigen::Map<Eigen::Vector4d>(record.K) = constraint.getK().cast<double>();
+            return record;
+        }
+
+        elasty::IsometricBendingConstraint restore(const elasty::ParticleSet& particles, const unsigned int offset) const
+        {
+            return elasty::IsometricBendingConstraint(particles, offset + indices[0], offset + indices[1], offset + indices[2], offset + indices[3], stiffness, Eigen::Map<const Eigen::Vector4d>(K).cast<elasty::Scalar>(), scale);
+        }
+    };
+
+    template <>
+    struct CacheRecord<elasty::FixedPointConstraint>
+    {
+        std::uint32_t indices[1];
+        std::uint32_t padding;
+        double stiffness;
+        double compliance;
+        double point[3];
+
+        static CacheRecord make(const elasty::FixedPointConstraint& constraint)
+        {
+            CacheRecord record = { {}, 0, constraint.m_stiffness, constraint.m_compliance, {} };
+            Eigen::Map<Eigen::Vector3d>(record.point) = constraint.getPoint().cast<double>();
+            return record;
+        }
+
+        elasty::FixedPointConstraint restore(const elasty::ParticleSet& particles, const unsigned int offset) const
+        {
+            return elasty::FixedPointConstraint(particles, offset + indices[0], stiffness, Eigen::Map<const Eigen::Vector3d>(point).cast<elasty::Scalar>());
+        }
+    };
+
+    template <>
+    struct CacheRecord<elasty::EnvironmentalCollisionConstraint>
+    {
+        std::uint32_t indices[1];
+        std::uint32_t padding;
+        double stiffness;
+        double compliance;
+        double n[3];
+        double d;
+
+        static CacheRecord make(const elasty::EnvironmentalCollisionConstraint& constraint)
+        {
+            CacheRecord record = { {}, 0, constraint.m_stiffness, constraint.m_compliance, {}, constraint.getDistance() };
+            Eigen::Map<Eigen::Vector3d>(record.n) = constraint.getNormal().cast<double>();
+            return record;
+        }
+
+        elasty::EnvironmentalCollisionConstraint restore(const elasty::ParticleSet& particles, const unsigned int offset) const
+        {
+            return elasty::EnvironmentalCollisionConstraint(particles, offset + indices[0], stiffness, Eigen::Map<const Eigen::Vector3d>(n).cast<elasty::Scalar>(), d);
+        }
+    };
+
+    template <>
+    struct CacheRecord<elasty::ParticleCollisionConstraint>
+    {
+        std::uint32_t indices[2];
+        double stiffness;
+        double compliance;
+        double d;
+
+        static CacheRecord make(const elasty::ParticleCollisionConstraint& constraint)
+        {
+            return { {}, constraint.m_stiffness, constraint.m_compliance, constraint.getDistance() };
+        }
+
+        elasty::ParticleCollisionConstraint restore(const elasty::ParticleSet& particles, const unsigned int offset) const
+        {
+            return elasty::ParticleCollisionConstraint(particles, offset + indices[0], offset + indices[1], stiffness, d);
+        }
+    };
+
+    template <>
+    struct CacheRecord<elasty::PointTriangleCollisionConstraint>
+    {
+        std::uint32_t indices[4];
+        double stiffness;
+        double compliance;
+        double thickness;
+        double barycentric_coords[3];
+        double side;
+
+        static CacheRecord make(const elasty::PointTriangleCollisionConstraint& constraint)
+        {
+            CacheRecord record = { {}, constraint.m_stiffness, constraint.m_compliance, constraint.getThickness(), {}, constraint.getSide() };
+            Eigen::Map<Eigen::Vector3d>(record.barycentric_coords) = constraint.getBarycentricCoords().cast<double>();
+            return record;
+        }
+
+        elasty::PointTriangleCollisionConstraint restore(const elasty::ParticleSet& particles, const unsigned int offset) const
+        {
+            return elasty::PointTriangleCollisionConstraint(particles, offset + indices[0], offset + indices[1], offset + indices[2], offset + indices[3], stiffness, thickness, Eigen::Map<const Eigen::Vector3d>(barycentric_coords).cast<elasty::Scalar>(), side);
+        }
+    };
+
+    template <>
+    struct CacheRecord<elasty::LongRangeAttachmentConstraint>
+    {
+        std::uint32_t indices[1];
+        std::uint32_t padding;
+        double stiffness;
+        double compliance;
+        double attachment_point[3];
+        double d;
+
+        static CacheRecord make(const elasty::LongRangeAttachmentConstraint& constraint)
+        {
+            CacheRecord record = { {}, 0, constraint.m_stiffness, constraint.m_compliance, {}, constraint.getDistance() };
+            Eigen::Map<Eigen::Vector3d>(record.attachment_point) = constraint.getAttachmentPoint().cast<double>();
+            return record;
+        }
+
+        elasty::LongRangeAttachmentConstraint restore(const elasty::ParticleSet& particles, const unsigned int offset) const
+        {
+            return elasty::LongRangeAttachmentConstraint(particles, offset + indices[0], stiffness, Eigen::Map<const Eigen::Vector3d>(attachment_point).cast<elasty::Scalar>(), d);
+        }
+    };
+
+    template <>
+    struct CacheRecord<elasty::TriangleStrainConstraint>
+    {
+        std::uint32_t indices[3];
+        std::uint32_t padding;
+        double stiffness;
+        double compliance;
+        double inv_rest_matrix[4];
+        double rest_area;
+
+        static CacheRecord make(const elasty::TriangleStrainConstraint& constraint)
+        {
+            CacheRecord record = { {}, 0, constraint.m_stiffness, constraint.m_compliance, {}, constraint.getRestArea() };
+            Eigen::Map<Eigen::Matrix2d>(record.inv_rest_matrix) = constraint.getInverseRestMatrix().cast<double>();
+            return record;
+        }
+
+        elasty::TriangleStrainConstraint restore(const elasty::ParticleSet& particles, const unsigned int offset) const
+        {
+            return elasty::TriangleStrainConstraint(particles, offset + indices[0], offset + indices[1], offset + indices[2], stiffness, Eigen::Map<const Eigen::Matrix2d>(inv_rest_matrix).cast<elasty::Scalar>(), rest_area);
+        }
+    };
+
+    template <>
+    struct CacheRecord<elasty::TriangleAreaConstraint>
+    {
+        std::uint32_t indices[3];
+        std::uint32_t padding;
+        double stiffness;
+        double compliance;
+        double rest_area;
+
+        static CacheRecord make(const elasty::TriangleAreaConstraint& constraint)
+        {
+            return { {}, 0, constraint.m_stiffness, constraint.m_compliance, constraint.getRestArea() };
+        }
+
+        elasty::TriangleAreaConstraint restore(const elasty::ParticleSet& particles, const unsigned int offset) const
+        {
+            return elasty::TriangleAreaConstraint(particles, offset + indices[0], offset + indices[1], offset + indices[2], stiffness, rest_area);
+        }
+    };
+
+    template <>
+    struct CacheRecord<elasty::TetrahedronStrainConstraint>
+    {
+        std::uint32_t indices[4];
+        double stiffness;
+        double compliance;
+        double inv_rest_matrix[9];
+        double rest_volume;
+
+        static CacheRecord make(const elasty::TetrahedronStrainConstraint& constraint)
+        {
+            CacheRecord record = { {}, constraint.m_stiffness, constraint.m_compliance, {}, constraint.getRestVolume() };
+            Eigen::Map<Eigen::Matrix3d>(record.inv_rest_matrix) = constraint.getInverseRestMatrix().cast<double>();
+            return record;
+        }
+
+        elasty::TetrahedronStrainConstraint restore(const elasty::ParticleSet& particles, const unsigned int offset) const
+        {
+            return elasty::TetrahedronStrainConstraint(particles, offset + indices[0], offset + indices[1], offset + indices[2], offset + indices[3], stiffness, Eigen::Map<const Eigen::Matrix3d>(inv_rest_matrix).cast<elasty::Scalar>(), rest_volume);
+        }
+    };
+
+    template <>
+    struct CacheRecord<elasty::VolumeConstraint>
+    {
+        std::uint32_t indices[4];
+        double stiffness;
+        double compliance;
+        double rest_volume;
+
+        static CacheRecord make(const elasty::VolumeConstraint& constraint)
+        {
+            return { {}, constraint.m_stiffness, constraint.m_compliance, constraint.getRestVolume() };
+        }
+
+        elasty::VolumeConstraint restore(const elasty::ParticleSet& particles, const unsigned int offset) const
+        {
+            return elasty::VolumeConstraint(particles, offset + indices[0], offset + indices[1], offset + indices[2], offset + indices[3], stiffness, rest_volume);
+        }
+    };
+
+    static_assert(sizeof(CacheRecord<elasty::DistanceConstraint>) == 32, "Cache records should not have implicit padding");
+    static_assert(sizeof(CacheRecord<elasty::BendingConstraint>) == 40, "Cache records should not have implicit padding");
+    static_assert(sizeof(CacheRecord<elasty::IsometricBendingConstraint>) == 72, "Cache records should not have implicit padding");
+    static_assert(sizeof(CacheRecord<elasty::FixedPointConstraint>) == 48, "Cache records should not have implicit padding");
+    static_assert(sizeof(CacheRecord<elasty::EnvironmentalCollisionConstraint>) == 56, "Cache records should not have implicit padding");
+    static_assert(sizeof(CacheRecord<elasty::ParticleCollisionConstraint>) == 32, "Cache records should not have implicit padding");
+    static_assert(sizeof(CacheRecord<elasty::PointTriangleCollisionConstraint>) == 72, "Cache records should not have implicit padding");
+    static_assert(sizeof(CacheRecord<elasty::LongRangeAttachmentConstraint>) == 56, "Cache records should not have implicit padding");
+    static_assert(sizeof(CacheRecord<elasty::TriangleStrainConstraint>) == 72, "Cache records should not have implicit padding");
+    static_assert(sizeof(CacheRecord<elasty::TriangleAreaConstraint>) == 40, "Cache records should not have implicit padding");
+    static_assert(sizeof(CacheRecord<elasty::TetrahedronStrainConstraint>) == 112, "Cache records should not have implicit padding");
+    static_assert(sizeof(CacheRecord<elasty::VolumeConstraint>) == 40, "Cache records should not have implicit padding");
+
+    // All the sections have sizes of multiples of 8 bytes (the triangle list is
+    // padded), so every section starts at an 8-byte aligned offset
+    inline std::size_t calculatePaddedSize(const std::size_t size) { return (size + 7) / 8 * 8; }
+
+    class CacheReader
+    {
+    public:
+
+        CacheReader(const std::vector<char>& buffer) : m_buffer(buffer) {}
+
+        template <typename Type>
+        const Type* read(const std::size_t num_elements)
+        {
+            // Also rejects the counts whose sizes would overflow
+            if (num_elements > (m_buffer.size() - m_position) / sizeof(Type)) { throw std::runtime_error("The cache file is truncated"); }
+
+            const std::size_t size = calculatePaddedSize(sizeof(Type) * num_elements);
+            if (m_position + size > m_buffer.size()) { throw std::runtime_error("The cache file is truncated"); }
+
+            const Type* data = reinterpret_cast<const Type*>(m_buffer.data() + m_position);
+            m_position += size;
+            return data;
+        }
+
+    private:
+
+        const std::vector<char>& m_buffer;
+        std::size_t m_position = 0;
+    };
+}
+
+void elasty::ClothSimObject::writeCache(const std::string& cache_path, const ParticleSet& particles) const
+{
+    std::ofstream file(cache_path, std::ios::binary);
+    if (!file) { throw std::runtime_error("Failed to open " + cache_path); }
+
+    auto write = [&](const void* data, const std::size_t size)
+    {
+        static constexpr char zeros[8] = {};
+        file.write(static_cast<const char*>(data), size);
+        file.write(zeros, calculatePaddedSize(size) - size);
+    };
+
+    CacheHeader header = {};
+    std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+    header.version = cache_version;
+    header.byte_order_mark = cache_byte_order_mark;
+    header.num_particles = m_num_particles;
+    header.num_triangles = m_triangle_list.rows();
+
+    const std::vector<std::size_t> batch_sizes = m_constraints.getBatchSizes();
+    for (std::size_t i = 0; i < batch_sizes.size(); ++ i) { header.num_constraints[i] = batch_sizes[i]; }
+
+    write(&header, sizeof(CacheHeader));
+
+    // Particles
+    // The file stores doubles regardless of the precision of the build
+    std::vector<Eigen::Vector3d> x(m_num_particles);
+    std::vector<Eigen::Vector3d> v(m_num_particles);
+    std::vector<double> m(m_num_particles);
+    for (std::size_t i = 0; i < m_num_particles; ++ i)
+    {
+        x[i] = particles.x[m_particle_offset + i].cast<double>();
+        v[i] = particles.v[m_particle_offset + i].cast<double>();
+        m[i] = particles.m[m_particle_offset + i];
+    }
+    write(x.data(), sizeof(Eigen::Vector3d) * m_num_particles);
+    write(v.data(), sizeof(Eigen::Vector3d) * m_num_particles);
+    write(m.data(), sizeof(double) * m_num_particles);
+
+    // Triangles
+    write(m_triangle_list.data(), sizeof(int32_t) * m_triangle_list.size());
+
+    // Mapping to the OBJ vertices
+    static_assert(sizeof(unsigned int) == sizeof(std::uint32_t), "The mapping is stored as it is");
+    write(m_obj_vertex_indices.data(), sizeof(std::uint32_t) * m_num_particles);
+
+    // Constraints
+    m_constraints.forEachBatch([&](const auto& constraints)
+    {
+        using Type = typename std::decay_t<decltype(constraints)>::value_type;
+        using Record = CacheRecord<Type>;
+
+        std::vector<Record> records;
+        records.reserve(constraints.size());
+        for (const auto& constraint : constraints)
+        {
+            Record record = Record::make(constraint);
+            for (unsigned int j = 0; j < Type::num_particles; ++ j)
+            {
+                const unsigned int index = constraint.getIndices()[j];
+                if (index < m_particle_offset || index >= m_particle_offset + m_num_particles)
+                {
+                    throw std::runtime_error("A constraint refers to a particle that does not belong to the object");
+                }
+                record.indices[j] = index - m_particle_offset;
+            }
+            records.push_back(record);
+        }
+
+        write(records.data(), sizeof(Record) * records.size());
+    });
+
+    if (!file) { throw std::runtime_error("Failed to write " + cache_path); }
+}
+
+std::shared_ptr<elasty::ClothSimObject> elasty::ClothSimObject::readCache(const std::string& cache_path, ParticleSet& particles)
+{
+    // Read the whole file at once
+    std::ifstream file(cache_path, std::ios::binary | std::ios::ate);
+    if (!file) { throw std::runtime_error("Failed to open " + cache_path); }
+
+    std::vector<char> buffer(static_cast<std::size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(buffer.data(), buffer.size());
+    if (!file) { throw std::runtime_error("Failed to read " + cache_path); }
+
+    CacheReader reader(buffer);
+
+    const CacheHeader& header = *reader.read<CacheHeader>(1);
+    if (std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) != 0) { throw std::runtime_error(cache_path + " is not a cloth cache"); }
+    if (header.version != cache_version) { throw std::runtime_error(cache_path + " has an unsupported version"); }
+    if (header.byte_order_mark != cache_byte_order_mark) { throw std::runtime_error(cache_path + " has a different byte order"); }
+
+    // Read and validate all the sections before touching the particle set, so
+    // that a corrupted file leaves it as it is
+    // The counts are checked before they are multiplied, as a wrapped size
+    // would pass the bounds check of the reader
+    constexpr std::uint64_t max_count = std::numeric_limits<std::size_t>::max() / 3;
+    if (header.num_particles > max_count || header.num_triangles > max_count) { throw std::runtime_error(cache_path + " is corrupted"); }
+
+    const std::size_t num_particles = header.num_particles;
+    const std::size_t num_triangles = header.num_triangles;
+    const double* x = reader.read<double>(3 * num_particles);
+    const double* v = reader.read<double>(3 * num_particles);
+    const double* m = reader.read<double>(num_particles);
+
+    const int32_t* triangles = reader.read<int32_t>(3 * num_triangles);
+    for (std::size_t i = 0; i < 3 * num_triangles; ++ i)
+    {
+        if (triangles[i] < 0 || std::size_t(triangles[i]) >= num_particles) { throw std::runtime_error(cache_path + " is corrupted"); }
+    }
+
+    const std::uint32_t* obj_vertex_indices = reader.read<std::uint32_t>(num_particles);
+    for (std::size_t i = 0; i < num_particles; ++ i)
+    {
+        if (obj_vertex_indices[i] >= num_particles) { throw std::runtime_error(cache_path + " is corrupted"); }
+    }
+
+    std::shared_ptr<ClothSimObject> object(new ClothSimObject());
+
+    std::vector<const void*> batch_records;
+    std::size_t batch_index = 0;
+    object->m_constraints.forEachBatch([&](const auto& constraints)
+    {
+        using Type = typename std::decay_t<decltype(constraints)>::value_type;
+        using Record = CacheRecord<Type>;
+
+        const std::size_t num_constraints = header.num_constraints[batch_index ++];
+        const Record* records = reader.read<Record>(num_constraints);
+
+        for (std::size_t i = 0; i < num_constraints; ++ i)
+        {
+            for (unsigned int j = 0; j < Type::num_particles; ++ j)
+            {
+                if (records[i].indices[j] >= num_particles) { throw std::runtime_error(cache_path + " is corrupted"); }
+            }
+        }
+
+        batch_records.push_back(records);
+    });
+
+    object->m_particle_offset = particles.size();
+    object->m_num_particles = num_particles;
+
+    // Particles
+    particles.reserve(object->m_particle_offset + num_particles);
+    for (std::size_t i = 0; i < num_particles; ++ i)
+    {
+        particles.addParticle(Eigen::Map<const Eigen::Vector3d>(x + 3 * i).cast<Scalar>(), Eigen::Map<const Eigen::Vector3d>(v + 3 * i).cast<Scalar>(), Scalar(m[i]));
+    }
+
+    // Triangles
+    object->m_triangle_list = Eigen::Map<const TriangleList>(triangles, num_triangles, 3);
+    object->m_topology.build(object->m_triangle_list, object->m_num_particles);
+
+    // Mapping to the OBJ vertices
+    object->m_obj_vertex_indices.assign(obj_vertex_indices, obj_vertex_indices + num_particles);
+
+    // Constraints
+    batch_index = 0;
+    object->m_constraints.forEachBatch([&](auto& constraints)
+    {
+        using Type = typename std::decay_t<decltype(constraints)>::value_type;
+        using Record = CacheRecord<Type>;
+
+        const std::size_t num_constraints = header.num_constraints[batch_index];
+        const Record* records = static_cast<const Record*>(batch_records[batch_index ++]);
+
+        constraints.reserve(num_constraints);
+        for (std::size_t i = 0; i < num_constraints; ++ i)
+        {
+            constraints.push_back(records[i].restore(particles, object->m_particle_offset));
+            constraints.back().m_compliance = records[i].compliance;
+        }
+    });
+
+    return object;
+}
@@ -1,15 +1,23 @@
 #include <elasty/cloth-sim-object.hpp>
 #include <elasty/constraint.hpp>
-#include <elasty/particle.hpp>
+#include <elasty/particle-set.hpp>
+#include <elasty/thread-pool.hpp>
+#include <elasty/vertex-ordering.hpp>
+#include <algorithm>
 #include <iostream>
+#include <memory>
+#include <numeric>
 #include <Eigen/Geometry>
 #include <tiny_obj_loader.h>
 
 elasty::ClothSimObject::ClothSimObject(const std::string& obj_path,
-                                       const double distance_stiffness,
-                                       const double bending_stiffness,
+                                       ParticleSet& particles,
+                                       const Scalar distance_stiffness,
+                                       const Scalar bending_stiffness,
                                        const Eigen::Affine3d& transform,
-                                       const Strategy strategy)
+                                       const Strategy strategy,
+                                       const StretchStrategy stretch_strategy,
+                                       const ParticleOrder particle_order)
 {
     tinyobj::attrib_t attrib;
     std::vector<tinyobj::shape_t> shapes;
@@ -39,8 +47,11 @@ elasty::ClothSimObject::ClothSimObject(const std::string& obj_path,
         m_triangle_list(i, 2) = shape.mesh.indices[i * 3 + 2].vertex_index;
     }
 
-    std::map<unsigned int, std::shared_ptr<Particle>> map_from_obj_vertex_index_to_particle;
-    for (unsigned int i = 0; i < attrib.vertices.size() / 3; ++ i)
+    m_particle_offset = particles.size();
+    m_num_particles = attrib.vertices.size() / 3;
+
+    std::vector<Vector3> obj_positions(m_num_particles);
+    for (unsigned int i = 0; i < m_num_particles; ++ i)
     {
         const Eigen::Vector3d position
         {
@@ -49,149 +60,209 @@ elasty::ClothSimObject::ClothSimObject(const std::string& obj_path,
             attrib.vertices[3 * i + 2]
         };
 
-        const Eigen::Vector3d x = transform * position;
-        const Eigen::Vector3d v = Eigen::Vector3d::Zero();
-        const double m = 1.0 / double(attrib.vertices.size());
+        obj_positions[i] = (transform * position).cast<Scalar>();
+    }
+
+    // Building the topology of a large mesh is worth the thread start-up cost
+    constexpr unsigned int min_num_triangles_for_parallel_build = 1 << 16;
+    std::unique_ptr<ThreadPool> thread_pool;
+    if (m_triangle_list.rows() >= min_num_triangles_for_parallel_build) { thread_pool = std::make_unique<ThreadPool>(); }
+
+    switch (particle_order)
+    {
+        case ParticleOrder::Obj:
+        {
+            m_obj_vertex_indices.resize(m_num_particles);
+            std::iota(m_obj_vertex_indices.begin(), m_obj_vertex_indices.end(), 0);
+            break;
+        }
+        case ParticleOrder::Morton:
+        {
+            m_obj_vertex_indices = calculateMortonOrder(obj_positions);
+            break;
+        }
+        case ParticleOrder::ReverseCuthillMcKee:
+        {
+            // The traversal needs the adjacency of the OBJ vertices
+            m_topology.build(m_triangle_list, m_num_particles, thread_pool.get());
+            m_obj_vertex_indices = calculateReverseCuthillMcKeeOrder(m_topology, m_num_particles);
+            break;
+        }
+    }
+
+    const bool is_reordered = particle_order != ParticleOrder::Obj;
 
-        auto particle = std::make_shared<elasty::Particle>(x, v, m);
+    if (is_reordered)
+    {
+        const std::vector<unsigned int> local_indices = invertPermutation(m_obj_vertex_indices);
+        for (unsigned int i = 0; i < m_triangle_list.rows(); ++ i)
+        {
+            for (unsigned int k = 0; k < 3; ++ k) { m_triangle_list(i, k) = local_indices[m_triangle_list(i, k)]; }
+        }
 
-        map_from_obj_vertex_index_to_particle[i] = particle;
+        // The triangles (and thus the stretching constraints built from
+        // them) follow the particles
+        std::vector<unsigned int> triangle_order(m_triangle_list.rows());
+        std::iota(triangle_order.begin(), triangle_order.end(), 0);
+        std::stable_sort(triangle_order.begin(), triangle_order.end(), [&](const unsigned int a, const unsigned int b)
+        {
+            return m_triangle_list.row(a).minCoeff() < m_triangle_list.row(b).minCoeff();
+        });
 
-        m_particles.push_back(particle);
+        const TriangleList triangle_list = m_triangle_list;
+        for (unsigned int i = 0; i < triangle_order.size(); ++ i) { m_triangle_list.row(i) = triangle_list.row(triangle_order[i]); }
     }
 
-    for (unsigned int i = 0; i < shape.mesh.indices.size() / 3; ++ i)
+    particles.reserve(m_particle_offset + m_num_particles);
+
+    // The particles are appended in the local order, so a local vertex index
+    // (i.e., of the triangle list) is mapped to a particle index just by
+    // adding the offset
+    auto map_from_local_vertex_index_to_particle = [&](const unsigned int local_vertex_index)
     {
-        const auto p_0 = map_from_obj_vertex_index_to_particle[shape.mesh.indices[i * 3 + 0].vertex_index];
-        const auto p_1 = map_from_obj_vertex_index_to_particle[shape.mesh.indices[i * 3 + 1].vertex_index];
-        const auto p_2 = map_from_obj_vertex_index_to_particle[shape.mesh.indices[i * 3 + 2].vertex_index];
+        return m_particle_offset + local_vertex_index;
+    };
 
-        m_constraints.push_back(std::make_shared<elasty::DistanceConstraint>(p_0, p_1, distance_stiffness, (p_0->x - p_1->x).norm()));
-        m_constraints.push_back(std::make_shared<elasty::DistanceConstraint>(p_0, p_2, distance_stiffness, (p_0->x - p_2->x).norm()));
-        m_constraints.push_back(std::make_shared<elasty::DistanceConstraint>(p_1, p_2, distance_stiffness, (p_1->x - p_2->x).norm()));
+    for (unsigned int i = 0; i < m_num_particles; ++ i)
+    {
+        const Vector3& x = obj_positions[m_obj_vertex_indices[i]];
+        const Vector3 v = Vector3::Zero();
+        const Scalar m = 1.0 / Scalar(attrib.vertices.size());
+
+        particles.addParticle(x, v, m);
     }
 
+    m_topology.build(m_triangle_list, m_num_particles, thread_pool.get());
+
     using vertex_t = unsigned int;
-    using triangle_t = unsigned int;
-    using edge_t = std::pair<vertex_t, vertex_t>;
-    std::map<edge_t, std::vector<triangle_t>> edges_and_triangles;
-    for (unsigned int i = 0; i < shape.mesh.indices.size() / 3; ++ i)
+    using edge_t = MeshTopology::Edge;
+
+    auto add_distance_constraint = [&](const vertex_t vertex_0, const vertex_t vertex_1, const Scalar stiffness)
     {
-        const vertex_t index_0 = shape.mesh.indices[i * 3 + 0].vertex_index;
-        const vertex_t index_1 = shape.mesh.indices[i * 3 + 1].vertex_index;
-        const vertex_t index_2 = shape.mesh.indices[i * 3 + 2].vertex_index;
+        const unsigned int p_0 = map_from_local_vertex_index_to_particle(vertex_0);
+        const unsigned int p_1 = map_from_local_vertex_index_to_particle(vertex_1);
+
+        const Vector3& x_0 = particles.x[p_0];
+        const Vector3& x_1 = particles.x[p_1];
+
+        m_constraints.add(elasty::DistanceConstraint(particles, p_0, p_1, stiffness, (x_0 - x_1).norm()));
+    };
 
-        const edge_t e_01 = std::make_pair(std::min(index_0, index_1), std::max(index_0, index_1));
-        const edge_t e_02 = std::make_pair(std::min(index_0, index_2), std::max(index_0, index_2));
-        const edge_t e_12 = std::make_pair(std::min(index_1, index_2), std::max(index_1, index_2));
+    // A Gauss-Seidel projection of a constraint with stiffness k leaves (1 - k)
+    // of its violation, so the two projections of a duplicated constraint
+    // correspond to a single one with stiffness 1 - (1 - k)^2 (exactly only
+    // for an edge not coupled with the others)
+    const Scalar shared_edge_stiffness = 1.0 - (1.0 - distance_stiffness) * (1.0 - distance_stiffness);
 
-        auto register_edge = [&](const edge_t& edge)
+    for (unsigned int i = 0; i < m_triangle_list.rows(); ++ i)
+    {
+        const vertex_t index_0 = m_triangle_list(i, 0);
+        const vertex_t index_1 = m_triangle_list(i, 1);
+        const vertex_t index_2 = m_triangle_list(i, 2);
+
+        if (stretch_strategy == StretchStrategy::TriangleStrain || stretch_strategy == StretchStrategy::TriangleStrainAndArea)
         {
-            if (edges_and_triangles.find(edge) == edges_and_triangles.end())
-            {
-                edges_and_triangles[edge] =  { i };
-            }
-            else
+            const unsigned int p_0 = map_from_local_vertex_index_to_particle(index_0);
+            const unsigned int p_1 = map_from_local_vertex_index_to_particle(index_1);
+            const unsigned int p_2 = map_from_local_vertex_index_to_particle(index_2);
+
+            const elasty::TriangleStrainConstraint strain_constraint(particles, p_0, p_1, p_2, distance_stiffness);
+            m_constraints.add(strain_constraint);
+
+            if (stretch_strategy == StretchStrategy::TriangleStrainAndArea)
             {
-                edges_and_triangles[edge].push_back(i);
+                m_constraints.add(elasty::TriangleAreaConstraint(particles, p_0, p_1, p_2, distance_stiffness, strain_constraint.getRestArea()));
             }
-        };
+            continue;
+        }
 
-        register_edge(e_01);
-        register_edge(e_02);
-        register_edge(e_12);
-    }
+        if (stretch_strategy == StretchStrategy::DistancePerTriangle)
+        {
+            add_distance_constraint(index_0, index_1, distance_stiffness);
+            add_distance_constraint(index_0, index_2, distance_stiffness);
+            add_distance_constraint(index_1, index_2, distance_stiffness);
+            continue;
+        }
 
-    for (const auto& key_value : edges_and_triangles)
-    {
-        const edge_t& edge = key_value.first;
-        const std::vector<triangle_t>& triangles = key_value.second;
+        // Each edge is constrained once, when its first triangle is visited
+        for (const unsigned int k : { 2, 1, 0 })
+        {
+            const edge_t& edge = m_topology.getEdges()[m_topology.getTriangleEdges(i)[k]];
 
-        assert(triangles.size() == 1 || triangles.size() == 2);
+            if (edge.triangles[0] != i) { continue; }
 
-        // Boundary
-        if (triangles.size() == 1) { continue; }
+            const vertex_t vertex_0 = (k == 0) ? index_1 : index_0;
+            const vertex_t vertex_1 = (k == 2) ? index_1 : index_2;
 
-        auto obtain_another_vertex = [&](const triangle_t& triangle, const edge_t& edge)
-        {
-            const vertex_t vertex_0 = shape.mesh.indices[3 * triangle + 0].vertex_index;
-            const vertex_t vertex_1 = shape.mesh.indices[3 * triangle + 1].vertex_index;
-            const vertex_t vertex_2 = shape.mesh.indices[3 * triangle + 2].vertex_index;
+            add_distance_constraint(vertex_0, vertex_1, edge.isBoundary() ? distance_stiffness : shared_edge_stiffness);
+        }
+    }
 
-            if (vertex_0 != edge.first && vertex_0 != edge.second)
-            {
-                return vertex_0;
-            }
-            else if (vertex_1 != edge.first && vertex_1 != edge.second)
-            {
-                return vertex_1;
-            }
-            else
-            {
-                assert(vertex_2 != edge.first && vertex_2 != edge.second);
-                return vertex_2;
-            }
-        };
+    for (const edge_t& edge : m_topology.getEdges())
+    {
+        if (edge.isBoundary()) { continue; }
 
-        const triangle_t another_vertex_0 = obtain_another_vertex(triangles[0], edge);
-        const triangle_t another_vertex_1 = obtain_another_vertex(triangles[1], edge);
+        const vertex_t another_vertex_0 = edge.opposite_vertices[0];
+        const vertex_t another_vertex_1 = edge.opposite_vertices[1];
 
         switch (strategy)
         {
             case Strategy::Bending:
             {
-                const auto p_0 = map_from_obj_vertex_index_to_particle[edge.first];
-                const auto p_1 = map_from_obj_vertex_index_to_particle[edge.second];
-                const auto p_2 = map_from_obj_vertex_index_to_particle[another_vertex_0];
-                const auto p_3 = map_from_obj_vertex_index_to_particle[another_vertex_1];
+                const unsigned int p_0 = map_from_local_vertex_index_to_particle(edge.vertices[0]);
+                const unsigned int p_1 = map_from_local_vertex_index_to_particle(edge.vertices[1]);
+                const unsigned int p_2 = map_from_local_vertex_index_to_particle(another_vertex_0);
+                const unsigned int p_3 = map_from_local_vertex_index_to_particle(another_vertex_1);
 
-                const Eigen::Vector3d& x_0 = p_0->x;
-                const Eigen::Vector3d& x_1 = p_1->x;
-                const Eigen::Vector3d& x_2 = p_2->x;
-                const Eigen::Vector3d& x_3 = p_3->x;
+                const Vector3& x_0 = particles.x[p_0];
+                const Vector3& x_1 = particles.x[p_1];
+                const Vector3& x_2 = particles.x[p_2];
+                const Vector3& x_3 = particles.x[p_3];
 
-                const Eigen::Vector3d p_10 = x_1 - x_0;
-                const Eigen::Vector3d p_20 = x_2 - x_0;
-                const Eigen::Vector3d p_30 = x_3 - x_0;
+                const Vector3 p_10 = x_1 - x_0;
+                const Vector3 p_20 = x_2 - x_0;
+                const Vector3 p_30 = x_3 - x_0;
 
-                const Eigen::Vector3d n_0 = p_10.cross(p_20).normalized();
-                const Eigen::Vector3d n_1 = p_10.cross(p_30).normalized();
+                const Vector3 n_0 = p_10.cross(p_20).normalized();
+                const Vector3 n_1 = p_10.cross(p_30).normalized();
 
                 assert(!n_0.hasNaN());
                 assert(!n_1.hasNaN());
 
                 // Typical value is 0.0 or pi
-                const double dihedral_angle = std::acos(std::max(- 1.0, std::min(+ 1.0, n_0.dot(n_1))));
+                const Scalar dihedral_angle = std::acos(std::max(Scalar(- 1.0), std::min(Scalar(+ 1.0), n_0.dot(n_1))));
 
                 assert(!std::isnan(dihedral_angle));
 
-                m_constraints.push_back(std::make_shared<elasty::BendingConstraint>(p_0, p_1, p_2, p_3, bending_stiffness, dihedral_angle));
+                m_constraints.add(elasty::BendingConstraint(particles, p_0, p_1, p_2, p_3, bending_stiffness, dihedral_angle));
 
                 break;
             }
             case Strategy::IsometricBending:
             {
-                const auto p_0 = map_from_obj_vertex_index_to_particle[edge.first];
-                const auto p_1 = map_from_obj_vertex_index_to_particle[edge.second];
-                const auto p_2 = map_from_obj_vertex_index_to_particle[another_vertex_0];
-                const auto p_3 = map_from_obj_vertex_index_to_particle[another_vertex_1];
+                const unsigned int p_0 = map_from_local_vertex_index_to_particle(edge.vertices[0]);
+                const unsigned int p_1 = map_from_local_vertex_index_to_particle(edge.vertices[1]);
+                const unsigned int p_2 = map_from_local_vertex_index_to_particle(another_vertex_0);
+                const unsigned int p_3 = map_from_local_vertex_index_to_particle(another_vertex_1);
 
-                m_constraints.push_back(std::make_shared<elasty::IsometricBendingConstraint>(p_0, p_1, p_2, p_3, bending_stiffness));
+                m_constraints.add(elasty::IsometricBendingConstraint(particles, p_0, p_1, p_2, p_3, bending_stiffness));
 
                 break;
             }
             case Strategy::Cross:
             {
-                const auto p_2 = map_from_obj_vertex_index_to_particle[another_vertex_0];
-                const auto p_3 = map_from_obj_vertex_index_to_particle[another_vertex_1];
+                const unsigned int p_2 = map_from_local_vertex_index_to_particle(another_vertex_0);
+                const unsigned int p_3 = map_from_local_vertex_index_to_particle(another_vertex_1);
 
-                const Eigen::Vector3d& x_2 = p_2->x;
-                const Eigen::Vector3d& x_3 = p_3->x;
+                const Vector3& x_2 = particles.x[p_2];
+                const Vector3& x_3 = particles.x[p_3];
 
-                m_constraints.push_back(std::make_shared<elasty::DistanceConstraint>(p_2, p_3, bending_stiffness, (x_2 - x_3).norm()));
+                m_constraints.add(elasty::DistanceConstraint(particles, p_2, p_3, bending_stiffness, (x_2 - x_3).norm()));
 
                 break;
             }
         }
     }
+
+    if (is_reordered) { m_constraints.sortByFirstParticle(); }
 }
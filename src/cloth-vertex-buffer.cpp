@@ -0,0 +1,113 @@
+#include <elasty/cloth-vertex-buffer.hpp>
+#include <elasty/cloth-sim-object.hpp>
+#include <elasty/particle-set.hpp>
+#include <elasty/thread-pool.hpp>
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+
+elasty::ClothVertexBuffer::ClothVertexBuffer(std::shared_ptr<const ClothSimObject> cloth, const bool has_normals) :
+m_cloth(cloth),
+m_has_normals(has_normals)
+{
+    assert(m_cloth != nullptr);
+
+    m_positions.resize(3 * m_cloth->m_num_particles, 0.0f);
+
+    if (m_has_normals)
+    {
+        m_normals.resize(3 * m_cloth->m_num_particles, 0.0f);
+        m_face_normals.resize(3 * m_cloth->m_triangle_list.rows(), 0.0f);
+    }
+}
+
+void elasty::ClothVertexBuffer::update(const ParticleSet& particles, ThreadPool* thread_pool)
+{
+    const std::size_t num_vertices = getNumVertices();
+    const unsigned int offset = m_cloth->m_particle_offset;
+
+    if (offset + num_vertices > particles.size()) { throw std::runtime_error("The particles of the cloth are not in the particle set"); }
+
+    auto copy_positions = [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++ i)
+        {
+            const Vector3& x = particles.x[offset + i];
+            m_positions[3 * i + 0] = x(0);
+            m_positions[3 * i + 1] = x(1);
+            m_positions[3 * i + 2] = x(2);
+        }
+    };
+    if (thread_pool != nullptr) { thread_pool->parallelFor(0, num_vertices, copy_positions); } else { copy_positions(0, num_vertices); }
+
+    if (m_has_normals) { updateNormals(thread_pool); }
+
+    ++ m_revision;
+}
+
+void elasty::ClothVertexBuffer::updateNormals(ThreadPool* thread_pool)
+{
+    const auto& triangles = m_cloth->m_triangle_list;
+    const std::size_t num_triangles = triangles.rows();
+    const std::size_t num_vertices = getNumVertices();
+
+    // The face normals are computed once per triangle instead of once per
+    // vertex of it
+    auto compute_face_normals = [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t t = begin; t < end; ++ t)
+        {
+            const float* x_0 = m_positions.data() + 3 * triangles(t, 0);
+            const float* x_1 = m_positions.data() + 3 * triangles(t, 1);
+            const float* x_2 = m_positions.data() + 3 * triangles(t, 2);
+
+            const float e_1[3] = { x_1[0] - x_0[0], x_1[1] - x_0[1], x_1[2] - x_0[2] };
+            const float e_2[3] = { x_2[0] - x_0[0], x_2[1] - x_0[1], x_2[2] - x_0[2] };
+
+            m_face_normals[3 * t + 0] = e_1[1] * e_2[2] - e_1[2] * e_2[1];
+            m_face_normals[3 * t + 1] = e_1[2] * e_2[0] - e_1[0] * e_2[2];
+            m_face_normals[3 * t + 2] = e_1[0] * e_2[1] - e_1[1] * e_2[0];
+        }
+    };
+
+    // Each vertex gathers the normals of its own triangles, so that no two
+    // chunks write to the same vertex
+    const auto& offsets = m_cloth->m_topology.getVertexTriangleOffsets();
+    const auto& vertex_triangles = m_cloth->m_topology.getVertexTriangles();
+
+    assert(offsets.size() == num_vertices + 1);
+
+    auto accumulate_normals = [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t v = begin; v < end; ++ v)
+        {
+            float n[3] = { 0.0f, 0.0f, 0.0f };
+            for (unsigned int k = offsets[v]; k < offsets[v + 1]; ++ k)
+            {
+                const float* face_normal = m_face_normals.data() + 3 * vertex_triangles[k];
+                n[0] += face_normal[0];
+                n[1] += face_normal[1];
+                n[2] += face_normal[2];
+            }
+
+            // An isolated or fully degenerate vertex gets the zero normal
+            const float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            const float scale = length > 0.0f ? 1.0f / length : 0.0f;
+
+            m_normals[3 * v + 0] = scale * n[0];
+            m_normals[3 * v + 1] = scale * n[1];
+            m_normals[3 * v + 2] = scale * n[2];
+        }
+    };
+
+    if (thread_pool != nullptr)
+    {
+        thread_pool->parallelFor(0, num_triangles, compute_face_normals);
+        thread_pool->parallelFor(0, num_vertices, accumulate_normals);
+    }
+    else
+    {
+        compute_face_normals(0, num_triangles);
+        accumulate_normals(0, num_vertices);
+    }
+}
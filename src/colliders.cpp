@@ -0,0 +1,303 @@
+#include <elasty/colliders.hpp>
+#include <elasty/bvh.hpp>
+#include <elasty/particle-set.hpp>
+#include <elasty/thread-pool.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <tiny_obj_loader.h>
+
+elasty::Scalar elasty::SphereCollider::calculateSignedDistance(const Vector3& point, Vector3& normal) const
+{
+    const Vector3 r = point - center;
+    const Scalar norm = r.norm();
+
+    normal = (norm > 0.0) ? Vector3(r / norm) : Vector3::UnitY();
+
+    return norm - radius;
+}
+
+elasty::Scalar elasty::CapsuleCollider::calculateSignedDistance(const Vector3& point, Vector3& normal) const
+{
+    const Vector3 axis = end_1 - end_0;
+    const Scalar squared_length = axis.squaredNorm();
+    const Scalar t = (squared_length > 0.0) ? std::clamp(axis.dot(point - end_0) / squared_length, Scalar(0.0), Scalar(1.0)) : Scalar(0.0);
+
+    const Vector3 r = point - (end_0 + t * axis);
+    const Scalar norm = r.norm();
+
+    normal = (norm > 0.0) ? Vector3(r / norm) : Vector3::UnitY();
+
+    return norm - radius;
+}
+
+elasty::Scalar elasty::BoxCollider::calculateSignedDistance(const Vector3& point, Vector3& normal) const
+{
+    const Vector3 local_point = transform.inverse() * point;
+    const Vector3 q = local_point.cwiseAbs() - half_extents;
+
+    Vector3 local_normal;
+    Scalar signed_distance;
+
+    if ((q.array() > 0.0).any())
+    {
+        // Outside: the distance to the nearest point on the surface
+        const Vector3 outside = q.cwiseMax(0.0);
+        signed_distance = outside.norm();
+        local_normal = (outside.array() * local_point.array().sign()).matrix() / signed_distance;
+    }
+    else
+    {
+        // Inside: the distance to the nearest face
+        int axis;
+        signed_distance = q.maxCoeff(&axis);
+        local_normal = Vector3::Zero();
+        local_normal(axis) = (local_point(axis) < 0.0) ? - 1.0 : 1.0;
+    }
+
+    normal = transform.linear() * local_normal;
+
+    return signed_distance;
+}
+
+void elasty::SdfCollider::build(const std::vector<Vector3>& vertices,
+                                const MeshTopology::TriangleList& triangles,
+                                const Scalar cell_size,
+                                const Scalar margin,
+                                ThreadPool* thread_pool)
+{
+    if (vertices.empty() || triangles.rows() == 0) { throw std::runtime_error("Empty mesh for the signed distance field."); }
+    if (!(cell_size > 0.0)) { throw std::runtime_error("Non-positive cell size for the signed distance field."); }
+
+    TriangleBvh bvh;
+    bvh.build(vertices, triangles);
+
+    MeshTopology topology;
+    topology.build(triangles, static_cast<unsigned int>(vertices.size()));
+
+    // Angle-weighted pseudo normals of the faces, the edges, and the vertices
+    std::vector<Vector3> face_normals(triangles.rows());
+    std::vector<Vector3> vertex_normals(vertices.size(), Vector3::Zero());
+    for (int32_t t = 0; t < triangles.rows(); ++ t)
+    {
+        const Vector3& x_0 = vertices[triangles(t, 0)];
+        const Vector3& x_1 = vertices[triangles(t, 1)];
+        const Vector3& x_2 = vertices[triangles(t, 2)];
+
+        const Vector3 n = (x_1 - x_0).cross(x_2 - x_0).normalized();
+        face_normals[t] = n.hasNaN() ? Vector3::Zero() : n;
+
+        for (int k = 0; k < 3; ++ k)
+        {
+            const Vector3 e_0 = (vertices[triangles(t, (k + 1) % 3)] - vertices[triangles(t, k)]).normalized();
+            const Vector3 e_1 = (vertices[triangles(t, (k + 2) % 3)] - vertices[triangles(t, k)]).normalized();
+            const Scalar angle = std::acos(std::clamp(e_0.dot(e_1), Scalar(- 1.0), Scalar(1.0)));
+
+            if (std::isfinite(angle)) { vertex_normals[triangles(t, k)] += angle * face_normals[t]; }
+        }
+    }
+
+    std::vector<Vector3> edge_normals(topology.getEdges().size());
+    for (std::size_t e = 0; e < topology.getEdges().size(); ++ e)
+    {
+        const MeshTopology::Edge& edge = topology.getEdges()[e];
+        edge_normals[e] = face_normals[edge.triangles[0]];
+        if (!edge.isBoundary()) { edge_normals[e] += face_normals[edge.triangles[1]]; }
+    }
+
+    m_cell_size = cell_size;
+    m_box_min = bvh.getBoxMin() - Vector3::Constant(margin);
+
+    const Vector3 extent = bvh.getBoxMax() - bvh.getBoxMin() + Vector3::Constant(2.0 * margin);
+    m_resolution = (extent / cell_size).array().ceil().cast<int>() + 1;
+    m_resolution = m_resolution.cwiseMax(2);
+
+    const std::size_t num_nodes = std::size_t(m_resolution(0)) * std::size_t(m_resolution(1)) * std::size_t(m_resolution(2));
+    m_values.resize(num_nodes);
+
+    const std::size_t num_slices = std::size_t(m_resolution(2));
+
+    auto compute_slices = [&](const std::size_t begin, const std::size_t end)
+    {
+        for (std::size_t k = begin; k < end; ++ k)
+        {
+            for (int j = 0; j < m_resolution(1); ++ j)
+            {
+                for (int i = 0; i < m_resolution(0); ++ i)
+                {
+                    const Vector3 point = m_box_min + cell_size * Vector3(Scalar(i), Scalar(j), Scalar(k));
+                    const TriangleBvh::ClosestPoint closest_point = bvh.findClosestPoint(point);
+
+                    const auto& edges = topology.getTriangleEdges(closest_point.triangle);
+
+                    Vector3 pseudo_normal = face_normals[closest_point.triangle];
+                    if (closest_point.feature == TriangleBvh::Feature::Edge)
+                    {
+                        pseudo_normal = edge_normals[edges[closest_point.feature_index]];
+                    }
+                    else if (closest_point.feature == TriangleBvh::Feature::Vertex)
+                    {
+                        pseudo_normal = vertex_normals[triangles(closest_point.triangle, closest_point.feature_index)];
+                    }
+
+                    const Scalar distance = std::sqrt(closest_point.squared_distance);
+                    const Scalar sign = (pseudo_normal.dot(point - closest_point.point) < 0.0) ? - 1.0 : 1.0;
+
+                    m_values[(k * m_resolution(1) + j) * m_resolution(0) + i] = sign * distance;
+                }
+            }
+        }
+    };
+
+    if (thread_pool != nullptr) { thread_pool->parallelFor(0, num_slices, compute_slices); } else { compute_slices(0, num_slices); }
+}
+
+void elasty::SdfCollider::build(const std::string& obj_path,
+                                const Eigen::Affine3d& transform,
+                                const Scalar cell_size,
+                                const Scalar margin,
+                                ThreadPool* thread_pool)
+{
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+
+    std::string warn;
+    std::string err;
+    const bool return_value = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, obj_path.c_str());
+
+    if (!warn.empty()) { std::cerr << warn << std::endl; }
+    if (!err.empty()) { std::cerr << err << std::endl; }
+    if (!return_value) { throw std::runtime_error(""); }
+
+    std::vector<Vector3> vertices(attrib.vertices.size() / 3);
+    for (std::size_t i = 0; i < vertices.size(); ++ i)
+    {
+        vertices[i] = (transform * Eigen::Vector3d(attrib.vertices[3 * i + 0], attrib.vertices[3 * i + 1], attrib.vertices[3 * i + 2])).cast<Scalar>();
+    }
+
+    // All the shapes are merged into a single mesh (LoadObj triangulates the faces by default)
+    std::size_t num_indices = 0;
+    for (const auto& shape : shapes) { num_indices += shape.mesh.indices.size(); }
+
+    MeshTopology::TriangleList triangles(num_indices / 3, 3);
+    std::size_t row = 0;
+    for (const auto& shape : shapes)
+    {
+        for (std::size_t i = 0; i + 2 < shape.mesh.indices.size(); i += 3, ++ row)
+        {
+            triangles(row, 0) = shape.mesh.indices[i + 0].vertex_index;
+            triangles(row, 1) = shape.mesh.indices[i + 1].vertex_index;
+            triangles(row, 2) = shape.mesh.indices[i + 2].vertex_index;
+        }
+    }
+
+    build(vertices, triangles, cell_size, margin, thread_pool);
+}
+
+elasty::Scalar elasty::SdfCollider::calculateSignedDistance(const Vector3& point, Vector3& normal) const
+{
+    const Vector3 grid_point = (point - m_box_min) / m_cell_size;
+
+    if ((grid_point.array() < 0.0).any() || (grid_point.array() > (m_resolution.array() - 1).cast<Scalar>()).any())
+    {
+        normal = Vector3::UnitY();
+        return std::numeric_limits<Scalar>::infinity();
+    }
+
+    // The cell containing the point and the local coordinates in it
+    const Eigen::Vector3i cell = grid_point.cast<int>().cwiseMin(m_resolution - Eigen::Vector3i::Constant(2));
+    const Vector3 t = grid_point - cell.cast<Scalar>();
+
+    const int i = cell(0);
+    const int j = cell(1);
+    const int k = cell(2);
+
+    const Scalar v_000 = getValue(i, j, k);
+    const Scalar v_100 = getValue(i + 1, j, k);
+    const Scalar v_010 = getValue(i, j + 1, k);
+    const Scalar v_110 = getValue(i + 1, j + 1, k);
+    const Scalar v_001 = getValue(i, j, k + 1);
+    const Scalar v_101 = getValue(i + 1, j, k + 1);
+    const Scalar v_011 = getValue(i, j + 1, k + 1);
+    const Scalar v_111 = getValue(i + 1, j + 1, k + 1);
+
+    // Interpolate along x, then y, then z
+    const Scalar v_00 = v_000 + t(0) * (v_100 - v_000);
+    const Scalar v_10 = v_010 + t(0) * (v_110 - v_010);
+    const Scalar v_01 = v_001 + t(0) * (v_101 - v_001);
+    const Scalar v_11 = v_011 + t(0) * (v_111 - v_011);
+
+    const Scalar v_0 = v_00 + t(1) * (v_10 - v_00);
+    const Scalar v_1 = v_01 + t(1) * (v_11 - v_01);
+
+    const Scalar value = v_0 + t(2) * (v_1 - v_0);
+
+    // Analytic gradient of the trilinear interpolation
+    const Scalar d_x_0 = (v_100 - v_000) + t(1) * ((v_110 - v_010) - (v_100 - v_000));
+    const Scalar d_x_1 = (v_101 - v_001) + t(1) * ((v_111 - v_011) - (v_101 - v_001));
+    const Scalar d_y_0 = v_10 - v_00;
+    const Scalar d_y_1 = v_11 - v_01;
+
+    const Vector3 gradient(d_x_0 + t(2) * (d_x_1 - d_x_0),
+                                   d_y_0 + t(2) * (d_y_1 - d_y_0),
+                                   v_1 - v_0);
+
+    const Scalar norm = gradient.norm();
+    normal = (norm > 0.0) ? Vector3(gradient / norm) : Vector3::UnitY();
+
+    return value;
+}
+
+void elasty::ColliderSet::clear()
+{
+    m_spheres.clear();
+    m_capsules.clear();
+    m_boxes.clear();
+    m_sdfs.clear();
+}
+
+template <typename Collider>
+void elasty::ColliderSet::generateConstraintsForCollider(const Collider& collider,
+                                                         const ParticleSet& particles,
+                                                         ConstraintSet& constraints,
+                                                         ThreadPool* thread_pool)
+{
+    const std::size_t num_particles = particles.size();
+
+    // Evaluate the distance field for all the particles first, which can be
+    // done in parallel, and then emit the contacts in the particle order
+    auto evaluate = [&](const std::size_t begin, const std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++ i)
+        {
+            m_signed_distances[i] = collider.calculateSignedDistance(particles.p[i], m_normals[i]);
+        }
+    };
+
+    if (thread_pool != nullptr) { thread_pool->parallelFor(0, num_particles, evaluate); } else { evaluate(0, num_particles); }
+
+    for (std::size_t i = 0; i < num_particles; ++ i)
+    {
+        if (m_signed_distances[i] >= m_thickness || particles.w[i] == 0.0) { continue; }
+
+        // The tangent plane at the closest surface point, offset by the thickness
+        const Vector3& n = m_normals[i];
+        const Scalar d = n.dot(particles.p[i]) - m_signed_distances[i] + m_thickness;
+
+        constraints.emplace<EnvironmentalCollisionConstraint>(particles, static_cast<unsigned int>(i), m_stiffness, n, d);
+    }
+}
+
+void elasty::ColliderSet::generateConstraints(const ParticleSet& particles, ConstraintSet& constraints, ThreadPool* thread_pool)
+{
+    m_signed_distances.resize(particles.size());
+    m_normals.resize(particles.size());
+
+    for (const auto& sphere : m_spheres) { generateConstraintsForCollider(sphere, particles, constraints, thread_pool); }
+    for (const auto& capsule : m_capsules) { generateConstraintsForCollider(capsule, particles, constraints, thread_pool); }
+    for (const auto& box : m_boxes) { generateConstraintsForCollider(box, particles, constraints, thread_pool); }
+    for (const auto& sdf : m_sdfs) { generateConstraintsForCollider(*sdf, particles, constraints, thread_pool); }
+}
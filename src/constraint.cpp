@@ -1,14 +1,15 @@
 #include <elasty/constraint.hpp>
-#include <elasty/particle.hpp>
 #include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <Eigen/Geometry>
+#include <Eigen/LU>
 
 namespace
 {
-    inline Eigen::Matrix3d convert_vector_to_cross_operator(const Eigen::Vector3d& vec)
+    inline elasty::Matrix3 convert_vector_to_cross_operator(const elasty::Vector3& vec)
     {
-        Eigen::Matrix3d mat = Eigen::Matrix3d::Zero();
+        elasty::Matrix3 mat = elasty::Matrix3::Zero();
         mat(0, 1) = + vec(2);
         mat(0, 2) = - vec(1);
         mat(1, 0) = - vec(2);
@@ -18,190 +19,171 @@ namespace
         return mat;
     };
 
-    inline double calculateCotTheta(const Eigen::Vector3d& x, const Eigen::Vector3d& y)
+    inline elasty::Scalar calculateCotTheta(const elasty::Vector3& x, const elasty::Vector3& y)
     {
-        const double cos_theta = x.dot(y);
-        const double sin_theta = x.cross(y).norm();
+        const elasty::Scalar cos_theta = x.dot(y);
+        const elasty::Scalar sin_theta = x.cross(y).norm();
         return cos_theta / sin_theta;
     }
 
-    template<int Num>
-    void projectPositions(const double C,
-                          const Eigen::Matrix<double, Num * 3, 1>& grad_C,
-                          const Eigen::Matrix<double, Num * 3, 1>& inv_M,
-                          const double stiffness,
-                          std::vector<std::shared_ptr<elasty::Particle>>& particles)
+    // Calculate the strain constraint C = scale |E|_F of the deformation
+    // gradient F (3 x Dim) and its gradient w.r.t. the Dim + 1 particles
+    template <int Dim>
+    elasty::Scalar calculateStrainValueAndGrad(const Eigen::Matrix<elasty::Scalar, 3, Dim>& F,
+                                               const Eigen::Matrix<elasty::Scalar, Dim, Dim>& inv_rest_matrix,
+                                               const elasty::Scalar scale,
+                                               elasty::Scalar* grad_C)
     {
-        // Skip if the gradient is sufficiently small
-        if (grad_C.isApprox(Eigen::Matrix<double, Num * 3, 1>::Zero())) { return; }
+        using Matrix = Eigen::Matrix<elasty::Scalar, Dim, Dim>;
 
-        // Calculate $s$
-        const double s = C / (grad_C.transpose() * inv_M.asDiagonal() * grad_C);
+        const Matrix E = 0.5 * (F.transpose() * F - Matrix::Identity());
+        const elasty::Scalar E_norm = E.norm();
 
-        // Calculate $\Delta x$
-        const Eigen::Matrix<double, Num * 3, 1> delta_x = - s * inv_M.asDiagonal() * grad_C;
-        assert(!delta_x.hasNaN());
-
-        // Update predicted positions
-        for (unsigned int j = 0; j < Num; ++ j)
+        // The gradient is undefined at the rest shape, where the particles
+        // need not be moved anyway
+        if (!(E_norm > 0.0))
         {
-            particles[j]->p += stiffness * delta_x.segment(3 * j, 3);
+            std::fill(grad_C, grad_C + 3 * (Dim + 1), elasty::Scalar(0.0));
+            return 0.0;
         }
-    }
 
-    template<int Num>
-    Eigen::Matrix<double, Num * 3, 1> constructInverseMassMatrix(const std::vector<std::shared_ptr<elasty::Particle>>& particles)
-    {
-        Eigen::Matrix<double, Num * 3, 1> inv_M;
-        for (unsigned int j = 0; j < Num; ++ j)
-        {
-            inv_M(j * 3 + 0) = particles[j]->w;
-            inv_M(j * 3 + 1) = particles[j]->w;
-            inv_M(j * 3 + 2) = particles[j]->w;
-        }
-        return inv_M;
+        // dC/dF = scale F E / |E|_F, and the gradient w.r.t. the particles is
+        // its product with D_m^{-T}, where the first particle takes the
+        // negative sum of the others
+        const Eigen::Matrix<elasty::Scalar, 3, Dim> H = (scale / E_norm) * F * E * inv_rest_matrix.transpose();
+
+        const elasty::Vector3 grad_C_wrt_p_0 = - H.rowwise().sum();
+        std::memcpy(grad_C, grad_C_wrt_p_0.data(), sizeof(elasty::Scalar) * 3);
+        std::memcpy(grad_C + 3, H.data(), sizeof(elasty::Scalar) * 3 * Dim);
+
+        return scale * E_norm;
     }
 }
 
-elasty::BendingConstraint::BendingConstraint(const std::shared_ptr<Particle> p_0,
-                                             const std::shared_ptr<Particle> p_1,
-                                             const std::shared_ptr<Particle> p_2,
-                                             const std::shared_ptr<Particle> p_3,
-                                             const double stiffness,
-                                             const double dihedral_angle) :
-Constraint(std::vector<std::shared_ptr<Particle>>{ p_0, p_1, p_2, p_3 }, stiffness),
+elasty::BendingConstraint::BendingConstraint(const ParticleSet& particles,
+                                             const unsigned int index_0,
+                                             const unsigned int index_1,
+                                             const unsigned int index_2,
+                                             const unsigned int index_3,
+                                             const Scalar stiffness,
+                                             const Scalar dihedral_angle) :
+FixedNumConstraint(particles, { index_0, index_1, index_2, index_3 }, stiffness),
 m_dihedral_angle(dihedral_angle)
 {
 }
 
-void elasty::BendingConstraint::projectParticles()
-{
-    const double C = calculateValue();
-
-    Eigen::Matrix<double, 12, 1> grad_C;
-    calculateGrad(grad_C.data());
-
-    projectPositions<4>(C, grad_C, m_inv_M, m_stiffness, m_particles);
-}
-
-double elasty::BendingConstraint::calculateValue()
+elasty::Scalar elasty::BendingConstraint::calculateValue(const ParticleSet& particles) const
 {
-    const Eigen::Vector3d& x_0 = m_particles[0]->p;
-    const Eigen::Vector3d& x_1 = m_particles[1]->p;
-    const Eigen::Vector3d& x_2 = m_particles[2]->p;
-    const Eigen::Vector3d& x_3 = m_particles[3]->p;
+    const Vector3& x_0 = particles.p[m_indices[0]];
+    const Vector3& x_1 = particles.p[m_indices[1]];
+    const Vector3& x_2 = particles.p[m_indices[2]];
+    const Vector3& x_3 = particles.p[m_indices[3]];
 
-    const Eigen::Vector3d p_10 = x_1 - x_0;
-    const Eigen::Vector3d p_20 = x_2 - x_0;
-    const Eigen::Vector3d p_30 = x_3 - x_0;
+    const Vector3 p_10 = x_1 - x_0;
+    const Vector3 p_20 = x_2 - x_0;
+    const Vector3 p_30 = x_3 - x_0;
 
-    const Eigen::Vector3d n_0 = p_10.cross(p_20).normalized();
-    const Eigen::Vector3d n_1 = p_10.cross(p_30).normalized();
+    const Vector3 n_0 = p_10.cross(p_20).normalized();
+    const Vector3 n_1 = p_10.cross(p_30).normalized();
 
     assert(!n_0.hasNaN());
     assert(!n_1.hasNaN());
 
-    const double current_dihedral_angle = std::acos(std::min(+ 1.0, std::max(- 1.0, n_0.dot(n_1))));
+    const Scalar current_dihedral_angle = std::acos(std::min(Scalar(+ 1.0), std::max(Scalar(- 1.0), n_0.dot(n_1))));
 
     assert(!std::isnan(current_dihedral_angle));
 
     return current_dihedral_angle - m_dihedral_angle;
 }
 
-void elasty::BendingConstraint::calculateGrad(double* grad_C)
+void elasty::BendingConstraint::calculateGrad(const ParticleSet& particles, Scalar* grad_C) const
 {
-    const Eigen::Vector3d& x_0 = m_particles[0]->p;
-    const Eigen::Vector3d& x_1 = m_particles[1]->p;
-    const Eigen::Vector3d& x_2 = m_particles[2]->p;
-    const Eigen::Vector3d& x_3 = m_particles[3]->p;
+    calculateValueAndGrad(particles, grad_C);
+}
+
+elasty::Scalar elasty::BendingConstraint::calculateValueAndGrad(const ParticleSet& particles, Scalar* grad_C) const
+{
+    const Vector3& x_0 = particles.p[m_indices[0]];
+    const Vector3& x_1 = particles.p[m_indices[1]];
+    const Vector3& x_2 = particles.p[m_indices[2]];
+    const Vector3& x_3 = particles.p[m_indices[3]];
 
     // Assuming that p_0 = [ 0, 0, 0 ]^T without loss of generality
-    const Eigen::Vector3d p_1 = x_1 - x_0;
-    const Eigen::Vector3d p_2 = x_2 - x_0;
-    const Eigen::Vector3d p_3 = x_3 - x_0;
+    const Vector3 p_1 = x_1 - x_0;
+    const Vector3 p_2 = x_2 - x_0;
+    const Vector3 p_3 = x_3 - x_0;
 
-    const Eigen::Vector3d p_1_cross_p_2 = p_1.cross(p_2);
-    const Eigen::Vector3d p_1_cross_p_3 = p_1.cross(p_3);
+    const Vector3 p_1_cross_p_2 = p_1.cross(p_2);
+    const Vector3 p_1_cross_p_3 = p_1.cross(p_3);
 
-    const Eigen::Vector3d n_0 = p_1_cross_p_2.normalized();
-    const Eigen::Vector3d n_1 = p_1_cross_p_3.normalized();
+    const Scalar p_1_cross_p_2_norm = p_1_cross_p_2.norm();
+    const Scalar p_1_cross_p_3_norm = p_1_cross_p_3.norm();
+
+    const Vector3 n_0 = p_1_cross_p_2 / p_1_cross_p_2_norm;
+    const Vector3 n_1 = p_1_cross_p_3 / p_1_cross_p_3_norm;
+
+    assert(!n_0.hasNaN());
+    assert(!n_1.hasNaN());
 
-    const double d = n_0.dot(n_1);
+    const Scalar d = std::min(Scalar(+ 1.0), std::max(Scalar(- 1.0), n_0.dot(n_1)));
+    const Scalar C = std::acos(d) - m_dihedral_angle;
 
-    // If the dihedral angle is sufficiently small, return zeros
-    constexpr double epsilon = 1e-12;
-    if (std::abs(d) - 1.0 < epsilon)
+    // If the triangles are (almost) coplanar, where the derivative of acos
+    // diverges, return zeros
+    constexpr Scalar epsilon = 1e-12;
+    if (1.0 - std::abs(d) < epsilon)
     {
         std::fill(grad_C, grad_C + 12, 0.0);
-        return;
+        return C;
     }
 
-    const double common_coeff = - 1.0 / std::sqrt(1.0 - d * d);
+    const Scalar common_coeff = - 1.0 / std::sqrt(1.0 - d * d);
 
-    auto calculate_gradient_of_normalized_cross_product_wrt_p_1 = [](const Eigen::Vector3d& p_1,
-                                                                     const Eigen::Vector3d& p_2,
-                                                                     const Eigen::Vector3d& n)
-    -> Eigen::Matrix3d
-    {
-        return + (1.0 / p_1.cross(p_2).norm()) * (- convert_vector_to_cross_operator(p_2) + n * (n.cross(p_2)).transpose());
-    };
+    // The derivatives of d through each normal, where the derivative of a
+    // normalized cross product projects out its normal component
+    const Vector3 q_0 = (n_1 - d * n_0) / p_1_cross_p_2_norm;
+    const Vector3 q_1 = (n_0 - d * n_1) / p_1_cross_p_3_norm;
 
-    auto calculate_gradient_of_normalized_cross_product_wrt_p_2 = [](const Eigen::Vector3d& p_1,
-                                                                     const Eigen::Vector3d& p_2,
-                                                                     const Eigen::Vector3d& n)
-    -> Eigen::Matrix3d
-    {
-        return - (1.0 / p_1.cross(p_2).norm()) * (- convert_vector_to_cross_operator(p_1) + n * (n.cross(p_1)).transpose());
-    };
+    const Vector3 grad_C_wrt_p_1 = common_coeff * (p_2.cross(q_0) + p_3.cross(q_1));
+    const Vector3 grad_C_wrt_p_2 = common_coeff * q_0.cross(p_1);
+    const Vector3 grad_C_wrt_p_3 = common_coeff * q_1.cross(p_1);
+    const Vector3 grad_C_wrt_p_0 = - grad_C_wrt_p_1 - grad_C_wrt_p_2 - grad_C_wrt_p_3;
 
-    const Eigen::Vector3d grad_C_wrt_p_1 = common_coeff * (calculate_gradient_of_normalized_cross_product_wrt_p_1(n_0, p_1, p_2).transpose() * n_1 + calculate_gradient_of_normalized_cross_product_wrt_p_1(n_1, p_1, p_3).transpose() * n_0);
-    const Eigen::Vector3d grad_C_wrt_p_2 = common_coeff * calculate_gradient_of_normalized_cross_product_wrt_p_2(n_0, p_1, p_2).transpose() * n_1;
-    const Eigen::Vector3d grad_C_wrt_p_3 = common_coeff * calculate_gradient_of_normalized_cross_product_wrt_p_2(n_1, p_1, p_3).transpose() * n_0;
-    const Eigen::Vector3d grad_C_wrt_p_0 = - grad_C_wrt_p_1 - grad_C_wrt_p_2 - grad_C_wrt_p_3;
+    std::memcpy(grad_C + (3 * 0), grad_C_wrt_p_0.data(), sizeof(Scalar) * 3);
+    std::memcpy(grad_C + (3 * 1), grad_C_wrt_p_1.data(), sizeof(Scalar) * 3);
+    std::memcpy(grad_C + (3 * 2), grad_C_wrt_p_2.data(), sizeof(Scalar) * 3);
+    std::memcpy(grad_C + (3 * 3), grad_C_wrt_p_3.data(), sizeof(Scalar) * 3);
 
-    std::memcpy(grad_C + (3 * 0), grad_C_wrt_p_0.data(), sizeof(double) * 3);
-    std::memcpy(grad_C + (3 * 1), grad_C_wrt_p_1.data(), sizeof(double) * 3);
-    std::memcpy(grad_C + (3 * 2), grad_C_wrt_p_2.data(), sizeof(double) * 3);
-    std::memcpy(grad_C + (3 * 3), grad_C_wrt_p_3.data(), sizeof(double) * 3);
+    return C;
 }
 
-elasty::DistanceConstraint::DistanceConstraint(const std::shared_ptr<Particle> p_0,
-                                               const std::shared_ptr<Particle> p_1,
-                                               const double stiffness,
-                                               const double d) :
-Constraint(std::vector<std::shared_ptr<Particle>>{ p_0, p_1 }, stiffness),
-m_inv_M(constructInverseMassMatrix<2>(m_particles)),
+elasty::DistanceConstraint::DistanceConstraint(const ParticleSet& particles,
+                                               const unsigned int index_0,
+                                               const unsigned int index_1,
+                                               const Scalar stiffness,
+                                               const Scalar d) :
+FixedNumConstraint(particles, { index_0, index_1 }, stiffness),
 m_d(d)
 {
     assert(d >= 0.0);
 }
 
-void elasty::DistanceConstraint::projectParticles()
+elasty::Scalar elasty::DistanceConstraint::calculateValue(const ParticleSet& particles) const
 {
-    const double C = calculateValue();
-
-    Eigen::Matrix<double, 6, 1> grad_C;
-    calculateGrad(grad_C.data());
-
-    projectPositions<2>(C, grad_C, m_inv_M, m_stiffness, m_particles);
-}
-
-double elasty::DistanceConstraint::calculateValue()
-{
-    const Eigen::Vector3d& x_0 = m_particles[0]->p;
-    const Eigen::Vector3d& x_1 = m_particles[1]->p;
+    const Vector3& x_0 = particles.p[m_indices[0]];
+    const Vector3& x_1 = particles.p[m_indices[1]];
 
     return (x_0 - x_1).norm() - m_d;
 }
 
-void elasty::DistanceConstraint::calculateGrad(double* grad_C)
+void elasty::DistanceConstraint::calculateGrad(const ParticleSet& particles, Scalar* grad_C) const
 {
-    const Eigen::Vector3d& x_0 = m_particles[0]->p;
-    const Eigen::Vector3d& x_1 = m_particles[1]->p;
+    const Vector3& x_0 = particles.p[m_indices[0]];
+    const Vector3& x_1 = particles.p[m_indices[1]];
 
-    Eigen::Vector3d n = (x_0 - x_1).normalized();
+    Vector3 n = (x_0 - x_1).normalized();
 
-    if (n.hasNaN()) { n = Eigen::Vector3d::Random(3).normalized(); }
+    if (n.hasNaN()) { n = Vector3::Random(3).normalized(); }
 
     grad_C[0] = + n(0);
     grad_C[1] = + n(1);
@@ -211,139 +193,505 @@ void elasty::DistanceConstraint::calculateGrad(double* grad_C)
     grad_C[5] = - n(2);
 }
 
-elasty::EnvironmentalCollisionConstraint::EnvironmentalCollisionConstraint(const std::shared_ptr<Particle> p_0,
-                                                                           const double stiffness,
-                                                                           const Eigen::Vector3d& n,
-                                                                           const double d) :
-Constraint(std::vector<std::shared_ptr<Particle>>{ p_0 }, stiffness),
-m_inv_M(constructInverseMassMatrix<1>(m_particles)),
+elasty::EnvironmentalCollisionConstraint::EnvironmentalCollisionConstraint(const ParticleSet& particles,
+                                                                           const unsigned int index_0,
+                                                                           const Scalar stiffness,
+                                                                           const Vector3& n,
+                                                                           const Scalar d) :
+FixedNumConstraint(particles, { index_0 }, stiffness),
 m_n(n),
 m_d(d)
 {
 }
 
-void elasty::EnvironmentalCollisionConstraint::projectParticles()
+elasty::Scalar elasty::EnvironmentalCollisionConstraint::calculateValue(const ParticleSet& particles) const
 {
-    const double C = calculateValue();
+    const Vector3& x = particles.p[m_indices[0]];
+    return m_n.transpose() * x - m_d;
+}
 
-    if (C >= 0.0) { return; }
+void elasty::EnvironmentalCollisionConstraint::calculateGrad([[maybe_unused]] const ParticleSet& particles, Scalar* grad_C) const
+{
+    std::memcpy(grad_C, m_n.data(), sizeof(Scalar) * 3);
+}
 
-    Eigen::Vector3d grad_C;
-    calculateGrad(grad_C.data());
+elasty::FixedPointConstraint::FixedPointConstraint(const ParticleSet& particles,
+                                                   const unsigned int index_0,
+                                                   const Scalar stiffness,
+                                                   const Vector3& point) :
+FixedNumConstraint(particles, { index_0 }, stiffness),
+m_point(point)
+{
+}
 
-    projectPositions<1>(C, grad_C, m_inv_M, m_stiffness, m_particles);
+elasty::Scalar elasty::FixedPointConstraint::calculateValue(const ParticleSet& particles) const
+{
+    const Vector3& x = particles.p[m_indices[0]];
+    return (x - m_point).norm();
 }
 
-double elasty::EnvironmentalCollisionConstraint::calculateValue()
+void elasty::FixedPointConstraint::calculateGrad(const ParticleSet& particles, Scalar* grad_C) const
 {
-    const Eigen::Vector3d& x = m_particles[0]->p;
-    return m_n.transpose() * x - m_d;
+    const Vector3& x = particles.p[m_indices[0]];
+    const Vector3 n = (x - m_point).normalized();
+
+    if (n.hasNaN())
+    {
+        std::fill(grad_C, grad_C + 3, 0.0);
+        return;
+    }
+
+    std::memcpy(grad_C, n.data(), sizeof(Scalar) * 3);
 }
 
-void elasty::EnvironmentalCollisionConstraint::calculateGrad(double* grad_C)
+elasty::LongRangeAttachmentConstraint::LongRangeAttachmentConstraint(const ParticleSet& particles,
+                                                                     const unsigned int index_0,
+                                                                     const Scalar stiffness,
+                                                                     const Vector3& attachment_point,
+                                                                     const Scalar d) :
+FixedNumConstraint(particles, { index_0 }, stiffness),
+m_attachment_point(attachment_point),
+m_d(d)
 {
-    std::memcpy(grad_C, m_n.data(), sizeof(double) * 3);
 }
 
-elasty::FixedPointConstraint::FixedPointConstraint(const std::shared_ptr<Particle> p_0,
-                                                   const double stiffness,
-                                                   const Eigen::Vector3d& point) :
-Constraint(std::vector<std::shared_ptr<Particle>>{ p_0 }, stiffness),
-m_inv_M(constructInverseMassMatrix<1>(m_particles)),
-m_point(point)
+elasty::Scalar elasty::LongRangeAttachmentConstraint::calculateValue(const ParticleSet& particles) const
 {
+    const Vector3& x = particles.p[m_indices[0]];
+    return m_d - (x - m_attachment_point).norm();
 }
 
-void elasty::FixedPointConstraint::projectParticles()
+void elasty::LongRangeAttachmentConstraint::calculateGrad(const ParticleSet& particles, Scalar* grad_C) const
 {
-    const double C = calculateValue();
+    const Vector3& x = particles.p[m_indices[0]];
+    const Vector3 n = - (x - m_attachment_point).normalized();
 
-    Eigen::Vector3d grad_C;
-    calculateGrad(grad_C.data());
+    if (n.hasNaN())
+    {
+        std::fill(grad_C, grad_C + 3, 0.0);
+        return;
+    }
 
-    projectPositions<1>(C, grad_C, m_inv_M, m_stiffness, m_particles);
+    std::memcpy(grad_C, n.data(), sizeof(Scalar) * 3);
 }
 
-double elasty::FixedPointConstraint::calculateValue()
+elasty::IsometricBendingConstraint::IsometricBendingConstraint(const ParticleSet& particles,
+                                                               const unsigned int index_0,
+                                                               const unsigned int index_1,
+                                                               const unsigned int index_2,
+                                                               const unsigned int index_3,
+                                                               const Scalar stiffness) :
+FixedNumConstraint(particles, { index_0, index_1, index_2, index_3 }, stiffness)
 {
-    const Eigen::Vector3d& x = m_particles[0]->p;
-    return (x - m_point).norm();
+    const Vector3& x_0 = particles.x[index_0];
+    const Vector3& x_1 = particles.x[index_1];
+    const Vector3& x_2 = particles.x[index_2];
+    const Vector3& x_3 = particles.x[index_3];
+
+    const Vector3 e0 = x_1 - x_0;
+    const Vector3 e1 = x_2 - x_1;
+    const Vector3 e2 = x_0 - x_2;
+    const Vector3 e3 = x_3 - x_0;
+    const Vector3 e4 = x_1 - x_3;
+
+    const Scalar cot_01 = calculateCotTheta(e0, - e1);
+    const Scalar cot_02 = calculateCotTheta(e0, - e2);
+    const Scalar cot_03 = calculateCotTheta(e0, e3);
+    const Scalar cot_04 = calculateCotTheta(e0, e4);
+
+    m_K = Vector4(cot_01 + cot_04, cot_02 + cot_03, - cot_01 - cot_02, - cot_03 - cot_04);
+
+    const Scalar A_0 = 0.5 * e0.cross(e1).norm();
+    const Scalar A_1 = 0.5 * e0.cross(e3).norm();
+
+    m_scale = 3.0 / (A_0 + A_1);
 }
 
-void elasty::FixedPointConstraint::calculateGrad(double* grad_C)
+elasty::IsometricBendingConstraint::IsometricBendingConstraint(const ParticleSet& particles,
+                                                               const unsigned int index_0,
+                                                               const unsigned int index_1,
+                                                               const unsigned int index_2,
+                                                               const unsigned int index_3,
+                                                               const Scalar stiffness,
+                                                               const Vector4& K,
+                                                               const Scalar scale) :
+FixedNumConstraint(particles, { index_0, index_1, index_2, index_3 }, stiffness),
+m_K(K),
+m_scale(scale)
 {
-    const Eigen::Vector3d& x = m_particles[0]->p;
-    const Eigen::Vector3d n = (x - m_point).normalized();
+}
 
-    if (n.hasNaN()) { std::fill(grad_C, grad_C + 3, 0.0); }
+elasty::Vector3 elasty::IsometricBendingConstraint::calculateWeightedSum(const ParticleSet& particles) const
+{
+    // As K sums to zero, the sum does not depend on the origin, and taking
+    // the first particle as the origin avoids the cancellation of large
+    // coordinates
+    const Vector3& x_0 = particles.p[m_indices[0]];
 
-    std::memcpy(grad_C, n.data(), sizeof(double) * 3);
+    return m_K(1) * (particles.p[m_indices[1]] - x_0) + m_K(2) * (particles.p[m_indices[2]] - x_0) + m_K(3) * (particles.p[m_indices[3]] - x_0);
 }
 
-elasty::IsometricBendingConstraint::IsometricBendingConstraint(const std::shared_ptr<Particle> p_0,
-                                                               const std::shared_ptr<Particle> p_1,
-                                                               const std::shared_ptr<Particle> p_2,
-                                                               const std::shared_ptr<Particle> p_3,
-                                                               const double stiffness) :
-Constraint(std::vector<std::shared_ptr<Particle>>{ p_0, p_1, p_2, p_3 }, stiffness),
-m_inv_M(constructInverseMassMatrix<4>(m_particles))
+elasty::Scalar elasty::IsometricBendingConstraint::calculateValue(const ParticleSet& particles) const
 {
-    const Eigen::Vector3d& x_0 = p_0->x;
-    const Eigen::Vector3d& x_1 = p_1->x;
-    const Eigen::Vector3d& x_2 = p_2->x;
-    const Eigen::Vector3d& x_3 = p_3->x;
+    // C = (1 / 2) x^T Q x with Q = s K K^T, i.e., (s / 2) |sum_i K_i x_i|^2
+    const Vector3 v = calculateWeightedSum(particles);
+    return 0.5 * m_scale * v.squaredNorm();
+}
 
-    const Eigen::Vector3d e0 = x_1 - x_0;
-    const Eigen::Vector3d e1 = x_2 - x_1;
-    const Eigen::Vector3d e2 = x_0 - x_2;
-    const Eigen::Vector3d e3 = x_3 - x_0;
-    const Eigen::Vector3d e4 = x_1 - x_3;
+void elasty::IsometricBendingConstraint::calculateGrad(const ParticleSet& particles, Scalar* grad_C) const
+{
+    calculateValueAndGrad(particles, grad_C);
+}
 
-    const double cot_01 = calculateCotTheta(e0, - e1);
-    const double cot_02 = calculateCotTheta(e0, - e2);
-    const double cot_03 = calculateCotTheta(e0, e3);
-    const double cot_04 = calculateCotTheta(e0, e4);
+elasty::Scalar elasty::IsometricBendingConstraint::calculateValueAndGrad(const ParticleSet& particles, Scalar* grad_C) const
+{
+    const Vector3 v = calculateWeightedSum(particles);
+    const Vector3 s_v = m_scale * v;
 
-    const Eigen::Vector4d K = Eigen::Vector4d(cot_01 + cot_04, cot_02 + cot_03, - cot_01 - cot_02, - cot_03 - cot_04);
+    for (unsigned int i = 0; i < 4; ++ i)
+    {
+        const Vector3 grad_C_wrt_p_i = m_K(i) * s_v;
+        std::memcpy(grad_C + (3 * i), grad_C_wrt_p_i.data(), sizeof(Scalar) * 3);
+    }
 
-    const double A_0 = 0.5 * e0.cross(e1).norm();
-    const double A_1 = 0.5 * e0.cross(e3).norm();
+    return 0.5 * s_v.dot(v);
+}
 
-    m_Q = (3.0 / (A_0 + A_1)) * K * K.transpose();
+elasty::ParticleCollisionConstraint::ParticleCollisionConstraint(const ParticleSet& particles,
+                                                                 const unsigned int index_0,
+                                                                 const unsigned int index_1,
+                                                                 const Scalar stiffness,
+                                                                 const Scalar d) :
+FixedNumConstraint(particles, { index_0, index_1 }, stiffness),
+m_d(d)
+{
+    assert(d >= 0.0);
 }
 
-void elasty::IsometricBendingConstraint::projectParticles()
+elasty::Scalar elasty::ParticleCollisionConstraint::calculateValue(const ParticleSet& particles) const
 {
-    const double C = calculateValue();
+    const Vector3& x_0 = particles.p[m_indices[0]];
+    const Vector3& x_1 = particles.p[m_indices[1]];
+
+    return (x_0 - x_1).norm() - m_d;
+}
 
-    Eigen::Matrix<double, 12, 1> grad_C;
-    calculateGrad(grad_C.data());
+void elasty::ParticleCollisionConstraint::calculateGrad(const ParticleSet& particles, Scalar* grad_C) const
+{
+    const Vector3& x_0 = particles.p[m_indices[0]];
+    const Vector3& x_1 = particles.p[m_indices[1]];
 
-    projectPositions<4>(C, grad_C, m_inv_M, m_stiffness, m_particles);
+    Vector3 n = (x_0 - x_1).normalized();
+
+    if (n.hasNaN()) { n = Vector3::Random(3).normalized(); }
+
+    grad_C[0] = + n(0);
+    grad_C[1] = + n(1);
+    grad_C[2] = + n(2);
+    grad_C[3] = - n(0);
+    grad_C[4] = - n(1);
+    grad_C[5] = - n(2);
 }
 
-double elasty::IsometricBendingConstraint::calculateValue()
+elasty::PointTriangleCollisionConstraint::PointTriangleCollisionConstraint(const ParticleSet& particles,
+                                                                           const unsigned int index_0,
+                                                                           const unsigned int index_1,
+                                                                           const unsigned int index_2,
+                                                                           const unsigned int index_3,
+                                                                           const Scalar stiffness,
+                                                                           const Scalar thickness,
+                                                                           const Vector3& barycentric_coords,
+                                                                           const Scalar side) :
+FixedNumConstraint(particles, { index_0, index_1, index_2, index_3 }, stiffness),
+m_thickness(thickness),
+m_barycentric_coords(barycentric_coords),
+m_side(side)
 {
-    double sum = 0.0;
-    for (unsigned int i = 0; i < 4; ++ i)
+    assert(thickness >= 0.0);
+    assert(side == + 1.0 || side == - 1.0);
+}
+
+elasty::Vector3 elasty::PointTriangleCollisionConstraint::calculateSideNormal(const ParticleSet& particles) const
+{
+    const Vector3& x_1 = particles.p[m_indices[1]];
+    const Vector3& x_2 = particles.p[m_indices[2]];
+    const Vector3& x_3 = particles.p[m_indices[3]];
+
+    return m_side * (x_2 - x_1).cross(x_3 - x_1).normalized();
+}
+
+elasty::Scalar elasty::PointTriangleCollisionConstraint::calculateValue(const ParticleSet& particles) const
+{
+    const Vector3 n = calculateSideNormal(particles);
+
+    // A degenerate triangle does not push the particle
+    if (n.hasNaN()) { return 0.0; }
+
+    const Vector3 contact_point = m_barycentric_coords(0) * particles.p[m_indices[1]] +
+                                          m_barycentric_coords(1) * particles.p[m_indices[2]] +
+                                          m_barycentric_coords(2) * particles.p[m_indices[3]];
+
+    return n.dot(particles.p[m_indices[0]] - contact_point) - m_thickness;
+}
+
+void elasty::PointTriangleCollisionConstraint::calculateGrad(const ParticleSet& particles, Scalar* grad_C) const
+{
+    const Vector3 n = calculateSideNormal(particles);
+
+    if (n.hasNaN())
     {
-        for (unsigned int j = 0; j < 4; ++ j)
-        {
-            sum += m_Q(i, j) * double(m_particles[i]->p.transpose() * m_particles[j]->p);
-        }
+        std::fill(grad_C, grad_C + 12, 0.0);
+        return;
     }
-    return 0.5 * sum;
+
+    const Vector3 grad_C_wrt_x_0 = n;
+    const Vector3 grad_C_wrt_x_1 = - m_barycentric_coords(0) * n;
+    const Vector3 grad_C_wrt_x_2 = - m_barycentric_coords(1) * n;
+    const Vector3 grad_C_wrt_x_3 = - m_barycentric_coords(2) * n;
+
+    std::memcpy(grad_C + (3 * 0), grad_C_wrt_x_0.data(), sizeof(Scalar) * 3);
+    std::memcpy(grad_C + (3 * 1), grad_C_wrt_x_1.data(), sizeof(Scalar) * 3);
+    std::memcpy(grad_C + (3 * 2), grad_C_wrt_x_2.data(), sizeof(Scalar) * 3);
+    std::memcpy(grad_C + (3 * 3), grad_C_wrt_x_3.data(), sizeof(Scalar) * 3);
 }
 
-void elasty::IsometricBendingConstraint::calculateGrad(double* grad_C)
+elasty::TetrahedronStrainConstraint::TetrahedronStrainConstraint(const ParticleSet& particles,
+                                                                 const unsigned int index_0,
+                                                                 const unsigned int index_1,
+                                                                 const unsigned int index_2,
+                                                                 const unsigned int index_3,
+                                                                 const Scalar stiffness) :
+FixedNumConstraint(particles, { index_0, index_1, index_2, index_3 }, stiffness)
 {
-    for (unsigned int i = 0; i < 4; ++ i)
+    const Vector3& x_0 = particles.x[index_0];
+
+    Matrix3 rest_matrix;
+    rest_matrix.col(0) = particles.x[index_1] - x_0;
+    rest_matrix.col(1) = particles.x[index_2] - x_0;
+    rest_matrix.col(2) = particles.x[index_3] - x_0;
+
+    const Scalar determinant = rest_matrix.determinant();
+
+    assert(determinant != 0.0);
+
+    m_inv_rest_matrix = rest_matrix.inverse();
+    m_rest_volume = std::abs(determinant) / 6.0;
+}
+
+elasty::TetrahedronStrainConstraint::TetrahedronStrainConstraint(const ParticleSet& particles,
+                                                                 const unsigned int index_0,
+                                                                 const unsigned int index_1,
+                                                                 const unsigned int index_2,
+                                                                 const unsigned int index_3,
+                                                                 const Scalar stiffness,
+                                                                 const Matrix3& inv_rest_matrix,
+                                                                 const Scalar rest_volume) :
+FixedNumConstraint(particles, { index_0, index_1, index_2, index_3 }, stiffness),
+m_inv_rest_matrix(inv_rest_matrix),
+m_rest_volume(rest_volume)
+{
+}
+
+elasty::Matrix3 elasty::TetrahedronStrainConstraint::calculateDeformationGradient(const ParticleSet& particles) const
+{
+    const Vector3& x_0 = particles.p[m_indices[0]];
+
+    Matrix3 deformed_matrix;
+    deformed_matrix.col(0) = particles.p[m_indices[1]] - x_0;
+    deformed_matrix.col(1) = particles.p[m_indices[2]] - x_0;
+    deformed_matrix.col(2) = particles.p[m_indices[3]] - x_0;
+
+    return deformed_matrix * m_inv_rest_matrix;
+}
+
+elasty::Scalar elasty::TetrahedronStrainConstraint::calculateValue(const ParticleSet& particles) const
+{
+    const Matrix3 F = calculateDeformationGradient(particles);
+    const Matrix3 E = 0.5 * (F.transpose() * F - Matrix3::Identity());
+
+    return std::sqrt(m_rest_volume) * E.norm();
+}
+
+void elasty::TetrahedronStrainConstraint::calculateGrad(const ParticleSet& particles, Scalar* grad_C) const
+{
+    calculateValueAndGrad(particles, grad_C);
+}
+
+elasty::Scalar elasty::TetrahedronStrainConstraint::calculateValueAndGrad(const ParticleSet& particles, Scalar* grad_C) const
+{
+    return calculateStrainValueAndGrad<3>(calculateDeformationGradient(particles), m_inv_rest_matrix, std::sqrt(m_rest_volume), grad_C);
+}
+
+elasty::TriangleAreaConstraint::TriangleAreaConstraint(const ParticleSet& particles,
+                                                       const unsigned int index_0,
+                                                       const unsigned int index_1,
+                                                       const unsigned int index_2,
+                                                       const Scalar stiffness,
+                                                       const Scalar rest_area) :
+FixedNumConstraint(particles, { index_0, index_1, index_2 }, stiffness),
+m_rest_area(rest_area)
+{
+    assert(rest_area >= 0.0);
+}
+
+elasty::Scalar elasty::TriangleAreaConstraint::calculateValue(const ParticleSet& particles) const
+{
+    const Vector3& x_0 = particles.p[m_indices[0]];
+    const Vector3& x_1 = particles.p[m_indices[1]];
+    const Vector3& x_2 = particles.p[m_indices[2]];
+
+    return 0.5 * (x_1 - x_0).cross(x_2 - x_0).norm() - m_rest_area;
+}
+
+void elasty::TriangleAreaConstraint::calculateGrad(const ParticleSet& particles, Scalar* grad_C) const
+{
+    calculateValueAndGrad(particles, grad_C);
+}
+
+elasty::Scalar elasty::TriangleAreaConstraint::calculateValueAndGrad(const ParticleSet& particles, Scalar* grad_C) const
+{
+    const Vector3& x_0 = particles.p[m_indices[0]];
+
+    const Vector3 e_1 = particles.p[m_indices[1]] - x_0;
+    const Vector3 e_2 = particles.p[m_indices[2]] - x_0;
+
+    const Vector3 normal = e_1.cross(e_2);
+    const Scalar normal_norm = normal.norm();
+
+    // A degenerate triangle has no direction to grow in
+    if (!(normal_norm > 0.0))
     {
-        Eigen::Vector3d sum = Eigen::Vector3d::Zero();
-        for (unsigned int j = 0; j < 4; ++ j)
-        {
-            sum += m_Q(i, j) * m_particles[j]->p;
-        }
-        std::memcpy(grad_C + (3 * i), sum.data(), sizeof(double) * 3);
+        std::fill(grad_C, grad_C + 9, Scalar(0.0));
+        return - m_rest_area;
     }
+
+    const Vector3 n = normal / normal_norm;
+
+    const Vector3 grad_C_wrt_p_1 = 0.5 * e_2.cross(n);
+    const Vector3 grad_C_wrt_p_2 = 0.5 * n.cross(e_1);
+    const Vector3 grad_C_wrt_p_0 = - grad_C_wrt_p_1 - grad_C_wrt_p_2;
+
+    std::memcpy(grad_C + (3 * 0), grad_C_wrt_p_0.data(), sizeof(Scalar) * 3);
+    std::memcpy(grad_C + (3 * 1), grad_C_wrt_p_1.data(), sizeof(Scalar) * 3);
+    std::memcpy(grad_C + (3 * 2), grad_C_wrt_p_2.data(), sizeof(Scalar) * 3);
+
+    return 0.5 * normal_norm - m_rest_area;
+}
+
+elasty::TriangleStrainConstraint::TriangleStrainConstraint(const ParticleSet& particles,
+                                                           const unsigned int index_0,
+                                                           const unsigned int index_1,
+                                                           const unsigned int index_2,
+                                                           const Scalar stiffness) :
+FixedNumConstraint(particles, { index_0, index_1, index_2 }, stiffness)
+{
+    const Vector3& x_0 = particles.x[index_0];
+
+    const Vector3 e_1 = particles.x[index_1] - x_0;
+    const Vector3 e_2 = particles.x[index_2] - x_0;
+
+    // An orthonormal frame of the rest triangle, whose first axis is along
+    // the first edge
+    const Vector3 u = e_1.normalized();
+    const Vector3 v = e_1.cross(e_2).cross(e_1).normalized();
+
+    assert(!u.hasNaN() && !v.hasNaN());
+
+    Matrix2 rest_matrix;
+    rest_matrix << e_1.dot(u), e_2.dot(u),
+                   0.0,        e_2.dot(v);
+
+    m_inv_rest_matrix = rest_matrix.inverse();
+    m_rest_area = 0.5 * rest_matrix.determinant();
+}
+
+elasty::TriangleStrainConstraint::TriangleStrainConstraint(const ParticleSet& particles,
+                                                           const unsigned int index_0,
+                                                           const unsigned int index_1,
+                                                           const unsigned int index_2,
+                                                           const Scalar stiffness,
+                                                           const Matrix2& inv_rest_matrix,
+                                                           const Scalar rest_area) :
+FixedNumConstraint(particles, { index_0, index_1, index_2 }, stiffness),
+m_inv_rest_matrix(inv_rest_matrix),
+m_rest_area(rest_area)
+{
+}
+
+Eigen::Matrix<elasty::Scalar, 3, 2> elasty::TriangleStrainConstraint::calculateDeformationGradient(const ParticleSet& particles) const
+{
+    const Vector3& x_0 = particles.p[m_indices[0]];
+
+    Eigen::Matrix<Scalar, 3, 2> deformed_matrix;
+    deformed_matrix.col(0) = particles.p[m_indices[1]] - x_0;
+    deformed_matrix.col(1) = particles.p[m_indices[2]] - x_0;
+
+    return deformed_matrix * m_inv_rest_matrix;
+}
+
+elasty::Scalar elasty::TriangleStrainConstraint::calculateValue(const ParticleSet& particles) const
+{
+    const Eigen::Matrix<Scalar, 3, 2> F = calculateDeformationGradient(particles);
+    const Matrix2 E = 0.5 * (F.transpose() * F - Matrix2::Identity());
+
+    return std::sqrt(m_rest_area) * E.norm();
+}
+
+void elasty::TriangleStrainConstraint::calculateGrad(const ParticleSet& particles, Scalar* grad_C) const
+{
+    calculateValueAndGrad(particles, grad_C);
+}
+
+elasty::Scalar elasty::TriangleStrainConstraint::calculateValueAndGrad(const ParticleSet& particles, Scalar* grad_C) const
+{
+    return calculateStrainValueAndGrad<2>(calculateDeformationGradient(particles), m_inv_rest_matrix, std::sqrt(m_rest_area), grad_C);
+}
+
+elasty::VolumeConstraint::VolumeConstraint(const ParticleSet& particles,
+                                           const unsigned int index_0,
+                                           const unsigned int index_1,
+                                           const unsigned int index_2,
+                                           const unsigned int index_3,
+                                           const Scalar stiffness,
+                                           const Scalar rest_volume) :
+FixedNumConstraint(particles, { index_0, index_1, index_2, index_3 }, stiffness),
+m_rest_volume(rest_volume)
+{
+}
+
+elasty::Scalar elasty::VolumeConstraint::calculateValue(const ParticleSet& particles) const
+{
+    const Vector3& x_0 = particles.p[m_indices[0]];
+
+    const Vector3 e_1 = particles.p[m_indices[1]] - x_0;
+    const Vector3 e_2 = particles.p[m_indices[2]] - x_0;
+    const Vector3 e_3 = particles.p[m_indices[3]] - x_0;
+
+    return e_1.dot(e_2.cross(e_3)) / 6.0 - m_rest_volume;
+}
+
+void elasty::VolumeConstraint::calculateGrad(const ParticleSet& particles, Scalar* grad_C) const
+{
+    calculateValueAndGrad(particles, grad_C);
+}
+
+elasty::Scalar elasty::VolumeConstraint::calculateValueAndGrad(const ParticleSet& particles, Scalar* grad_C) const
+{
+    const Vector3& x_0 = particles.p[m_indices[0]];
+
+    const Vector3 e_1 = particles.p[m_indices[1]] - x_0;
+    const Vector3 e_2 = particles.p[m_indices[2]] - x_0;
+    const Vector3 e_3 = particles.p[m_indices[3]] - x_0;
+
+    const Vector3 grad_C_wrt_p_1 = e_2.cross(e_3) / 6.0;
+    const Vector3 grad_C_wrt_p_2 = e_3.cross(e_1) / 6.0;
+    const Vector3 grad_C_wrt_p_3 = e_1.cross(e_2) / 6.0;
+    const Vector3 grad_C_wrt_p_0 = - grad_C_wrt_p_1 - grad_C_wrt_p_2 - grad_C_wrt_p_3;
+
+    std::memcpy(grad_C + (3 * 0), grad_C_wrt_p_0.data(), sizeof(Scalar) * 3);
+    std::memcpy(grad_C + (3 * 1), grad_C_wrt_p_1.data(), sizeof(Scalar) * 3);
+    std::memcpy(grad_C + (3 * 2), grad_C_wrt_p_2.data(), sizeof(Scalar) * 3);
+    std::memcpy(grad_C + (3 * 3), grad_C_wrt_p_3.data(), sizeof(Scalar) * 3);
+
+    return grad_C_wrt_p_1.dot(e_1) - m_rest_volume;
 }
@@ -0,0 +1,391 @@
+#include <elasty/device-solver.hpp>
+#include <cuda_runtime.h>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    using elasty::Scalar;
+    using elasty::device::Contact;
+    using elasty::device::Record;
+    using elasty::device::Vec3;
+
+    void check(const cudaError_t error, const char* what)
+    {
+        if (error != cudaSuccess) { throw std::runtime_error(std::string(what) + ": " + cudaGetErrorString(error)); }
+    }
+
+    // An array in the device memory
+    template <typename T>
+    class DeviceBuffer
+    {
+    public:
+
+        DeviceBuffer() = default;
+        DeviceBuffer(const DeviceBuffer&) = delete;
+        DeviceBuffer& operator=(const DeviceBuffer&) = delete;
+
+        ~DeviceBuffer() { cudaFree(m_data); }
+
+        void resize(const std::size_t size)
+        {
+            if (size == m_size) { return; }
+
+            cudaFree(m_data);
+            m_data = nullptr;
+            m_size = size;
+
+            if (size != 0) { check(cudaMalloc(&m_data, sizeof(T) * size), "cudaMalloc"); }
+        }
+
+        void upload(const std::vector<T>& values)
+        {
+            resize(values.size());
+            if (m_size != 0) { check(cudaMemcpy(m_data, values.data(), sizeof(T) * m_size, cudaMemcpyHostToDevice), "cudaMemcpy"); }
+        }
+
+        void download(std::vector<T>& values) const
+        {
+            values.resize(m_size);
+            if (m_size != 0) { check(cudaMemcpy(values.data(), m_data, sizeof(T) * m_size, cudaMemcpyDeviceToHost), "cudaMemcpy"); }
+        }
+
+        void fill(const int value)
+        {
+            if (m_size != 0) { check(cudaMemset(m_data, value, sizeof(T) * m_size), "cudaMemset"); }
+        }
+
+        T* data() { return m_data; }
+        const T* data() const { return m_data; }
+        std::size_t size() const { return m_size; }
+
+    private:
+
+        T* m_data = nullptr;
+        std::size_t m_size = 0;
+    };
+
+    constexpr unsigned int block_size = 128;
+
+    inline unsigned int getNumBlocks(const std::size_t num_threads)
+    {
+        return static_cast<unsigned int>((num_threads + block_size - 1) / block_size);
+    }
+
+    __global__ void integrateKernel(Vec3* x,
+                                    Vec3* v,
+                                    const Vec3* f,
+                                    const Scalar* w,
+                                    Vec3* p,
+                                    const Scalar dt,
+                                    const elasty::device::ColliderView colliders,
+                                    Contact* contacts,
+                                    unsigned int* num_contacts,
+                                    const unsigned int num_particles)
+    {
+        const unsigned int i = blockIdx.x * blockDim.x + threadIdx.x;
+        if (i >= num_particles) { return; }
+
+        elasty::device::integrate(x[i], v[i], f[i], w[i], dt, p[i]);
+        num_contacts[i] = elasty::device::generateContacts(colliders, p[i], w[i], contacts + elasty::device::max_num_contacts * i);
+    }
+
+    // The constraints of a color share no particle, so that each thread
+    // projects one of them in place
+    template <typename Type>
+    __global__ void projectColorKernel(const Record<Type>* records,
+                                       Scalar* lambdas,
+                                       Vec3* p,
+                                       const Scalar* w,
+                                       const bool is_xpbd,
+                                       const Scalar dt,
+                                       const unsigned int begin,
+                                       const unsigned int end)
+    {
+        const unsigned int k = begin + blockIdx.x * blockDim.x + threadIdx.x;
+        if (k >= end) { return; }
+
+        elasty::device::projectConstraint(records[k], p, w, is_xpbd, dt, lambdas[k]);
+    }
+
+    template <typename Type>
+    __global__ void accumulateCorrectionKernel(const Record<Type>* records,
+                                               Scalar* lambdas,
+                                               const Vec3* p,
+                                               const Scalar* w,
+                                               const bool is_xpbd,
+                                               const Scalar dt,
+                                               Vec3* correction_sums,
+                                               unsigned int* correction_counts,
+                                               const unsigned int num_records)
+    {
+        const unsigned int k = blockIdx.x * blockDim.x + threadIdx.x;
+        if (k >= num_records) { return; }
+
+        Vec3 delta_x[Record<Type>::num_particles];
+        if (!elasty::device::calculateCorrection(records[k], p, w, is_xpbd, dt, lambdas[k], delta_x)) { return; }
+
+        // The double-precision atomicAdd needs the compute capability 6.0
+        for (unsigned int j = 0; j < Record<Type>::num_particles; ++ j)
+        {
+            const unsigned int index = records[k].indices[j];
+            atomicAdd(&correction_sums[index].x, delta_x[j].x);
+            atomicAdd(&correction_sums[index].y, delta_x[j].y);
+            atomicAdd(&correction_sums[index].z, delta_x[j].z);
+            atomicAdd(&correction_counts[index], 1u);
+        }
+    }
+
+    __global__ void applyCorrectionKernel(Vec3* p,
+                                          const Vec3* correction_sums,
+                                          const unsigned int* correction_counts,
+                                          const Scalar relaxation,
+                                          const unsigned int num_particles)
+    {
+        const unsigned int i = blockIdx.x * blockDim.x + threadIdx.x;
+        if (i >= num_particles || correction_counts[i] == 0) { return; }
+
+        p[i] += (relaxation / Scalar(correction_counts[i])) * correction_sums[i];
+    }
+
+    __global__ void projectContactsKernel(Vec3* p,
+                                          const bool is_xpbd,
+                                          const elasty::device::ColliderView colliders,
+                                          const Contact* contacts,
+                                          const unsigned int* num_contacts,
+                                          const unsigned int num_particles)
+    {
+        const unsigned int i = blockIdx.x * blockDim.x + threadIdx.x;
+        if (i >= num_particles) { return; }
+
+        elasty::device::projectContacts(colliders, p[i], is_xpbd, contacts + elasty::device::max_num_contacts * i, num_contacts[i]);
+    }
+
+    __global__ void updateVelocityKernel(Vec3* x, Vec3* v, const Vec3* p, const Scalar dt, const Scalar damping, const unsigned int num_particles)
+    {
+        const unsigned int i = blockIdx.x * blockDim.x + threadIdx.x;
+        if (i >= num_particles) { return; }
+
+        elasty::device::updateVelocity(x[i], v[i], p[i], dt, damping);
+    }
+
+    template <typename Type>
+    struct RecordBuffers
+    {
+        DeviceBuffer<Record<Type>> records;
+        DeviceBuffer<Scalar> lambdas;
+        std::vector<std::size_t> color_offsets;
+    };
+
+    template <typename... Types>
+    using RecordBufferTuple = std::tuple<RecordBuffers<Types>...>;
+
+    // The tuple of the buffers in the order of DeviceScene::ConstraintRecords
+    template <typename Tuple>
+    struct ToRecordBuffers;
+
+    template <typename... Types>
+    struct ToRecordBuffers<std::tuple<std::vector<Record<Types>>...>>
+    {
+        using type = RecordBufferTuple<Types...>;
+    };
+
+    // The device solver run by CUDA: the arrays stay in the device memory
+    // between the steps, and each color (or, in the Jacobi scheme, each type
+    // of the constraints) is a kernel launch on the default stream
+    class CudaSolver final : public elasty::DeviceSolver
+    {
+    public:
+
+        void upload(const elasty::DeviceScene& scene) override
+        {
+            m_num_particles = static_cast<unsigned int>(scene.getNumParticles());
+
+            m_x.upload(scene.x);
+            m_v.upload(scene.v);
+            m_w.upload(scene.w);
+            m_p.upload(scene.x);
+            m_f.resize(m_num_particles);
+            m_f.fill(0);
+
+            m_contacts.resize(elasty::device::max_num_contacts * m_num_particles);
+            m_num_contacts.resize(m_num_particles);
+            m_correction_sums.resize(m_num_particles);
+            m_correction_counts.resize(m_num_particles);
+
+            uploadRecords(scene, std::make_index_sequence<elasty::ConstraintSet::num_types>());
+
+            m_spheres.upload(scene.spheres);
+            m_capsules.upload(scene.capsules);
+            m_boxes.upload(scene.boxes);
+            m_colliders = { m_spheres.data(),
+                            static_cast<unsigned int>(m_spheres.size()),
+                            m_capsules.data(),
+                            static_cast<unsigned int>(m_capsules.size()),
+                            m_boxes.data(),
+                            static_cast<unsigned int>(m_boxes.size()),
+                            scene.collider_thickness,
+                            scene.collider_stiffness };
+        }
+
+        void uploadForces(const std::vector<elasty::Vector3>& f) override
+        {
+            if (f.size() != m_num_particles) { throw std::runtime_error("The number of forces does not match the uploaded scene."); }
+
+            m_host_buffer.resize(f.size());
+            std::transform(f.begin(), f.end(), m_host_buffer.begin(), [](const elasty::Vector3& f_i) { return Vec3{ f_i.x(), f_i.y(), f_i.z() }; });
+            m_f.upload(m_host_buffer);
+        }
+
+        void step(const elasty::DeviceStepSettings& settings) override;
+
+        void download(elasty::ParticleSet& particles) override
+        {
+            if (particles.size() != m_num_particles) { throw std::runtime_error("The particles do not match the uploaded scene."); }
+
+            m_x.download(m_host_buffer);
+            for (std::size_t i = 0; i < particles.size(); ++ i)
+            {
+                particles.x[i] = elasty::Vector3(m_host_buffer[i].x, m_host_buffer[i].y, m_host_buffer[i].z);
+                particles.p[i] = particles.x[i];
+            }
+
+            m_v.download(m_host_buffer);
+            for (std::size_t i = 0; i < particles.size(); ++ i)
+            {
+                particles.v[i] = elasty::Vector3(m_host_buffer[i].x, m_host_buffer[i].y, m_host_buffer[i].z);
+            }
+        }
+
+    private:
+
+        template <std::size_t... Indices>
+        void uploadRecords(const elasty::DeviceScene& scene, std::index_sequence<Indices...>)
+        {
+            ((std::get<Indices>(m_records).records.upload(std::get<Indices>(scene.records)),
+              std::get<Indices>(m_records).lambdas.resize(std::get<Indices>(scene.records).size()),
+              std::get<Indices>(m_records).color_offsets = scene.color_offsets[Indices]),
+             ...);
+        }
+
+        void projectConstraints(const elasty::DeviceStepSettings& settings, const Scalar dt);
+
+        unsigned int m_num_particles = 0;
+
+        DeviceBuffer<Vec3> m_x;
+        DeviceBuffer<Vec3> m_v;
+        DeviceBuffer<Vec3> m_f;
+        DeviceBuffer<Scalar> m_w;
+        DeviceBuffer<Vec3> m_p;
+
+        typename ToRecordBuffers<elasty::DeviceScene::ConstraintRecords>::type m_records;
+
+        DeviceBuffer<elasty::device::SphereRecord> m_spheres;
+        DeviceBuffer<elasty::device::CapsuleRecord> m_capsules;
+        DeviceBuffer<elasty::device::BoxRecord> m_boxes;
+        elasty::device::ColliderView m_colliders = {};
+
+        DeviceBuffer<Contact> m_contacts;
+        DeviceBuffer<unsigned int> m_num_contacts;
+
+        // Accumulators of the Jacobi scheme
+        DeviceBuffer<Vec3> m_correction_sums;
+        DeviceBuffer<unsigned int> m_correction_counts;
+
+        // Staging of the forces and the downloads
+        std::vector<Vec3> m_host_buffer;
+    };
+
+    void CudaSolver::step(const elasty::DeviceStepSettings& settings)
+    {
+        if (m_num_particles == 0) { return; }
+
+        const Scalar dt = settings.dt / Scalar(settings.num_substeps);
+        const unsigned int num_blocks = getNumBlocks(m_num_particles);
+
+        for (unsigned int substep = 0; substep < settings.num_substeps; ++ substep)
+        {
+            integrateKernel<<<num_blocks, block_size>>>(m_x.data(),
+                                                        m_v.data(),
+                                                        m_f.data(),
+                                                        m_w.data(),
+                                                        m_p.data(),
+                                                        dt,
+                                                        m_colliders,
+                                                        m_contacts.data(),
+                                                        m_num_contacts.data(),
+                                                        m_num_particles);
+
+            std::apply([](auto&... buffers) { (buffers.lambdas.fill(0), ...); }, m_records);
+
+            for (unsigned int iteration = 0; iteration < settings.num_iterations; ++ iteration)
+            {
+                projectConstraints(settings, dt);
+
+                projectContactsKernel<<<num_blocks, block_size>>>(m_p.data(), settings.is_xpbd, m_colliders, m_contacts.data(), m_num_contacts.data(), m_num_particles);
+            }
+
+            updateVelocityKernel<<<num_blocks, block_size>>>(m_x.data(), m_v.data(), m_p.data(), dt, settings.velocity_damping, m_num_particles);
+        }
+
+        check(cudaGetLastError(), "A kernel launch");
+    }
+
+    void CudaSolver::projectConstraints(const elasty::DeviceStepSettings& settings, const Scalar dt)
+    {
+        if (settings.is_jacobi)
+        {
+            m_correction_sums.fill(0);
+            m_correction_counts.fill(0);
+        }
+
+        auto project_batch = [&](auto& buffers)
+        {
+            const unsigned int num_records = static_cast<unsigned int>(buffers.records.size());
+            if (num_records == 0) { return; }
+
+            if (settings.is_jacobi)
+            {
+                accumulateCorrectionKernel<<<getNumBlocks(num_records), block_size>>>(buffers.records.data(),
+                                                                                     buffers.lambdas.data(),
+                                                                                     m_p.data(),
+                                                                                     m_w.data(),
+                                                                                     settings.is_xpbd,
+                                                                                     dt,
+                                                                                     m_correction_sums.data(),
+                                                                                     m_correction_counts.data(),
+                                                                                     num_records);
+                return;
+            }
+
+            // The launches on the same stream run one after another, which
+            // gives the Gauss-Seidel order over the colors
+            for (std::size_t color = 0; color + 1 < buffers.color_offsets.size(); ++ color)
+            {
+                const unsigned int begin = static_cast<unsigned int>(buffers.color_offsets[color]);
+                const unsigned int end = static_cast<unsigned int>(buffers.color_offsets[color + 1]);
+                if (begin == end) { continue; }
+
+                projectColorKernel<<<getNumBlocks(end - begin), block_size>>>(buffers.records.data(), buffers.lambdas.data(), m_p.data(), m_w.data(), settings.is_xpbd, dt, begin, end);
+            }
+        };
+        std::apply([&](auto&... buffers) { (project_batch(buffers), ...); }, m_records);
+
+        if (settings.is_jacobi)
+        {
+            applyCorrectionKernel<<<getNumBlocks(m_num_particles), block_size>>>(m_p.data(), m_correction_sums.data(), m_correction_counts.data(), settings.jacobi_relaxation, m_num_particles);
+        }
+    }
+}
+
+std::unique_ptr<elasty::DeviceSolver> elasty::createCudaSolver()
+{
+    int num_devices = 0;
+    if (cudaGetDeviceCount(&num_devices) != cudaSuccess || num_devices == 0) { throw std::runtime_error("No CUDA device is found."); }
+
+    return std::make_unique<CudaSolver>();
+}
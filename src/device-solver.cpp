@@ -0,0 +1,370 @@
+#include <elasty/device-solver.hpp>
+#include <elasty/constraint.hpp>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <type_traits>
+
+namespace
+{
+    using elasty::device::Record;
+    using elasty::device::Vec3;
+
+    inline Vec3 convert(const elasty::Vector3& vec)
+    {
+        return { vec.x(), vec.y(), vec.z() };
+    }
+
+    template <typename Type>
+    Record<Type> makeRecordBase(const Type& constraint)
+    {
+        Record<Type> record;
+        std::copy(constraint.getIndices().begin(), constraint.getIndices().end(), record.indices);
+        record.stiffness = constraint.m_stiffness;
+        record.compliance = constraint.m_compliance;
+        return record;
+    }
+
+    Record<elasty::DistanceConstraint> makeRecord(const elasty::DistanceConstraint& constraint)
+    {
+        auto record = makeRecordBase(constraint);
+        record.rest_length = constraint.getRestLength();
+        return record;
+    }
+
+    Record<elasty::BendingConstraint> makeRecord(const elasty::BendingConstraint& constraint)
+    {
+        auto record = makeRecordBase(constraint);
+        record.dihedral_angle = constraint.getDihedralAngle();
+        return record;
+    }
+
+    Record<elasty::IsometricBendingConstraint> makeRecord(const elasty::IsometricBendingConstraint& constraint)
+    {
+        auto record = makeRecordBase(constraint);
+        for (unsigned int i = 0; i < 4; ++ i) { record.K[i] = constraint.getK()(i); }
+        record.scale = constraint.getScale();
+        return record;
+    }
+
+    Record<elasty::FixedPointConstraint> makeRecord(const elasty::FixedPointConstraint& constraint)
+    {
+        auto record = makeRecordBase(constraint);
+        record.point = convert(constraint.getPoint());
+        return record;
+    }
+
+    Record<elasty::EnvironmentalCollisionConstraint> makeRecord(const elasty::EnvironmentalCollisionConstraint& constraint)
+    {
+        auto record = makeRecordBase(constraint);
+        record.n = convert(constraint.getNormal());
+        record.d = constraint.getDistance();
+        return record;
+    }
+
+    Record<elasty::ParticleCollisionConstraint> makeRecord(const elasty::ParticleCollisionConstraint& constraint)
+    {
+        auto record = makeRecordBase(constraint);
+        record.distance = constraint.getDistance();
+        return record;
+    }
+
+    Record<elasty::PointTriangleCollisionConstraint> makeRecord(const elasty::PointTriangleCollisionConstraint& constraint)
+    {
+        auto record = makeRecordBase(constraint);
+        record.thickness = constraint.getThickness();
+        for (unsigned int i = 0; i < 3; ++ i) { record.barycentric_coords[i] = constraint.getBarycentricCoords()(i); }
+        record.side = constraint.getSide();
+        return record;
+    }
+
+    Record<elasty::LongRangeAttachmentConstraint> makeRecord(const elasty::LongRangeAttachmentConstraint& constraint)
+    {
+        auto record = makeRecordBase(constraint);
+        record.attachment_point = convert(constraint.getAttachmentPoint());
+        record.distance = constraint.getDistance();
+        return record;
+    }
+
+    Record<elasty::TriangleStrainConstraint> makeRecord(const elasty::TriangleStrainConstraint& constraint)
+    {
+        auto record = makeRecordBase(constraint);
+        for (int i = 0; i < 2; ++ i)
+        {
+            for (int j = 0; j < 2; ++ j) { record.inv_rest_matrix[2 * i + j] = constraint.getInverseRestMatrix()(i, j); }
+        }
+        record.scale = std::sqrt(constraint.getRestArea());
+        return record;
+    }
+
+    Record<elasty::TriangleAreaConstraint> makeRecord(const elasty::TriangleAreaConstraint& constraint)
+    {
+        auto record = makeRecordBase(constraint);
+        record.rest_area = constraint.getRestArea();
+        return record;
+    }
+
+    Record<elasty::TetrahedronStrainConstraint> makeRecord(const elasty::TetrahedronStrainConstraint& constraint)
+    {
+        auto record = makeRecordBase(constraint);
+        for (int i = 0; i < 3; ++ i)
+        {
+            for (int j = 0; j < 3; ++ j) { record.inv_rest_matrix[3 * i + j] = constraint.getInverseRestMatrix()(i, j); }
+        }
+        record.scale = std::sqrt(constraint.getRestVolume());
+        return record;
+    }
+
+    Record<elasty::VolumeConstraint> makeRecord(const elasty::VolumeConstraint& constraint)
+    {
+        auto record = makeRecordBase(constraint);
+        record.rest_volume = constraint.getRestVolume();
+        return record;
+    }
+
+    elasty::device::BoxRecord makeBoxRecord(const elasty::BoxCollider& box)
+    {
+        elasty::device::BoxRecord record;
+
+        const elasty::Matrix3 rotation = box.transform.linear();
+        for (int i = 0; i < 3; ++ i)
+        {
+            for (int j = 0; j < 3; ++ j) { record.rotation[3 * i + j] = rotation(i, j); }
+        }
+        record.translation = convert(box.transform.translation());
+        record.half_extents = convert(box.half_extents);
+
+        return record;
+    }
+
+    // The device solver run on the calling thread, which is the reference
+    // of the other device backends: the constraints of a color are projected
+    // one after another instead of concurrently, which gives the same result
+    // as they share no particle
+    class ReferenceSolver final : public elasty::DeviceSolver
+    {
+    public:
+
+        void upload(const elasty::DeviceScene& scene) override
+        {
+            m_scene = scene;
+            m_f.assign(scene.getNumParticles(), Vec3{ 0.0, 0.0, 0.0 });
+            m_p = scene.x;
+            m_contacts.resize(elasty::device::max_num_contacts * scene.getNumParticles());
+            m_num_contacts.assign(scene.getNumParticles(), 0);
+
+            std::size_t batch_index = 0;
+            std::apply([&](const auto&... batches) { ((m_lambdas[batch_index ++].assign(batches.size(), 0.0)), ...); }, m_scene.records);
+        }
+
+        void uploadForces(const std::vector<elasty::Vector3>& f) override
+        {
+            if (f.size() != m_f.size()) { throw std::runtime_error("The number of forces does not match the uploaded scene."); }
+
+            std::transform(f.begin(), f.end(), m_f.begin(), convert);
+        }
+
+        void step(const elasty::DeviceStepSettings& settings) override;
+
+        void download(elasty::ParticleSet& particles) override
+        {
+            if (particles.size() != m_scene.getNumParticles()) { throw std::runtime_error("The particles do not match the uploaded scene."); }
+
+            for (std::size_t i = 0; i < particles.size(); ++ i)
+            {
+                particles.x[i] = elasty::Vector3(m_scene.x[i].x, m_scene.x[i].y, m_scene.x[i].z);
+                particles.v[i] = elasty::Vector3(m_scene.v[i].x, m_scene.v[i].y, m_scene.v[i].z);
+                particles.p[i] = particles.x[i];
+            }
+        }
+
+    private:
+
+        void projectConstraints(const elasty::DeviceStepSettings& settings, const elasty::Scalar dt);
+
+        elasty::DeviceScene m_scene;
+
+        std::vector<Vec3> m_f;
+        std::vector<Vec3> m_p;
+        std::vector<elasty::Scalar> m_lambdas[elasty::ConstraintSet::num_types];
+
+        std::vector<elasty::device::Contact> m_contacts;
+        std::vector<unsigned int> m_num_contacts;
+
+        // Accumulators of the Jacobi scheme
+        std::vector<Vec3> m_correction_sums;
+        std::vector<unsigned int> m_correction_counts;
+    };
+
+    void ReferenceSolver::step(const elasty::DeviceStepSettings& settings)
+    {
+        const std::size_t num_particles = m_scene.getNumParticles();
+        const elasty::Scalar dt = settings.dt / elasty::Scalar(settings.num_substeps);
+
+        const elasty::device::ColliderView colliders = { m_scene.spheres.data(),
+                                                         static_cast<unsigned int>(m_scene.spheres.size()),
+                                                         m_scene.capsules.data(),
+                                                         static_cast<unsigned int>(m_scene.capsules.size()),
+                                                         m_scene.boxes.data(),
+                                                         static_cast<unsigned int>(m_scene.boxes.size()),
+                                                         m_scene.collider_thickness,
+                                                         m_scene.collider_stiffness };
+
+        for (unsigned int substep = 0; substep < settings.num_substeps; ++ substep)
+        {
+            for (std::size_t i = 0; i < num_particles; ++ i)
+            {
+                elasty::device::integrate(m_scene.x[i], m_scene.v[i], m_f[i], m_scene.w[i], dt, m_p[i]);
+                m_num_contacts[i] = elasty::device::generateContacts(colliders, m_p[i], m_scene.w[i], m_contacts.data() + elasty::device::max_num_contacts * i);
+            }
+
+            for (auto& lambdas : m_lambdas) { std::fill(lambdas.begin(), lambdas.end(), 0.0); }
+
+            for (unsigned int iteration = 0; iteration < settings.num_iterations; ++ iteration)
+            {
+                projectConstraints(settings, dt);
+
+                for (std::size_t i = 0; i < num_particles; ++ i)
+                {
+                    elasty::device::projectContacts(colliders, m_p[i], settings.is_xpbd, m_contacts.data() + elasty::device::max_num_contacts * i, m_num_contacts[i]);
+                }
+            }
+
+            for (std::size_t i = 0; i < num_particles; ++ i)
+            {
+                elasty::device::updateVelocity(m_scene.x[i], m_scene.v[i], m_p[i], dt, settings.velocity_damping);
+            }
+        }
+    }
+
+    void ReferenceSolver::projectConstraints(const elasty::DeviceStepSettings& settings, const elasty::Scalar dt)
+    {
+        const std::size_t num_particles = m_scene.getNumParticles();
+
+        if (settings.is_jacobi)
+        {
+            m_correction_sums.assign(num_particles, Vec3{ 0.0, 0.0, 0.0 });
+            m_correction_counts.assign(num_particles, 0);
+        }
+
+        std::size_t batch_index = 0;
+        auto project_batch = [&](const auto& records)
+        {
+            using Record = typename std::decay_t<decltype(records)>::value_type;
+            constexpr unsigned int num_particles_per_constraint = Record::num_particles;
+
+            std::vector<elasty::Scalar>& lambdas = m_lambdas[batch_index ++];
+
+            for (std::size_t k = 0; k < records.size(); ++ k)
+            {
+                if (settings.is_jacobi)
+                {
+                    Vec3 delta_x[num_particles_per_constraint];
+                    if (!elasty::device::calculateCorrection(records[k], m_p.data(), m_scene.w.data(), settings.is_xpbd, dt, lambdas[k], delta_x)) { continue; }
+
+                    for (unsigned int j = 0; j < num_particles_per_constraint; ++ j)
+                    {
+                        m_correction_sums[records[k].indices[j]] += delta_x[j];
+                        ++ m_correction_counts[records[k].indices[j]];
+                    }
+                }
+                else
+                {
+                    elasty::device::projectConstraint(records[k], m_p.data(), m_scene.w.data(), settings.is_xpbd, dt, lambdas[k]);
+                }
+            }
+        };
+        std::apply([&](const auto&... batches) { (project_batch(batches), ...); }, m_scene.records);
+
+        if (settings.is_jacobi)
+        {
+            for (std::size_t i = 0; i < num_particles; ++ i)
+            {
+                if (m_correction_counts[i] == 0) { continue; }
+
+                m_p[i] += (settings.jacobi_relaxation / elasty::Scalar(m_correction_counts[i])) * m_correction_sums[i];
+            }
+        }
+    }
+}
+
+void elasty::DeviceScene::build(const ParticleSet& particles,
+                                const ConstraintSet& constraints,
+                                const ConstraintColoring* coloring,
+                                const ColliderSet& colliders)
+{
+    if (!colliders.m_sdfs.empty()) { throw std::runtime_error("The device backends do not support signed distance fields."); }
+
+    const std::size_t num_particles = particles.size();
+
+    x.resize(num_particles);
+    v.resize(num_particles);
+    w.resize(num_particles);
+    for (std::size_t i = 0; i < num_particles; ++ i)
+    {
+        x[i] = convert(particles.x[i]);
+        v[i] = convert(particles.v[i]);
+        w[i] = particles.w[i];
+    }
+
+    color_offsets.clear();
+
+    std::size_t batch_index = 0;
+    constraints.forEachBatch([&](const auto& batch)
+    {
+        using Type = typename std::decay_t<decltype(batch)>::value_type;
+
+        std::vector<device::Record<Type>>& batch_records = std::get<std::vector<device::Record<Type>>>(records);
+        batch_records.clear();
+        batch_records.reserve(batch.size());
+        for (const Type& constraint : batch) { batch_records.push_back(makeRecord(constraint)); }
+
+        color_offsets.push_back(coloring != nullptr ? coloring->getColorOffsets(batch_index) : std::vector<std::size_t>{ 0, batch.size() });
+        ++ batch_index;
+    });
+
+    spheres.clear();
+    for (const SphereCollider& sphere : colliders.m_spheres) { spheres.push_back({ convert(sphere.center), sphere.radius }); }
+    capsules.clear();
+    for (const CapsuleCollider& capsule : colliders.m_capsules) { capsules.push_back({ convert(capsule.end_0), convert(capsule.end_1), capsule.radius }); }
+    boxes.clear();
+    for (const BoxCollider& box : colliders.m_boxes) { boxes.push_back(makeBoxRecord(box)); }
+
+    collider_thickness = colliders.m_thickness;
+    collider_stiffness = colliders.m_stiffness;
+}
+
+bool elasty::isBackendAvailable(const Backend backend)
+{
+    switch (backend)
+    {
+        case Backend::Cpu:
+        case Backend::Reference:
+            return true;
+        case Backend::Cuda:
+#if defined(ELASTY_CUDA)
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+std::unique_ptr<elasty::DeviceSolver> elasty::createDeviceSolver(const Backend backend)
+{
+    switch (backend)
+    {
+        case Backend::Cpu:
+            break;
+        case Backend::Reference:
+            return std::make_unique<ReferenceSolver>();
+        case Backend::Cuda:
+#if defined(ELASTY_CUDA)
+            return createCudaSolver();
+#else
+            throw std::runtime_error("The CUDA backend is not available; the library should be built with ELASTY_CUDA.");
+#endif
+    }
+    throw std::runtime_error("Not a device backend.");
+}
@@ -0,0 +1,606 @@
+#include <elasty/distance-constraint-batch.hpp>
+#include <cmath>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define ELASTY_X86_DISPATCH
+#include <immintrin.h>
+#if defined(__GNUC__) && !defined(__clang__)
+// GCC reports false positives in its own gather intrinsics
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define ELASTY_NEON
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+    // Constraints whose particles are closer than this are skipped
+    constexpr elasty::Scalar epsilon = 1e-12;
+
+    struct KernelArguments
+    {
+        const std::int32_t* offsets_0;
+        const std::int32_t* offsets_1;
+        const elasty::Scalar* rest_lengths;
+        const elasty::Scalar* inv_masses_0;
+        const elasty::Scalar* inv_masses_1;
+        const elasty::Scalar* stiffnesses;
+        const elasty::Scalar* compliances;
+        elasty::Scalar* lambdas;
+        elasty::Scalar* values;
+        elasty::Scalar* positions;
+        bool is_xpbd;
+        elasty::Scalar inv_dt_squared;
+    };
+
+    // In both frameworks, the correction is
+    //   delta_lambda = (- k C - alpha_tilde lambda) / (w_0 + w_1 + alpha_tilde),
+    //   delta_x_0 = + w_0 delta_lambda n, delta_x_1 = - w_1 delta_lambda n,
+    // where k is the stiffness and alpha_tilde = 0 in PBD, and k = 1 in XPBD.
+    void projectScalar(const KernelArguments& args, const std::size_t begin, const std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++ i)
+        {
+            elasty::Scalar* x_0 = args.positions + args.offsets_0[i];
+            elasty::Scalar* x_1 = args.positions + args.offsets_1[i];
+
+            const elasty::Scalar d_x = x_0[0] - x_1[0];
+            const elasty::Scalar d_y = x_0[1] - x_1[1];
+            const elasty::Scalar d_z = x_0[2] - x_1[2];
+            const elasty::Scalar length = std::sqrt(d_x * d_x + d_y * d_y + d_z * d_z);
+
+            const elasty::Scalar C = length - args.rest_lengths[i];
+            if (args.values != nullptr) { args.values[i] = C; }
+
+            const elasty::Scalar alpha_tilde = args.is_xpbd ? args.compliances[i] * args.inv_dt_squared : 0.0;
+            const elasty::Scalar denominator = args.inv_masses_0[i] + args.inv_masses_1[i] + alpha_tilde;
+
+            if (!(length > epsilon) || !(denominator > 0.0)) { continue; }
+
+            const elasty::Scalar k = args.is_xpbd ? 1.0 : args.stiffnesses[i];
+            const elasty::Scalar lambda = args.is_xpbd ? args.lambdas[i] : 0.0;
+            const elasty::Scalar delta_lambda = (- k * C - alpha_tilde * lambda) / denominator;
+
+            if (args.is_xpbd) { args.lambdas[i] = lambda + delta_lambda; }
+
+            const elasty::Scalar s_0 = + args.inv_masses_0[i] * delta_lambda / length;
+            const elasty::Scalar s_1 = - args.inv_masses_1[i] * delta_lambda / length;
+
+            x_0[0] += s_0 * d_x; x_0[1] += s_0 * d_y; x_0[2] += s_0 * d_z;
+            x_1[0] += s_1 * d_x; x_1[1] += s_1 * d_y; x_1[2] += s_1 * d_z;
+        }
+    }
+
+#if defined(ELASTY_X86_DISPATCH)
+    // The SIMD functions are compiled for their instruction sets with target
+    // attributes (rather than global compiler flags) so that the rest of the
+    // library keeps the baseline ABI, and are selected at runtime.
+
+#if defined(ELASTY_SINGLE_PRECISION)
+    __attribute__((target("avx2,fma")))
+    void projectAvx2(const KernelArguments& args, const std::size_t begin, const std::size_t end)
+    {
+        constexpr std::size_t width = 8;
+
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 eps = _mm256_set1_ps(epsilon);
+        const __m256 inv_dt_squared = _mm256_set1_ps(args.is_xpbd ? args.inv_dt_squared : 0.0f);
+
+        std::size_t i = begin;
+        for (; i + width <= end; i += width)
+        {
+            const __m256i o_0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(args.offsets_0 + i));
+            const __m256i o_1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(args.offsets_1 + i));
+
+            const __m256 x_0 = _mm256_i32gather_ps(args.positions + 0, o_0, 4);
+            const __m256 y_0 = _mm256_i32gather_ps(args.positions + 1, o_0, 4);
+            const __m256 z_0 = _mm256_i32gather_ps(args.positions + 2, o_0, 4);
+            const __m256 x_1 = _mm256_i32gather_ps(args.positions + 0, o_1, 4);
+            const __m256 y_1 = _mm256_i32gather_ps(args.positions + 1, o_1, 4);
+            const __m256 z_1 = _mm256_i32gather_ps(args.positions + 2, o_1, 4);
+
+            const __m256 d_x = _mm256_sub_ps(x_0, x_1);
+            const __m256 d_y = _mm256_sub_ps(y_0, y_1);
+            const __m256 d_z = _mm256_sub_ps(z_0, z_1);
+            const __m256 length = _mm256_sqrt_ps(_mm256_fmadd_ps(d_x, d_x, _mm256_fmadd_ps(d_y, d_y, _mm256_mul_ps(d_z, d_z))));
+
+            const __m256 w_0 = _mm256_loadu_ps(args.inv_masses_0 + i);
+            const __m256 w_1 = _mm256_loadu_ps(args.inv_masses_1 + i);
+            const __m256 alpha_tilde = args.is_xpbd ? _mm256_mul_ps(_mm256_loadu_ps(args.compliances + i), inv_dt_squared) : zero;
+            const __m256 denominator = _mm256_add_ps(_mm256_add_ps(w_0, w_1), alpha_tilde);
+
+            const __m256 mask = _mm256_and_ps(_mm256_cmp_ps(length, eps, _CMP_GT_OQ), _mm256_cmp_ps(denominator, zero, _CMP_GT_OQ));
+            const __m256 safe_length = _mm256_blendv_ps(one, length, mask);
+            const __m256 safe_denominator = _mm256_blendv_ps(one, denominator, mask);
+
+            const __m256 C = _mm256_sub_ps(length, _mm256_loadu_ps(args.rest_lengths + i));
+            if (args.values != nullptr) { _mm256_storeu_ps(args.values + i, C); }
+            const __m256 k = args.is_xpbd ? one : _mm256_loadu_ps(args.stiffnesses + i);
+            const __m256 lambda = args.is_xpbd ? _mm256_loadu_ps(args.lambdas + i) : zero;
+            const __m256 numerator = _mm256_fnmadd_ps(alpha_tilde, lambda, _mm256_mul_ps(_mm256_sub_ps(zero, k), C));
+            const __m256 delta_lambda = _mm256_and_ps(mask, _mm256_div_ps(numerator, safe_denominator));
+
+            if (args.is_xpbd) { _mm256_storeu_ps(args.lambdas + i, _mm256_add_ps(lambda, delta_lambda)); }
+
+            const __m256 scale = _mm256_div_ps(delta_lambda, safe_length);
+            const __m256 s_0 = _mm256_mul_ps(w_0, scale);
+            const __m256 s_1 = _mm256_sub_ps(zero, _mm256_mul_ps(w_1, scale));
+
+            // AVX2 has no scatter instruction; store the lanes one by one
+            alignas(32) float new_x_0[width], new_y_0[width], new_z_0[width];
+            alignas(32) float new_x_1[width], new_y_1[width], new_z_1[width];
+            _mm256_store_ps(new_x_0, _mm256_fmadd_ps(s_0, d_x, x_0));
+            _mm256_store_ps(new_y_0, _mm256_fmadd_ps(s_0, d_y, y_0));
+            _mm256_store_ps(new_z_0, _mm256_fmadd_ps(s_0, d_z, z_0));
+            _mm256_store_ps(new_x_1, _mm256_fmadd_ps(s_1, d_x, x_1));
+            _mm256_store_ps(new_y_1, _mm256_fmadd_ps(s_1, d_y, y_1));
+            _mm256_store_ps(new_z_1, _mm256_fmadd_ps(s_1, d_z, z_1));
+
+            for (std::size_t lane = 0; lane < width; ++ lane)
+            {
+                float* p_0 = args.positions + args.offsets_0[i + lane];
+                float* p_1 = args.positions + args.offsets_1[i + lane];
+                p_0[0] = new_x_0[lane]; p_0[1] = new_y_0[lane]; p_0[2] = new_z_0[lane];
+                p_1[0] = new_x_1[lane]; p_1[1] = new_y_1[lane]; p_1[2] = new_z_1[lane];
+            }
+        }
+
+        projectScalar(args, i, end);
+    }
+
+    __attribute__((target("avx512f")))
+    void projectAvx512(const KernelArguments& args, const std::size_t begin, const std::size_t end)
+    {
+        constexpr std::size_t width = 16;
+
+        const __m512 zero = _mm512_setzero_ps();
+        const __m512 one = _mm512_set1_ps(1.0f);
+        const __m512 eps = _mm512_set1_ps(epsilon);
+        const __m512 inv_dt_squared = _mm512_set1_ps(args.is_xpbd ? args.inv_dt_squared : 0.0f);
+
+        std::size_t i = begin;
+        for (; i + width <= end; i += width)
+        {
+            const __m512i o_0 = _mm512_loadu_si512(args.offsets_0 + i);
+            const __m512i o_1 = _mm512_loadu_si512(args.offsets_1 + i);
+
+            const __m512 x_0 = _mm512_i32gather_ps(o_0, args.positions + 0, 4);
+            const __m512 y_0 = _mm512_i32gather_ps(o_0, args.positions + 1, 4);
+            const __m512 z_0 = _mm512_i32gather_ps(o_0, args.positions + 2, 4);
+            const __m512 x_1 = _mm512_i32gather_ps(o_1, args.positions + 0, 4);
+            const __m512 y_1 = _mm512_i32gather_ps(o_1, args.positions + 1, 4);
+            const __m512 z_1 = _mm512_i32gather_ps(o_1, args.positions + 2, 4);
+
+            const __m512 d_x = _mm512_sub_ps(x_0, x_1);
+            const __m512 d_y = _mm512_sub_ps(y_0, y_1);
+            const __m512 d_z = _mm512_sub_ps(z_0, z_1);
+            const __m512 length = _mm512_sqrt_ps(_mm512_fmadd_ps(d_x, d_x, _mm512_fmadd_ps(d_y, d_y, _mm512_mul_ps(d_z, d_z))));
+
+            const __m512 w_0 = _mm512_loadu_ps(args.inv_masses_0 + i);
+            const __m512 w_1 = _mm512_loadu_ps(args.inv_masses_1 + i);
+            const __m512 alpha_tilde = args.is_xpbd ? _mm512_mul_ps(_mm512_loadu_ps(args.compliances + i), inv_dt_squared) : zero;
+            const __m512 denominator = _mm512_add_ps(_mm512_add_ps(w_0, w_1), alpha_tilde);
+
+            const __mmask16 mask = _mm512_cmp_ps_mask(length, eps, _CMP_GT_OQ) & _mm512_cmp_ps_mask(denominator, zero, _CMP_GT_OQ);
+            const __m512 safe_length = _mm512_mask_blend_ps(mask, one, length);
+            const __m512 safe_denominator = _mm512_mask_blend_ps(mask, one, denominator);
+
+            const __m512 C = _mm512_sub_ps(length, _mm512_loadu_ps(args.rest_lengths + i));
+            if (args.values != nullptr) { _mm512_storeu_ps(args.values + i, C); }
+            const __m512 k = args.is_xpbd ? one : _mm512_loadu_ps(args.stiffnesses + i);
+            const __m512 lambda = args.is_xpbd ? _mm512_loadu_ps(args.lambdas + i) : zero;
+            const __m512 numerator = _mm512_fnmadd_ps(alpha_tilde, lambda, _mm512_mul_ps(_mm512_sub_ps(zero, k), C));
+            const __m512 delta_lambda = _mm512_maskz_div_ps(mask, numerator, safe_denominator);
+
+            if (args.is_xpbd) { _mm512_storeu_ps(args.lambdas + i, _mm512_add_ps(lambda, delta_lambda)); }
+
+            const __m512 scale = _mm512_div_ps(delta_lambda, safe_length);
+            const __m512 s_0 = _mm512_mul_ps(w_0, scale);
+            const __m512 s_1 = _mm512_sub_ps(zero, _mm512_mul_ps(w_1, scale));
+
+            // The particles in a batch are distinct, so the scatters do not
+            // conflict with each other
+            _mm512_i32scatter_ps(args.positions + 0, o_0, _mm512_fmadd_ps(s_0, d_x, x_0), 4);
+            _mm512_i32scatter_ps(args.positions + 1, o_0, _mm512_fmadd_ps(s_0, d_y, y_0), 4);
+            _mm512_i32scatter_ps(args.positions + 2, o_0, _mm512_fmadd_ps(s_0, d_z, z_0), 4);
+            _mm512_i32scatter_ps(args.positions + 0, o_1, _mm512_fmadd_ps(s_1, d_x, x_1), 4);
+            _mm512_i32scatter_ps(args.positions + 1, o_1, _mm512_fmadd_ps(s_1, d_y, y_1), 4);
+            _mm512_i32scatter_ps(args.positions + 2, o_1, _mm512_fmadd_ps(s_1, d_z, z_1), 4);
+        }
+
+        projectScalar(args, i, end);
+    }
+#else
+    __attribute__((target("avx2,fma")))
+    void projectAvx2(const KernelArguments& args, const std::size_t begin, const std::size_t end)
+    {
+        constexpr std::size_t width = 4;
+
+        const __m256d zero = _mm256_setzero_pd();
+        const __m256d one = _mm256_set1_pd(1.0);
+        const __m256d eps = _mm256_set1_pd(epsilon);
+        const __m256d inv_dt_squared = _mm256_set1_pd(args.is_xpbd ? args.inv_dt_squared : 0.0);
+
+        std::size_t i = begin;
+        for (; i + width <= end; i += width)
+        {
+            const __m128i o_0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(args.offsets_0 + i));
+            const __m128i o_1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(args.offsets_1 + i));
+
+            const __m256d x_0 = _mm256_i32gather_pd(args.positions + 0, o_0, 8);
+            const __m256d y_0 = _mm256_i32gather_pd(args.positions + 1, o_0, 8);
+            const __m256d z_0 = _mm256_i32gather_pd(args.positions + 2, o_0, 8);
+            const __m256d x_1 = _mm256_i32gather_pd(args.positions + 0, o_1, 8);
+            const __m256d y_1 = _mm256_i32gather_pd(args.positions + 1, o_1, 8);
+            const __m256d z_1 = _mm256_i32gather_pd(args.positions + 2, o_1, 8);
+
+            const __m256d d_x = _mm256_sub_pd(x_0, x_1);
+            const __m256d d_y = _mm256_sub_pd(y_0, y_1);
+            const __m256d d_z = _mm256_sub_pd(z_0, z_1);
+            const __m256d length = _mm256_sqrt_pd(_mm256_fmadd_pd(d_x, d_x, _mm256_fmadd_pd(d_y, d_y, _mm256_mul_pd(d_z, d_z))));
+
+            const __m256d w_0 = _mm256_loadu_pd(args.inv_masses_0 + i);
+            const __m256d w_1 = _mm256_loadu_pd(args.inv_masses_1 + i);
+            const __m256d alpha_tilde = args.is_xpbd ? _mm256_mul_pd(_mm256_loadu_pd(args.compliances + i), inv_dt_squared) : zero;
+            const __m256d denominator = _mm256_add_pd(_mm256_add_pd(w_0, w_1), alpha_tilde);
+
+            const __m256d mask = _mm256_and_pd(_mm256_cmp_pd(length, eps, _CMP_GT_OQ), _mm256_cmp_pd(denominator, zero, _CMP_GT_OQ));
+            const __m256d safe_length = _mm256_blendv_pd(one, length, mask);
+            const __m256d safe_denominator = _mm256_blendv_pd(one, denominator, mask);
+
+            const __m256d C = _mm256_sub_pd(length, _mm256_loadu_pd(args.rest_lengths + i));
+            if (args.values != nullptr) { _mm256_storeu_pd(args.values + i, C); }
+            const __m256d k = args.is_xpbd ? one : _mm256_loadu_pd(args.stiffnesses + i);
+            const __m256d lambda = args.is_xpbd ? _mm256_loadu_pd(args.lambdas + i) : zero;
+            const __m256d numerator = _mm256_fnmadd_pd(alpha_tilde, lambda, _mm256_mul_pd(_mm256_sub_pd(zero, k), C));
+            const __m256d delta_lambda = _mm256_and_pd(mask, _mm256_div_pd(numerator, safe_denominator));
+
+            if (args.is_xpbd) { _mm256_storeu_pd(args.lambdas + i, _mm256_add_pd(lambda, delta_lambda)); }
+
+            const __m256d scale = _mm256_div_pd(delta_lambda, safe_length);
+            const __m256d s_0 = _mm256_mul_pd(w_0, scale);
+            const __m256d s_1 = _mm256_sub_pd(zero, _mm256_mul_pd(w_1, scale));
+
+            // AVX2 has no scatter instruction; store the lanes one by one
+            alignas(32) double new_x_0[width], new_y_0[width], new_z_0[width];
+            alignas(32) double new_x_1[width], new_y_1[width], new_z_1[width];
+            _mm256_store_pd(new_x_0, _mm256_fmadd_pd(s_0, d_x, x_0));
+            _mm256_store_pd(new_y_0, _mm256_fmadd_pd(s_0, d_y, y_0));
+            _mm256_store_pd(new_z_0, _mm256_fmadd_pd(s_0, d_z, z_0));
+            _mm256_store_pd(new_x_1, _mm256_fmadd_pd(s_1, d_x, x_1));
+            _mm256_store_pd(new_y_1, _mm256_fmadd_pd(s_1, d_y, y_1));
+            _mm256_store_pd(new_z_1, _mm256_fmadd_pd(s_1, d_z, z_1));
+
+            for (std::size_t lane = 0; lane < width; ++ lane)
+            {
+                double* p_0 = args.positions + args.offsets_0[i + lane];
+                double* p_1 = args.positions + args.offsets_1[i + lane];
+                p_0[0] = new_x_0[lane]; p_0[1] = new_y_0[lane]; p_0[2] = new_z_0[lane];
+                p_1[0] = new_x_1[lane]; p_1[1] = new_y_1[lane]; p_1[2] = new_z_1[lane];
+            }
+        }
+
+        projectScalar(args, i, end);
+    }
+
+    __attribute__((target("avx512f")))
+    void projectAvx512(const KernelArguments& args, const std::size_t begin, const std::size_t end)
+    {
+        constexpr std::size_t width = 8;
+
+        const __m512d zero = _mm512_setzero_pd();
+        const __m512d one = _mm512_set1_pd(1.0);
+        const __m512d eps = _mm512_set1_pd(epsilon);
+        const __m512d inv_dt_squared = _mm512_set1_pd(args.is_xpbd ? args.inv_dt_squared : 0.0);
+
+        std::size_t i = begin;
+        for (; i + width <= end; i += width)
+        {
+            const __m256i o_0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(args.offsets_0 + i));
+            const __m256i o_1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(args.offsets_1 + i));
+
+            const __m512d x_0 = _mm512_i32gather_pd(o_0, args.positions + 0, 8);
+            const __m512d y_0 = _mm512_i32gather_pd(o_0, args.positions + 1, 8);
+            const __m512d z_0 = _mm512_i32gather_pd(o_0, args.positions + 2, 8);
+            const __m512d x_1 = _mm512_i32gather_pd(o_1, args.positions + 0, 8);
+            const __m512d y_1 = _mm512_i32gather_pd(o_1, args.positions + 1, 8);
+            const __m512d z_1 = _mm512_i32gather_pd(o_1, args.positions + 2, 8);
+
+            const __m512d d_x = _mm512_sub_pd(x_0, x_1);
+            const __m512d d_y = _mm512_sub_pd(y_0, y_1);
+            const __m512d d_z = _mm512_sub_pd(z_0, z_1);
+            const __m512d length = _mm512_sqrt_pd(_mm512_fmadd_pd(d_x, d_x, _mm512_fmadd_pd(d_y, d_y, _mm512_mul_pd(d_z, d_z))));
+
+            const __m512d w_0 = _mm512_loadu_pd(args.inv_masses_0 + i);
+            const __m512d w_1 = _mm512_loadu_pd(args.inv_masses_1 + i);
+            const __m512d alpha_tilde = args.is_xpbd ? _mm512_mul_pd(_mm512_loadu_pd(args.compliances + i), inv_dt_squared) : zero;
+            const __m512d denominator = _mm512_add_pd(_mm512_add_pd(w_0, w_1), alpha_tilde);
+
+            const __mmask8 mask = _mm512_cmp_pd_mask(length, eps, _CMP_GT_OQ) & _mm512_cmp_pd_mask(denominator, zero, _CMP_GT_OQ);
+            const __m512d safe_length = _mm512_mask_blend_pd(mask, one, length);
+            const __m512d safe_denominator = _mm512_mask_blend_pd(mask, one, denominator);
+
+            const __m512d C = _mm512_sub_pd(length, _mm512_loadu_pd(args.rest_lengths + i));
+            if (args.values != nullptr) { _mm512_storeu_pd(args.values + i, C); }
+            const __m512d k = args.is_xpbd ? one : _mm512_loadu_pd(args.stiffnesses + i);
+            const __m512d lambda = args.is_xpbd ? _mm512_loadu_pd(args.lambdas + i) : zero;
+            const __m512d numerator = _mm512_fnmadd_pd(alpha_tilde, lambda, _mm512_mul_pd(_mm512_sub_pd(zero, k), C));
+            const __m512d delta_lambda = _mm512_maskz_div_pd(mask, numerator, safe_denominator);
+
+            if (args.is_xpbd) { _mm512_storeu_pd(args.lambdas + i, _mm512_add_pd(lambda, delta_lambda)); }
+
+            const __m512d scale = _mm512_div_pd(delta_lambda, safe_length);
+            const __m512d s_0 = _mm512_mul_pd(w_0, scale);
+            const __m512d s_1 = _mm512_sub_pd(zero, _mm512_mul_pd(w_1, scale));
+
+            // The particles in a batch are distinct, so the scatters do not
+            // conflict with each other
+            _mm512_i32scatter_pd(args.positions + 0, o_0, _mm512_fmadd_pd(s_0, d_x, x_0), 8);
+            _mm512_i32scatter_pd(args.positions + 1, o_0, _mm512_fmadd_pd(s_0, d_y, y_0), 8);
+            _mm512_i32scatter_pd(args.positions + 2, o_0, _mm512_fmadd_pd(s_0, d_z, z_0), 8);
+            _mm512_i32scatter_pd(args.positions + 0, o_1, _mm512_fmadd_pd(s_1, d_x, x_1), 8);
+            _mm512_i32scatter_pd(args.positions + 1, o_1, _mm512_fmadd_pd(s_1, d_y, y_1), 8);
+            _mm512_i32scatter_pd(args.positions + 2, o_1, _mm512_fmadd_pd(s_1, d_z, z_1), 8);
+        }
+
+        projectScalar(args, i, end);
+    }
+
+#endif
+
+    using Kernel = void (*)(const KernelArguments&, std::size_t, std::size_t);
+
+    Kernel selectKernel()
+    {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) { return projectAvx512; }
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) { return projectAvx2; }
+        return projectScalar;
+    }
+#elif defined(ELASTY_NEON)
+#if defined(ELASTY_SINGLE_PRECISION)
+    void projectNeon(const KernelArguments& args, const std::size_t begin, const std::size_t end)
+    {
+        constexpr std::size_t width = 4;
+
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+        const float32x4_t one = vdupq_n_f32(1.0f);
+        const float32x4_t eps = vdupq_n_f32(epsilon);
+        const float32x4_t inv_dt_squared = vdupq_n_f32(args.is_xpbd ? args.inv_dt_squared : 0.0f);
+
+        std::size_t i = begin;
+        for (; i + width <= end; i += width)
+        {
+            float* p_0[width];
+            float* p_1[width];
+            for (std::size_t lane = 0; lane < width; ++ lane)
+            {
+                p_0[lane] = args.positions + args.offsets_0[i + lane];
+                p_1[lane] = args.positions + args.offsets_1[i + lane];
+            }
+
+            // NEON has no gather instruction; build the vectors lane by lane
+            const float32x4_t x_0 = { p_0[0][0], p_0[1][0], p_0[2][0], p_0[3][0] };
+            const float32x4_t y_0 = { p_0[0][1], p_0[1][1], p_0[2][1], p_0[3][1] };
+            const float32x4_t z_0 = { p_0[0][2], p_0[1][2], p_0[2][2], p_0[3][2] };
+            const float32x4_t x_1 = { p_1[0][0], p_1[1][0], p_1[2][0], p_1[3][0] };
+            const float32x4_t y_1 = { p_1[0][1], p_1[1][1], p_1[2][1], p_1[3][1] };
+            const float32x4_t z_1 = { p_1[0][2], p_1[1][2], p_1[2][2], p_1[3][2] };
+
+            const float32x4_t d_x = vsubq_f32(x_0, x_1);
+            const float32x4_t d_y = vsubq_f32(y_0, y_1);
+            const float32x4_t d_z = vsubq_f32(z_0, z_1);
+            const float32x4_t length = vsqrtq_f32(vfmaq_f32(vfmaq_f32(vmulq_f32(d_z, d_z), d_y, d_y), d_x, d_x));
+
+            const float32x4_t w_0 = vld1q_f32(args.inv_masses_0 + i);
+            const float32x4_t w_1 = vld1q_f32(args.inv_masses_1 + i);
+            const float32x4_t alpha_tilde = args.is_xpbd ? vmulq_f32(vld1q_f32(args.compliances + i), inv_dt_squared) : zero;
+            const float32x4_t denominator = vaddq_f32(vaddq_f32(w_0, w_1), alpha_tilde);
+
+            const uint32x4_t mask = vandq_u32(vcgtq_f32(length, eps), vcgtq_f32(denominator, zero));
+            const float32x4_t safe_length = vbslq_f32(mask, length, one);
+            const float32x4_t safe_denominator = vbslq_f32(mask, denominator, one);
+
+            const float32x4_t C = vsubq_f32(length, vld1q_f32(args.rest_lengths + i));
+            if (args.values != nullptr) { vst1q_f32(args.values + i, C); }
+            const float32x4_t k = args.is_xpbd ? one : vld1q_f32(args.stiffnesses + i);
+            const float32x4_t lambda = args.is_xpbd ? vld1q_f32(args.lambdas + i) : zero;
+            const float32x4_t numerator = vfmsq_f32(vnegq_f32(vmulq_f32(k, C)), alpha_tilde, lambda);
+            const float32x4_t delta_lambda = vbslq_f32(mask, vdivq_f32(numerator, safe_denominator), zero);
+
+            if (args.is_xpbd) { vst1q_f32(args.lambdas + i, vaddq_f32(lambda, delta_lambda)); }
+
+            const float32x4_t scale = vdivq_f32(delta_lambda, safe_length);
+            const float32x4_t s_0 = vmulq_f32(w_0, scale);
+            const float32x4_t s_1 = vnegq_f32(vmulq_f32(w_1, scale));
+
+            float new_x_0[width], new_y_0[width], new_z_0[width];
+            float new_x_1[width], new_y_1[width], new_z_1[width];
+            vst1q_f32(new_x_0, vfmaq_f32(x_0, s_0, d_x));
+            vst1q_f32(new_y_0, vfmaq_f32(y_0, s_0, d_y));
+            vst1q_f32(new_z_0, vfmaq_f32(z_0, s_0, d_z));
+            vst1q_f32(new_x_1, vfmaq_f32(x_1, s_1, d_x));
+            vst1q_f32(new_y_1, vfmaq_f32(y_1, s_1, d_y));
+            vst1q_f32(new_z_1, vfmaq_f32(z_1, s_1, d_z));
+
+            for (std::size_t lane = 0; lane < width; ++ lane)
+            {
+                p_0[lane][0] = new_x_0[lane]; p_0[lane][1] = new_y_0[lane]; p_0[lane][2] = new_z_0[lane];
+                p_1[lane][0] = new_x_1[lane]; p_1[lane][1] = new_y_1[lane]; p_1[lane][2] = new_z_1[lane];
+            }
+        }
+
+        projectScalar(args, i, end);
+    }
+#else
+    void projectNeon(const KernelArguments& args, const std::size_t begin, const std::size_t end)
+    {
+        constexpr std::size_t width = 2;
+
+        const float64x2_t zero = vdupq_n_f64(0.0);
+        const float64x2_t one = vdupq_n_f64(1.0);
+        const float64x2_t eps = vdupq_n_f64(epsilon);
+        const float64x2_t inv_dt_squared = vdupq_n_f64(args.is_xpbd ? args.inv_dt_squared : 0.0);
+
+        std::size_t i = begin;
+        for (; i + width <= end; i += width)
+        {
+            double* p_0[width] = { args.positions + args.offsets_0[i], args.positions + args.offsets_0[i + 1] };
+            double* p_1[width] = { args.positions + args.offsets_1[i], args.positions + args.offsets_1[i + 1] };
+
+            // NEON has no gather instruction; build the vectors lane by lane
+            const float64x2_t x_0 = { p_0[0][0], p_0[1][0] };
+            const float64x2_t y_0 = { p_0[0][1], p_0[1][1] };
+            const float64x2_t z_0 = { p_0[0][2], p_0[1][2] };
+            const float64x2_t x_1 = { p_1[0][0], p_1[1][0] };
+            const float64x2_t y_1 = { p_1[0][1], p_1[1][1] };
+            const float64x2_t z_1 = { p_1[0][2], p_1[1][2] };
+
+            const float64x2_t d_x = vsubq_f64(x_0, x_1);
+            const float64x2_t d_y = vsubq_f64(y_0, y_1);
+            const float64x2_t d_z = vsubq_f64(z_0, z_1);
+            const float64x2_t length = vsqrtq_f64(vfmaq_f64(vfmaq_f64(vmulq_f64(d_z, d_z), d_y, d_y), d_x, d_x));
+
+            const float64x2_t w_0 = vld1q_f64(args.inv_masses_0 + i);
+            const float64x2_t w_1 = vld1q_f64(args.inv_masses_1 + i);
+            const float64x2_t alpha_tilde = args.is_xpbd ? vmulq_f64(vld1q_f64(args.compliances + i), inv_dt_squared) : zero;
+            const float64x2_t denominator = vaddq_f64(vaddq_f64(w_0, w_1), alpha_tilde);
+
+            const uint64x2_t mask = vandq_u64(vcgtq_f64(length, eps), vcgtq_f64(denominator, zero));
+            const float64x2_t safe_length = vbslq_f64(mask, length, one);
+            const float64x2_t safe_denominator = vbslq_f64(mask, denominator, one);
+
+            const float64x2_t C = vsubq_f64(length, vld1q_f64(args.rest_lengths + i));
+            if (args.values != nullptr) { vst1q_f64(args.values + i, C); }
+            const float64x2_t k = args.is_xpbd ? one : vld1q_f64(args.stiffnesses + i);
+            const float64x2_t lambda = args.is_xpbd ? vld1q_f64(args.lambdas + i) : zero;
+            const float64x2_t numerator = vfmsq_f64(vnegq_f64(vmulq_f64(k, C)), alpha_tilde, lambda);
+            const float64x2_t delta_lambda = vbslq_f64(mask, vdivq_f64(numerator, safe_denominator), zero);
+
+            if (args.is_xpbd) { vst1q_f64(args.lambdas + i, vaddq_f64(lambda, delta_lambda)); }
+
+            const float64x2_t scale = vdivq_f64(delta_lambda, safe_length);
+            const float64x2_t s_0 = vmulq_f64(w_0, scale);
+            const float64x2_t s_1 = vnegq_f64(vmulq_f64(w_1, scale));
+
+            const float64x2_t new_x_0 = vfmaq_f64(x_0, s_0, d_x);
+            const float64x2_t new_y_0 = vfmaq_f64(y_0, s_0, d_y);
+            const float64x2_t new_z_0 = vfmaq_f64(z_0, s_0, d_z);
+            const float64x2_t new_x_1 = vfmaq_f64(x_1, s_1, d_x);
+            const float64x2_t new_y_1 = vfmaq_f64(y_1, s_1, d_y);
+            const float64x2_t new_z_1 = vfmaq_f64(z_1, s_1, d_z);
+
+            p_0[0][0] = vgetq_lane_f64(new_x_0, 0); p_0[0][1] = vgetq_lane_f64(new_y_0, 0); p_0[0][2] = vgetq_lane_f64(new_z_0, 0);
+            p_0[1][0] = vgetq_lane_f64(new_x_0, 1); p_0[1][1] = vgetq_lane_f64(new_y_0, 1); p_0[1][2] = vgetq_lane_f64(new_z_0, 1);
+            p_1[0][0] = vgetq_lane_f64(new_x_1, 0); p_1[0][1] = vgetq_lane_f64(new_y_1, 0); p_1[0][2] = vgetq_lane_f64(new_z_1, 0);
+            p_1[1][0] = vgetq_lane_f64(new_x_1, 1); p_1[1][1] = vgetq_lane_f64(new_y_1, 1); p_1[1][2] = vgetq_lane_f64(new_z_1, 1);
+        }
+
+        projectScalar(args, i, end);
+    }
+#endif
+#endif
+}
+
+void elasty::DistanceConstraintBatch::build(const std::vector<DistanceConstraint>& constraints)
+{
+    const std::size_t num_constraints = constraints.size();
+
+    m_offsets_0.resize(num_constraints);
+    m_offsets_1.resize(num_constraints);
+    m_rest_lengths.resize(num_constraints);
+    m_inv_masses_0.resize(num_constraints);
+    m_inv_masses_1.resize(num_constraints);
+    m_values.assign(num_constraints, 0.0);
+
+    for (std::size_t i = 0; i < num_constraints; ++ i)
+    {
+        const DistanceConstraint& constraint = constraints[i];
+
+        m_offsets_0[i] = static_cast<std::int32_t>(3 * constraint.getIndices()[0]);
+        m_offsets_1[i] = static_cast<std::int32_t>(3 * constraint.getIndices()[1]);
+        m_rest_lengths[i] = constraint.getRestLength();
+        m_inv_masses_0[i] = constraint.getInverseMasses()(0);
+        m_inv_masses_1[i] = constraint.getInverseMasses()(3);
+    }
+
+    updateParameters(constraints);
+}
+
+void elasty::DistanceConstraintBatch::updateParameters(const std::vector<DistanceConstraint>& constraints)
+{
+    const std::size_t num_constraints = constraints.size();
+
+    assert(num_constraints == size());
+
+    m_stiffnesses.resize(num_constraints);
+    m_compliances.resize(num_constraints);
+    m_lambdas.assign(num_constraints, 0.0);
+
+    for (std::size_t i = 0; i < num_constraints; ++ i)
+    {
+        m_stiffnesses[i] = constraints[i].m_stiffness;
+        m_compliances[i] = constraints[i].m_compliance;
+    }
+}
+
+void elasty::DistanceConstraintBatch::writeLagrangeMultipliers(std::vector<DistanceConstraint>& constraints) const
+{
+    assert(constraints.size() == size());
+
+    for (std::size_t i = 0; i < constraints.size(); ++ i)
+    {
+        constraints[i].m_lambda = m_lambdas[i];
+    }
+}
+
+void elasty::DistanceConstraintBatch::clear()
+{
+    m_offsets_0.clear();
+    m_offsets_1.clear();
+    m_rest_lengths.clear();
+    m_inv_masses_0.clear();
+    m_inv_masses_1.clear();
+    m_stiffnesses.clear();
+    m_compliances.clear();
+    m_lambdas.clear();
+    m_values.clear();
+}
+
+void elasty::projectDistanceConstraintBatch(DistanceConstraintBatch& batch,
+                                            const std::size_t begin,
+                                            const std::size_t end,
+                                            Scalar* positions,
+                                            const bool is_xpbd,
+                                            const Scalar dt,
+                                            const bool is_recording_values)
+{
+    assert(end <= batch.size());
+
+    const KernelArguments args
+    {
+        batch.m_offsets_0.data(),
+        batch.m_offsets_1.data(),
+        batch.m_rest_lengths.data(),
+        batch.m_inv_masses_0.data(),
+        batch.m_inv_masses_1.data(),
+        batch.m_stiffnesses.data(),
+        batch.m_compliances.data(),
+        batch.m_lambdas.data(),
+        is_recording_values ? batch.m_values.data() : nullptr,
+        positions,
+        is_xpbd,
+        is_xpbd ? Scalar(1.0) / (dt * dt) : Scalar(0.0),
+    };
+
+#if defined(ELASTY_X86_DISPATCH)
+    static const Kernel kernel = selectKernel();
+    kernel(args, begin, end);
+#elif defined(ELASTY_NEON)
+    projectNeon(args, begin, end);
+#else
+    projectScalar(args, begin, end);
+#endif
+}
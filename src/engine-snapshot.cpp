@@ -0,0 +1,303 @@
+#include <elasty/engine-snapshot.hpp>
+#include <elasty/constraint.hpp>
+#include <elasty/engine.hpp>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+    constexpr char snapshot_magic[8] = { 'E', 'L', 'A', 'S', 'T', 'Y', 'S', 'S' };
+    constexpr std::uint32_t snapshot_version = 1;
+    constexpr std::uint32_t snapshot_byte_order_mark = 0x01020304;
+
+    struct SnapshotHeader
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t byte_order_mark;
+        std::uint32_t scalar_size;
+        std::uint32_t padding;
+        std::uint64_t num_steps;
+        std::uint64_t num_particles;
+        std::uint64_t num_fixed_points;
+    };
+
+    static_assert(sizeof(SnapshotHeader) == 48, "The snapshot header should not have padding");
+
+    // The arrays of vectors are copied as they are
+    static_assert(sizeof(elasty::Vector3) == 3 * sizeof(elasty::Scalar), "Vector3 should be packed");
+
+    std::size_t calculatePaddedSize(const std::size_t size)
+    {
+        return (size + 7) & ~std::size_t(7);
+    }
+
+    // The sections in the order of the blob: x, v, p, m, w, and the points
+    // of the fixed-point constraints
+    std::size_t calculateDataSize(const std::uint64_t num_particles, const std::uint64_t num_fixed_points)
+    {
+        const std::size_t vectors_size = calculatePaddedSize(sizeof(elasty::Vector3) * num_particles);
+        const std::size_t scalars_size = calculatePaddedSize(sizeof(elasty::Scalar) * num_particles);
+        const std::size_t points_size = calculatePaddedSize(sizeof(elasty::Vector3) * num_fixed_points);
+
+        return sizeof(SnapshotHeader) + 3 * vectors_size + 2 * scalars_size + points_size;
+    }
+
+    SnapshotHeader readHeader(const std::vector<char>& data)
+    {
+        SnapshotHeader header;
+
+        if (data.size() < sizeof(SnapshotHeader)) { throw std::runtime_error("The snapshot is truncated"); }
+        std::memcpy(&header, data.data(), sizeof(SnapshotHeader));
+
+        if (std::memcmp(header.magic, snapshot_magic, sizeof(snapshot_magic)) != 0) { throw std::runtime_error("The data is not an engine snapshot"); }
+        if (header.version != snapshot_version) { throw std::runtime_error("The snapshot has an unsupported version"); }
+        if (header.byte_order_mark != snapshot_byte_order_mark) { throw std::runtime_error("The snapshot has a different byte order"); }
+        if (header.scalar_size != sizeof(elasty::Scalar)) { throw std::runtime_error("The snapshot is of another precision"); }
+        if (data.size() != calculateDataSize(header.num_particles, header.num_fixed_points)) { throw std::runtime_error("The snapshot is truncated"); }
+
+        return header;
+    }
+
+    class SnapshotWriter
+    {
+    public:
+
+        explicit SnapshotWriter(std::vector<char>& data) : m_data(data) {}
+
+        void write(const void* values, const std::size_t size)
+        {
+            writeRecord(values, size);
+            endSection();
+        }
+
+        // Append a record to the current section without padding, so that a
+        // section can be written one record at a time
+        void writeRecord(const void* values, const std::size_t size)
+        {
+            if (size != 0) { std::memcpy(m_data.data() + m_position, values, size); }
+            m_position += size;
+        }
+
+        // Pad the current section to an 8-byte boundary
+        void endSection()
+        {
+            const std::size_t padded_position = calculatePaddedSize(m_position);
+            std::memset(m_data.data() + m_position, 0, padded_position - m_position);
+            m_position = padded_position;
+        }
+
+    private:
+
+        std::vector<char>& m_data;
+        std::size_t m_position = 0;
+    };
+
+    class SnapshotReader
+    {
+    public:
+
+        explicit SnapshotReader(const std::vector<char>& data) : m_data(data) {}
+
+        void skip(const std::size_t size)
+        {
+            m_position += calculatePaddedSize(size);
+        }
+
+        void read(void* values, const std::size_t size)
+        {
+            readRecord(values, size);
+            endSection();
+        }
+
+        void readRecord(void* values, const std::size_t size)
+        {
+            if (size != 0) { std::memcpy(values, m_data.data() + m_position, size); }
+            m_position += size;
+        }
+
+        void endSection()
+        {
+            m_position = calculatePaddedSize(m_position);
+        }
+
+    private:
+
+        const std::vector<char>& m_data;
+        std::size_t m_position = 0;
+    };
+}
+
+std::uint64_t elasty::EngineSnapshot::getNumSteps() const
+{
+    return m_data.empty() ? 0 : readHeader(m_data).num_steps;
+}
+
+std::size_t elasty::EngineSnapshot::getNumParticles() const
+{
+    return m_data.empty() ? 0 : readHeader(m_data).num_particles;
+}
+
+void elasty::EngineSnapshot::setData(std::vector<char> data)
+{
+    readHeader(data);
+    m_data = std::move(data);
+}
+
+void elasty::EngineSnapshot::write(const std::string& file_path) const
+{
+    std::ofstream file(file_path, std::ios::binary);
+    if (!file) { throw std::runtime_error("Failed to open " + file_path); }
+
+    file.write(m_data.data(), m_data.size());
+    if (!file) { throw std::runtime_error("Failed to write " + file_path); }
+}
+
+elasty::EngineSnapshot elasty::EngineSnapshot::read(const std::string& file_path)
+{
+    // Read the whole file at once
+    std::ifstream file(file_path, std::ios::binary | std::ios::ate);
+    if (!file) { throw std::runtime_error("Failed to open " + file_path); }
+
+    std::vector<char> data(static_cast<std::size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(data.data(), data.size());
+    if (!file) { throw std::runtime_error("Failed to read " + file_path); }
+
+    EngineSnapshot snapshot;
+    snapshot.setData(std::move(data));
+    return snapshot;
+}
+
+void elasty::Engine::takeSnapshot(EngineSnapshot& snapshot)
+{
+    synchronizeParticles();
+
+    const auto& fixed_point_constraints = m_constraints.get<FixedPointConstraint>();
+
+    const std::size_t num_particles = m_particles.size();
+    const std::size_t num_fixed_points = fixed_point_constraints.size();
+
+    // Keeps the capacity of the previous snapshot
+    snapshot.m_data.resize(calculateDataSize(num_particles, num_fixed_points));
+
+    SnapshotHeader header = {};
+    std::memcpy(header.magic, snapshot_magic, sizeof(snapshot_magic));
+    header.version = snapshot_version;
+    header.byte_order_mark = snapshot_byte_order_mark;
+    header.scalar_size = sizeof(Scalar);
+    header.num_steps = m_num_steps;
+    header.num_particles = num_particles;
+    header.num_fixed_points = num_fixed_points;
+
+    SnapshotWriter writer(snapshot.m_data);
+    writer.write(&header, sizeof(SnapshotHeader));
+
+    writer.write(m_particles.x.data(), sizeof(Vector3) * num_particles);
+    writer.write(m_particles.v.data(), sizeof(Vector3) * num_particles);
+    writer.write(m_particles.p.data(), sizeof(Vector3) * num_particles);
+    writer.write(m_particles.m.data(), sizeof(Scalar) * num_particles);
+    writer.write(m_particles.w.data(), sizeof(Scalar) * num_particles);
+
+    // The points are written one by one, without a temporary array
+    for (const auto& constraint : fixed_point_constraints) { writer.writeRecord(constraint.getPoint().data(), sizeof(Vector3)); }
+    writer.endSection();
+}
+
+elasty::EngineSnapshot elasty::Engine::takeSnapshot()
+{
+    EngineSnapshot snapshot;
+    takeSnapshot(snapshot);
+    return snapshot;
+}
+
+void elasty::Engine::restoreSnapshot(const EngineSnapshot& snapshot)
+{
+    const SnapshotHeader header = readHeader(snapshot.m_data);
+
+    auto& fixed_point_constraints = m_constraints.get<FixedPointConstraint>();
+
+    if (header.num_particles != m_particles.size()) { throw std::runtime_error("The snapshot has a different number of particles"); }
+    if (header.num_fixed_points != fixed_point_constraints.size()) { throw std::runtime_error("The snapshot has a different number of fixed-point constraints"); }
+
+    const std::size_t num_particles = m_particles.size();
+
+    SnapshotReader reader(snapshot.m_data);
+    reader.skip(sizeof(SnapshotHeader));
+
+    reader.read(m_particles.x.data(), sizeof(Vector3) * num_particles);
+    reader.read(m_particles.v.data(), sizeof(Vector3) * num_particles);
+    reader.read(m_particles.p.data(), sizeof(Vector3) * num_particles);
+    reader.read(m_particles.m.data(), sizeof(Scalar) * num_particles);
+    reader.read(m_particles.w.data(), sizeof(Scalar) * num_particles);
+
+    for (auto& constraint : fixed_point_constraints)
+    {
+        Vector3 point;
+        reader.readRecord(point.data(), sizeof(Vector3));
+        constraint.setPoint(point);
+    }
+    reader.endSection();
+
+    m_num_steps = header.num_steps;
+    m_instant_constraints.clear();
+
+    // The state derived from the particles is built again from them
+    m_sleeping_islands.clear();
+    m_are_particles_on_device_newer = false;
+    m_is_device_scene_outdated = true;
+
+    updateVertexBuffers();
+}
+
+elasty::SnapshotRing::SnapshotRing(const std::size_t capacity) :
+m_snapshots(capacity)
+{
+    if (capacity == 0) { throw std::runtime_error("The ring of snapshots needs a positive capacity"); }
+}
+
+void elasty::SnapshotRing::push(Engine& engine)
+{
+    if (m_size == m_snapshots.size())
+    {
+        // Overwrite the oldest one
+        engine.takeSnapshot(m_snapshots[m_front]);
+        m_front = (m_front + 1) % m_snapshots.size();
+    }
+    else
+    {
+        engine.takeSnapshot(m_snapshots[(m_front + m_size) % m_snapshots.size()]);
+        ++ m_size;
+    }
+}
+
+bool elasty::SnapshotRing::rollBack(Engine& engine, const std::uint64_t num_steps)
+{
+    for (std::size_t i = m_size; i > 0; -- i)
+    {
+        const EngineSnapshot& snapshot = getSnapshot(i - 1);
+        if (snapshot.getNumSteps() > num_steps) { continue; }
+
+        engine.restoreSnapshot(snapshot);
+
+        // The later snapshots are of the discarded future
+        m_size = i;
+        return true;
+    }
+    return false;
+}
+
+void elasty::SnapshotRing::clear()
+{
+    m_front = 0;
+    m_size = 0;
+}
+
+const elasty::EngineSnapshot& elasty::SnapshotRing::getSnapshot(const std::size_t i) const
+{
+    if (i >= m_size) { throw std::runtime_error("The snapshot index is out of range"); }
+
+    return m_snapshots[(m_front + i) % m_snapshots.size()];
+}
@@ -1,61 +1,270 @@
 #include <elasty/engine.hpp>
-#include <elasty/constraint.hpp>
-#include <elasty/particle.hpp>
+#include <elasty/cloth-hierarchy.hpp>
+#include <elasty/cloth-vertex-buffer.hpp>
+#include <elasty/thread-pool.hpp>
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
 
-void elasty::Engine::stepTime()
+namespace
 {
-    // Apply external forces
-    setExternalForces();
-    for (auto& particle : m_particles)
+    // The names of the types of ConstraintSet, in the same order
+    constexpr const char* constraint_type_names[] =
+    {
+        "DistanceConstraint",
+        "BendingConstraint",
+        "IsometricBendingConstraint",
+        "FixedPointConstraint",
+        "EnvironmentalCollisionConstraint",
+        "ParticleCollisionConstraint",
+        "PointTriangleCollisionConstraint",
+        "LongRangeAttachmentConstraint",
+        "TriangleStrainConstraint",
+        "TriangleAreaConstraint",
+        "TetrahedronStrainConstraint",
+        "VolumeConstraint",
+    };
+    static_assert(sizeof(constraint_type_names) / sizeof(constraint_type_names[0]) == elasty::ConstraintSet::num_types,
+                  "A constraint type is not named");
+
+    template <typename Type>
+    [[maybe_unused]] const char* getConstraintTypeName()
     {
-        particle->v = particle->v + m_dt * particle->w * particle->f;
+        return constraint_type_names[elasty::ConstraintSet::getTypeIndex<Type>()];
     }
 
-    // Calculate predicted positions
-    for (auto& particle : m_particles)
+    [[maybe_unused]] std::size_t countConstraints(const elasty::ConstraintSet& constraints)
     {
-        particle->p = particle->x + m_dt * particle->v;
+        const std::vector<std::size_t> batch_sizes = constraints.getBatchSizes();
+        return std::accumulate(batch_sizes.begin(), batch_sizes.end(), std::size_t(0));
     }
+}
 
-    // Generate collision constraints
-    generateCollisionConstraints();
+elasty::Engine::Engine() = default;
 
-    // Solve constraints
-    for (unsigned int i = 0; i < m_num_iterations; ++ i)
+elasty::Engine::~Engine() = default;
+
+void elasty::Engine::stepTime()
+{
+    assert(m_num_substeps > 0);
+
+    ELASTY_PROFILE_SCOPE(m_profiler, "Step");
+
+    if (m_backend != Backend::Cpu)
+    {
+        stepTimeOnDevice();
+        return;
+    }
+
+    // Switching back from a device backend continues from its state
+    synchronizeParticles();
+
+    const Scalar dt = m_dt / Scalar(m_num_substeps);
+    const std::size_t num_particles = m_particles.size();
+
+    if (m_is_sleeping_enabled && !m_sleeping_islands.isUpToDate(m_constraints, m_particles))
     {
-        for (auto constraint : m_constraints)
+        m_sleeping_islands.build(m_constraints, m_particles);
+    }
+
+    for (unsigned int substep = 0; substep < m_num_substeps; ++ substep)
+    {
+#if defined(ELASTY_PROFILING)
+        const auto substep_begin = std::chrono::steady_clock::now();
+        Profiler::takeCounts();
+#endif
+
+        const bool has_sleeping_island = m_is_sleeping_enabled && m_sleeping_islands.hasSleepingIsland();
+
+        // Apply external forces (the sleeping particles keep their zero velocities)
+        {
+            ELASTY_PROFILE_SCOPE(m_profiler, "ExternalForces");
+
+            setExternalForces();
+            for (std::size_t i = 0; i < num_particles; ++ i)
+            {
+                if (has_sleeping_island && m_sleeping_islands.isParticleAsleep(i)) { continue; }
+
+                m_particles.v[i] = m_particles.v[i] + dt * m_particles.w[i] * m_particles.f[i];
+            }
+        }
+
+        // Calculate predicted positions
+        {
+            ELASTY_PROFILE_SCOPE(m_profiler, "Prediction");
+
+            for (std::size_t i = 0; i < num_particles; ++ i)
+            {
+                m_particles.p[i] = m_particles.x[i] + dt * m_particles.v[i];
+            }
+        }
+
+        // Generate collision constraints
         {
-            constraint->projectParticles();
+            ELASTY_PROFILE_SCOPE(m_profiler, "CollisionGeneration");
+
+            generateCollisionConstraints();
+            ELASTY_PROFILE_COUNT(Contacts, countConstraints(m_instant_constraints));
+        }
+
+        if (m_is_sleeping_enabled)
+        {
+            m_sleeping_islands.wakeUp(m_constraints, m_instant_constraints, m_particles, m_wake_up_tolerance);
         }
 
-        for (auto constraint : m_instant_constraints)
+        // Solve constraints
         {
-            constraint->projectParticles();
+            ELASTY_PROFILE_SCOPE(m_profiler, "Preparation");
+            prepareProjection(dt);
+        }
+        {
+            ELASTY_PROFILE_SCOPE(m_profiler, "Solve");
+            solveConstraints(dt);
+        }
+
+        // Put back the sleeping particles moved by the constraints that are not skipped
+        if (m_is_sleeping_enabled && m_sleeping_islands.hasSleepingIsland())
+        {
+            for (std::size_t i = 0; i < num_particles; ++ i)
+            {
+                if (m_sleeping_islands.isParticleAsleep(i)) { m_particles.p[i] = m_particles.x[i]; }
+            }
+        }
+
+#if defined(ELASTY_PROFILING)
+        const ResidualStatistics residual = m_profiler.m_is_enabled ? calculateResidualStatistics() : ResidualStatistics();
+#endif
+
+        // Apply the results and update velocities
+        {
+            ELASTY_PROFILE_SCOPE(m_profiler, "VelocityUpdate");
+
+            for (std::size_t i = 0; i < num_particles; ++ i)
+            {
+                m_particles.v[i] = (m_particles.p[i] - m_particles.x[i]) * (1.0 / dt);
+                m_particles.x[i] = m_particles.p[i];
+            }
+
+            updateVelocities();
         }
+
+        // Clear instant constraints
+        m_instant_constraints.clear();
+
+#if defined(ELASTY_PROFILING)
+        if (m_profiler.m_is_enabled)
+        {
+            const auto substep_end = std::chrono::steady_clock::now();
+            m_profiler.recordStep({ m_num_steps,
+                                    substep,
+                                    m_profiler.getTimestamp(substep_begin),
+                                    std::chrono::duration_cast<std::chrono::nanoseconds>(substep_end - substep_begin).count(),
+                                    Profiler::takeCounts(),
+                                    residual });
+        }
+#endif
     }
 
-    // Apply the results
-    for (auto& particle : m_particles)
+    if (m_is_sleeping_enabled)
     {
-        particle->v = (particle->p - particle->x) * (1.0 / m_dt);
-        particle->x = particle->p;
+        m_sleeping_islands.update(m_particles, m_sleep_speed_threshold, m_num_steps_to_sleep);
     }
 
-    // Update velocities
-    updateVelocities();
+    updateVertexBuffers();
 
-    // Clear instant constraints
-    m_instant_constraints.clear();
+    ++ m_num_steps;
+}
+
+void elasty::Engine::stepTimeOnDevice()
+{
+    if (m_framework == Framework::ProjectiveDynamics) { throw std::runtime_error("The device backends do not support projective dynamics."); }
+
+    const bool is_jacobi = m_projection_scheme == ProjectionScheme::Jacobi;
+
+    if (m_device_solver == nullptr || m_device_solver_backend != m_backend)
+    {
+        // Hand over the state of the previous device, if any
+        synchronizeParticles();
+
+        m_device_solver = createDeviceSolver(m_backend);
+        m_device_solver_backend = m_backend;
+        m_is_device_scene_outdated = true;
+    }
+
+    if (m_is_device_scene_outdated || m_num_device_particles != m_particles.size() || m_device_batch_sizes != m_constraints.getBatchSizes())
+    {
+        ELASTY_PROFILE_SCOPE(m_profiler, "DeviceUpload");
+
+        synchronizeParticles();
+
+        if (!is_jacobi && !m_coloring.isUpToDate(m_constraints))
+        {
+            m_coloring.build(m_constraints, m_particles.size());
+        }
+
+        DeviceScene scene;
+        scene.build(m_particles, m_constraints, is_jacobi ? nullptr : &m_coloring, m_device_colliders);
+        m_device_solver->upload(scene);
+
+        m_num_device_particles = m_particles.size();
+        m_device_batch_sizes = m_constraints.getBatchSizes();
+        m_is_device_scene_outdated = false;
+    }
+
+    {
+        ELASTY_PROFILE_SCOPE(m_profiler, "ExternalForces");
+
+        setExternalForces();
+        m_device_solver->uploadForces(m_particles.f);
+    }
+    {
+        ELASTY_PROFILE_SCOPE(m_profiler, "DeviceStep");
+
+        const DeviceStepSettings settings = { m_dt,
+                                              m_num_substeps,
+                                              m_num_iterations,
+                                              m_framework == Framework::Xpbd,
+                                              is_jacobi,
+                                              m_jacobi_relaxation,
+                                              m_device_velocity_damping };
+        m_device_solver->step(settings);
+    }
+
+    m_are_particles_on_device_newer = true;
+    m_last_num_iterations = m_num_iterations;
+    m_last_residual = 0.0;
+
+    ++ m_num_steps;
 }
 
-void elasty::Engine::addConstraint(std::shared_ptr<Constraint> constraint)
+void elasty::Engine::synchronizeParticles()
 {
-    m_constraints.push_back(constraint);
+    if (!m_are_particles_on_device_newer) { return; }
+
+    ELASTY_PROFILE_SCOPE(m_profiler, "DeviceDownload");
+
+    m_device_solver->download(m_particles);
+    m_are_particles_on_device_newer = false;
+
+    updateVertexBuffers();
 }
 
-void elasty::Engine::addInstantConstraint(std::shared_ptr<Constraint> constraint)
+void elasty::Engine::updateVertexBuffers()
 {
-    m_instant_constraints.push_back(constraint);
+    if (m_cloth_vertex_buffers.empty()) { return; }
+
+    ELASTY_PROFILE_SCOPE(m_profiler, "VertexBuffers");
+
+    ThreadPool* thread_pool = getThreadPool();
+    for (const auto& vertex_buffer : m_cloth_vertex_buffers)
+    {
+        vertex_buffer->update(m_particles, thread_pool);
+    }
 }
 
 void elasty::Engine::clearScene()
@@ -63,4 +272,368 @@ void elasty::Engine::clearScene()
     m_particles.clear();
     m_constraints.clear();
     m_instant_constraints.clear();
+    m_coloring.clear();
+    m_distance_batch.clear();
+    m_jacobi_projection.clear();
+    m_projective_dynamics_solver.clear();
+    m_sleeping_islands.clear();
+
+    // These refer to the particles of the cleared scene by their offsets
+    m_cloth_hierarchies.clear();
+    m_cloth_vertex_buffers.clear();
+
+    m_are_particles_on_device_newer = false;
+    m_is_device_scene_outdated = true;
+}
+
+elasty::ResidualStatistics elasty::Engine::calculateResidualStatistics() const
+{
+    ResidualAccumulator accumulator;
+
+    m_constraints.forEachBatch([&](const auto& constraints)
+    {
+        using Type = typename std::decay_t<decltype(constraints)>::value_type;
+
+        if constexpr (Type::getType() == ConstraintType::Bilateral)
+        {
+            for (const auto& constraint : constraints)
+            {
+                accumulator.add(constraint.calculateValue(m_particles));
+            }
+        }
+    });
+
+    return accumulator.getStatistics();
+}
+
+elasty::ThreadPool* elasty::Engine::getThreadPool()
+{
+    if (m_num_threads <= 1) { return nullptr; }
+
+    if (m_thread_pool == nullptr || m_thread_pool->getNumThreads() != m_num_threads)
+    {
+        m_thread_pool = std::make_unique<ThreadPool>(m_num_threads);
+    }
+    return m_thread_pool.get();
+}
+
+void elasty::Engine::prepareProjection(const Scalar dt)
+{
+    const bool is_parallel = getThreadPool() != nullptr;
+
+    if (m_framework == Framework::ProjectiveDynamics)
+    {
+        if (!m_projective_dynamics_solver.isUpToDate(m_constraints, m_particles, dt, m_projective_dynamics_weight_scale))
+        {
+            m_projective_dynamics_solver.build(m_constraints, m_particles, dt, m_projective_dynamics_weight_scale);
+        }
+        return;
+    }
+
+    const bool is_jacobi = m_projection_scheme == ProjectionScheme::Jacobi;
+    if (is_jacobi && !m_jacobi_projection.isUpToDate(m_constraints, m_particles.size()))
+    {
+        m_jacobi_projection.build(m_constraints, m_particles.size());
+    }
+    if (!is_jacobi && (is_parallel || m_use_vectorized_kernels) && !m_coloring.isUpToDate(m_constraints))
+    {
+        m_coloring.build(m_constraints, m_particles.size());
+    }
+
+    const std::vector<DistanceConstraint>& distance_constraints = m_constraints.get<DistanceConstraint>();
+    if (!is_jacobi && m_use_vectorized_kernels)
+    {
+        if (m_distance_batch.size() != distance_constraints.size())
+        {
+            m_distance_batch.build(distance_constraints);
+        }
+        else
+        {
+            m_distance_batch.updateParameters(distance_constraints);
+        }
+    }
+}
+
+void elasty::Engine::solveConstraints(const Scalar dt)
+{
+    const bool is_parallel = m_num_threads > 1;
+    const bool is_pd = m_framework == Framework::ProjectiveDynamics;
+    const bool is_jacobi = !is_pd && m_projection_scheme == ProjectionScheme::Jacobi;
+    const bool is_colored = !is_pd && !is_jacobi && (is_parallel || m_use_vectorized_kernels);
+    const bool is_xpbd = m_framework == Framework::Xpbd;
+
+    m_last_num_iterations = 0;
+    m_last_residual = 0.0;
+
+    // Nothing can move while all the islands are asleep
+    if (m_is_sleeping_enabled && m_sleeping_islands.areAllIslandsAsleep()) { return; }
+
+    const bool is_skipping_sleeping = m_is_sleeping_enabled && m_sleeping_islands.hasSleepingIsland();
+
+    // The Lagrange multipliers are accumulated within each (sub)step
+    if (is_xpbd)
+    {
+        m_constraints.forEachBatch([](auto& constraints)
+        {
+            for (auto& constraint : constraints) { constraint.m_lambda = 0.0; }
+        });
+    }
+
+    // The residual is measured on the fly during the Gauss-Seidel sweeps, as
+    // the value of each bilateral constraint right before its projection
+    const bool is_adaptive = m_residual_tolerance > 0.0;
+
+    auto project = [&](auto& constraint, ResidualAccumulator* residual)
+    {
+        using Type = std::decay_t<decltype(constraint)>;
+
+        if (is_skipping_sleeping && m_sleeping_islands.isConstraintAsleep(constraint)) { return; }
+
+        Scalar C = 0.0;
+        Scalar* value = (Type::getType() == ConstraintType::Bilateral && residual != nullptr) ? &C : nullptr;
+
+        if (is_xpbd)
+        {
+            constraint.projectParticlesXpbd(m_particles, dt, value);
+        }
+        else
+        {
+            constraint.projectParticles(m_particles, value);
+        }
+
+        if (value != nullptr) { residual->add(C); }
+    };
+
+    auto calculate_correction = [&](auto& constraint, auto& delta_x)
+    {
+        if (is_skipping_sleeping && m_sleeping_islands.isConstraintAsleep(constraint)) { return false; }
+
+        return is_xpbd ? constraint.calculateXpbdCorrection(m_particles, dt, delta_x) : constraint.calculateCorrection(m_particles, delta_x);
+    };
+
+    auto project_batch = [&](auto& constraints, ResidualAccumulator* residual)
+    {
+        for (auto& constraint : constraints)
+        {
+            project(constraint, residual);
+        }
+    };
+
+    // The inertial term is of the predicted positions before any projection
+    if (is_pd)
+    {
+        m_projective_dynamics_solver.setInertialPositions(m_particles);
+    }
+
+    // Remove the large-scale stretching first, which the iterations below
+    // would propagate only slowly across a fine mesh
+    for (const auto& cloth_hierarchy : m_cloth_hierarchies)
+    {
+        ELASTY_PROFILE_SCOPE(m_profiler, "ClothHierarchy");
+        cloth_hierarchy->project(m_particles);
+    }
+
+    // The acceleration starts from the positions before the first iteration
+    const bool is_accelerated = m_acceleration != Acceleration::None;
+    Scalar chebyshev_weight = 1.0;
+
+    if (is_accelerated)
+    {
+        m_previous_positions = m_particles.p;
+        m_older_positions = m_particles.p;
+    }
+
+    for (unsigned int i = 0; i < m_num_iterations; ++ i)
+    {
+        ELASTY_PROFILE_SCOPE(m_profiler, "Iteration");
+
+        // The convergence is not checked before the minimum number of iterations
+        const bool is_checking_convergence = is_adaptive && i + 1 >= m_min_num_iterations;
+
+        ResidualAccumulator accumulator;
+        ResidualAccumulator* residual = (is_checking_convergence && !is_pd && !is_jacobi) ? &accumulator : nullptr;
+
+        if (is_pd)
+        {
+            ELASTY_PROFILE_SCOPE(m_profiler, "ProjectiveDynamics");
+            m_projective_dynamics_solver.project(m_constraints, m_particles, is_parallel ? m_thread_pool.get() : nullptr);
+        }
+        else if (is_jacobi)
+        {
+            ELASTY_PROFILE_SCOPE(m_profiler, "JacobiProjection");
+            m_jacobi_projection.project(m_constraints, m_particles, m_jacobi_relaxation, is_parallel ? m_thread_pool.get() : nullptr, calculate_correction);
+        }
+        else if (is_colored)
+        {
+            projectConstraintsByColor(project, dt, residual);
+        }
+        else
+        {
+            m_constraints.forEachBatch([&](auto& constraints)
+            {
+                if (constraints.empty()) { return; }
+
+                ELASTY_PROFILE_SCOPE(m_profiler, getConstraintTypeName<typename std::decay_t<decltype(constraints)>::value_type>());
+                project_batch(constraints, residual);
+            });
+        }
+
+        if (is_accelerated)
+        {
+            ELASTY_PROFILE_SCOPE(m_profiler, "Acceleration");
+            accelerateIteration(i, chebyshev_weight);
+        }
+
+        {
+            ELASTY_PROFILE_SCOPE(m_profiler, "InstantConstraints");
+            m_instant_constraints.forEachBatch([&](auto& constraints) { project_batch(constraints, nullptr); });
+        }
+
+        m_last_num_iterations = i + 1;
+
+        if (!is_checking_convergence) { continue; }
+
+        // The schemes updating all the particles at once do not see the
+        // individual values, so the residual is evaluated after the sweep
+        const ResidualStatistics statistics = (residual != nullptr) ? residual->getStatistics() : calculateResidualStatistics();
+
+        m_last_residual = (m_residual_norm == ResidualNorm::Max) ? statistics.max : statistics.rms;
+
+        if (m_last_residual <= m_residual_tolerance) { break; }
+    }
+
+    if (is_colored && is_xpbd && m_use_vectorized_kernels)
+    {
+        m_distance_batch.writeLagrangeMultipliers(m_constraints.get<DistanceConstraint>());
+    }
+}
+
+void elasty::Engine::accelerateIteration(const unsigned int iteration, Scalar& chebyshev_weight)
+{
+    const std::size_t num_particles = m_particles.size();
+
+    ThreadPool* thread_pool = m_num_threads > 1 ? m_thread_pool.get() : nullptr;
+    auto parallel_for = [&](const auto& function)
+    {
+        if (thread_pool != nullptr) { thread_pool->parallelFor(0, num_particles, function); } else { function(0, num_particles); }
+    };
+
+    std::vector<Vector3>& p = m_particles.p;
+
+    if (m_acceleration == Acceleration::OverRelaxation)
+    {
+        const Scalar omega = m_over_relaxation;
+        parallel_for([&](const std::size_t begin, const std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; ++ i)
+            {
+                p[i] = m_previous_positions[i] + omega * (p[i] - m_previous_positions[i]);
+                m_previous_positions[i] = p[i];
+            }
+        });
+        return;
+    }
+
+    // The weight sequence of [Wang 2015], where the particles that nothing
+    // moves (e.g., of zero inverse masses) stay where they are
+    const Scalar rho_squared = m_chebyshev_spectral_radius * m_chebyshev_spectral_radius;
+    if (iteration < m_chebyshev_delay)
+    {
+        chebyshev_weight = 1.0;
+    }
+    else if (iteration == m_chebyshev_delay)
+    {
+        chebyshev_weight = 2.0 / (2.0 - rho_squared);
+    }
+    else
+    {
+        chebyshev_weight = 4.0 / (4.0 - rho_squared * chebyshev_weight);
+    }
+
+    const Scalar omega = chebyshev_weight;
+    parallel_for([&](const std::size_t begin, const std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++ i)
+        {
+            p[i] = m_older_positions[i] + omega * (p[i] - m_older_positions[i]);
+            m_older_positions[i] = m_previous_positions[i];
+            m_previous_positions[i] = p[i];
+        }
+    });
+}
+
+template <typename ProjectFunction>
+void elasty::Engine::projectConstraintsByColor(ProjectFunction&& project, const Scalar dt, ResidualAccumulator* residual)
+{
+    const bool is_xpbd = m_framework == Framework::Xpbd;
+
+    auto parallel_for = [&](const std::size_t begin, const std::size_t end, const auto& function)
+    {
+        if (m_thread_pool != nullptr && m_num_threads > 1)
+        {
+            m_thread_pool->parallelFor(begin, end, function);
+        }
+        else
+        {
+            function(begin, end);
+        }
+    };
+
+    // Each chunk accumulates its own residual and merges it once at its end
+    std::mutex residual_mutex;
+
+    std::size_t batch_index = 0;
+
+    m_constraints.forEachBatch([&](auto& constraints)
+    {
+        using Type = typename std::decay_t<decltype(constraints)>::value_type;
+
+        const std::vector<std::size_t>& color_offsets = m_coloring.getColorOffsets(batch_index ++);
+
+        if (constraints.empty()) { return; }
+
+        ELASTY_PROFILE_SCOPE(m_profiler, getConstraintTypeName<Type>());
+
+        // Colors are processed one after another, while the constraints
+        // within a color share no particle and can be projected concurrently
+        for (std::size_t color = 0; color + 1 < color_offsets.size(); ++ color)
+        {
+            if constexpr (std::is_same<Type, DistanceConstraint>::value)
+            {
+                if (m_use_vectorized_kernels)
+                {
+                    parallel_for(color_offsets[color], color_offsets[color + 1], [&](const std::size_t begin, const std::size_t end)
+                    {
+                        projectDistanceConstraintBatch(m_distance_batch, begin, end, m_particles.p.front().data(), is_xpbd, dt, residual != nullptr);
+                        ELASTY_PROFILE_COUNT(ProjectedConstraints, end - begin);
+
+                        if (residual != nullptr)
+                        {
+                            ResidualAccumulator local_residual;
+                            for (std::size_t i = begin; i < end; ++ i) { local_residual.add(m_distance_batch.m_values[i]); }
+
+                            const std::lock_guard<std::mutex> lock(residual_mutex);
+                            residual->merge(local_residual);
+                        }
+                    });
+                    continue;
+                }
+            }
+
+            parallel_for(color_offsets[color], color_offsets[color + 1], [&](const std::size_t begin, const std::size_t end)
+            {
+                ResidualAccumulator local_residual;
+                for (std::size_t i = begin; i < end; ++ i)
+                {
+                    project(constraints[i], residual != nullptr ? &local_residual : nullptr);
+                }
+
+                if (residual != nullptr)
+                {
+                    const std::lock_guard<std::mutex> lock(residual_mutex);
+                    residual->merge(local_residual);
+                }
+            });
+        }
+    });
 }
@@ -0,0 +1,60 @@
+#include <elasty/graph-coloring.hpp>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+
+std::vector<unsigned int> elasty::calculateGreedyColoring(const std::vector<unsigned int>& indices,
+                                                          const unsigned int num_particles_per_constraint,
+                                                          const std::size_t num_particles)
+{
+    assert(num_particles_per_constraint > 0);
+    assert(indices.size() % num_particles_per_constraint == 0);
+
+    constexpr unsigned int uncolored = std::numeric_limits<unsigned int>::max();
+    constexpr unsigned int num_colors_per_pass = 64;
+
+    const std::size_t num_constraints = indices.size() / num_particles_per_constraint;
+
+    std::vector<unsigned int> colors(num_constraints, uncolored);
+
+    // Colors are assigned in passes of 64 colors, where each particle keeps
+    // the colors used by its constraints as a bit mask. Most meshes need only
+    // a single pass.
+    std::vector<std::uint64_t> used_colors(num_particles);
+    std::size_t num_remaining_constraints = num_constraints;
+    for (unsigned int base_color = 0; num_remaining_constraints != 0; base_color += num_colors_per_pass)
+    {
+        std::fill(used_colors.begin(), used_colors.end(), 0);
+
+        for (std::size_t i = 0; i < num_constraints; ++ i)
+        {
+            if (colors[i] != uncolored) { continue; }
+
+            const unsigned int* constraint_indices = indices.data() + num_particles_per_constraint * i;
+
+            std::uint64_t mask = 0;
+            for (unsigned int j = 0; j < num_particles_per_constraint; ++ j)
+            {
+                assert(constraint_indices[j] < num_particles);
+                mask |= used_colors[constraint_indices[j]];
+            }
+
+            // All the colors of this pass are taken by the neighbors
+            if (mask == ~std::uint64_t(0)) { continue; }
+
+            // Find the lowest zero bit
+            unsigned int color = 0;
+            while ((mask >> color) & 1) { ++ color; }
+
+            for (unsigned int j = 0; j < num_particles_per_constraint; ++ j)
+            {
+                used_colors[constraint_indices[j]] |= std::uint64_t(1) << color;
+            }
+
+            colors[i] = base_color + color;
+            -- num_remaining_constraints;
+        }
+    }
+
+    return colors;
+}
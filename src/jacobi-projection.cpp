@@ -0,0 +1,40 @@
+#include <elasty/jacobi-projection.hpp>
+#include <cassert>
+
+void elasty::JacobiProjection::clear()
+{
+    m_batch_sizes.clear();
+    m_batch_slot_offsets.clear();
+    m_slot_corrections.clear();
+    m_is_slot_active.clear();
+    m_particle_slot_offsets.clear();
+    m_particle_slots.clear();
+}
+
+void elasty::JacobiProjection::buildSlotAdjacency(const std::vector<unsigned int>& slot_particles,
+                                                  const std::size_t num_particles)
+{
+    const std::size_t num_slots = slot_particles.size();
+
+    m_slot_corrections.assign(num_slots, Vector3::Zero());
+    m_is_slot_active.assign(num_slots, 0);
+
+    // Counting sort of the slots by their particles
+    m_particle_slot_offsets.assign(num_particles + 1, 0);
+    for (const unsigned int particle : slot_particles)
+    {
+        assert(particle < num_particles);
+        ++ m_particle_slot_offsets[particle + 1];
+    }
+    for (std::size_t i = 0; i < num_particles; ++ i)
+    {
+        m_particle_slot_offsets[i + 1] += m_particle_slot_offsets[i];
+    }
+
+    std::vector<std::size_t> positions(m_particle_slot_offsets.begin(), m_particle_slot_offsets.end() - 1);
+    m_particle_slots.resize(num_slots);
+    for (std::size_t slot = 0; slot < num_slots; ++ slot)
+    {
+        m_particle_slots[positions[slot_particles[slot]] ++] = slot;
+    }
+}
@@ -0,0 +1,149 @@
+#include <elasty/mesh-topology.hpp>
+#include <elasty/thread-pool.hpp>
+#include <algorithm>
+#include <cassert>
+#include <mutex>
+#include <utility>
+
+namespace
+{
+    // A key identifies an undirected edge by its (sorted) vertices, and the
+    // value packs the triangle index and the local index of the edge
+    using EdgeEntry = std::pair<std::uint64_t, std::uint64_t>;
+
+    inline std::uint64_t makeEdgeKey(const unsigned int vertex_0, const unsigned int vertex_1)
+    {
+        const std::uint64_t min_vertex = std::min(vertex_0, vertex_1);
+        const std::uint64_t max_vertex = std::max(vertex_0, vertex_1);
+        return (min_vertex << 32) | max_vertex;
+    }
+
+    void parallelFor(elasty::ThreadPool* thread_pool,
+                     const std::size_t begin,
+                     const std::size_t end,
+                     const std::function<void(std::size_t, std::size_t)>& function)
+    {
+        if (thread_pool != nullptr) { thread_pool->parallelFor(begin, end, function); } else { function(begin, end); }
+    }
+
+    // Sort the chunks of the threads in parallel, and then merge them
+    void parallelSort(elasty::ThreadPool* thread_pool, std::vector<EdgeEntry>& entries)
+    {
+        std::mutex mutex;
+        std::vector<std::pair<std::size_t, std::size_t>> chunks;
+
+        parallelFor(thread_pool, 0, entries.size(), [&](const std::size_t begin, const std::size_t end)
+        {
+            std::sort(entries.begin() + begin, entries.begin() + end);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            chunks.push_back({ begin, end });
+        });
+
+        std::sort(chunks.begin(), chunks.end());
+
+        while (chunks.size() > 1)
+        {
+            std::vector<std::pair<std::size_t, std::size_t>> merged_chunks;
+            for (std::size_t i = 0; i + 1 < chunks.size(); i += 2)
+            {
+                assert(chunks[i].second == chunks[i + 1].first);
+
+                std::inplace_merge(entries.begin() + chunks[i].first,
+                                   entries.begin() + chunks[i].second,
+                                   entries.begin() + chunks[i + 1].second);
+                merged_chunks.push_back({ chunks[i].first, chunks[i + 1].second });
+            }
+            if (chunks.size() % 2 == 1) { merged_chunks.push_back(chunks.back()); }
+
+            chunks = std::move(merged_chunks);
+        }
+    }
+}
+
+void elasty::MeshTopology::build(const TriangleList& triangles, const unsigned int num_vertices, ThreadPool* thread_pool)
+{
+    const std::size_t num_triangles = triangles.rows();
+
+    // Collect the edges of all the triangles and sort them by key, so that
+    // the occurrences of each edge become adjacent
+    std::vector<EdgeEntry> entries(3 * num_triangles);
+    parallelFor(thread_pool, 0, num_triangles, [&](const std::size_t begin, const std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++ i)
+        {
+            for (unsigned int k = 0; k < 3; ++ k)
+            {
+                const unsigned int vertex_0 = triangles(i, (k + 1) % 3);
+                const unsigned int vertex_1 = triangles(i, (k + 2) % 3);
+
+                entries[3 * i + k] = { makeEdgeKey(vertex_0, vertex_1), 3 * i + k };
+            }
+        }
+    });
+
+    parallelSort(thread_pool, entries);
+
+    // Merge the occurrences of each edge into a single edge
+    m_edges.clear();
+    m_triangle_edges.resize(num_triangles);
+    for (std::size_t i = 0; i < entries.size();)
+    {
+        std::size_t j = i + 1;
+        while (j < entries.size() && entries[j].first == entries[i].first) { ++ j; }
+
+        // Each edge should be shared by at most two triangles
+        assert(j - i == 1 || j - i == 2);
+
+        const unsigned int edge_index = static_cast<unsigned int>(m_edges.size());
+
+        Edge edge;
+        edge.vertices = { static_cast<unsigned int>(entries[i].first >> 32), static_cast<unsigned int>(entries[i].first & 0xffffffff) };
+        edge.triangles = { invalid_index, invalid_index };
+        edge.opposite_vertices = { invalid_index, invalid_index };
+
+        for (std::size_t side = 0; side < std::min<std::size_t>(j - i, 2); ++ side)
+        {
+            const unsigned int triangle = static_cast<unsigned int>(entries[i + side].second / 3);
+            const unsigned int local_index = static_cast<unsigned int>(entries[i + side].second % 3);
+
+            edge.triangles[side] = triangle;
+            edge.opposite_vertices[side] = triangles(triangle, local_index);
+        }
+
+        for (std::size_t l = i; l < j; ++ l)
+        {
+            m_triangle_edges[entries[l].second / 3][entries[l].second % 3] = edge_index;
+        }
+
+        m_edges.push_back(edge);
+
+        i = j;
+    }
+
+    // Build the vertex-to-triangle adjacency by a counting sort
+    m_vertex_triangle_offsets.assign(num_vertices + 1, 0);
+    for (std::size_t i = 0; i < num_triangles; ++ i)
+    {
+        for (unsigned int k = 0; k < 3; ++ k) { ++ m_vertex_triangle_offsets[triangles(i, k) + 1]; }
+    }
+    for (unsigned int v = 0; v < num_vertices; ++ v)
+    {
+        m_vertex_triangle_offsets[v + 1] += m_vertex_triangle_offsets[v];
+    }
+
+    std::vector<unsigned int> positions(m_vertex_triangle_offsets.begin(), m_vertex_triangle_offsets.end() - 1);
+    m_vertex_triangles.resize(3 * num_triangles);
+    for (std::size_t i = 0; i < num_triangles; ++ i)
+    {
+        for (unsigned int k = 0; k < 3; ++ k) { m_vertex_triangles[positions[triangles(i, k)] ++] = static_cast<unsigned int>(i); }
+    }
+}
+
+void elasty::MeshTopology::clear()
+{
+    m_edges.clear();
+    m_triangle_edges.clear();
+    m_vertex_triangle_offsets.clear();
+    m_vertex_triangles.clear();
+}
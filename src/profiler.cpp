@@ -0,0 +1,93 @@
+#include <elasty/profiler.hpp>
+#include <fstream>
+#include <stdexcept>
+
+void elasty::Profiler::clear()
+{
+    m_origin = std::chrono::steady_clock::now();
+    m_events.clear();
+    m_steps.clear();
+}
+
+void elasty::Profiler::recordEvent(const char* name,
+                                   const std::chrono::steady_clock::time_point begin,
+                                   const std::chrono::steady_clock::time_point end)
+{
+    m_events.push_back({ name, getTimestamp(begin), std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() });
+}
+
+std::map<std::string, double> elasty::Profiler::calculateTotalDurations() const
+{
+    std::map<std::string, double> total_durations;
+    for (const Event& event : m_events)
+    {
+        total_durations[event.name] += 1e-06 * double(event.duration);
+    }
+    return total_durations;
+}
+
+void elasty::Profiler::writeChromeTrace(const std::string& path) const
+{
+    std::ofstream file(path);
+    if (!file) { throw std::runtime_error("Failed to open " + path); }
+
+    // The timestamps of the format are in microseconds
+    auto to_microseconds = [](const std::int64_t nanoseconds) { return 1e-03 * double(nanoseconds); };
+
+    file << "{\"traceEvents\":[\n";
+
+    bool is_first = true;
+    auto begin_event = [&]()
+    {
+        if (!is_first) { file << ",\n"; }
+        is_first = false;
+    };
+
+    for (const Event& event : m_events)
+    {
+        begin_event();
+        file << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":" << to_microseconds(event.begin)
+             << ",\"dur\":" << to_microseconds(event.duration) << "}";
+    }
+
+    for (const StepRecord& step : m_steps)
+    {
+        begin_event();
+        file << "{\"name\":\"Counters\",\"ph\":\"C\",\"pid\":0,\"ts\":" << to_microseconds(step.begin) << ",\"args\":{";
+        for (std::size_t i = 0; i < num_counters; ++ i)
+        {
+            file << (i == 0 ? "" : ",") << "\"" << getCounterName(static_cast<Counter>(i)) << "\":" << step.counts[i];
+        }
+        file << "}}";
+
+        begin_event();
+        file << "{\"name\":\"Residual\",\"ph\":\"C\",\"pid\":0,\"ts\":" << to_microseconds(step.begin) << ",\"args\":{\"max\":"
+             << step.residual.max << ",\"rms\":" << step.residual.rms << "}}";
+    }
+
+    file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    if (!file) { throw std::runtime_error("Failed to write " + path); }
+}
+
+elasty::Profiler::Counts elasty::Profiler::takeCounts()
+{
+    Counts counts;
+    for (std::size_t i = 0; i < num_counters; ++ i)
+    {
+        counts[i] = s_counts[i].exchange(0, std::memory_order_relaxed);
+    }
+    return counts;
+}
+
+const char* elasty::Profiler::getCounterName(const Counter counter)
+{
+    switch (counter)
+    {
+        case Counter::ProjectedConstraints: return "ProjectedConstraints";
+        case Counter::InactiveConstraints: return "InactiveConstraints";
+        case Counter::DegenerateConstraints: return "DegenerateConstraints";
+        case Counter::Contacts: return "Contacts";
+    }
+    return "";
+}
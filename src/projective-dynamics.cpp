@@ -0,0 +1,147 @@
+#include <elasty/projective-dynamics.hpp>
+#include <cassert>
+#include <stdexcept>
+
+void elasty::ProjectiveDynamicsSolver::clear()
+{
+    m_batch_sizes.clear();
+    m_stiffnesses.clear();
+    m_inverse_masses.clear();
+    m_dt = 0.0;
+    m_weight_scale = 0.0;
+    m_batch_slot_offsets.clear();
+    m_slot_weights.clear();
+    m_slot_values.clear();
+    m_unknown_slot_offsets.clear();
+    m_unknown_slots.clear();
+    m_unknown_particles.clear();
+    m_inertia.resize(0);
+    m_inertial_rhs.resize(0, 3);
+    m_rhs.resize(0, 3);
+    m_solution.resize(0, 3);
+}
+
+void elasty::ProjectiveDynamicsSolver::factorize(const std::vector<unsigned int>& slot_particles,
+                                                 const std::vector<Scalar>& slot_weights,
+                                                 const std::vector<unsigned int>& slot_sizes,
+                                                 const ParticleSet& particles,
+                                                 const Scalar dt)
+{
+    const std::size_t num_particles = particles.size();
+    const std::size_t num_slots = slot_particles.size();
+
+    // Number the particles of nonzero inverse masses
+    std::vector<int> particle_unknowns(num_particles, -1);
+    m_unknown_particles.clear();
+    for (std::size_t i = 0; i < num_particles; ++ i)
+    {
+        if (particles.w[i] == 0.0) { continue; }
+
+        particle_unknowns[i] = static_cast<int>(m_unknown_particles.size());
+        m_unknown_particles.push_back(static_cast<unsigned int>(i));
+    }
+    const std::size_t num_unknowns = m_unknown_particles.size();
+
+    // Counting sort of the slots by their unknowns
+    m_unknown_slot_offsets.assign(num_unknowns + 1, 0);
+    for (const unsigned int particle : slot_particles)
+    {
+        assert(particle < num_particles);
+        if (particle_unknowns[particle] >= 0) { ++ m_unknown_slot_offsets[particle_unknowns[particle] + 1]; }
+    }
+    for (std::size_t i = 0; i < num_unknowns; ++ i)
+    {
+        m_unknown_slot_offsets[i + 1] += m_unknown_slot_offsets[i];
+    }
+
+    std::vector<std::size_t> positions(m_unknown_slot_offsets.begin(), m_unknown_slot_offsets.end() - 1);
+    m_unknown_slots.resize(m_unknown_slot_offsets.back());
+    for (std::size_t slot = 0; slot < num_slots; ++ slot)
+    {
+        const int unknown = particle_unknowns[slot_particles[slot]];
+        if (unknown >= 0) { m_unknown_slots[positions[unknown] ++] = slot; }
+    }
+
+    // The system matrix $M / h^2 + \sum_c w_c S_c^T A S_c$
+    std::vector<Eigen::Triplet<double>> triplets;
+
+    m_inertia.resize(num_unknowns);
+    for (std::size_t i = 0; i < num_unknowns; ++ i)
+    {
+        m_inertia(i) = double(particles.m[m_unknown_particles[i]]) / (double(dt) * double(dt));
+        triplets.emplace_back(i, i, m_inertia(i));
+    }
+
+    for (std::size_t slot = 0; slot < num_slots; slot += slot_sizes[slot])
+    {
+        const unsigned int size = slot_sizes[slot];
+        const Scalar weight = slot_weights[slot];
+
+        if (weight == 0.0) { continue; }
+
+        for (unsigned int j = 0; j < size; ++ j)
+        {
+            const int unknown_j = particle_unknowns[slot_particles[slot + j]];
+            if (unknown_j < 0) { continue; }
+
+            for (unsigned int k = 0; k < size; ++ k)
+            {
+                const int unknown_k = particle_unknowns[slot_particles[slot + k]];
+                if (unknown_k < 0) { continue; }
+
+                const double a = (size == 1) ? 1.0 : (((j == k) ? 1.0 : 0.0) - 1.0 / double(size));
+                triplets.emplace_back(unknown_j, unknown_k, double(weight) * a);
+            }
+        }
+    }
+
+    Eigen::SparseMatrix<double> matrix(num_unknowns, num_unknowns);
+    matrix.setFromTriplets(triplets.begin(), triplets.end());
+
+    m_ldlt.compute(matrix);
+    if (m_ldlt.info() != Eigen::Success) { throw std::runtime_error("Failed to factorize the projective dynamics system"); }
+
+    m_slot_weights = slot_weights;
+    m_slot_values.assign(num_slots, Vector3::Zero());
+
+    m_inertial_rhs.resize(num_unknowns, 3);
+    m_rhs.resize(num_unknowns, 3);
+    m_solution.resize(num_unknowns, 3);
+}
+
+void elasty::ProjectiveDynamicsSolver::setInertialPositions(const ParticleSet& particles)
+{
+    for (std::size_t i = 0; i < m_unknown_particles.size(); ++ i)
+    {
+        m_inertial_rhs.row(i) = m_inertia(i) * particles.p[m_unknown_particles[i]].cast<double>().transpose();
+    }
+}
+
+void elasty::ProjectiveDynamicsSolver::solveGlobalStep(ParticleSet& particles, ThreadPool* thread_pool)
+{
+    const std::size_t num_unknowns = m_unknown_particles.size();
+
+    // Gather the right-hand side
+    auto gather = [&](const std::size_t begin, const std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++ i)
+        {
+            Eigen::Vector3d sum = m_inertial_rhs.row(i).transpose();
+            for (std::size_t k = m_unknown_slot_offsets[i]; k < m_unknown_slot_offsets[i + 1]; ++ k)
+            {
+                sum += m_slot_values[m_unknown_slots[k]].cast<double>();
+            }
+            m_rhs.row(i) = sum.transpose();
+        }
+    };
+
+    if (thread_pool != nullptr) { thread_pool->parallelFor(0, num_unknowns, gather); } else { gather(0, num_unknowns); }
+
+    // The three coordinates are solved with the same factorization
+    m_solution = m_ldlt.solve(m_rhs);
+
+    for (std::size_t i = 0; i < num_unknowns; ++ i)
+    {
+        particles.p[m_unknown_particles[i]] = m_solution.row(i).transpose().cast<Scalar>();
+    }
+}
@@ -0,0 +1,251 @@
+#include <elasty/self-collision.hpp>
+#include <elasty/particle-set.hpp>
+#include <elasty/thread-pool.hpp>
+#include <algorithm>
+#include <limits>
+#include <Eigen/Geometry>
+
+namespace
+{
+    inline std::uint64_t makePairKey(const unsigned int index_0, const unsigned int index_1)
+    {
+        const std::uint64_t min_index = std::min(index_0, index_1);
+        const std::uint64_t max_index = std::max(index_0, index_1);
+        return (min_index << 32) | max_index;
+    }
+
+    // Barycentric coordinates of the projection of the point p onto the plane
+    // of the triangle (a, b, c) [Ericson 2004, Section 3.4]
+    elasty::Vector3 calculateProjectionBarycentricCoords(const elasty::Vector3& p,
+                                                         const elasty::Vector3& a,
+                                                         const elasty::Vector3& b,
+                                                         const elasty::Vector3& c)
+    {
+        const elasty::Vector3 v_0 = b - a;
+        const elasty::Vector3 v_1 = c - a;
+        const elasty::Vector3 v_2 = p - a;
+
+        const elasty::Scalar d_00 = v_0.dot(v_0);
+        const elasty::Scalar d_01 = v_0.dot(v_1);
+        const elasty::Scalar d_11 = v_1.dot(v_1);
+        const elasty::Scalar d_20 = v_2.dot(v_0);
+        const elasty::Scalar d_21 = v_2.dot(v_1);
+
+        const elasty::Scalar denom = d_00 * d_11 - d_01 * d_01;
+        const elasty::Scalar v = (d_11 * d_20 - d_01 * d_21) / denom;
+        const elasty::Scalar w = (d_00 * d_21 - d_01 * d_20) / denom;
+        return elasty::Vector3(1.0 - v - w, v, w);
+    }
+
+    // The unit normal of the triangle (a, b, c), or false if the triangle is
+    // degenerate (i.e., its area is negligible for its edge lengths)
+    bool calculateUnitNormal(const elasty::Vector3& a, const elasty::Vector3& b, const elasty::Vector3& c, elasty::Vector3& unit_normal)
+    {
+        const elasty::Vector3 normal = (b - a).cross(c - a);
+        const elasty::Scalar squared_edge_length = std::max({ (b - a).squaredNorm(), (c - b).squaredNorm(), (a - c).squaredNorm() });
+
+        const elasty::Scalar norm = normal.norm();
+        if (!(norm > std::numeric_limits<elasty::Scalar>::epsilon() * squared_edge_length)) { return false; }
+
+        unit_normal = normal / norm;
+        return true;
+    }
+}
+
+elasty::SelfCollisionDetector::SelfCollisionDetector(const Scalar thickness, const Scalar stiffness) :
+m_thickness(thickness),
+m_stiffness(stiffness)
+{
+}
+
+void elasty::SelfCollisionDetector::addTriangles(const MeshTopology::TriangleList& triangle_list, const unsigned int particle_offset)
+{
+    for (unsigned int i = 0; i < triangle_list.rows(); ++ i)
+    {
+        const unsigned int index_0 = particle_offset + triangle_list(i, 0);
+        const unsigned int index_1 = particle_offset + triangle_list(i, 1);
+        const unsigned int index_2 = particle_offset + triangle_list(i, 2);
+
+        m_triangles.push_back({ index_0, index_1, index_2 });
+
+        m_excluded_pairs.push_back(makePairKey(index_0, index_1));
+        m_excluded_pairs.push_back(makePairKey(index_1, index_2));
+        m_excluded_pairs.push_back(makePairKey(index_2, index_0));
+    }
+
+    std::sort(m_excluded_pairs.begin(), m_excluded_pairs.end());
+    m_excluded_pairs.erase(std::unique(m_excluded_pairs.begin(), m_excluded_pairs.end()), m_excluded_pairs.end());
+}
+
+void elasty::SelfCollisionDetector::clear()
+{
+    m_triangles.clear();
+    m_excluded_pairs.clear();
+}
+
+bool elasty::SelfCollisionDetector::isExcludedPair(const unsigned int index_0, const unsigned int index_1) const
+{
+    return std::binary_search(m_excluded_pairs.begin(), m_excluded_pairs.end(), makePairKey(index_0, index_1));
+}
+
+template <typename Function>
+void elasty::SelfCollisionDetector::runInChunks(ThreadPool* thread_pool, const std::size_t num_elements, Function&& function)
+{
+    const std::size_t num_threads = (thread_pool != nullptr) ? thread_pool->getNumThreads() : 1;
+    while (m_chunk_results.size() < num_threads) { m_chunk_results.push_back(ChunkResult{ 0, {}, {} }); }
+
+    m_num_chunk_results = 0;
+
+    auto process_chunk = [&](const std::size_t begin, const std::size_t end)
+    {
+        ChunkResult* result;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            result = &m_chunk_results[m_num_chunk_results ++];
+        }
+
+        result->begin = begin;
+        result->particle_collisions.clear();
+        result->triangle_collisions.clear();
+
+        function(begin, end, *result);
+    };
+
+    if (thread_pool != nullptr) { thread_pool->parallelFor(0, num_elements, process_chunk); } else if (num_elements > 0) { process_chunk(0, num_elements); }
+
+    // Keep the order of the constraints independent of the scheduling
+    std::sort(m_chunk_results.begin(), m_chunk_results.begin() + m_num_chunk_results, [](const ChunkResult& a, const ChunkResult& b)
+    {
+        return a.begin < b.begin;
+    });
+}
+
+void elasty::SelfCollisionDetector::generateConstraints(const ParticleSet& particles, ConstraintSet& constraints, ThreadPool* thread_pool)
+{
+    if (particles.size() == 0) { return; }
+
+    // The cells should be at least as large as the thickness, and as large as
+    // the triangles so that a triangle overlaps only a few cells
+    Scalar sum_extents = 0.0;
+    for (const auto& triangle : m_triangles)
+    {
+        const Vector3& x_0 = particles.p[triangle[0]];
+        const Vector3& x_1 = particles.p[triangle[1]];
+        const Vector3& x_2 = particles.p[triangle[2]];
+
+        sum_extents += (x_0.cwiseMax(x_1).cwiseMax(x_2) - x_0.cwiseMin(x_1).cwiseMin(x_2)).maxCoeff();
+    }
+    const Scalar mean_extent = m_triangles.empty() ? 0.0 : sum_extents / Scalar(m_triangles.size());
+    const Scalar cell_size = std::max(Scalar(2.0) * m_thickness, mean_extent);
+
+    m_spatial_hash.build(particles.p, cell_size, thread_pool);
+
+    const Vector3 margin = Vector3::Constant(m_thickness);
+
+    if (m_is_particle_collision_enabled)
+    {
+        runInChunks(thread_pool, particles.size(), [&](const std::size_t begin, const std::size_t end, ChunkResult& result)
+        {
+            for (std::size_t i = begin; i < end; ++ i)
+            {
+                const Vector3& x_i = particles.p[i];
+
+                m_spatial_hash.forEachPointInBox(x_i - margin, x_i + margin, [&](const unsigned int j, const Vector3& x_j)
+                {
+                    if (j <= i) { return; }
+                    if (particles.w[i] == 0.0 && particles.w[j] == 0.0) { return; }
+                    if ((x_i - x_j).squaredNorm() >= m_thickness * m_thickness) { return; }
+                    if (isExcludedPair(i, j)) { return; }
+
+                    // As for the triangles, a pair that was already closer is only kept from getting closer
+                    const Scalar distance_x = (particles.x[i] - particles.x[j]).norm();
+                    const Scalar distance = std::min(distance_x, m_thickness);
+
+                    result.particle_collisions.push_back(ParticleCollisionConstraint(particles, i, j, m_stiffness, distance));
+                });
+            }
+        });
+
+        auto& output = constraints.get<ParticleCollisionConstraint>();
+        for (std::size_t c = 0; c < m_num_chunk_results; ++ c)
+        {
+            output.insert(output.end(), m_chunk_results[c].particle_collisions.begin(), m_chunk_results[c].particle_collisions.end());
+        }
+    }
+
+    if (m_is_triangle_collision_enabled)
+    {
+        runInChunks(thread_pool, m_triangles.size(), [&](const std::size_t begin, const std::size_t end, ChunkResult& result)
+        {
+            for (std::size_t t = begin; t < end; ++ t)
+            {
+                const std::array<unsigned int, 3>& triangle = m_triangles[t];
+
+                const Vector3& x_0 = particles.x[triangle[0]];
+                const Vector3& x_1 = particles.x[triangle[1]];
+                const Vector3& x_2 = particles.x[triangle[2]];
+                const Vector3& p_0 = particles.p[triangle[0]];
+                const Vector3& p_1 = particles.p[triangle[1]];
+                const Vector3& p_2 = particles.p[triangle[2]];
+
+                // A triangle degenerate at either end of the step has no side
+                Vector3 n_x;
+                Vector3 n_p;
+                if (!calculateUnitNormal(x_0, x_1, x_2, n_x) || !calculateUnitNormal(p_0, p_1, p_2, n_p)) { continue; }
+
+                // The box swept by the triangle during the step
+                const Vector3 box_min = x_0.cwiseMin(x_1).cwiseMin(x_2).cwiseMin(p_0).cwiseMin(p_1).cwiseMin(p_2) - margin;
+                const Vector3 box_max = x_0.cwiseMax(x_1).cwiseMax(x_2).cwiseMax(p_0).cwiseMax(p_1).cwiseMax(p_2) + margin;
+
+                m_spatial_hash.forEachPointInBox(box_min, box_max, [&](const unsigned int i, const Vector3& p)
+                {
+                    if (i == triangle[0] || i == triangle[1] || i == triangle[2]) { return; }
+
+                    // The neighbors of the triangle on the same mesh are near it by construction
+                    if (isExcludedPair(i, triangle[0]) || isExcludedPair(i, triangle[1]) || isExcludedPair(i, triangle[2])) { return; }
+                    if (particles.w[i] == 0.0 && particles.w[triangle[0]] == 0.0 && particles.w[triangle[1]] == 0.0 && particles.w[triangle[2]] == 0.0) { return; }
+
+                    // Only the particles above or below the triangle are handled; the
+                    // particles beside it are left to the adjacent triangles, as pushing
+                    // them along this normal would inject energy into the mesh
+                    const Vector3 barycentric_coords = calculateProjectionBarycentricCoords(p, p_0, p_1, p_2);
+                    if ((barycentric_coords.array() < 0.0).any()) { return; }
+
+                    const Scalar signed_distance_x = n_x.dot(particles.x[i] - x_0);
+                    const Scalar signed_distance_p = n_p.dot(p - p_0);
+
+                    const Scalar side = (signed_distance_x != 0.0) ? std::copysign(1.0, signed_distance_x) : std::copysign(1.0, signed_distance_p);
+
+                    const bool is_close = std::abs(signed_distance_p) < m_thickness;
+
+                    // Crossing the plane within the triangle during the step
+                    const bool has_crossed = side * signed_distance_p < 0.0;
+
+                    if (!is_close && !has_crossed) { return; }
+
+                    // A particle that was already within the thickness at the beginning
+                    // of the step is only kept from getting closer; pushing it out to the
+                    // full thickness at once would be a large velocity change
+                    const Scalar distance_x = side * signed_distance_x;
+                    const Scalar thickness = std::clamp(distance_x, Scalar(0.0), m_thickness);
+
+                    result.triangle_collisions.push_back(PointTriangleCollisionConstraint(particles,
+                                                                                          i,
+                                                                                          triangle[0],
+                                                                                          triangle[1],
+                                                                                          triangle[2],
+                                                                                          m_stiffness,
+                                                                                          thickness,
+                                                                                          barycentric_coords,
+                                                                                          side));
+                });
+            }
+        });
+
+        auto& output = constraints.get<PointTriangleCollisionConstraint>();
+        for (std::size_t c = 0; c < m_num_chunk_results; ++ c)
+        {
+            output.insert(output.end(), m_chunk_results[c].triangle_collisions.begin(), m_chunk_results[c].triangle_collisions.end());
+        }
+    }
+}
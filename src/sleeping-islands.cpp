@@ -0,0 +1,251 @@
+#include <elasty/sleeping-islands.hpp>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <type_traits>
+
+namespace
+{
+    unsigned int findRoot(std::vector<unsigned int>& parents, unsigned int index)
+    {
+        while (parents[index] != index)
+        {
+            // Path halving
+            parents[index] = parents[parents[index]];
+            index = parents[index];
+        }
+        return index;
+    }
+}
+
+void elasty::SleepingIslands::build(const ConstraintSet& constraints, const ParticleSet& particles)
+{
+    const std::size_t num_particles = particles.size();
+
+    // Union-find over the dynamic particles of each constraint
+    std::vector<unsigned int> parents(num_particles);
+    std::iota(parents.begin(), parents.end(), 0);
+
+    constraints.forEachBatch([&](const auto& batch)
+    {
+        for (const auto& constraint : batch)
+        {
+            bool has_root = false;
+            unsigned int root = 0;
+            for (const unsigned int index : constraint.getIndices())
+            {
+                if (particles.w[index] == 0.0) { continue; }
+
+                const unsigned int index_root = findRoot(parents, index);
+                if (!has_root)
+                {
+                    root = index_root;
+                    has_root = true;
+                }
+                else if (index_root != root)
+                {
+                    // Keep the smaller index as the root
+                    parents[std::max(index_root, root)] = std::min(index_root, root);
+                    root = std::min(index_root, root);
+                }
+            }
+        }
+    });
+
+    // Number the islands in the order of their smallest particle indices
+    m_particle_islands.assign(num_particles, -1);
+    std::vector<int32_t> root_islands(num_particles, -1);
+    int32_t num_islands = 0;
+    for (std::size_t i = 0; i < num_particles; ++ i)
+    {
+        if (particles.w[i] == 0.0) { continue; }
+
+        const unsigned int root = findRoot(parents, static_cast<unsigned int>(i));
+        if (root_islands[root] < 0) { root_islands[root] = num_islands ++; }
+        m_particle_islands[i] = root_islands[root];
+    }
+
+    m_island_offsets.assign(num_islands + 1, 0);
+    for (const int32_t island : m_particle_islands)
+    {
+        if (island >= 0) { ++ m_island_offsets[island + 1]; }
+    }
+    std::partial_sum(m_island_offsets.begin(), m_island_offsets.end(), m_island_offsets.begin());
+
+    m_island_particles.resize(m_island_offsets.back());
+    std::vector<std::size_t> cursors(m_island_offsets.begin(), m_island_offsets.end() - 1);
+    for (std::size_t i = 0; i < num_particles; ++ i)
+    {
+        if (m_particle_islands[i] >= 0) { m_island_particles[cursors[m_particle_islands[i]] ++] = static_cast<unsigned int>(i); }
+    }
+
+    // The kinematic particles that can wake up the islands
+    m_kinematic_neighbors.clear();
+    constraints.forEachBatch([&](const auto& batch)
+    {
+        for (const auto& constraint : batch)
+        {
+            int32_t island = -1;
+            for (const unsigned int index : constraint.getIndices())
+            {
+                if (m_particle_islands[index] >= 0) { island = m_particle_islands[index]; }
+            }
+            if (island < 0) { continue; }
+
+            for (const unsigned int index : constraint.getIndices())
+            {
+                if (m_particle_islands[index] < 0) { m_kinematic_neighbors.push_back({ index, island }); }
+            }
+        }
+    });
+    std::sort(m_kinematic_neighbors.begin(), m_kinematic_neighbors.end());
+    m_kinematic_neighbors.erase(std::unique(m_kinematic_neighbors.begin(), m_kinematic_neighbors.end()), m_kinematic_neighbors.end());
+
+    m_kinematic_positions.resize(m_kinematic_neighbors.size());
+    for (std::size_t k = 0; k < m_kinematic_neighbors.size(); ++ k)
+    {
+        m_kinematic_positions[k] = particles.p[m_kinematic_neighbors[k].first];
+    }
+
+    const auto& fixed_point_constraints = constraints.get<FixedPointConstraint>();
+    m_fixed_points.resize(fixed_point_constraints.size());
+    for (std::size_t c = 0; c < fixed_point_constraints.size(); ++ c)
+    {
+        m_fixed_points[c] = fixed_point_constraints[c].getPoint();
+    }
+
+    m_is_particle_resting.resize(num_particles);
+    for (std::size_t i = 0; i < num_particles; ++ i)
+    {
+        m_is_particle_resting[i] = (particles.w[i] == 0.0) ? 1 : 0;
+    }
+
+    m_is_island_asleep.assign(num_islands, 0);
+    m_num_resting_steps.assign(num_islands, 0);
+    m_num_sleeping_islands = 0;
+
+    m_batch_sizes = constraints.getBatchSizes();
+}
+
+void elasty::SleepingIslands::clear()
+{
+    m_batch_sizes.clear();
+    m_particle_islands.clear();
+    m_is_particle_resting.clear();
+    m_island_offsets.clear();
+    m_island_particles.clear();
+    m_is_island_asleep.clear();
+    m_num_resting_steps.clear();
+    m_num_sleeping_islands = 0;
+    m_kinematic_neighbors.clear();
+    m_kinematic_positions.clear();
+    m_fixed_points.clear();
+}
+
+void elasty::SleepingIslands::setIslandAsleep(const int32_t island, const bool is_asleep, const std::vector<Scalar>& inverse_masses)
+{
+    if (bool(m_is_island_asleep[island]) == is_asleep) { return; }
+
+    m_is_island_asleep[island] = is_asleep ? 1 : 0;
+    m_num_resting_steps[island] = 0;
+
+    if (is_asleep) { ++ m_num_sleeping_islands; } else { -- m_num_sleeping_islands; }
+
+    for (std::size_t k = m_island_offsets[island]; k < m_island_offsets[island + 1]; ++ k)
+    {
+        const unsigned int index = m_island_particles[k];
+        m_is_particle_resting[index] = (is_asleep || inverse_masses[index] == 0.0) ? 1 : 0;
+    }
+}
+
+void elasty::SleepingIslands::wakeUp(const ConstraintSet& constraints,
+                                     const ConstraintSet& instant_constraints,
+                                     const ParticleSet& particles,
+                                     const Scalar tolerance)
+{
+    // Moved kinematic particles
+    for (std::size_t k = 0; k < m_kinematic_neighbors.size(); ++ k)
+    {
+        const Vector3& position = particles.p[m_kinematic_neighbors[k].first];
+        if (position != m_kinematic_positions[k])
+        {
+            m_kinematic_positions[k] = position;
+            setIslandAsleep(m_kinematic_neighbors[k].second, false, particles.w);
+        }
+    }
+
+    // Moved fixed points
+    const auto& fixed_point_constraints = constraints.get<FixedPointConstraint>();
+    for (std::size_t c = 0; c < fixed_point_constraints.size(); ++ c)
+    {
+        if (fixed_point_constraints[c].getPoint() != m_fixed_points[c])
+        {
+            m_fixed_points[c] = fixed_point_constraints[c].getPoint();
+
+            const int32_t island = m_particle_islands[fixed_point_constraints[c].getIndices()[0]];
+            if (island >= 0) { setIslandAsleep(island, false, particles.w); }
+        }
+    }
+
+    if (m_num_sleeping_islands == 0) { return; }
+
+    // Instant constraints touching sleeping islands
+    instant_constraints.forEachBatch([&](const auto& batch)
+    {
+        using Constraint = typename std::decay_t<decltype(batch)>::value_type;
+
+        for (const auto& constraint : batch)
+        {
+            bool touches_sleeping_island = false;
+            bool touches_moving_particle = false;
+            for (const unsigned int index : constraint.getIndices())
+            {
+                const int32_t island = m_particle_islands[index];
+                if (island < 0) { continue; }
+                if (m_is_island_asleep[island]) { touches_sleeping_island = true; } else { touches_moving_particle = true; }
+            }
+            if (!touches_sleeping_island) { continue; }
+
+            const Scalar C = constraint.calculateValue(particles);
+            const bool is_violated = (Constraint::getType() == ConstraintType::Unilateral) ? C < - tolerance : std::abs(C) > tolerance;
+            if (!touches_moving_particle && !is_violated) { continue; }
+
+            for (const unsigned int index : constraint.getIndices())
+            {
+                if (m_particle_islands[index] >= 0) { setIslandAsleep(m_particle_islands[index], false, particles.w); }
+            }
+        }
+    });
+}
+
+void elasty::SleepingIslands::update(ParticleSet& particles, const Scalar speed_threshold, const unsigned int num_steps_to_sleep)
+{
+    const Scalar squared_speed_threshold = speed_threshold * speed_threshold;
+
+    for (int32_t island = 0; island < int32_t(m_is_island_asleep.size()); ++ island)
+    {
+        if (m_is_island_asleep[island]) { continue; }
+
+        bool is_resting = true;
+        for (std::size_t k = m_island_offsets[island]; k < m_island_offsets[island + 1]; ++ k)
+        {
+            if (particles.v[m_island_particles[k]].squaredNorm() > squared_speed_threshold)
+            {
+                is_resting = false;
+                break;
+            }
+        }
+
+        m_num_resting_steps[island] = is_resting ? m_num_resting_steps[island] + 1 : 0;
+
+        if (m_num_resting_steps[island] >= num_steps_to_sleep)
+        {
+            setIslandAsleep(island, true, particles.w);
+
+            for (std::size_t k = m_island_offsets[island]; k < m_island_offsets[island + 1]; ++ k)
+            {
+                particles.v[m_island_particles[k]].setZero();
+            }
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#include <elasty/spatial-hash.hpp>
+#include <elasty/thread-pool.hpp>
+#include <cassert>
+
+void elasty::SpatialHash::build(const std::vector<Vector3>& positions, const Scalar cell_size, ThreadPool* thread_pool)
+{
+    assert(cell_size > 0.0);
+
+    const std::size_t num_points = positions.size();
+
+    m_cell_size = cell_size;
+    m_inv_cell_size = 1.0 / cell_size;
+
+    // Use about twice as many buckets as the points (a power of two)
+    m_num_buckets = 1;
+    while (m_num_buckets < 2 * num_points) { m_num_buckets <<= 1; }
+
+    m_point_hashes.resize(num_points);
+    m_point_cells.resize(num_points);
+
+    auto calculate_hashes = [&](const std::size_t begin, const std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++ i)
+        {
+            m_point_cells[i] = calculateCell(positions[i]);
+            m_point_hashes[i] = calculateHash(m_point_cells[i]);
+        }
+    };
+
+    if (thread_pool != nullptr) { thread_pool->parallelFor(0, num_points, calculate_hashes); } else { calculate_hashes(0, num_points); }
+
+    // Counting sort by the buckets
+    m_bucket_offsets.assign(m_num_buckets + 1, 0);
+    for (std::size_t i = 0; i < num_points; ++ i)
+    {
+        ++ m_bucket_offsets[m_point_hashes[i] + 1];
+    }
+    for (std::uint32_t b = 0; b < m_num_buckets; ++ b)
+    {
+        m_bucket_offsets[b + 1] += m_bucket_offsets[b];
+    }
+
+    m_sorted_indices.resize(num_points);
+    m_sorted_cells.resize(num_points);
+    m_sorted_positions.resize(num_points);
+
+    // The start offsets are temporarily advanced while filling the buckets,
+    // and then shifted back
+    for (std::size_t i = 0; i < num_points; ++ i)
+    {
+        const std::uint32_t slot = m_bucket_offsets[m_point_hashes[i]] ++;
+
+        m_sorted_indices[slot] = static_cast<std::uint32_t>(i);
+        m_sorted_cells[slot] = m_point_cells[i];
+        m_sorted_positions[slot] = positions[i];
+    }
+    for (std::uint32_t b = m_num_buckets; b > 0; -- b)
+    {
+        m_bucket_offsets[b] = m_bucket_offsets[b - 1];
+    }
+    m_bucket_offsets[0] = 0;
+}
@@ -0,0 +1,91 @@
+#include <elasty/thread-pool.hpp>
+#include <algorithm>
+
+elasty::ThreadPool::ThreadPool(const unsigned int num_threads)
+{
+    const unsigned int num_total_threads = (num_threads != 0) ? num_threads : std::max(1u, std::thread::hardware_concurrency());
+
+    for (unsigned int i = 1; i < num_total_threads; ++ i)
+    {
+        m_workers.emplace_back(&ThreadPool::work, this, i);
+    }
+}
+
+elasty::ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_is_terminating = true;
+    }
+    m_start_condition.notify_all();
+
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+void elasty::ThreadPool::parallelFor(const std::size_t begin,
+                                     const std::size_t end,
+                                     const std::function<void(std::size_t, std::size_t)>& function,
+                                     const std::size_t min_range)
+{
+    if (begin >= end) { return; }
+
+    if (m_workers.empty() || end - begin < min_range)
+    {
+        function(begin, end);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_function = &function;
+        m_begin = begin;
+        m_end = end;
+        m_num_pending_workers = static_cast<unsigned int>(m_workers.size());
+        ++ m_generation;
+    }
+    m_start_condition.notify_all();
+
+    processChunk(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done_condition.wait(lock, [&]() { return m_num_pending_workers == 0; });
+    m_function = nullptr;
+}
+
+void elasty::ThreadPool::processChunk(const unsigned int thread_index)
+{
+    const std::size_t num_threads = getNumThreads();
+    const std::size_t range = m_end - m_begin;
+    const std::size_t chunk_begin = m_begin + (range * thread_index) / num_threads;
+    const std::size_t chunk_end = m_begin + (range * (thread_index + 1)) / num_threads;
+
+    if (chunk_begin < chunk_end) { (*m_function)(chunk_begin, chunk_end); }
+}
+
+void elasty::ThreadPool::work(const unsigned int thread_index)
+{
+    unsigned long last_generation = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start_condition.wait(lock, [&]() { return m_is_terminating || m_generation != last_generation; });
+
+            if (m_is_terminating) { return; }
+
+            last_generation = m_generation;
+        }
+
+        processChunk(thread_index);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            -- m_num_pending_workers;
+        }
+        m_done_condition.notify_one();
+    }
+}
@@ -1,120 +1,546 @@
 #include <elasty/utils.hpp>
 #include <elasty/cloth-sim-object.hpp>
 #include <elasty/constraint.hpp>
-#include <elasty/particle.hpp>
+#include <elasty/particle-set.hpp>
+#include <elasty/thread-pool.hpp>
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+#include <thread>
 #include <Alembic/AbcGeom/All.h>
 #include <Alembic/AbcCoreOgawa/All.h>
 
-std::vector<float> elasty::packParticlePositions(const std::vector<std::shared_ptr<Particle>>& particles)
+std::vector<float> elasty::packParticlePositions(const ParticleSet& particles,
+                                                 const unsigned int offset,
+                                                 const unsigned int num_particles)
 {
     std::vector<float> verts;
-    verts.reserve(3 * particles.size());
-    for (const auto& particle : particles)
+    verts.reserve(3 * num_particles);
+    for (unsigned int i = offset; i < offset + num_particles; ++ i)
     {
-        verts.push_back(particle->x(0));
-        verts.push_back(particle->x(1));
-        verts.push_back(particle->x(2));
+        verts.push_back(particles.x[i](0));
+        verts.push_back(particles.x[i](1));
+        verts.push_back(particles.x[i](2));
     }
     return verts;
 }
 
-void elasty::setRandomVelocities(const std::vector<std::shared_ptr<Particle>>& particles,
-                                 const double scale)
+void elasty::packParticlePositions(const ParticleSet& particles,
+                                   const unsigned int offset,
+                                   const unsigned int num_particles,
+                                   float* verts)
 {
-    for (const auto& particle: particles)
+    for (unsigned int i = 0; i < num_particles; ++ i)
     {
-        particle->v = scale * Eigen::Vector3d::Random();
+        const Vector3& x = particles.x[offset + i];
+        verts[3 * i + 0] = x(0);
+        verts[3 * i + 1] = x(1);
+        verts[3 * i + 2] = x(2);
     }
 }
 
-void elasty::generateFixedPointConstraints(const Eigen::Vector3d& search_position,
-                                           const Eigen::Vector3d& fixed_position,
-                                           const std::vector<std::shared_ptr<Particle>>& particles,
-                                           std::vector<std::shared_ptr<Constraint>>& constraints)
+void elasty::setRandomVelocities(ParticleSet& particles,
+                                 const Scalar scale)
 {
-    for (const auto& particle : particles)
+    for (auto& v : particles.v)
     {
-        if (particle->x.isApprox(search_position))
+        v = scale * Vector3::Random();
+    }
+}
+
+void elasty::generateFixedPointConstraints(const Vector3& search_position,
+                                           const Vector3& fixed_position,
+                                           const ParticleSet& particles,
+                                           ConstraintSet& constraints)
+{
+    for (unsigned int i = 0; i < particles.size(); ++ i)
+    {
+        if (particles.x[i].isApprox(search_position))
+        {
+            constraints.add(elasty::FixedPointConstraint(particles, i, 1.0, fixed_position));
+        }
+    }
+}
+
+void elasty::generateLongRangeAttachmentConstraints(const ClothSimObject& cloth_sim_object,
+                                                    const ParticleSet& particles,
+                                                    ConstraintSet& constraints,
+                                                    const AttachmentDistance distance,
+                                                    const Scalar stiffness,
+                                                    ThreadPool* thread_pool)
+{
+    const unsigned int offset = cloth_sim_object.m_particle_offset;
+    const unsigned int num_particles = cloth_sim_object.m_num_particles;
+    const auto& edges = cloth_sim_object.m_topology.getEdges();
+
+    // The pins and their attachment points (in the local indices)
+    std::vector<bool> is_pinned(num_particles, false);
+    std::vector<Vector3> attachment_points(num_particles);
+    for (unsigned int i = 0; i < num_particles; ++ i)
+    {
+        if (particles.w[offset + i] == 0.0)
+        {
+            is_pinned[i] = true;
+            attachment_points[i] = particles.x[offset + i];
+        }
+    }
+    for (const auto& constraint : constraints.get<FixedPointConstraint>())
+    {
+        const unsigned int index = constraint.getIndices()[0];
+        if (index < offset || index >= offset + num_particles) { continue; }
+
+        is_pinned[index - offset] = true;
+        attachment_points[index - offset] = constraint.getPoint();
+    }
+
+    // Group the pins connected by edges into regions (by union-find)
+    std::vector<unsigned int> parents(num_particles);
+    std::iota(parents.begin(), parents.end(), 0);
+
+    auto find_root = [&parents](unsigned int index)
+    {
+        while (parents[index] != index)
+        {
+            // Path halving
+            parents[index] = parents[parents[index]];
+            index = parents[index];
+        }
+        return index;
+    };
+
+    for (const auto& edge : edges)
+    {
+        if (!is_pinned[edge.vertices[0]] || !is_pinned[edge.vertices[1]]) { continue; }
+
+        const unsigned int root_0 = find_root(edge.vertices[0]);
+        const unsigned int root_1 = find_root(edge.vertices[1]);
+        parents[std::max(root_0, root_1)] = std::min(root_0, root_1);
+    }
+
+    std::vector<std::vector<unsigned int>> regions;
+    std::vector<int> root_regions(num_particles, -1);
+    for (unsigned int i = 0; i < num_particles; ++ i)
+    {
+        if (!is_pinned[i]) { continue; }
+
+        const unsigned int root = find_root(i);
+        if (root_regions[root] < 0)
+        {
+            root_regions[root] = static_cast<int>(regions.size());
+            regions.emplace_back();
+        }
+        regions[root_regions[root]].push_back(i);
+    }
+
+    if (regions.empty()) { return; }
+
+    // For each region, the distance from each particle to the nearest pin of the region and the pin
+    std::vector<std::vector<Scalar>> distances(regions.size(), std::vector<Scalar>(num_particles, std::numeric_limits<Scalar>::infinity()));
+    std::vector<std::vector<unsigned int>> nearest_pins(regions.size(), std::vector<unsigned int>(num_particles, 0));
+
+    auto rest_position = [&](const unsigned int i) -> const Vector3& { return particles.x[offset + i]; };
+
+    if (distance == AttachmentDistance::Euclidean)
+    {
+        auto compute = [&](const std::size_t begin, const std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; ++ i)
+            {
+                for (std::size_t r = 0; r < regions.size(); ++ r)
+                {
+                    for (const unsigned int pin : regions[r])
+                    {
+                        const Scalar d = (rest_position(static_cast<unsigned int>(i)) - rest_position(pin)).norm();
+                        if (d < distances[r][i])
+                        {
+                            distances[r][i] = d;
+                            nearest_pins[r][i] = pin;
+                        }
+                    }
+                }
+            }
+        };
+
+        if (thread_pool != nullptr) { thread_pool->parallelFor(0, num_particles, compute); } else { compute(0, num_particles); }
+    }
+    else
+    {
+        // The adjacency of the particles in the CSR format
+        std::vector<unsigned int> adjacency_offsets(num_particles + 1, 0);
+        for (const auto& edge : edges)
         {
-            constraints.push_back(std::make_shared<elasty::FixedPointConstraint>(particle, 1.0, fixed_position));
+            ++ adjacency_offsets[edge.vertices[0] + 1];
+            ++ adjacency_offsets[edge.vertices[1] + 1];
+        }
+        std::partial_sum(adjacency_offsets.begin(), adjacency_offsets.end(), adjacency_offsets.begin());
+
+        std::vector<unsigned int> adjacency(adjacency_offsets.back());
+        std::vector<unsigned int> cursors(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+        for (const auto& edge : edges)
+        {
+            adjacency[cursors[edge.vertices[0]] ++] = edge.vertices[1];
+            adjacency[cursors[edge.vertices[1]] ++] = edge.vertices[0];
+        }
+
+        // Multi-source Dijkstra's algorithm from all the pins of each region
+        auto compute = [&](const std::size_t begin, const std::size_t end)
+        {
+            using Entry = std::pair<Scalar, unsigned int>;
+
+            for (std::size_t r = begin; r < end; ++ r)
+            {
+                std::vector<Scalar>& region_distances = distances[r];
+                std::vector<unsigned int>& region_nearest_pins = nearest_pins[r];
+
+                std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+                for (const unsigned int pin : regions[r])
+                {
+                    region_distances[pin] = 0.0;
+                    region_nearest_pins[pin] = pin;
+                    queue.push({ 0.0, pin });
+                }
+
+                while (!queue.empty())
+                {
+                    const auto [d, i] = queue.top();
+                    queue.pop();
+
+                    if (d > region_distances[i]) { continue; }
+
+                    for (unsigned int k = adjacency_offsets[i]; k < adjacency_offsets[i + 1]; ++ k)
+                    {
+                        const unsigned int j = adjacency[k];
+                        const Scalar d_j = d + (rest_position(i) - rest_position(j)).norm();
+
+                        if (d_j < region_distances[j])
+                        {
+                            region_distances[j] = d_j;
+                            region_nearest_pins[j] = region_nearest_pins[i];
+                            queue.push({ d_j, j });
+                        }
+                    }
+                }
+            }
+        };
+
+        // Each region is worth a thread by itself
+        if (thread_pool != nullptr) { thread_pool->parallelFor(0, regions.size(), compute, 1); } else { compute(0, regions.size()); }
+    }
+
+    for (std::size_t r = 0; r < regions.size(); ++ r)
+    {
+        for (unsigned int i = 0; i < num_particles; ++ i)
+        {
+            if (is_pinned[i] || !std::isfinite(distances[r][i])) { continue; }
+
+            constraints.emplace<LongRangeAttachmentConstraint>(particles,
+                                                               offset + i,
+                                                               stiffness,
+                                                               attachment_points[nearest_pins[r][i]],
+                                                               distances[r][i]);
         }
     }
 }
 
+/// \brief Writer of the positions of cloth objects to an Alembic archive.
+/// \details The Alembic writes are done by a background thread. The
+/// simulation thread only copies the positions into one of a fixed number of
+/// preallocated frame buffers, and blocks only when all the buffers are
+/// waiting to be written. The manager should be used from a single thread.
+/// Once a write fails, the writer thread stops, and every later
+/// submitCurrentStatus, flush, and close rethrows the error.
+///
+/// Quantization and rest detection are done by the writer thread. Both make
+/// consecutive samples bitwise identical, which Ogawa stores only once.
 class elasty::AlembicManager
 {
 public:
     AlembicManager(const std::string& file_path,
-                   const std::shared_ptr<ClothSimObject> cloth_sim_object,
-                   const double dt = 1.0 / 60.0) :
-    m_cloth_sim_object(cloth_sim_object),
+                   const std::vector<std::shared_ptr<ClothSimObject>>& cloth_sim_objects,
+                   const ParticleSet& particles,
+                   const double dt,
+                   const AlembicExportOptions& options) :
+    m_cloth_sim_objects(cloth_sim_objects),
+    m_particles(particles),
+    m_options(options),
     m_archive(Alembic::AbcCoreOgawa::WriteArchive(), file_path.c_str())
     {
         using namespace Alembic::Abc;
         using namespace Alembic::AbcGeom;
 
-        const TimeSampling time_sampling(dt, 0);
+        // Only every Nth step is written
+        const TimeSampling time_sampling(dt * double(std::max(1u, m_options.sample_interval)), 0);
         const uint32_t time_sampling_index = m_archive.addTimeSampling(time_sampling);
 
-        m_mesh_obj = OPolyMesh(OObject(m_archive, kTop), "cloth");
-        m_mesh_obj.getSchema().setTimeSampling(time_sampling_index);
+        const std::size_t num_objects = m_cloth_sim_objects.size();
+
+        m_object_offsets.resize(num_objects + 1, 0);
+        for (std::size_t i = 0; i < num_objects; ++ i)
+        {
+            m_object_offsets[i + 1] = m_object_offsets[i] + 3 * m_cloth_sim_objects[i]->m_num_particles;
+        }
+
+        m_mesh_objs.resize(num_objects);
+        m_last_verts.resize(num_objects);
+        m_new_verts.resize(num_objects);
+        for (std::size_t i = 0; i < num_objects; ++ i)
+        {
+            const std::string name = (num_objects == 1) ? "cloth" : "cloth_" + std::to_string(i);
+
+            m_mesh_objs[i] = OPolyMesh(OObject(m_archive, kTop), name);
+            m_mesh_objs[i].getSchema().setTimeSampling(time_sampling_index);
+        }
+
+        m_buffers.resize(std::max(1u, m_options.num_buffers), std::vector<float>(m_object_offsets.back()));
+
+        m_writer = std::thread(&AlembicManager::processQueue, this);
+    }
+
+    ~AlembicManager()
+    {
+        try { close(); } catch (...) {}
     }
 
     void submitCurrentStatus()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        if (m_is_closing) { throw std::runtime_error("The Alembic manager has been closed"); }
+        rethrowWriterError();
+
+        // Skip the steps between the samples
+        if (m_num_submitted_steps ++ % std::max(1u, m_options.sample_interval) != 0) { return; }
+
+        m_not_full_condition.wait(lock, [&]() { return m_num_queued_buffers < m_buffers.size() || m_writer_error != nullptr; });
+        rethrowWriterError();
+
+        const std::size_t buffer_index = (m_front_buffer_index + m_num_queued_buffers) % m_buffers.size();
+
+        // The writer does not touch the buffer until it is queued
+        lock.unlock();
+        for (std::size_t i = 0; i < m_cloth_sim_objects.size(); ++ i)
+        {
+            packParticlePositions(m_particles,
+                                  m_cloth_sim_objects[i]->m_particle_offset,
+                                  m_cloth_sim_objects[i]->m_num_particles,
+                                  m_buffers[buffer_index].data() + m_object_offsets[i]);
+        }
+        lock.lock();
+
+        ++ m_num_queued_buffers;
+        lock.unlock();
+        m_not_empty_condition.notify_one();
+    }
+
+    /// \brief Block until all the submitted frames have been written.
+    void flush()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_full_condition.wait(lock, [&]() { return m_num_queued_buffers == 0 || m_writer_error != nullptr; });
+        rethrowWriterError();
+    }
+
+    /// \brief Write all the submitted frames, stop the writer thread, and
+    /// close the archive.
+    void close()
+    {
+        if (!m_writer.joinable()) { return; }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_is_closing = true;
+        }
+        m_not_empty_condition.notify_one();
+        m_writer.join();
+
+        for (auto& mesh_obj : m_mesh_objs) { mesh_obj.reset(); }
+        m_archive.reset();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        rethrowWriterError();
+    }
+
+private:
+
+    // Called with the mutex locked. The error is kept, as the writer thread
+    // has stopped and no later frame can be written.
+    void rethrowWriterError()
+    {
+        if (m_writer_error != nullptr) { std::rethrow_exception(m_writer_error); }
+    }
+
+    void processQueue()
+    {
+        while (true)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_not_empty_condition.wait(lock, [&]() { return m_num_queued_buffers > 0 || m_is_closing; });
+
+            // The queue is drained before the writer stops
+            if (m_num_queued_buffers == 0) { return; }
+
+            const std::size_t buffer_index = m_front_buffer_index;
+            lock.unlock();
+
+            try
+            {
+                for (std::size_t i = 0; i < m_cloth_sim_objects.size(); ++ i)
+                {
+                    writeSample(i, m_buffers[buffer_index].data() + m_object_offsets[i]);
+                }
+            }
+            catch (...)
+            {
+                // The queue is left as it is, as the simulation thread may be
+                // filling the next buffer; the waits end on the error instead
+                lock.lock();
+                m_writer_error = std::current_exception();
+                lock.unlock();
+                m_not_full_condition.notify_all();
+                return;
+            }
+
+            lock.lock();
+            m_front_buffer_index = (m_front_buffer_index + 1) % m_buffers.size();
+            -- m_num_queued_buffers;
+            lock.unlock();
+            m_not_full_condition.notify_all();
+        }
+    }
+
+    void writeSample(const std::size_t object_index, const float* packed_verts)
     {
         using namespace Alembic::Abc;
         using namespace Alembic::AbcGeom;
 
-        const size_t num_verts = m_cloth_sim_object->m_particles.size();
-        const std::vector<float> verts = packParticlePositions(m_cloth_sim_object->m_particles);
+        const std::shared_ptr<ClothSimObject>& cloth_sim_object = m_cloth_sim_objects[object_index];
+        const size_t num_verts = cloth_sim_object->m_num_particles;
+
+        std::vector<float>& last_verts = m_last_verts[object_index];
+        std::vector<float>& new_verts = m_new_verts[object_index];
+
+        const bool is_first = last_verts.empty();
+
+        // The vertices are written in the order of the OBJ file, even if the
+        // particles of the object have been reordered
+        const std::vector<unsigned int>& obj_vertex_indices = cloth_sim_object->m_obj_vertex_indices;
+        new_verts.resize(3 * num_verts);
+        for (std::size_t i = 0; i < num_verts; ++ i)
+        {
+            for (unsigned int k = 0; k < 3; ++ k) { new_verts[3 * obj_vertex_indices[i] + k] = packed_verts[3 * i + k]; }
+        }
+        if (m_options.quantization_step > 0.0)
+        {
+            const float step = m_options.quantization_step;
+            for (float& value : new_verts) { value = std::round(value / step) * step; }
+        }
+
+        // Repeat the last sample while the object is at rest
+        const bool is_at_rest = !is_first && m_options.rest_threshold > 0.0 && [&]()
+        {
+            for (std::size_t i = 0; i < new_verts.size(); ++ i)
+            {
+                if (std::abs(new_verts[i] - last_verts[i]) > m_options.rest_threshold) { return false; }
+            }
+            return true;
+        }();
+        if (!is_at_rest) { std::swap(last_verts, new_verts); }
 
-        if (m_is_first)
+        if (is_first)
         {
-            const size_t num_indices = m_cloth_sim_object->m_triangle_list.size();
+            const size_t num_indices = cloth_sim_object->m_triangle_list.size();
             const std::vector<int32_t> indices = [&]()
             {
                 std::vector<int32_t> indices;
                 indices.reserve(num_indices);
-                for (unsigned int i = 0; i < m_cloth_sim_object->m_triangle_list.rows(); ++ i)
+                for (unsigned int i = 0; i < cloth_sim_object->m_triangle_list.rows(); ++ i)
                 {
-                    indices.push_back(m_cloth_sim_object->m_triangle_list(i, 0));
-                    indices.push_back(m_cloth_sim_object->m_triangle_list(i, 1));
-                    indices.push_back(m_cloth_sim_object->m_triangle_list(i, 2));
+                    indices.push_back(obj_vertex_indices[cloth_sim_object->m_triangle_list(i, 0)]);
+                    indices.push_back(obj_vertex_indices[cloth_sim_object->m_triangle_list(i, 1)]);
+                    indices.push_back(obj_vertex_indices[cloth_sim_object->m_triangle_list(i, 2)]);
                 }
                 return indices;
             }();
-            const size_t num_counts = m_cloth_sim_object->m_triangle_list.rows();
+            const size_t num_counts = cloth_sim_object->m_triangle_list.rows();
             const std::vector<int32_t> counts(num_counts, 3);
 
-            const OPolyMeshSchema::Sample sample(V3fArraySample((const V3f*) verts.data(), num_verts),
+            const OPolyMeshSchema::Sample sample(V3fArraySample((const V3f*) last_verts.data(), num_verts),
                                                  Int32ArraySample(indices.data(), num_indices),
                                                  Int32ArraySample(counts.data(), num_counts));
-            m_mesh_obj.getSchema().set(sample);
-            m_is_first = false;
+            m_mesh_objs[object_index].getSchema().set(sample);
         }
         else
         {
-            const OPolyMeshSchema::Sample sample(V3fArraySample((const V3f*) verts.data(), num_verts));
-            m_mesh_obj.getSchema().set(sample);
+            const OPolyMeshSchema::Sample sample(V3fArraySample((const V3f*) last_verts.data(), num_verts));
+            m_mesh_objs[object_index].getSchema().set(sample);
         }
     }
 
-private:
-
-    bool m_is_first = true;
-    const std::shared_ptr<ClothSimObject> m_cloth_sim_object;
+    const std::vector<std::shared_ptr<ClothSimObject>> m_cloth_sim_objects;
+    const ParticleSet& m_particles;
+    const AlembicExportOptions m_options;
     Alembic::Abc::OArchive m_archive;
-    Alembic::AbcGeom::OPolyMesh m_mesh_obj;
+    std::vector<Alembic::AbcGeom::OPolyMesh> m_mesh_objs;
+
+    // Offsets of the objects in a frame buffer
+    std::vector<std::size_t> m_object_offsets;
+
+    // The last written and the new positions of each object (writer only)
+    std::vector<std::vector<float>> m_last_verts;
+    std::vector<std::vector<float>> m_new_verts;
+
+    // Ring of frame buffers; the queued ones are [front, front + num_queued)
+    std::vector<std::vector<float>> m_buffers;
+    std::size_t m_front_buffer_index = 0;
+    std::size_t m_num_queued_buffers = 0;
+    unsigned long m_num_submitted_steps = 0;
+
+    std::thread m_writer;
+    std::mutex m_mutex;
+    std::condition_variable m_not_empty_condition;
+    std::condition_variable m_not_full_condition;
+    std::exception_ptr m_writer_error;
+    bool m_is_closing = false;
 };
 
+std::shared_ptr<elasty::AlembicManager> elasty::createAlembicManager(const std::string& file_path,
+                                                                     const std::vector<std::shared_ptr<ClothSimObject>>& cloth_sim_objects,
+                                                                     const ParticleSet& particles,
+                                                                     const double dt,
+                                                                     const AlembicExportOptions& options)
+{
+    return std::make_shared<AlembicManager>(file_path, cloth_sim_objects, particles, dt, options);
+}
+
 std::shared_ptr<elasty::AlembicManager> elasty::createAlembicManager(const std::string& file_path,
                                                                      const std::shared_ptr<ClothSimObject> cloth_sim_object,
-                                                                     const double dt)
+                                                                     const ParticleSet& particles,
+                                                                     const double dt,
+                                                                     const unsigned int num_buffers)
 {
-    return std::make_shared<AlembicManager>(file_path, cloth_sim_object, dt);
+    AlembicExportOptions options;
+    options.num_buffers = num_buffers;
+    return std::make_shared<AlembicManager>(file_path, std::vector<std::shared_ptr<ClothSimObject>>{ cloth_sim_object }, particles, dt, options);
 }
 
 void elasty::submitCurrentStatus(const std::shared_ptr<AlembicManager> alembic_manager)
 {
     alembic_manager->submitCurrentStatus();
 }
+
+void elasty::flushAlembicManager(const std::shared_ptr<AlembicManager> alembic_manager)
+{
+    alembic_manager->flush();
+}
+
+void elasty::closeAlembicManager(const std::shared_ptr<AlembicManager> alembic_manager)
+{
+    alembic_manager->close();
+}
@@ -0,0 +1,133 @@
+#include <elasty/vertex-ordering.hpp>
+#include <elasty/mesh-topology.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <numeric>
+
+namespace
+{
+    constexpr unsigned int num_morton_bits = 21;
+
+    // Spread the lower 21 bits so that two zero bits follow each of them
+    std::uint64_t expandBits(std::uint64_t value)
+    {
+        value &= 0x1fffff;
+        value = (value | value << 32) & 0x1f00000000ffff;
+        value = (value | value << 16) & 0x1f0000ff0000ff;
+        value = (value | value << 8) & 0x100f00f00f00f00f;
+        value = (value | value << 4) & 0x10c30c30c30c30c3;
+        value = (value | value << 2) & 0x1249249249249249;
+        return value;
+    }
+}
+
+std::vector<unsigned int> elasty::calculateMortonOrder(const std::vector<Vector3>& positions)
+{
+    std::vector<unsigned int> order(positions.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    if (positions.empty()) { return order; }
+
+    Eigen::Vector3d min_corner = positions.front().cast<double>();
+    Eigen::Vector3d max_corner = min_corner;
+    for (const Vector3& position : positions)
+    {
+        min_corner = min_corner.cwiseMin(position.cast<double>());
+        max_corner = max_corner.cwiseMax(position.cast<double>());
+    }
+
+    // The same scale for the three axes keeps the curve from being stretched
+    // along the shorter sides of the box
+    const double extent = (max_corner - min_corner).maxCoeff();
+    const double scale = extent > 0.0 ? double((1u << num_morton_bits) - 1) / extent : 0.0;
+
+    std::vector<std::uint64_t> codes(positions.size());
+    for (std::size_t i = 0; i < positions.size(); ++ i)
+    {
+        const Eigen::Vector3d cell = scale * (positions[i].cast<double>() - min_corner);
+
+        codes[i] = (expandBits(std::uint64_t(cell.x())) << 2) | (expandBits(std::uint64_t(cell.y())) << 1) | expandBits(std::uint64_t(cell.z()));
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&](const unsigned int a, const unsigned int b) { return codes[a] < codes[b]; });
+
+    return order;
+}
+
+std::vector<unsigned int> elasty::calculateReverseCuthillMcKeeOrder(const MeshTopology& topology, const unsigned int num_vertices)
+{
+    // Adjacency of the vertices in the compressed sparse row layout
+    std::vector<unsigned int> offsets(num_vertices + 1, 0);
+    for (const auto& edge : topology.getEdges())
+    {
+        assert(edge.vertices[0] < num_vertices && edge.vertices[1] < num_vertices);
+
+        ++ offsets[edge.vertices[0] + 1];
+        ++ offsets[edge.vertices[1] + 1];
+    }
+    for (unsigned int v = 0; v < num_vertices; ++ v) { offsets[v + 1] += offsets[v]; }
+
+    std::vector<unsigned int> neighbors(offsets.back());
+    std::vector<unsigned int> positions(offsets.begin(), offsets.end() - 1);
+    for (const auto& edge : topology.getEdges())
+    {
+        neighbors[positions[edge.vertices[0]] ++] = edge.vertices[1];
+        neighbors[positions[edge.vertices[1]] ++] = edge.vertices[0];
+    }
+
+    const auto get_degree = [&](const unsigned int v) { return offsets[v + 1] - offsets[v]; };
+    const auto has_lower_degree = [&](const unsigned int a, const unsigned int b)
+    {
+        return get_degree(a) != get_degree(b) ? get_degree(a) < get_degree(b) : a < b;
+    };
+
+    for (unsigned int v = 0; v < num_vertices; ++ v)
+    {
+        std::sort(neighbors.begin() + offsets[v], neighbors.begin() + offsets[v + 1], has_lower_degree);
+    }
+
+    // The candidates of the starting vertices of the components
+    std::vector<unsigned int> start_candidates(num_vertices);
+    std::iota(start_candidates.begin(), start_candidates.end(), 0);
+    std::sort(start_candidates.begin(), start_candidates.end(), has_lower_degree);
+
+    // The breadth-first traversal uses the order itself as the queue
+    std::vector<unsigned int> order;
+    order.reserve(num_vertices);
+    std::vector<bool> is_visited(num_vertices, false);
+    for (const unsigned int start : start_candidates)
+    {
+        if (is_visited[start]) { continue; }
+
+        is_visited[start] = true;
+        order.push_back(start);
+
+        for (std::size_t head = order.size() - 1; head < order.size(); ++ head)
+        {
+            const unsigned int v = order[head];
+            for (unsigned int k = offsets[v]; k < offsets[v + 1]; ++ k)
+            {
+                if (is_visited[neighbors[k]]) { continue; }
+
+                is_visited[neighbors[k]] = true;
+                order.push_back(neighbors[k]);
+            }
+        }
+    }
+
+    std::reverse(order.begin(), order.end());
+
+    return order;
+}
+
+std::vector<unsigned int> elasty::invertPermutation(const std::vector<unsigned int>& permutation)
+{
+    std::vector<unsigned int> inverse(permutation.size());
+    for (unsigned int i = 0; i < permutation.size(); ++ i)
+    {
+        assert(permutation[i] < permutation.size());
+        inverse[permutation[i]] = i;
+    }
+    return inverse;
+}
@@ -0,0 +1,81 @@
+#include <elasty/constraint.hpp>
+#include <elasty/engine.hpp>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+    // A chain of particles swinging from a particle of infinite mass
+    class ChainEngine final : public elasty::Engine
+    {
+    public:
+
+        void initializeScene() override
+        {
+            m_particles.addParticle(elasty::Vector3::Zero(), elasty::Vector3::Zero(), std::numeric_limits<elasty::Scalar>::infinity());
+            for (unsigned int i = 1; i < num_particles; ++ i)
+            {
+                m_particles.addParticle(elasty::Scalar(i) * segment_length * elasty::Vector3::UnitX(), elasty::Vector3::Zero(), 0.1);
+                addConstraint(elasty::DistanceConstraint(m_particles, i - 1, i, 1.0, segment_length));
+            }
+        }
+
+        void setExternalForces() override
+        {
+            for (unsigned int i = 1; i < m_particles.size(); ++ i)
+            {
+                m_particles.f[i] = m_particles.m[i] * elasty::Vector3(0.0, - 9.8, 0.0);
+            }
+        }
+
+        void generateCollisionConstraints() override {}
+
+        void updateVelocities() override {}
+
+        static constexpr unsigned int num_particles = 20;
+        static constexpr elasty::Scalar segment_length = 0.1;
+    };
+
+    // The mean residual over the steps of a swing
+    elasty::Scalar simulate(const elasty::Acceleration acceleration, const elasty::ProjectionScheme scheme, const bool is_colored)
+    {
+        ChainEngine engine;
+        engine.initializeScene();
+        engine.m_acceleration = acceleration;
+        engine.m_projection_scheme = scheme;
+        engine.m_use_vectorized_kernels = is_colored;
+
+        constexpr unsigned int num_steps = 60;
+
+        elasty::Scalar sum_of_residuals = 0.0;
+        for (unsigned int i = 0; i < num_steps; ++ i)
+        {
+            engine.stepTime();
+
+            // The fixed particle is not moved by the extrapolation
+            if (engine.m_particles.x[0] != elasty::Vector3::Zero()) { throw std::runtime_error("The fixed particle moves."); }
+
+            sum_of_residuals += engine.calculateResidualStatistics().rms;
+        }
+        return sum_of_residuals / elasty::Scalar(num_steps);
+    }
+}
+
+int main()
+{
+    using elasty::Acceleration;
+    using elasty::ProjectionScheme;
+
+    for (const bool is_colored : { false, true })
+    {
+        const elasty::Scalar residual = simulate(Acceleration::None, ProjectionScheme::GaussSeidel, is_colored);
+
+        if (!(simulate(Acceleration::OverRelaxation, ProjectionScheme::GaussSeidel, is_colored) < residual)) { throw std::runtime_error("The over-relaxation does not accelerate the convergence."); }
+        if (!(simulate(Acceleration::Chebyshev, ProjectionScheme::GaussSeidel, is_colored) < residual)) { throw std::runtime_error("The Chebyshev method does not accelerate the convergence."); }
+    }
+
+    const elasty::Scalar jacobi_residual = simulate(Acceleration::None, ProjectionScheme::Jacobi, false);
+    if (!(simulate(Acceleration::Chebyshev, ProjectionScheme::Jacobi, false) < jacobi_residual)) { throw std::runtime_error("The Chebyshev method does not accelerate the Jacobi scheme."); }
+
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include <elasty/constraint.hpp>
+#include <elasty/engine.hpp>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+    // A chain of particles hanging from a particle of infinite mass, starting
+    // either straight down (i.e., at rest) or horizontally (i.e., swinging)
+    class ChainEngine final : public elasty::Engine
+    {
+    public:
+
+        ChainEngine(const bool is_horizontal) : m_is_horizontal(is_horizontal) {}
+
+        void initializeScene() override
+        {
+            const elasty::Vector3 direction = m_is_horizontal ? elasty::Vector3::UnitX() : elasty::Vector3(- elasty::Vector3::UnitY());
+
+            m_particles.addParticle(elasty::Vector3::Zero(), elasty::Vector3::Zero(), std::numeric_limits<elasty::Scalar>::infinity());
+            for (unsigned int i = 1; i < num_particles; ++ i)
+            {
+                m_particles.addParticle(elasty::Scalar(i) * segment_length * direction, elasty::Vector3::Zero(), 0.1);
+                addConstraint(elasty::DistanceConstraint(m_particles, i - 1, i, 1.0, segment_length));
+            }
+        }
+
+        void setExternalForces() override
+        {
+            for (unsigned int i = 1; i < m_particles.size(); ++ i)
+            {
+                m_particles.f[i] = m_particles.m[i] * elasty::Vector3(0.0, - 9.8, 0.0);
+            }
+        }
+
+        void generateCollisionConstraints() override {}
+
+        void updateVelocities() override {}
+
+        static constexpr unsigned int num_particles = 5;
+        static constexpr elasty::Scalar segment_length = 0.1;
+
+    private:
+
+        const bool m_is_horizontal;
+    };
+
+    constexpr elasty::Scalar tolerance = 1e-04;
+
+    void configure(ChainEngine& engine, const bool is_colored)
+    {
+        engine.m_num_iterations = 50;
+        engine.m_residual_tolerance = tolerance;
+        engine.m_min_num_iterations = 2;
+        engine.m_use_vectorized_kernels = is_colored;
+    }
+
+    void testHanging(const bool is_colored)
+    {
+        ChainEngine engine(false);
+        engine.initializeScene();
+        configure(engine, is_colored);
+
+        for (unsigned int i = 0; i < 10; ++ i)
+        {
+            engine.stepTime();
+
+            if (engine.getLastNumIterations() >= engine.m_num_iterations) { throw std::runtime_error("The iterations do not stop for the hanging chain."); }
+            if (engine.getLastResidual() > tolerance) { throw std::runtime_error("Wrong residual of the hanging chain."); }
+        }
+
+        // Any residual is below a loose enough tolerance, which leaves only
+        // the minimum number of iterations
+        engine.m_residual_tolerance = 1.0;
+        engine.stepTime();
+
+        if (engine.getLastNumIterations() != engine.m_min_num_iterations) { throw std::runtime_error("Wrong minimum number of iterations."); }
+    }
+
+    void testSwinging(const bool is_colored)
+    {
+        ChainEngine engine(true);
+        engine.initializeScene();
+        configure(engine, is_colored);
+
+        unsigned int max_num_iterations = 0;
+        for (unsigned int i = 0; i < 60; ++ i)
+        {
+            engine.stepTime();
+
+            const unsigned int num_iterations = engine.getLastNumIterations();
+            if (num_iterations < engine.m_min_num_iterations || num_iterations > engine.m_num_iterations) { throw std::runtime_error("Wrong number of iterations."); }
+            if (num_iterations < engine.m_num_iterations && engine.getLastResidual() > tolerance) { throw std::runtime_error("The iterations stop before the convergence."); }
+
+            max_num_iterations = std::max(max_num_iterations, num_iterations);
+        }
+
+        if (max_num_iterations <= engine.m_min_num_iterations) { throw std::runtime_error("The swinging chain needs more iterations."); }
+    }
+
+    // Without a tolerance, the same number of iterations runs in every step
+    void testFixedIterations()
+    {
+        ChainEngine engine(true);
+        engine.initializeScene();
+
+        for (unsigned int i = 0; i < 10; ++ i)
+        {
+            engine.stepTime();
+            if (engine.getLastNumIterations() != engine.m_num_iterations) { throw std::runtime_error("Wrong number of fixed iterations."); }
+        }
+    }
+}
+
+int main()
+{
+    for (const bool is_colored : { false, true })
+    {
+        testHanging(is_colored);
+        testSwinging(is_colored);
+    }
+    testFixedIterations();
+
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include <elasty/batched-engine.hpp>
+#include <elasty/constraint.hpp>
+#include <elasty/engine.hpp>
+#include <stdexcept>
+
+namespace
+{
+    void buildRope(elasty::ParticleSet& particles, elasty::ConstraintSet& constraints)
+    {
+        // A horizontal rope pinned at one end, which swings down onto a sphere
+        constexpr unsigned int num_particles = 30;
+        for (unsigned int i = 0; i < num_particles; ++ i)
+        {
+            particles.addParticle(elasty::Vector3(0.05 * elasty::Scalar(i), 0.0, 0.0), elasty::Vector3::Zero(), 0.1);
+        }
+        for (unsigned int i = 1; i < num_particles; ++ i)
+        {
+            constraints.add(elasty::DistanceConstraint(particles, i - 1, i, 0.9, 0.05));
+        }
+        constraints.add(elasty::FixedPointConstraint(particles, 0, 1.0, elasty::Vector3::Zero()));
+    }
+
+    // The reference, which is the same scene in a plain engine
+    class RopeEngine final : public elasty::Engine
+    {
+    public:
+
+        void initializeScene() override
+        {
+            buildRope(m_particles, m_constraints);
+            m_colliders.m_spheres.push_back({ elasty::Vector3(0.7, - 0.9, 0.0), 0.4 });
+        }
+
+        void setExternalForces() override
+        {
+            for (unsigned int i = 0; i < m_particles.size(); ++ i)
+            {
+                m_particles.f[i] = m_particles.m[i] * elasty::Vector3(0.0, - 9.8, 0.0);
+            }
+        }
+
+        void generateCollisionConstraints() override { m_colliders.generateConstraints(m_particles, m_instant_constraints); }
+
+        void updateVelocities() override
+        {
+            for (auto& v : m_particles.v) { v *= 1.0 - 0.01; }
+        }
+
+        elasty::ColliderSet m_colliders;
+    };
+}
+
+int main()
+{
+    RopeEngine engine;
+    engine.initializeScene();
+
+    constexpr std::size_t num_instances = 5;
+
+    elasty::BatchedEngine batched_engine(engine.m_particles, engine.m_constraints, num_instances);
+    batched_engine.m_colliders = engine.m_colliders;
+    batched_engine.m_velocity_damping = 0.01;
+    for (std::size_t k = 1; k < num_instances; ++ k)
+    {
+        batched_engine.setStiffness<elasty::DistanceConstraint>(k, 0.1 * elasty::Scalar(k));
+    }
+
+    elasty::BatchedEngine threaded_batched_engine = [&]()
+    {
+        elasty::BatchedEngine batched_engine(engine.m_particles, engine.m_constraints, num_instances);
+        batched_engine.m_colliders = engine.m_colliders;
+        batched_engine.m_velocity_damping = 0.01;
+        batched_engine.m_num_threads = 3;
+        for (std::size_t k = 1; k < num_instances; ++ k)
+        {
+            batched_engine.setStiffness<elasty::DistanceConstraint>(k, 0.1 * elasty::Scalar(k));
+        }
+        return batched_engine;
+    }();
+
+    for (unsigned int i = 0; i < 90; ++ i)
+    {
+        // The working buffers follow a change of the number of threads
+        if (i == 45) { threaded_batched_engine.m_num_threads = 2; }
+
+        engine.stepTime();
+        batched_engine.stepTime();
+        threaded_batched_engine.stepTime();
+    }
+
+    const std::size_t num_particles = engine.m_particles.size();
+
+    // The instance without overrides follows the plain engine
+    for (std::size_t i = 0; i < num_particles; ++ i)
+    {
+        if ((batched_engine.getPositions(0)[i] - engine.m_particles.x[i]).norm() > 1e-12) { throw std::runtime_error("The instance differs from the engine."); }
+    }
+
+    // Softer ropes stretch more
+    for (std::size_t k = 1; k < num_instances; ++ k)
+    {
+        const elasty::Scalar length = (batched_engine.getPositions(k)[num_particles - 1] - batched_engine.getPositions(k)[0]).norm();
+        const elasty::Scalar stiffer_length = (batched_engine.getPositions(k + 1 < num_instances ? k + 1 : 0)[num_particles - 1] - batched_engine.getPositions(k + 1 < num_instances ? k + 1 : 0)[0]).norm();
+        if (length <= stiffer_length) { throw std::runtime_error("The stiffness override has no effect."); }
+    }
+
+    // The instances are independent of the number of threads
+    for (std::size_t k = 0; k < num_instances; ++ k)
+    {
+        for (std::size_t i = 0; i < num_particles; ++ i)
+        {
+            if (batched_engine.getPositions(k)[i] != threaded_batched_engine.getPositions(k)[i]) { throw std::runtime_error("The threaded instances differ."); }
+        }
+    }
+
+    return 0;
+}
@@ -1,44 +1,111 @@
 #include <elasty/constraint.hpp>
-#include <elasty/particle.hpp>
+#include <elasty/particle-set.hpp>
+#include <stdexcept>
+#include <type_traits>
+#include <Eigen/Geometry>
+
+namespace
+{
+    // Compare the gradient of the constraint, and the fused value and
+    // gradient, with central differences at a bent configuration
+    template <typename Type>
+    void testGradient(const Type& constraint, elasty::ParticleSet particles)
+    {
+        using Correction = typename Type::Correction;
+
+        Correction grad;
+        constraint.calculateGrad(particles, grad.data());
+
+        Correction fused_grad;
+        const elasty::Scalar fused_value = constraint.calculateValueAndGrad(particles, fused_grad.data());
+
+        if (std::abs(fused_value - constraint.calculateValue(particles)) > 1e-06) { throw std::runtime_error("Wrong fused value."); }
+        if ((fused_grad - grad).norm() > 1e-06) { throw std::runtime_error("Wrong fused gradient."); }
+
+        const bool is_float = std::is_same<elasty::Scalar, float>::value;
+        const elasty::Scalar h = is_float ? 1e-03 : 1e-06;
+        const elasty::Scalar tolerance = is_float ? 1e-02 : 1e-06;
+
+        Correction numerical_grad;
+        for (unsigned int j = 0; j < Type::num_particles; ++ j)
+        {
+            for (unsigned int k = 0; k < 3; ++ k)
+            {
+                elasty::Vector3& p = particles.p[constraint.getIndices()[j]];
+                const elasty::Scalar original = p(k);
+
+                p(k) = original + h;
+                const elasty::Scalar value_plus = constraint.calculateValue(particles);
+                p(k) = original - h;
+                const elasty::Scalar value_minus = constraint.calculateValue(particles);
+                p(k) = original;
+
+                numerical_grad(3 * j + k) = (value_plus - value_minus) / (2.0 * h);
+            }
+        }
+
+        if (grad.norm() < 1e-03) { throw std::runtime_error("The gradient of the bent configuration vanishes."); }
+        if ((grad - numerical_grad).norm() > tolerance * numerical_grad.norm()) { throw std::runtime_error("Wrong gradient."); }
+    }
+}
 
 int main()
 {
-    auto p_0 = std::make_shared<elasty::Particle>(Eigen::Vector3d(  0.0, 0.0, 0.0), Eigen::Vector3d::Zero(), 1.0);
-    auto p_1 = std::make_shared<elasty::Particle>(Eigen::Vector3d(  0.0, 1.0, 0.0), Eigen::Vector3d::Zero(), 1.0);
-    auto p_2 = std::make_shared<elasty::Particle>(Eigen::Vector3d(- 0.5, 0.5, 0.0), Eigen::Vector3d::Zero(), 1.0);
-    auto p_3 = std::make_shared<elasty::Particle>(Eigen::Vector3d(+ 0.5, 0.5, 0.0), Eigen::Vector3d::Zero(), 1.0);
+    elasty::ParticleSet particles;
 
-    const Eigen::Vector3d& x_0 = p_0->x;
-    const Eigen::Vector3d& x_1 = p_1->x;
-    const Eigen::Vector3d& x_2 = p_2->x;
-    const Eigen::Vector3d& x_3 = p_3->x;
+    const unsigned int p_0 = particles.addParticle(elasty::Vector3(  0.0, 0.0, 0.0), elasty::Vector3::Zero(), 1.0);
+    const unsigned int p_1 = particles.addParticle(elasty::Vector3(  0.0, 1.0, 0.0), elasty::Vector3::Zero(), 1.0);
+    const unsigned int p_2 = particles.addParticle(elasty::Vector3(- 0.5, 0.5, 0.0), elasty::Vector3::Zero(), 1.0);
+    const unsigned int p_3 = particles.addParticle(elasty::Vector3(+ 0.5, 0.5, 0.0), elasty::Vector3::Zero(), 1.0);
 
-    const Eigen::Vector3d p_10 = x_1 - x_0;
-    const Eigen::Vector3d p_20 = x_2 - x_0;
-    const Eigen::Vector3d p_30 = x_3 - x_0;
+    const elasty::Vector3& x_0 = particles.x[p_0];
+    const elasty::Vector3& x_1 = particles.x[p_1];
+    const elasty::Vector3& x_2 = particles.x[p_2];
+    const elasty::Vector3& x_3 = particles.x[p_3];
 
-    const Eigen::Vector3d n_0 = p_10.cross(p_20).normalized();
-    const Eigen::Vector3d n_1 = p_10.cross(p_30).normalized();
+    const elasty::Vector3 p_10 = x_1 - x_0;
+    const elasty::Vector3 p_20 = x_2 - x_0;
+    const elasty::Vector3 p_30 = x_3 - x_0;
+
+    const elasty::Vector3 n_0 = p_10.cross(p_20).normalized();
+    const elasty::Vector3 n_1 = p_10.cross(p_30).normalized();
 
     assert(!n_0.hasNaN());
     assert(!n_1.hasNaN());
 
-    const double dihedral_angle = std::acos(std::max(- 1.0, std::min(+ 1.0, n_0.dot(n_1))));
+    const elasty::Scalar dihedral_angle = std::acos(std::max(elasty::Scalar(- 1.0), std::min(elasty::Scalar(+ 1.0), n_0.dot(n_1))));
 
     assert(!std::isnan(dihedral_angle));
 
-    const auto constraint = std::make_shared<elasty::BendingConstraint>(p_0, p_1, p_2, p_3, 1.0, dihedral_angle);
+    elasty::BendingConstraint constraint(particles, p_0, p_1, p_2, p_3, 1.0, dihedral_angle);
 
-    const double value = constraint->calculateValue();
+    const elasty::Scalar value = constraint.calculateValue(particles);
 
-    Eigen::Matrix<double, 12, 1> grad;
-    constraint->calculateGrad(grad.data());
+    Eigen::Matrix<elasty::Scalar, 12, 1> grad;
+    constraint.calculateGrad(particles, grad.data());
 
-    constexpr double epsilon = 1e-20;
+    constexpr elasty::Scalar epsilon = 1e-20;
     if (!(std::abs(value) < epsilon) || !(grad.norm() < epsilon))
     {
         throw std::runtime_error("");
     }
 
+    // Fold the triangles along their shared edge and move them away from the
+    // origin
+    for (elasty::Vector3& p : particles.p) { p += elasty::Vector3(3.0, - 2.0, 1.0); }
+    particles.p[p_2] += elasty::Vector3(0.1, - 0.05, 0.3);
+    particles.p[p_3] += elasty::Vector3(0.0, 0.1, 0.2);
+
+    testGradient(constraint, particles);
+    testGradient(elasty::IsometricBendingConstraint(particles, p_0, p_1, p_2, p_3, 1.0), particles);
+
+    // The compact form of the isometric bending constraint agrees with its
+    // quadratic form
+    const elasty::IsometricBendingConstraint isometric_bending_constraint(particles, p_0, p_1, p_2, p_3, 1.0);
+    Eigen::Matrix<elasty::Scalar, 4, 3> X;
+    for (unsigned int i = 0; i < 4; ++ i) { X.row(i) = particles.p[isometric_bending_constraint.getIndices()[i]].transpose(); }
+    const elasty::Scalar quadratic_value = 0.5 * (X.transpose() * isometric_bending_constraint.getQ() * X).trace();
+    if (std::abs(quadratic_value - isometric_bending_constraint.calculateValue(particles)) > 1e-04) { throw std::runtime_error("Wrong isometric bending value."); }
+
     return 0;
 }
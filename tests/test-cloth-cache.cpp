@@ -0,0 +1,159 @@
+#include <elasty/cloth-sim-object.hpp>
+#include <elasty/constraint.hpp>
+#include <elasty/particle-set.hpp>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr std::size_t header_size = 128;
+
+    const std::string cache_path = (std::filesystem::temp_directory_path() / "elasty-test-cloth-cache.cache").string();
+
+    // A square of four triangles around a center vertex
+    std::string writeObj()
+    {
+        const std::string path = (std::filesystem::temp_directory_path() / "elasty-test-cloth-cache.obj").string();
+
+        std::ofstream file(path);
+        file << "v 0 0 0\nv 1 0 0\nv 1 0 1\nv 0 0 1\nv 0.5 0.1 0.5\nvn 0 1 0\n";
+        file << "f 1//1 5//1 2//1\nf 2//1 5//1 3//1\nf 3//1 5//1 4//1\nf 4//1 5//1 1//1\n";
+
+        return path;
+    }
+
+    std::vector<char> readFile(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    void writeFile(const std::string& path, const std::vector<char>& data)
+    {
+        std::ofstream file(path, std::ios::binary);
+        file.write(data.data(), data.size());
+    }
+
+    // The particles added before the cloth, so that the offset is not zero
+    elasty::ParticleSet makeParticles()
+    {
+        elasty::ParticleSet particles;
+        particles.addParticle(elasty::Vector3(0.0, 5.0, 0.0), elasty::Vector3::Zero(), 1.0);
+        particles.addParticle(elasty::Vector3(0.0, 6.0, 0.0), elasty::Vector3::Zero(), 1.0);
+        return particles;
+    }
+
+    void testRoundTrip(const elasty::ClothSimObject& cloth, const elasty::ParticleSet& particles)
+    {
+        elasty::ParticleSet cached_particles = makeParticles();
+        const auto cached_cloth = elasty::ClothSimObject::readCache(cache_path, cached_particles);
+
+        if (cached_cloth->m_particle_offset != 2 || cached_cloth->m_num_particles != cloth.m_num_particles) { throw std::runtime_error("The particle range is not restored."); }
+        for (unsigned int i = 0; i < cloth.m_num_particles; ++ i)
+        {
+            if (cached_particles.x[2 + i] != particles.x[cloth.m_particle_offset + i] || cached_particles.m[2 + i] != particles.m[cloth.m_particle_offset + i])
+            {
+                throw std::runtime_error("The particles are not restored.");
+            }
+        }
+
+        if (cached_cloth->m_triangle_list != cloth.m_triangle_list || cached_cloth->m_obj_vertex_indices != cloth.m_obj_vertex_indices)
+        {
+            throw std::runtime_error("The triangles are not restored.");
+        }
+        if (cached_cloth->m_topology.getEdges().size() != cloth.m_topology.getEdges().size()) { throw std::runtime_error("The topology is not rebuilt."); }
+        if (cached_cloth->m_constraints.getBatchSizes() != cloth.m_constraints.getBatchSizes()) { throw std::runtime_error("The constraints are not restored."); }
+
+        // The constraints refer to the particles by the new offset
+        const auto& constraints = cloth.m_constraints.get<elasty::DistanceConstraint>();
+        const auto& cached_constraints = cached_cloth->m_constraints.get<elasty::DistanceConstraint>();
+        for (std::size_t i = 0; i < constraints.size(); ++ i)
+        {
+            if (cached_constraints[i].getIndices()[0] - 2 != constraints[i].getIndices()[0] - cloth.m_particle_offset ||
+                cached_constraints[i].getRestLength() != constraints[i].getRestLength() ||
+                cached_constraints[i].m_stiffness != constraints[i].m_stiffness)
+            {
+                throw std::runtime_error("The distance constraints are not restored.");
+            }
+        }
+
+        const auto& bending_constraints = cloth.m_constraints.get<elasty::IsometricBendingConstraint>();
+        const auto& cached_bending_constraints = cached_cloth->m_constraints.get<elasty::IsometricBendingConstraint>();
+        for (std::size_t i = 0; i < bending_constraints.size(); ++ i)
+        {
+            if (cached_bending_constraints[i].getK() != bending_constraints[i].getK()) { throw std::runtime_error("The bending constraints are not restored."); }
+        }
+    }
+
+    // A file damaged by the function is rejected, and leaves the particle set
+    // as it is
+    void testRejection(const std::vector<char>& data, const std::function<void(std::vector<char>&)>& damage)
+    {
+        std::vector<char> damaged_data = data;
+        damage(damaged_data);
+        writeFile(cache_path, damaged_data);
+
+        elasty::ParticleSet particles = makeParticles();
+
+        bool has_thrown = false;
+        try { elasty::ClothSimObject::readCache(cache_path, particles); }
+        catch (const std::runtime_error&) { has_thrown = true; }
+
+        if (!has_thrown) { throw std::runtime_error("A damaged cache is accepted."); }
+        if (particles.size() != 2) { throw std::runtime_error("A damaged cache leaves particles behind."); }
+    }
+}
+
+int main()
+{
+    const std::string obj_path = writeObj();
+
+    elasty::ParticleSet particles = makeParticles();
+    particles.addParticle(elasty::Vector3::Zero(), elasty::Vector3::Zero(), 1.0);
+
+    const elasty::ClothSimObject cloth(obj_path, particles);
+    std::filesystem::remove(obj_path);
+
+    cloth.writeCache(cache_path, particles);
+    testRoundTrip(cloth, particles);
+
+    const std::vector<char> data = readFile(cache_path);
+
+    const std::size_t num_vertices = cloth.m_num_particles;
+    const std::size_t triangle_offset = header_size + 7 * sizeof(double) * num_vertices;
+    const std::size_t obj_vertex_index_offset = triangle_offset + (sizeof(std::int32_t) * cloth.m_triangle_list.size() + 7) / 8 * 8;
+    const std::size_t constraint_offset = obj_vertex_index_offset + (sizeof(std::uint32_t) * num_vertices + 7) / 8 * 8;
+
+    const auto write_index = [](std::vector<char>& data, const std::size_t offset, const std::uint32_t index) { std::memcpy(data.data() + offset, &index, sizeof(index)); };
+
+    // Another version
+    testRejection(data, [&](std::vector<char>& data) { write_index(data, 8, 1000); });
+
+    // Truncation
+    testRejection(data, [&](std::vector<char>& data) { data.resize(data.size() - 8); });
+    testRejection(data, [&](std::vector<char>& data) { data.resize(header_size + 8); });
+
+    // A huge number of particles, whose size would overflow
+    testRejection(data, [&](std::vector<char>& data) { const std::uint64_t n = ~std::uint64_t(0) / 2; std::memcpy(data.data() + 16, &n, sizeof(n)); });
+
+    // A huge number of triangles whose number of indices wraps to 11, so that
+    // the padded section still ends where the four triangles end
+    testRejection(data, [&](std::vector<char>& data) { const std::uint64_t n = 0x5555555555555559; std::memcpy(data.data() + 24, &n, sizeof(n)); });
+
+    // Indices out of range in each of the sections
+    testRejection(data, [&](std::vector<char>& data) { write_index(data, triangle_offset + 4, std::uint32_t(num_vertices)); });
+    testRejection(data, [&](std::vector<char>& data) { write_index(data, triangle_offset, std::uint32_t(- 1)); });
+    testRejection(data, [&](std::vector<char>& data) { write_index(data, obj_vertex_index_offset, std::uint32_t(num_vertices)); });
+    testRejection(data, [&](std::vector<char>& data) { write_index(data, constraint_offset + 4, std::uint32_t(num_vertices)); });
+
+    std::filesystem::remove(cache_path);
+
+    return 0;
+}
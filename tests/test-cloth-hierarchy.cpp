@@ -0,0 +1,167 @@
+#include <elasty/cloth-hierarchy.hpp>
+#include <elasty/cloth-sim-object.hpp>
+#include <elasty/constraint.hpp>
+#include <elasty/engine.hpp>
+#include <elasty/mesh-topology.hpp>
+#include <elasty/particle-set.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+    const bool is_float = std::is_same<elasty::Scalar, float>::value;
+
+    constexpr unsigned int resolution = 6;
+
+    // A flat grid of quads (each split into two triangles) on the xz-plane
+    std::string writeGridObj()
+    {
+        const std::string path = (std::filesystem::temp_directory_path() / "elasty-test-cloth-hierarchy.obj").string();
+
+        std::ofstream file(path);
+        for (unsigned int i = 0; i <= resolution; ++ i)
+        {
+            for (unsigned int j = 0; j <= resolution; ++ j) { file << "v " << double(j) / resolution << " 0 " << double(i) / resolution << "\n"; }
+        }
+        file << "vn 0 1 0\n";
+
+        const auto index = [](const unsigned int i, const unsigned int j) { return i * (resolution + 1) + j + 1; };
+        for (unsigned int i = 0; i < resolution; ++ i)
+        {
+            for (unsigned int j = 0; j < resolution; ++ j)
+            {
+                file << "f " << index(i, j) << "//1 " << index(i + 1, j) << "//1 " << index(i + 1, j + 1) << "//1\n";
+                file << "f " << index(i, j) << "//1 " << index(i + 1, j + 1) << "//1 " << index(i, j + 1) << "//1\n";
+            }
+        }
+
+        return path;
+    }
+
+    class EmptyEngine final : public elasty::Engine
+    {
+    public:
+
+        void initializeScene() override {}
+        void setExternalForces() override {}
+        void generateCollisionConstraints() override {}
+        void updateVelocities() override {}
+    };
+}
+
+int main()
+{
+    const std::string obj_path = writeGridObj();
+
+    // A particle before the cloth, so that the offset is not zero
+    elasty::ParticleSet particles;
+    particles.addParticle(elasty::Vector3(0.0, 5.0, 0.0), elasty::Vector3::Zero(), 1.0);
+
+    elasty::ClothSimObject cloth(obj_path, particles);
+    const unsigned int offset = cloth.m_particle_offset;
+    const unsigned int num_vertices = cloth.m_num_particles;
+
+    // Pin a corner by its inverse mass and another by a fixed-point constraint
+    const unsigned int pinned_0 = 0;
+    const unsigned int pinned_1 = resolution;
+    particles.w[offset + pinned_0] = 0.0;
+    cloth.m_constraints.emplace<elasty::FixedPointConstraint>(particles, offset + pinned_1, 1.0, particles.x[offset + pinned_1]);
+
+    // The coarse level is identical to the cloth, so that each of the
+    // embeddings maps a vertex onto itself
+    elasty::ClothHierarchy hierarchy(cloth, particles, cloth.m_constraints, { obj_path });
+    std::filesystem::remove(obj_path);
+
+    if (hierarchy.getNumLevels() != 1) { throw std::runtime_error("Wrong number of levels."); }
+
+    const elasty::Scalar tolerance = is_float ? 1e-05 : 1e-10;
+    const auto calculate_max_difference = [&](const std::vector<elasty::Vector3>& a, const std::vector<elasty::Vector3>& b)
+    {
+        elasty::Scalar max_difference = 0.0;
+        for (unsigned int i = 0; i < num_vertices; ++ i) { max_difference = std::max(max_difference, (a[offset + i] - b[offset + i]).norm()); }
+        return max_difference;
+    };
+
+    // The restriction and the prolongation of an unstretched cloth give its
+    // positions back
+    particles.p = particles.x;
+    hierarchy.project(particles);
+    if (calculate_max_difference(particles.p, particles.x) > tolerance) { throw std::runtime_error("The round trip changes the positions."); }
+
+    // Stretch the cloth along the x-axis
+    for (unsigned int i = 0; i < num_vertices; ++ i)
+    {
+        if (i == pinned_0 || i == pinned_1) { continue; }
+        particles.p[offset + i].x() *= 1.3;
+    }
+    const std::vector<elasty::Vector3> stretched_positions = particles.p;
+
+    hierarchy.project(particles);
+
+    if (particles.p[offset + pinned_0] != stretched_positions[offset + pinned_0] || particles.p[offset + pinned_1] != stretched_positions[offset + pinned_1])
+    {
+        throw std::runtime_error("A pinned vertex moves.");
+    }
+    if (particles.p[0] != stretched_positions[0]) { throw std::runtime_error("A particle of another object moves."); }
+
+    // The result equals the unilateral projections on the cloth itself, as the
+    // embeddings are identities
+    std::vector<elasty::Vector3> expected_positions = stretched_positions;
+    std::vector<elasty::Scalar> inverse_masses(num_vertices, 1.0);
+    inverse_masses[pinned_0] = 0.0;
+    inverse_masses[pinned_1] = 0.0;
+
+    elasty::MeshTopology topology;
+    topology.build(cloth.m_triangle_list, num_vertices);
+
+    for (unsigned int iteration = 0; iteration < hierarchy.m_num_iterations; ++ iteration)
+    {
+        for (const auto& edge : topology.getEdges())
+        {
+            const unsigned int i_0 = edge.vertices[0];
+            const unsigned int i_1 = edge.vertices[1];
+            const elasty::Scalar w_0 = inverse_masses[i_0];
+            const elasty::Scalar w_1 = inverse_masses[i_1];
+            if (w_0 + w_1 == 0.0) { continue; }
+
+            elasty::Vector3& x_0 = expected_positions[offset + i_0];
+            elasty::Vector3& x_1 = expected_positions[offset + i_1];
+            const elasty::Scalar rest_length = (particles.x[offset + i_0] - particles.x[offset + i_1]).norm();
+
+            const elasty::Vector3 r = x_0 - x_1;
+            const elasty::Scalar C = r.norm() - rest_length;
+            if (C <= 0.0) { continue; }
+
+            const elasty::Vector3 correction = (hierarchy.m_stiffness * C / ((w_0 + w_1) * r.norm())) * r;
+            x_0 -= w_0 * correction;
+            x_1 += w_1 * correction;
+        }
+    }
+
+    if (calculate_max_difference(particles.p, expected_positions) > 1e+03 * tolerance) { throw std::runtime_error("The prolongation does not give the coarse corrections."); }
+    if (!(calculate_max_difference(particles.p, particles.x) < 0.5 * calculate_max_difference(stretched_positions, particles.x))) { throw std::runtime_error("The stretching is not reduced."); }
+
+    // The hierarchies are removed together with the scene
+    EmptyEngine engine;
+    engine.m_particles = particles;
+    engine.m_cloth_hierarchies.push_back(std::make_shared<elasty::ClothHierarchy>(hierarchy));
+    engine.clearScene();
+    if (!engine.m_cloth_hierarchies.empty()) { throw std::runtime_error("The hierarchies survive the scene."); }
+
+    // A stale hierarchy is rejected instead of writing out of bounds
+    elasty::ParticleSet other_particles;
+    other_particles.addParticle(elasty::Vector3::Zero(), elasty::Vector3::Zero(), 1.0);
+
+    bool has_thrown = false;
+    try { hierarchy.project(other_particles); }
+    catch (const std::runtime_error&) { has_thrown = true; }
+    if (!has_thrown) { throw std::runtime_error("A stale hierarchy is projected."); }
+
+    return 0;
+}
@@ -0,0 +1,128 @@
+#include <elasty/cloth-sim-object.hpp>
+#include <elasty/constraint.hpp>
+#include <elasty/particle-set.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace
+{
+    constexpr unsigned int resolution = 4;
+    constexpr double distance_stiffness = 0.8;
+
+    // A slightly irregular grid of quads (each split into two triangles)
+    std::string writeGridObj()
+    {
+        const std::string path = (std::filesystem::temp_directory_path() / "elasty-test-cloth-sim-object.obj").string();
+
+        std::ofstream file(path);
+        for (unsigned int i = 0; i <= resolution; ++ i)
+        {
+            for (unsigned int j = 0; j <= resolution; ++ j)
+            {
+                file << "v " << 0.25 * j + 0.01 * i << " " << 0.02 * ((i * 7 + j * 3) % 5) << " " << 0.25 * i << "\n";
+            }
+        }
+        file << "vn 0 1 0\n";
+
+        const auto index = [](const unsigned int i, const unsigned int j) { return i * (resolution + 1) + j + 1; };
+        for (unsigned int i = 0; i < resolution; ++ i)
+        {
+            for (unsigned int j = 0; j < resolution; ++ j)
+            {
+                file << "f " << index(i, j) << "//1 " << index(i + 1, j) << "//1 " << index(i + 1, j + 1) << "//1\n";
+                file << "f " << index(i, j) << "//1 " << index(i + 1, j + 1) << "//1 " << index(i, j + 1) << "//1\n";
+            }
+        }
+
+        return path;
+    }
+
+    std::pair<unsigned int, unsigned int> makeSortedPair(const unsigned int a, const unsigned int b) { return { std::min(a, b), std::max(a, b) }; }
+}
+
+int main()
+{
+    using Strategy = elasty::ClothSimObject::Strategy;
+    using StretchStrategy = elasty::ClothSimObject::StretchStrategy;
+
+    const std::string obj_path = writeGridObj();
+
+    elasty::ParticleSet particles;
+    const elasty::ClothSimObject cloth(obj_path, particles, distance_stiffness, 0.5, Eigen::Affine3d::Identity(), Strategy::IsometricBending, StretchStrategy::Distance);
+
+    elasty::ParticleSet legacy_particles;
+    const elasty::ClothSimObject legacy_cloth(obj_path, legacy_particles, distance_stiffness, 0.5, Eigen::Affine3d::Identity(), Strategy::IsometricBending, StretchStrategy::DistancePerTriangle);
+
+    std::filesystem::remove(obj_path);
+
+    // Each edge is constrained once, and the shared edges are stiffer
+    const auto& edges = cloth.m_topology.getEdges();
+    const auto& constraints = cloth.m_constraints.get<elasty::DistanceConstraint>();
+    if (edges.size() != 3 * resolution * resolution + 2 * resolution || constraints.size() != edges.size())
+    {
+        throw std::runtime_error("The edges are not constrained once each.");
+    }
+
+    const elasty::Scalar shared_edge_stiffness = 1.0 - (1.0 - distance_stiffness) * (1.0 - distance_stiffness);
+
+    std::set<std::pair<unsigned int, unsigned int>> constrained_edges;
+    for (const auto& constraint : constraints)
+    {
+        constrained_edges.insert(makeSortedPair(constraint.getIndices()[0], constraint.getIndices()[1]));
+    }
+    for (const auto& edge : edges)
+    {
+        if (constrained_edges.count(makeSortedPair(edge.vertices[0], edge.vertices[1])) == 0) { throw std::runtime_error("An edge is not constrained."); }
+    }
+    for (const auto& constraint : constraints)
+    {
+        const auto edge = std::find_if(edges.begin(), edges.end(), [&](const auto& edge)
+        {
+            return makeSortedPair(edge.vertices[0], edge.vertices[1]) == makeSortedPair(constraint.getIndices()[0], constraint.getIndices()[1]);
+        });
+        if (constraint.m_stiffness != (edge->isBoundary() ? elasty::Scalar(distance_stiffness) : shared_edge_stiffness))
+        {
+            throw std::runtime_error("Wrong stiffness of an edge.");
+        }
+    }
+
+    // The legacy strategy builds exactly the constraints of the former
+    // implementation: three per triangle in this order, with the given
+    // stiffness, so that the results are reproduced bit for bit
+    const auto& legacy_constraints = legacy_cloth.m_constraints.get<elasty::DistanceConstraint>();
+    if (legacy_constraints.size() != 3 * std::size_t(legacy_cloth.m_triangle_list.rows())) { throw std::runtime_error("The legacy strategy does not constrain every triangle."); }
+
+    for (unsigned int t = 0; t < legacy_cloth.m_triangle_list.rows(); ++ t)
+    {
+        const unsigned int p_0 = legacy_cloth.m_triangle_list(t, 0);
+        const unsigned int p_1 = legacy_cloth.m_triangle_list(t, 1);
+        const unsigned int p_2 = legacy_cloth.m_triangle_list(t, 2);
+
+        const std::pair<unsigned int, unsigned int> expected_pairs[] = { { p_0, p_1 }, { p_0, p_2 }, { p_1, p_2 } };
+        for (unsigned int k = 0; k < 3; ++ k)
+        {
+            const auto& constraint = legacy_constraints[3 * t + k];
+            const auto& [a, b] = expected_pairs[k];
+
+            if (constraint.getIndices()[0] != a || constraint.getIndices()[1] != b ||
+                constraint.m_stiffness != elasty::Scalar(distance_stiffness) ||
+                constraint.getRestLength() != (legacy_particles.x[a] - legacy_particles.x[b]).norm())
+            {
+                throw std::runtime_error("The legacy strategy differs from the former constraints.");
+            }
+        }
+    }
+
+    // The other constraints are not affected by the stretch strategy
+    if (legacy_cloth.m_constraints.get<elasty::IsometricBendingConstraint>().size() != cloth.m_constraints.get<elasty::IsometricBendingConstraint>().size())
+    {
+        throw std::runtime_error("The stretch strategy changes the bending constraints.");
+    }
+
+    return 0;
+}
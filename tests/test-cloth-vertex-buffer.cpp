@@ -0,0 +1,163 @@
+#include <elasty/cloth-sim-object.hpp>
+#include <elasty/cloth-vertex-buffer.hpp>
+#include <elasty/engine.hpp>
+#include <elasty/thread-pool.hpp>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr unsigned int resolution = 20;
+
+    // A flat square of the grid of quads (each split into two triangles) on
+    // the xz-plane
+    std::string writeGridObj()
+    {
+        const std::string path = (std::filesystem::temp_directory_path() / "elasty-test-cloth-vertex-buffer.obj").string();
+
+        std::ofstream file(path);
+        for (unsigned int i = 0; i <= resolution; ++ i)
+        {
+            for (unsigned int j = 0; j <= resolution; ++ j)
+            {
+                file << "v " << double(j) / double(resolution) - 0.5 << " 0 " << double(i) / double(resolution) - 0.5 << "\n";
+            }
+        }
+
+        // The loader requires the normals
+        file << "vn 0 1 0\n";
+
+        const auto index = [](unsigned int i, unsigned int j) { return std::to_string(i * (resolution + 1) + j + 1) + "//1"; };
+        for (unsigned int i = 0; i < resolution; ++ i)
+        {
+            for (unsigned int j = 0; j < resolution; ++ j)
+            {
+                file << "f " << index(i, j) << " " << index(i + 1, j) << " " << index(i + 1, j + 1) << "\n";
+                file << "f " << index(i, j) << " " << index(i + 1, j + 1) << " " << index(i, j + 1) << "\n";
+            }
+        }
+
+        return path;
+    }
+
+    class ClothEngine final : public elasty::Engine
+    {
+    public:
+
+        void initializeScene() override
+        {
+            const std::string path = writeGridObj();
+            m_cloth_sim_object = std::make_shared<elasty::ClothSimObject>(path, m_particles, 0.9, 0.1, Eigen::Affine3d(Eigen::Translation3d(0.0, 1.0, 0.0)));
+            std::filesystem::remove(path);
+
+            m_constraints.append(m_cloth_sim_object->m_constraints);
+            m_constraints.emplace<elasty::FixedPointConstraint>(m_particles, 0, 1.0, m_particles.x[0]);
+            m_constraints.emplace<elasty::FixedPointConstraint>(m_particles, resolution, 1.0, m_particles.x[resolution]);
+        }
+
+        void setExternalForces() override
+        {
+            for (unsigned int i = 0; i < m_particles.size(); ++ i)
+            {
+                m_particles.f[i] = m_particles.m[i] * elasty::Vector3(0.0, - 9.8, 0.0);
+            }
+        }
+
+        void generateCollisionConstraints() override {}
+
+        void updateVelocities() override {}
+
+        std::shared_ptr<elasty::ClothSimObject> m_cloth_sim_object;
+    };
+
+    // The area-weighted normals computed triangle by triangle
+    std::vector<elasty::Vector3> calculateReferenceNormals(const elasty::ClothSimObject& cloth, const elasty::ParticleSet& particles)
+    {
+        std::vector<elasty::Vector3> normals(cloth.m_num_particles, elasty::Vector3::Zero());
+        for (unsigned int t = 0; t < cloth.m_triangle_list.rows(); ++ t)
+        {
+            const elasty::Vector3& x_0 = particles.x[cloth.m_particle_offset + cloth.m_triangle_list(t, 0)];
+            const elasty::Vector3& x_1 = particles.x[cloth.m_particle_offset + cloth.m_triangle_list(t, 1)];
+            const elasty::Vector3& x_2 = particles.x[cloth.m_particle_offset + cloth.m_triangle_list(t, 2)];
+
+            const elasty::Vector3 face_normal = (x_1 - x_0).cross(x_2 - x_0);
+            for (unsigned int k = 0; k < 3; ++ k) { normals[cloth.m_triangle_list(t, k)] += face_normal; }
+        }
+        for (auto& normal : normals) { normal.normalize(); }
+        return normals;
+    }
+
+    void checkBuffer(const elasty::ClothVertexBuffer& buffer, const elasty::ClothSimObject& cloth, const elasty::ParticleSet& particles)
+    {
+        const std::vector<elasty::Vector3> normals = calculateReferenceNormals(cloth, particles);
+
+        for (unsigned int i = 0; i < cloth.m_num_particles; ++ i)
+        {
+            const elasty::Vector3& x = particles.x[cloth.m_particle_offset + i];
+            for (unsigned int k = 0; k < 3; ++ k)
+            {
+                if (buffer.getPositions()[3 * i + k] != float(x(k))) { throw std::runtime_error("The positions are not copied."); }
+                if (!(std::abs(buffer.getNormals()[3 * i + k] - normals[i](k)) < 1e-4)) { throw std::runtime_error("The normals are not correct."); }
+            }
+        }
+    }
+}
+
+int main()
+{
+    ClothEngine engine;
+    engine.initializeScene();
+
+    const elasty::ClothSimObject& cloth = *engine.m_cloth_sim_object;
+
+    auto buffer = std::make_shared<elasty::ClothVertexBuffer>(engine.m_cloth_sim_object);
+    auto parallel_buffer = std::make_shared<elasty::ClothVertexBuffer>(engine.m_cloth_sim_object);
+    auto position_buffer = std::make_shared<elasty::ClothVertexBuffer>(engine.m_cloth_sim_object, false);
+
+    if (buffer->getNumVertices() != cloth.m_num_particles) { throw std::runtime_error("The buffer is not allocated for the cloth."); }
+    if (position_buffer->getNormals() != nullptr) { throw std::runtime_error("The normals are exposed though not computed."); }
+
+    // The flat cloth faces along the y-axis
+    buffer->update(engine.m_particles);
+    checkBuffer(*buffer, cloth, engine.m_particles);
+    for (unsigned int i = 0; i < cloth.m_num_particles; ++ i)
+    {
+        if (!(std::abs(std::abs(buffer->getNormals()[3 * i + 1]) - 1.0f) < 1e-6f)) { throw std::runtime_error("The normals of the flat cloth are not vertical."); }
+    }
+
+    // The engine updates the registered buffers at the end of each step
+    engine.m_cloth_vertex_buffers = { buffer, position_buffer };
+    const unsigned long revision = buffer->getRevision();
+    for (unsigned int i = 0; i < 30; ++ i) { engine.stepTime(); }
+
+    if (buffer->getRevision() != revision + 30) { throw std::runtime_error("The buffer is not updated by the steps."); }
+    checkBuffer(*buffer, cloth, engine.m_particles);
+
+    // The parallel update gives the same values, as each vertex sums its own
+    // triangles in the same order
+    elasty::ThreadPool thread_pool(4);
+    parallel_buffer->update(engine.m_particles, &thread_pool);
+    for (std::size_t i = 0; i < 3 * cloth.m_num_particles; ++ i)
+    {
+        if (parallel_buffer->getPositions()[i] != buffer->getPositions()[i]) { throw std::runtime_error("The parallel update changes the positions."); }
+        if (parallel_buffer->getNormals()[i] != buffer->getNormals()[i]) { throw std::runtime_error("The parallel update changes the normals."); }
+        if (position_buffer->getPositions()[i] != buffer->getPositions()[i]) { throw std::runtime_error("The positions depend on the normals."); }
+    }
+
+    // The buffers are removed together with the scene, and a stale buffer is
+    // rejected instead of reading out of bounds
+    engine.clearScene();
+    if (!engine.m_cloth_vertex_buffers.empty()) { throw std::runtime_error("The buffers survive the scene."); }
+
+    bool has_thrown = false;
+    try { buffer->update(engine.m_particles); }
+    catch (const std::runtime_error&) { has_thrown = true; }
+    if (!has_thrown) { throw std::runtime_error("A stale buffer is updated."); }
+
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include <elasty/colliders.hpp>
+#include <elasty/constraint-set.hpp>
+#include <elasty/particle-set.hpp>
+#include <elasty/thread-pool.hpp>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+
+int main()
+{
+    // A closed cube mesh [-0.5, 0.5]^3, with the triangles in the counter-clockwise order seen from outside
+    const std::vector<elasty::Vector3> vertices =
+    {
+        { -0.5, -0.5, -0.5 }, { 0.5, -0.5, -0.5 }, { 0.5, 0.5, -0.5 }, { -0.5, 0.5, -0.5 },
+        { -0.5, -0.5, 0.5 }, { 0.5, -0.5, 0.5 }, { 0.5, 0.5, 0.5 }, { -0.5, 0.5, 0.5 },
+    };
+
+    elasty::MeshTopology::TriangleList triangles(12, 3);
+    triangles << 0, 2, 1,  0, 3, 2,  // -z
+                 4, 5, 6,  4, 6, 7,  // +z
+                 0, 1, 5,  0, 5, 4,  // -y
+                 3, 7, 6,  3, 6, 2,  // +y
+                 0, 4, 7,  0, 7, 3,  // -x
+                 1, 2, 6,  1, 6, 5;  // +x
+
+    constexpr elasty::Scalar cell_size = 0.05;
+
+    elasty::ThreadPool thread_pool(4);
+
+    auto sdf = std::make_shared<elasty::SdfCollider>();
+    sdf->build(vertices, triangles, cell_size, 0.2, &thread_pool);
+
+    const elasty::BoxCollider box{ elasty::Isometry3::Identity(), elasty::Vector3::Constant(0.5) };
+
+    // The interpolated distances should agree with the analytic ones up to
+    // the interpolation error, which is bounded by the cell size
+    std::mt19937 engine(0);
+    std::uniform_real_distribution<elasty::Scalar> distribution(-0.65, 0.65);
+    for (unsigned int i = 0; i < 1000; ++ i)
+    {
+        const elasty::Vector3 point(distribution(engine), distribution(engine), distribution(engine));
+
+        elasty::Vector3 sdf_normal;
+        elasty::Vector3 box_normal;
+        const elasty::Scalar sdf_distance = sdf->calculateSignedDistance(point, sdf_normal);
+        const elasty::Scalar box_distance = box.calculateSignedDistance(point, box_normal);
+
+        if (std::abs(sdf_distance - box_distance) > cell_size) { throw std::runtime_error("Wrong signed distance."); }
+
+        // Away from the edges of the cube, the normals should agree as well
+        const elasty::Vector3 sorted = point.cwiseAbs();
+        if (sorted.maxCoeff() > 0.5 + cell_size && (sorted.array() < 0.5 - cell_size).count() == 2 && sdf_normal.dot(box_normal) < 0.99)
+        {
+            throw std::runtime_error("Wrong normal.");
+        }
+    }
+
+    // A particle inside each collider should be pushed out to the thickness
+    elasty::ColliderSet colliders;
+    colliders.m_thickness = 0.01;
+    colliders.m_spheres.push_back({ elasty::Vector3(3.0, 0.0, 0.0), 0.5 });
+    colliders.m_capsules.push_back({ elasty::Vector3(0.0, 3.0, -1.0), elasty::Vector3(0.0, 3.0, 1.0), 0.5 });
+    colliders.m_sdfs.push_back(sdf);
+
+    elasty::ParticleSet particles;
+    particles.addParticle(elasty::Vector3(3.0, 0.4, 0.0), elasty::Vector3::Zero(), 1.0);
+    particles.addParticle(elasty::Vector3(0.0, 3.3, 0.5), elasty::Vector3::Zero(), 1.0);
+    particles.addParticle(elasty::Vector3(0.0, 0.45, 0.0), elasty::Vector3::Zero(), 1.0);
+    particles.addParticle(elasty::Vector3(10.0, 0.0, 0.0), elasty::Vector3::Zero(), 1.0);
+
+    elasty::ConstraintSet constraints;
+    colliders.generateConstraints(particles, constraints, &thread_pool);
+
+    auto& contacts = constraints.get<elasty::EnvironmentalCollisionConstraint>();
+    if (contacts.size() != 3) { throw std::runtime_error("Wrong number of contacts."); }
+
+    for (auto& contact : contacts) { contact.projectParticles(particles); }
+
+    constexpr elasty::Scalar tolerance = std::is_same<elasty::Scalar, float>::value ? 1e-05 : 1e-09;
+    if (std::abs(particles.p[0].y() - 0.51) > tolerance) { throw std::runtime_error("Wrong sphere contact."); }
+    if (std::abs(particles.p[1].y() - 3.51) > tolerance) { throw std::runtime_error("Wrong capsule contact."); }
+    if (std::abs(particles.p[2].y() - 0.51) > cell_size) { throw std::runtime_error("Wrong SDF contact."); }
+
+    return 0;
+}
@@ -0,0 +1,235 @@
+#include <elasty/constraint.hpp>
+#include <elasty/device-solver.hpp>
+#include <elasty/engine.hpp>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+    // A square cloth pinned at two of its corners falling onto a sphere
+    class ClothEngine final : public elasty::Engine
+    {
+    public:
+
+        void initializeScene() override
+        {
+            for (unsigned int i = 0; i < resolution; ++ i)
+            {
+                for (unsigned int j = 0; j < resolution; ++ j)
+                {
+                    const elasty::Vector3 x(elasty::Scalar(j) * spacing - 0.5, 1.0, elasty::Scalar(i) * spacing - 0.5);
+                    m_particles.addParticle(x, elasty::Vector3::Zero(), 0.01);
+                }
+            }
+
+            const auto index = [](unsigned int i, unsigned int j) { return i * resolution + j; };
+            for (unsigned int i = 0; i < resolution; ++ i)
+            {
+                for (unsigned int j = 0; j < resolution; ++ j)
+                {
+                    if (j + 1 < resolution) { m_constraints.emplace<elasty::DistanceConstraint>(m_particles, index(i, j), index(i, j + 1), 1.0, spacing); }
+                    if (i + 1 < resolution) { m_constraints.emplace<elasty::DistanceConstraint>(m_particles, index(i, j), index(i + 1, j), 1.0, spacing); }
+                    if (i + 1 < resolution && j + 1 < resolution)
+                    {
+                        m_constraints.emplace<elasty::IsometricBendingConstraint>(m_particles, index(i, j + 1), index(i + 1, j), index(i, j), index(i + 1, j + 1), 0.1);
+                    }
+                }
+            }
+
+            m_constraints.emplace<elasty::FixedPointConstraint>(m_particles, index(0, 0), 1.0, m_particles.x[index(0, 0)]);
+            m_constraints.emplace<elasty::FixedPointConstraint>(m_particles, index(0, resolution - 1), 1.0, m_particles.x[index(0, resolution - 1)]);
+
+            m_device_colliders.m_spheres.push_back({ elasty::Vector3(0.0, 0.5, 0.3), 0.3 });
+            m_device_colliders.m_thickness = 0.01;
+            m_device_velocity_damping = 0.01;
+        }
+
+        void setExternalForces() override
+        {
+            for (unsigned int i = 0; i < m_particles.size(); ++ i)
+            {
+                m_particles.f[i] = m_particles.m[i] * elasty::Vector3(0.0, - 9.8, 0.0);
+            }
+        }
+
+        // The counterparts of the device colliders and the velocity damping
+        void generateCollisionConstraints() override { m_device_colliders.generateConstraints(m_particles, m_instant_constraints); }
+
+        void updateVelocities() override
+        {
+            for (auto& v : m_particles.v) { v *= 1.0 - m_device_velocity_damping; }
+        }
+
+        static constexpr unsigned int resolution = 8;
+        static constexpr elasty::Scalar spacing = 1.0 / elasty::Scalar(resolution - 1);
+    };
+
+    elasty::ParticleSet simulate(const elasty::Backend backend, const elasty::Framework framework, const elasty::ProjectionScheme scheme)
+    {
+        ClothEngine engine;
+        engine.initializeScene();
+        engine.m_backend = backend;
+        engine.m_framework = framework;
+        engine.m_projection_scheme = scheme;
+        engine.m_num_substeps = 2;
+
+        // The CPU solver projects by the colors when run on threads, as the
+        // device backends always do
+        engine.m_num_threads = 2;
+
+        for (unsigned int i = 0; i < 60; ++ i) { engine.stepTime(); }
+
+        engine.synchronizeParticles();
+        return engine.m_particles;
+    }
+
+    elasty::Scalar calculateMaxDifference(const elasty::ParticleSet& a, const elasty::ParticleSet& b)
+    {
+        elasty::Scalar max_difference = 0.0;
+        for (std::size_t i = 0; i < a.size(); ++ i)
+        {
+            max_difference = std::max(max_difference, (a.x[i] - b.x[i]).norm());
+            max_difference = std::max(max_difference, (a.v[i] - b.v[i]).norm());
+        }
+        return max_difference;
+    }
+
+    void testBackendsMatch(const elasty::Framework framework, const elasty::ProjectionScheme scheme)
+    {
+        const elasty::ParticleSet cpu_particles = simulate(elasty::Backend::Cpu, framework, scheme);
+        const elasty::ParticleSet device_particles = simulate(elasty::Backend::Reference, framework, scheme);
+
+        // The cloth has reached the sphere
+        if (!(device_particles.x[ClothEngine::resolution * (ClothEngine::resolution / 2)].y() < 0.9)) { throw std::runtime_error("The cloth does not fall."); }
+
+        // Only the rounding differs (e.g., the arithmetic of the kernels)
+        constexpr elasty::Scalar tolerance = sizeof(elasty::Scalar) == 4 ? 1e-3 : 1e-8;
+        if (!(calculateMaxDifference(cpu_particles, device_particles) < tolerance)) { throw std::runtime_error("The device backend does not match the CPU solver."); }
+    }
+
+    // The records evaluate the constraints as the classes do
+    template <typename Type>
+    void testRecord(const elasty::ParticleSet& particles, const Type& constraint)
+    {
+        elasty::DeviceScene scene;
+        elasty::ConstraintSet constraints;
+        constraints.add(constraint);
+        scene.build(particles, constraints, nullptr, elasty::ColliderSet());
+
+        const auto& record = std::get<std::vector<elasty::device::Record<Type>>>(scene.records).front();
+
+        elasty::Scalar grad_C[3 * Type::num_particles];
+        const elasty::Scalar C = constraint.calculateValueAndGrad(particles, grad_C);
+
+        elasty::Scalar record_C;
+        elasty::device::Vec3 record_grad_C[Type::num_particles];
+        if (!record.evaluate(scene.x.data(), record_C, record_grad_C)) { throw std::runtime_error("The record is not evaluated."); }
+
+        constexpr elasty::Scalar tolerance = sizeof(elasty::Scalar) == 4 ? 1e-4 : 1e-10;
+        if (!(std::abs(C - record_C) < tolerance)) { throw std::runtime_error("The value of the record does not match the constraint."); }
+        for (unsigned int j = 0; j < Type::num_particles; ++ j)
+        {
+            const elasty::Vector3 grad(record_grad_C[j].x, record_grad_C[j].y, record_grad_C[j].z);
+            if (!((grad - Eigen::Map<const elasty::Vector3>(grad_C + 3 * j)).norm() < tolerance)) { throw std::runtime_error("The gradient of the record does not match the constraint."); }
+        }
+    }
+
+    void testRecords()
+    {
+        elasty::ParticleSet particles;
+        particles.addParticle(elasty::Vector3(0.0, 0.0, 0.0), elasty::Vector3::Zero(), 1.0);
+        particles.addParticle(elasty::Vector3(1.0, 0.1, 0.0), elasty::Vector3::Zero(), 1.0);
+        particles.addParticle(elasty::Vector3(0.4, 0.2, 0.9), elasty::Vector3::Zero(), 1.0);
+        particles.addParticle(elasty::Vector3(0.6, - 0.3, - 0.8), elasty::Vector3::Zero(), 1.0);
+
+        const elasty::BendingConstraint bending(particles, 0, 1, 2, 3, 1.0, 2.5);
+        const elasty::IsometricBendingConstraint isometric_bending(particles, 0, 1, 2, 3, 1.0);
+        const elasty::TriangleStrainConstraint triangle_strain(particles, 0, 1, 2, 1.0);
+        const elasty::TriangleAreaConstraint triangle_area(particles, 0, 1, 2, 1.0, 0.3);
+        const elasty::TetrahedronStrainConstraint tetrahedron_strain(particles, 0, 1, 2, 3, 1.0);
+        const elasty::VolumeConstraint volume(particles, 0, 1, 2, 3, 1.0, 0.1);
+
+        // Bend the pair of the triangles (and deform the tetrahedron) away
+        // from the rest shapes (the constraints are evaluated at the
+        // predicted positions, and the records at the positions of the scene)
+        particles.x[2] = elasty::Vector3(0.3, 0.5, 0.8);
+        particles.p[2] = particles.x[2];
+
+        testRecord(particles, bending);
+        testRecord(particles, isometric_bending);
+        testRecord(particles, triangle_strain);
+        testRecord(particles, triangle_area);
+        testRecord(particles, tetrahedron_strain);
+        testRecord(particles, volume);
+    }
+
+    void testSceneUpdate()
+    {
+        ClothEngine engine;
+        engine.initializeScene();
+        engine.m_backend = elasty::Backend::Reference;
+
+        engine.stepTime();
+
+        // The host copy is not touched until the synchronization
+        for (std::size_t i = 0; i < engine.m_particles.size(); ++ i)
+        {
+            if (engine.m_particles.v[i] != elasty::Vector3::Zero()) { throw std::runtime_error("The host particles are updated without the synchronization."); }
+        }
+
+        engine.synchronizeParticles();
+        const elasty::Scalar y = engine.m_particles.x[ClothEngine::resolution * ClothEngine::resolution - 1].y();
+        if (!(y < 1.0)) { throw std::runtime_error("The synchronization does not copy the particles."); }
+
+        // A constraint added on the host is uploaded at the next step
+        engine.m_constraints.emplace<elasty::FixedPointConstraint>(engine.m_particles,
+                                                                   ClothEngine::resolution * ClothEngine::resolution - 1,
+                                                                   1.0,
+                                                                   engine.m_particles.x[ClothEngine::resolution * ClothEngine::resolution - 1]);
+        for (unsigned int i = 0; i < 30; ++ i) { engine.stepTime(); }
+        engine.synchronizeParticles();
+
+        if (!(std::abs(engine.m_particles.x[ClothEngine::resolution * ClothEngine::resolution - 1].y() - y) < 1e-3)) { throw std::runtime_error("The added constraint is not uploaded."); }
+    }
+
+    void testUnsupported()
+    {
+        ClothEngine engine;
+        engine.initializeScene();
+        engine.m_backend = elasty::Backend::Reference;
+        engine.m_framework = elasty::Framework::ProjectiveDynamics;
+
+        bool has_thrown = false;
+        try { engine.stepTime(); }
+        catch (const std::runtime_error&) { has_thrown = true; }
+        if (!has_thrown) { throw std::runtime_error("Projective dynamics is accepted by the device backend."); }
+
+        has_thrown = false;
+        try { elasty::createDeviceSolver(elasty::Backend::Cpu); }
+        catch (const std::runtime_error&) { has_thrown = true; }
+        if (!has_thrown) { throw std::runtime_error("A device solver is created for the CPU backend."); }
+
+        has_thrown = false;
+        try { elasty::createDeviceSolver(elasty::Backend::Cuda); }
+        catch (const std::runtime_error&) { has_thrown = true; }
+        if (has_thrown == elasty::isBackendAvailable(elasty::Backend::Cuda)) { throw std::runtime_error("The availability of the CUDA backend is not consistent."); }
+    }
+}
+
+int main()
+{
+    using elasty::Framework;
+    using elasty::ProjectionScheme;
+
+    testBackendsMatch(Framework::Pbd, ProjectionScheme::GaussSeidel);
+    testBackendsMatch(Framework::Xpbd, ProjectionScheme::GaussSeidel);
+    testBackendsMatch(Framework::Pbd, ProjectionScheme::Jacobi);
+    testBackendsMatch(Framework::Xpbd, ProjectionScheme::Jacobi);
+
+    testRecords();
+    testSceneUpdate();
+    testUnsupported();
+
+    return 0;
+}
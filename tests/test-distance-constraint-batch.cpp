@@ -0,0 +1,75 @@
+#include <elasty/constraint.hpp>
+#include <elasty/distance-constraint-batch.hpp>
+#include <elasty/particle-set.hpp>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+int main()
+{
+    // Independent pairs of particles, so that all the constraints can be
+    // projected at once; the number of the constraints is not a multiple of
+    // the SIMD width so that the scalar remainder is also exercised
+    constexpr unsigned int num_constraints = 37;
+
+    elasty::ParticleSet particles;
+    std::vector<elasty::DistanceConstraint> constraints;
+    for (unsigned int i = 0; i < num_constraints; ++ i)
+    {
+        const elasty::Scalar mass_0 = (i % 5 == 0) ? std::numeric_limits<elasty::Scalar>::infinity() : 1.0 + 0.1 * elasty::Scalar(i);
+        const elasty::Scalar mass_1 = 2.0;
+
+        const unsigned int index_0 = particles.addParticle(elasty::Vector3::Random(), elasty::Vector3::Zero(), mass_0);
+        const unsigned int index_1 = particles.addParticle(elasty::Vector3::Random(), elasty::Vector3::Zero(), mass_1);
+
+        elasty::DistanceConstraint constraint(particles, index_0, index_1, 0.25 + 0.02 * elasty::Scalar(i), 0.5);
+        constraint.m_compliance = 1e-6 * elasty::Scalar(i);
+        constraints.push_back(constraint);
+    }
+
+    const std::vector<elasty::Vector3> initial_positions = particles.p;
+
+    for (const bool is_xpbd : { false, true })
+    {
+        constexpr elasty::Scalar dt = 1.0 / 60.0;
+
+        particles.p = initial_positions;
+
+        // Reference: the per-constraint projection
+        elasty::ParticleSet reference = particles;
+        std::vector<elasty::DistanceConstraint> reference_constraints = constraints;
+        for (unsigned int iter = 0; iter < 3; ++ iter)
+        {
+            for (auto& constraint : reference_constraints)
+            {
+                if (is_xpbd) { constraint.projectParticlesXpbd(reference, dt); } else { constraint.projectParticles(reference); }
+            }
+        }
+
+        elasty::DistanceConstraintBatch batch;
+        batch.build(constraints);
+        for (unsigned int iter = 0; iter < 3; ++ iter)
+        {
+            elasty::projectDistanceConstraintBatch(batch, 0, batch.size(), particles.p.front().data(), is_xpbd, dt);
+        }
+
+        // The kernels may contract the operations into FMAs, so the results
+        // agree only up to rounding
+        constexpr elasty::Scalar tolerance = std::is_same<elasty::Scalar, float>::value ? 1e-04 : 1e-10;
+        for (std::size_t i = 0; i < particles.size(); ++ i)
+        {
+            if (!particles.p[i].isApprox(reference.p[i], tolerance)) { throw std::runtime_error(""); }
+        }
+
+        if (is_xpbd)
+        {
+            batch.writeLagrangeMultipliers(constraints);
+            for (std::size_t i = 0; i < num_constraints; ++ i)
+            {
+                if (std::abs(constraints[i].m_lambda - reference_constraints[i].m_lambda) > tolerance) { throw std::runtime_error(""); }
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,159 @@
+#include <elasty/constraint.hpp>
+#include <elasty/engine.hpp>
+#include <elasty/engine-snapshot.hpp>
+#include <filesystem>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    // A chain of particles swinging from a pin, which is dragged along the
+    // x-axis in every step, and bouncing on the ground
+    class ChainEngine final : public elasty::Engine
+    {
+    public:
+
+        void initializeScene() override
+        {
+            for (unsigned int i = 0; i < num_particles; ++ i)
+            {
+                m_particles.addParticle(elasty::Vector3(elasty::Scalar(i) * 0.1, 0.5, 0.0), elasty::Vector3::Zero(), 0.1);
+                if (i > 0) { addConstraint(elasty::DistanceConstraint(m_particles, i - 1, i, 1.0, 0.1)); }
+            }
+            addConstraint(elasty::FixedPointConstraint(m_particles, 0, 1.0, m_particles.x[0]));
+        }
+
+        void setExternalForces() override
+        {
+            for (unsigned int i = 0; i < m_particles.size(); ++ i)
+            {
+                m_particles.f[i] = m_particles.m[i] * elasty::Vector3(0.0, - 9.8, 0.0);
+            }
+        }
+
+        void generateCollisionConstraints() override
+        {
+            for (unsigned int i = 0; i < m_particles.size(); ++ i)
+            {
+                if (m_particles.w[i] != 0.0 && m_particles.p[i].y() < 0.0)
+                {
+                    emplaceInstantConstraint<elasty::EnvironmentalCollisionConstraint>(m_particles, i, 1.0, elasty::Vector3::UnitY(), 0.0);
+                }
+            }
+        }
+
+        void updateVelocities() override {}
+
+        void stepDraggingPin()
+        {
+            auto& pin = m_constraints.get<elasty::FixedPointConstraint>().front();
+            pin.setPoint(pin.getPoint() + elasty::Vector3(0.01, 0.0, 0.0));
+
+            stepTime();
+        }
+
+        static constexpr unsigned int num_particles = 12;
+    };
+
+    bool isSameState(const elasty::ParticleSet& a, const elasty::ParticleSet& b)
+    {
+        return a.x == b.x && a.v == b.v && a.p == b.p && a.w == b.w;
+    }
+
+    // The steps after a restoration are the same as those after the snapshot
+    void testReplay(const elasty::Framework framework)
+    {
+        ChainEngine engine;
+        engine.initializeScene();
+        engine.m_framework = framework;
+
+        for (unsigned int i = 0; i < 20; ++ i) { engine.stepDraggingPin(); }
+
+        const elasty::EngineSnapshot snapshot = engine.takeSnapshot();
+        if (snapshot.getNumSteps() != 20 || snapshot.getNumParticles() != ChainEngine::num_particles) { throw std::runtime_error("The snapshot does not record the engine."); }
+
+        // Also pin another particle by its inverse mass after the snapshot
+        engine.m_particles.w[ChainEngine::num_particles - 1] = 0.0;
+        for (unsigned int i = 0; i < 20; ++ i) { engine.stepDraggingPin(); }
+
+        engine.restoreSnapshot(snapshot);
+        if (engine.getNumSteps() != 20) { throw std::runtime_error("The number of the steps is not restored."); }
+        if (engine.m_particles.w[ChainEngine::num_particles - 1] == 0.0) { throw std::runtime_error("The inverse masses are not restored."); }
+
+        for (unsigned int i = 0; i < 20; ++ i) { engine.stepDraggingPin(); }
+        const elasty::ParticleSet particles = engine.m_particles;
+        const elasty::Vector3 pin_point = engine.m_constraints.get<elasty::FixedPointConstraint>().front().getPoint();
+
+        // A restoration from the file gives the same steps
+        const std::string path = (std::filesystem::temp_directory_path() / "elasty-test-engine-snapshot.bin").string();
+        snapshot.write(path);
+        const elasty::EngineSnapshot read_snapshot = elasty::EngineSnapshot::read(path);
+        std::filesystem::remove(path);
+
+        engine.restoreSnapshot(read_snapshot);
+        for (unsigned int i = 0; i < 20; ++ i) { engine.stepDraggingPin(); }
+
+        if (!isSameState(engine.m_particles, particles)) { throw std::runtime_error("The steps after the restoration differ."); }
+        if (engine.m_constraints.get<elasty::FixedPointConstraint>().front().getPoint() != pin_point) { throw std::runtime_error("The pin target is not restored."); }
+    }
+
+    void testRing()
+    {
+        ChainEngine engine;
+        engine.initializeScene();
+
+        elasty::SnapshotRing ring(4);
+
+        std::vector<elasty::ParticleSet> history;
+        for (unsigned int i = 0; i < 10; ++ i)
+        {
+            engine.stepDraggingPin();
+            ring.push(engine);
+            history.push_back(engine.m_particles);
+        }
+
+        // The oldest snapshots are overwritten
+        if (ring.size() != 4 || ring.getSnapshot(0).getNumSteps() != 7 || ring.getSnapshot(3).getNumSteps() != 10) { throw std::runtime_error("The ring does not keep the last snapshots."); }
+
+        if (ring.rollBack(engine, 6)) { throw std::runtime_error("A rollback beyond the ring succeeds."); }
+        if (engine.getNumSteps() != 10) { throw std::runtime_error("A failed rollback touches the engine."); }
+
+        if (!ring.rollBack(engine, 8)) { throw std::runtime_error("The rollback fails."); }
+        if (engine.getNumSteps() != 8 || !isSameState(engine.m_particles, history[7])) { throw std::runtime_error("The rollback does not restore the step."); }
+        if (ring.size() != 2) { throw std::runtime_error("The rollback does not discard the later snapshots."); }
+
+        // The simulation continues from the restored step
+        engine.stepDraggingPin();
+        ring.push(engine);
+        if (ring.size() != 3 || ring.getSnapshot(2).getNumSteps() != 9) { throw std::runtime_error("The ring does not continue after the rollback."); }
+    }
+
+    void testMismatch()
+    {
+        ChainEngine engine;
+        engine.initializeScene();
+        const elasty::EngineSnapshot snapshot = engine.takeSnapshot();
+
+        engine.m_particles.addParticle(elasty::Vector3::Zero(), elasty::Vector3::Zero(), 1.0);
+
+        bool has_thrown = false;
+        try { engine.restoreSnapshot(snapshot); }
+        catch (const std::runtime_error&) { has_thrown = true; }
+        if (!has_thrown) { throw std::runtime_error("A snapshot of another scene is restored."); }
+
+        has_thrown = false;
+        try { elasty::EngineSnapshot().setData(std::vector<char>(64, 0)); }
+        catch (const std::runtime_error&) { has_thrown = true; }
+        if (!has_thrown) { throw std::runtime_error("Invalid data is accepted as a snapshot."); }
+    }
+}
+
+int main()
+{
+    testReplay(elasty::Framework::Pbd);
+    testReplay(elasty::Framework::Xpbd);
+    testRing();
+    testMismatch();
+
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include <elasty/constraint.hpp>
+#include <elasty/graph-coloring.hpp>
+#include <elasty/particle-set.hpp>
+#include <set>
+#include <stdexcept>
+
+int main()
+{
+    // A regular grid of particles connected by distance constraints along the
+    // rows, the columns, and the diagonals
+    constexpr unsigned int num_rows = 12;
+    constexpr unsigned int num_cols = 10;
+
+    elasty::ParticleSet particles;
+    for (unsigned int i = 0; i < num_rows; ++ i)
+    {
+        for (unsigned int j = 0; j < num_cols; ++ j)
+        {
+            particles.addParticle(elasty::Vector3(elasty::Scalar(j), elasty::Scalar(i), 0.0), elasty::Vector3::Zero(), 1.0);
+        }
+    }
+
+    auto index = [&](const unsigned int i, const unsigned int j) { return i * num_cols + j; };
+
+    std::vector<elasty::DistanceConstraint> constraints;
+    for (unsigned int i = 0; i < num_rows; ++ i)
+    {
+        for (unsigned int j = 0; j < num_cols; ++ j)
+        {
+            if (j + 1 < num_cols) { constraints.push_back(elasty::DistanceConstraint(particles, index(i, j), index(i, j + 1), 1.0, 1.0)); }
+            if (i + 1 < num_rows) { constraints.push_back(elasty::DistanceConstraint(particles, index(i, j), index(i + 1, j), 1.0, 1.0)); }
+            if (i + 1 < num_rows && j + 1 < num_cols) { constraints.push_back(elasty::DistanceConstraint(particles, index(i, j), index(i + 1, j + 1), 1.0, 1.0)); }
+        }
+    }
+
+    std::set<std::pair<unsigned int, unsigned int>> original_pairs;
+    for (const auto& constraint : constraints)
+    {
+        original_pairs.insert({ constraint.getIndices()[0], constraint.getIndices()[1] });
+    }
+
+    const std::vector<std::size_t> offsets = elasty::sortConstraintsByColor(constraints, particles.size());
+
+    // The reordering should keep all the constraints
+    std::set<std::pair<unsigned int, unsigned int>> sorted_pairs;
+    for (const auto& constraint : constraints)
+    {
+        sorted_pairs.insert({ constraint.getIndices()[0], constraint.getIndices()[1] });
+    }
+    if (original_pairs != sorted_pairs || offsets.front() != 0 || offsets.back() != constraints.size())
+    {
+        throw std::runtime_error("");
+    }
+
+    // No two constraints of the same color should share a particle
+    for (std::size_t color = 0; color + 1 < offsets.size(); ++ color)
+    {
+        std::set<unsigned int> used_particles;
+        for (std::size_t i = offsets[color]; i < offsets[color + 1]; ++ i)
+        {
+            for (const unsigned int particle : constraints[i].getIndices())
+            {
+                if (!used_particles.insert(particle).second) { throw std::runtime_error(""); }
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,155 @@
+#include <elasty/constraint.hpp>
+#include <elasty/constraint-set.hpp>
+#include <elasty/jacobi-projection.hpp>
+#include <elasty/particle-set.hpp>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+namespace
+{
+    bool isNear(const elasty::Vector3& a, const elasty::Vector3& b) { return (a - b).norm() < 1e-05; }
+
+    // Each particle receives the average of the corrections of its active
+    // constraints, scaled by the relaxation factor
+    void testAccumulation()
+    {
+        elasty::ParticleSet particles;
+        particles.addParticle(elasty::Vector3(0.0, 0.0, 0.0), elasty::Vector3::Zero(), 1.0);
+        particles.addParticle(elasty::Vector3(1.0, 0.0, 0.0), elasty::Vector3::Zero(), 2.0);
+        particles.addParticle(elasty::Vector3(2.0, 0.5, 0.0), elasty::Vector3::Zero(), 1.0);
+
+        // A free particle in no constraint
+        particles.addParticle(elasty::Vector3(5.0, 0.0, 0.0), elasty::Vector3::Zero(), 1.0);
+
+        elasty::ConstraintSet constraints;
+        constraints.emplace<elasty::DistanceConstraint>(particles, 0, 1, 1.0, 0.5);
+        constraints.emplace<elasty::DistanceConstraint>(particles, 1, 2, 1.0, 0.5);
+
+        const auto& distance_constraints = constraints.get<elasty::DistanceConstraint>();
+
+        elasty::DistanceConstraint::Correction delta_x_0;
+        elasty::DistanceConstraint::Correction delta_x_1;
+        distance_constraints[0].calculateCorrection(particles, delta_x_0);
+        distance_constraints[1].calculateCorrection(particles, delta_x_1);
+
+        elasty::JacobiProjection projection;
+        projection.build(constraints, particles.size());
+
+        const auto calculate_correction = [&](const auto& constraint, auto& delta_x) { return constraint.calculateCorrection(particles, delta_x); };
+
+        constexpr elasty::Scalar relaxation = 1.5;
+
+        elasty::ParticleSet projected_particles = particles;
+        projection.project(constraints, projected_particles, relaxation, nullptr, calculate_correction);
+
+        if (!isNear(projected_particles.p[0], particles.p[0] + relaxation * delta_x_0.segment<3>(0)) ||
+            !isNear(projected_particles.p[1], particles.p[1] + 0.5 * relaxation * (delta_x_0.segment<3>(3) + delta_x_1.segment<3>(0))) ||
+            !isNear(projected_particles.p[2], particles.p[2] + relaxation * delta_x_1.segment<3>(3)) ||
+            projected_particles.p[3] != particles.p[3])
+        {
+            throw std::runtime_error("The corrections are not averaged.");
+        }
+
+        // An inactive constraint (here, the second one) is not counted in the
+        // average
+        projected_particles = particles;
+        projection.project(constraints, projected_particles, 1.0, nullptr, [&](const auto& constraint, auto& delta_x)
+        {
+            return constraint.getIndices()[0] != 1 && calculate_correction(constraint, delta_x);
+        });
+
+        if (!isNear(projected_particles.p[1], particles.p[1] + delta_x_0.segment<3>(3)) || projected_particles.p[2] != particles.p[2])
+        {
+            throw std::runtime_error("An inactive constraint is counted.");
+        }
+
+        // The layout is stale once a particle is added, even though the
+        // constraints do not change
+        if (!projection.isUpToDate(constraints, particles.size())) { throw std::runtime_error("The built layout is stale."); }
+        particles.addParticle(elasty::Vector3::Zero(), elasty::Vector3::Zero(), 1.0);
+        if (projection.isUpToDate(constraints, particles.size())) { throw std::runtime_error("The added particle is not detected."); }
+    }
+
+    elasty::Scalar calculateResidual(const elasty::ConstraintSet& constraints, const elasty::ParticleSet& particles)
+    {
+        elasty::Scalar sum = 0.0;
+        for (const auto& constraint : constraints.get<elasty::DistanceConstraint>()) { sum += std::abs(constraint.calculateValue(particles)); }
+        return sum;
+    }
+
+    // Both of the schemes converge on a small cloth, and the Gauss-Seidel
+    // scheme in fewer iterations
+    void testConvergence()
+    {
+        constexpr unsigned int resolution = 8;
+        constexpr elasty::Scalar spacing = 0.1;
+        constexpr unsigned int num_iterations = 20;
+
+        elasty::ParticleSet particles;
+        for (unsigned int i = 0; i <= resolution; ++ i)
+        {
+            for (unsigned int j = 0; j <= resolution; ++ j)
+            {
+                particles.addParticle(elasty::Vector3(spacing * j, 0.0, spacing * i), elasty::Vector3::Zero(), 0.1);
+            }
+        }
+
+        const auto index = [](const unsigned int i, const unsigned int j) { return i * (resolution + 1) + j; };
+
+        elasty::ConstraintSet constraints;
+        for (unsigned int i = 0; i <= resolution; ++ i)
+        {
+            for (unsigned int j = 0; j <= resolution; ++ j)
+            {
+                if (j < resolution) { constraints.emplace<elasty::DistanceConstraint>(particles, index(i, j), index(i, j + 1), 1.0, spacing); }
+                if (i < resolution) { constraints.emplace<elasty::DistanceConstraint>(particles, index(i, j), index(i + 1, j), 1.0, spacing); }
+                if (i < resolution && j < resolution) { constraints.emplace<elasty::DistanceConstraint>(particles, index(i, j), index(i + 1, j + 1), 1.0, std::sqrt(2.0) * spacing); }
+            }
+        }
+
+        // Perturb the predicted positions
+        std::mt19937 random_engine(0);
+        std::uniform_real_distribution<double> distribution(- 0.3 * spacing, 0.3 * spacing);
+        for (elasty::Vector3& p : particles.p) { p += elasty::Vector3(distribution(random_engine), distribution(random_engine), distribution(random_engine)); }
+
+        const elasty::Scalar initial_residual = calculateResidual(constraints, particles);
+
+        elasty::ParticleSet gauss_seidel_particles = particles;
+        for (unsigned int k = 0; k < num_iterations; ++ k)
+        {
+            for (const auto& constraint : constraints.get<elasty::DistanceConstraint>()) { constraint.projectParticles(gauss_seidel_particles); }
+        }
+
+        elasty::JacobiProjection projection;
+        projection.build(constraints, particles.size());
+
+        elasty::ParticleSet jacobi_particles = particles;
+        elasty::Scalar previous_residual = initial_residual;
+        for (unsigned int k = 0; k < num_iterations; ++ k)
+        {
+            projection.project(constraints, jacobi_particles, 1.0, nullptr, [&](const auto& constraint, auto& delta_x)
+            {
+                return constraint.calculateCorrection(jacobi_particles, delta_x);
+            });
+
+            const elasty::Scalar residual = calculateResidual(constraints, jacobi_particles);
+            if (!(residual < previous_residual)) { throw std::runtime_error("The Jacobi iterations do not decrease the residual."); }
+            previous_residual = residual;
+        }
+
+        const elasty::Scalar gauss_seidel_residual = calculateResidual(constraints, gauss_seidel_particles);
+        const elasty::Scalar jacobi_residual = calculateResidual(constraints, jacobi_particles);
+
+        if (!(jacobi_residual < 0.5 * initial_residual)) { throw std::runtime_error("The Jacobi scheme does not converge."); }
+        if (!(gauss_seidel_residual < jacobi_residual)) { throw std::runtime_error("The Jacobi scheme converges faster than the Gauss-Seidel scheme."); }
+    }
+}
+
+int main()
+{
+    testAccumulation();
+    testConvergence();
+
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include <elasty/mesh-topology.hpp>
+#include <elasty/thread-pool.hpp>
+#include <stdexcept>
+
+int main()
+{
+    // A regular grid of quads, each of which is split into two triangles
+    constexpr unsigned int num_rows = 40;
+    constexpr unsigned int num_cols = 30;
+
+    auto index = [&](const unsigned int i, const unsigned int j) { return int32_t(i * (num_cols + 1) + j); };
+
+    elasty::MeshTopology::TriangleList triangles(2 * num_rows * num_cols, 3);
+    for (unsigned int i = 0; i < num_rows; ++ i)
+    {
+        for (unsigned int j = 0; j < num_cols; ++ j)
+        {
+            const unsigned int quad = i * num_cols + j;
+            triangles.row(2 * quad + 0) << index(i, j), index(i, j + 1), index(i + 1, j + 1);
+            triangles.row(2 * quad + 1) << index(i, j), index(i + 1, j + 1), index(i + 1, j);
+        }
+    }
+
+    const unsigned int num_vertices = (num_rows + 1) * (num_cols + 1);
+
+    elasty::MeshTopology topology;
+    topology.build(triangles, num_vertices);
+
+    // Horizontal, vertical, and diagonal edges
+    const std::size_t num_edges = num_rows * (num_cols + 1) + (num_rows + 1) * num_cols + num_rows * num_cols;
+    const std::size_t num_boundary_edges = 2 * (num_rows + num_cols);
+
+    std::size_t num_found_boundary_edges = 0;
+    for (const auto& edge : topology.getEdges())
+    {
+        if (edge.isBoundary()) { ++ num_found_boundary_edges; }
+
+        // The opposite vertices should be the remaining vertices of the triangles
+        for (unsigned int side = 0; side < (edge.isBoundary() ? 1u : 2u); ++ side)
+        {
+            const auto triangle = triangles.row(edge.triangles[side]);
+            if ((triangle.array() == int32_t(edge.vertices[0])).count() != 1 ||
+                (triangle.array() == int32_t(edge.vertices[1])).count() != 1 ||
+                (triangle.array() == int32_t(edge.opposite_vertices[side])).count() != 1)
+            {
+                throw std::runtime_error("");
+            }
+        }
+    }
+    if (topology.getEdges().size() != num_edges || num_found_boundary_edges != num_boundary_edges)
+    {
+        throw std::runtime_error("");
+    }
+
+    if (topology.getVertexTriangleOffsets().back() != 3 * triangles.rows()) { throw std::runtime_error(""); }
+
+    // The parallel build should give the same result
+    elasty::ThreadPool thread_pool(4);
+    elasty::MeshTopology parallel_topology;
+    parallel_topology.build(triangles, num_vertices, &thread_pool);
+
+    for (std::size_t i = 0; i < topology.getEdges().size(); ++ i)
+    {
+        const auto& edge = topology.getEdges()[i];
+        const auto& parallel_edge = parallel_topology.getEdges()[i];
+        if (edge.vertices != parallel_edge.vertices || edge.triangles != parallel_edge.triangles)
+        {
+            throw std::runtime_error("");
+        }
+    }
+    for (unsigned int i = 0; i < triangles.rows(); ++ i)
+    {
+        if (topology.getTriangleEdges(i) != parallel_topology.getTriangleEdges(i)) { throw std::runtime_error(""); }
+    }
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include <elasty/constraint.hpp>
+#include <elasty/engine.hpp>
+#include <elasty/profiler.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    // A chain of particles swinging from a particle of infinite mass above a
+    // ground plane, which the lower particles hit
+    class ChainEngine final : public elasty::Engine
+    {
+    public:
+
+        void initializeScene() override
+        {
+            m_particles.addParticle(elasty::Vector3::Zero(), elasty::Vector3::Zero(), std::numeric_limits<elasty::Scalar>::infinity());
+            for (unsigned int i = 1; i < num_particles; ++ i)
+            {
+                m_particles.addParticle(elasty::Scalar(i) * segment_length * elasty::Vector3::UnitX(), elasty::Vector3::Zero(), 0.1);
+                addConstraint(elasty::DistanceConstraint(m_particles, i - 1, i, 1.0, segment_length));
+            }
+        }
+
+        void setExternalForces() override
+        {
+            for (unsigned int i = 1; i < m_particles.size(); ++ i)
+            {
+                m_particles.f[i] = m_particles.m[i] * elasty::Vector3(0.0, - 9.8, 0.0);
+            }
+        }
+
+        void generateCollisionConstraints() override
+        {
+            for (unsigned int i = 0; i < m_particles.size(); ++ i)
+            {
+                if (m_particles.p[i].y() < ground_height)
+                {
+                    emplaceInstantConstraint<elasty::EnvironmentalCollisionConstraint>(m_particles, i, 1.0, elasty::Vector3::UnitY(), - ground_height);
+                }
+            }
+        }
+
+        void updateVelocities() override {}
+
+        static constexpr unsigned int num_particles = 20;
+        static constexpr elasty::Scalar segment_length = 0.1;
+        static constexpr elasty::Scalar ground_height = - 1.0;
+    };
+}
+
+int main()
+{
+    ChainEngine engine;
+    engine.initializeScene();
+    engine.m_num_substeps = 2;
+
+    // The residual of the chain in its rest shape
+    if (engine.calculateResidualStatistics().num_constraints != ChainEngine::num_particles - 1) { throw std::runtime_error("Wrong number of bilateral constraints."); }
+    if (engine.calculateResidualStatistics().max > 1e-06) { throw std::runtime_error("Wrong residual of the rest shape."); }
+
+    constexpr unsigned int num_steps = 120;
+    for (unsigned int i = 0; i < num_steps; ++ i) { engine.stepTime(); }
+
+    const elasty::Profiler& profiler = engine.m_profiler;
+
+#if defined(ELASTY_PROFILING)
+    const auto& steps = profiler.getSteps();
+    if (steps.size() != num_steps * engine.m_num_substeps) { throw std::runtime_error("Wrong number of step records."); }
+
+    std::uint64_t num_projected_constraints = 0;
+    std::uint64_t num_contacts = 0;
+    for (const auto& step : steps)
+    {
+        num_projected_constraints += step.counts[static_cast<std::size_t>(elasty::Profiler::Counter::ProjectedConstraints)];
+        num_contacts += step.counts[static_cast<std::size_t>(elasty::Profiler::Counter::Contacts)];
+
+        if (step.residual.num_constraints != ChainEngine::num_particles - 1) { throw std::runtime_error("Wrong residual."); }
+    }
+    if (num_projected_constraints == 0) { throw std::runtime_error("No projections are counted."); }
+    if (num_contacts == 0) { throw std::runtime_error("No contacts are counted."); }
+
+    // One step event per step, and one iteration event per iteration of each substep
+    const auto total_durations = profiler.calculateTotalDurations();
+    for (const char* name : { "Step", "ExternalForces", "Prediction", "CollisionGeneration", "Solve", "Iteration", "DistanceConstraint", "VelocityUpdate" })
+    {
+        if (total_durations.count(name) == 0) { throw std::runtime_error(std::string("No event of ") + name); }
+    }
+
+    std::size_t num_iterations = 0;
+    for (const auto& event : profiler.getEvents()) { num_iterations += std::string(event.name) == "Iteration"; }
+    if (num_iterations != num_steps * engine.m_num_substeps * engine.m_num_iterations) { throw std::runtime_error("Wrong number of iteration events."); }
+
+    const std::string path = "test-profiler-trace.json";
+    profiler.writeChromeTrace(path);
+
+    std::ifstream file(path);
+    const std::string trace((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+    std::remove(path.c_str());
+
+    if (trace.rfind("{\"traceEvents\":[", 0) != 0 || trace.find("\"name\":\"Iteration\"") == std::string::npos) { throw std::runtime_error("Wrong trace."); }
+#else
+    // Without the instrumentation, nothing is recorded
+    if (!profiler.getEvents().empty() || !profiler.getSteps().empty()) { throw std::runtime_error("Events are recorded without ELASTY_PROFILING."); }
+#endif
+
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include <elasty/constraint.hpp>
+#include <elasty/engine.hpp>
+#include <elasty/projective-dynamics.hpp>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+namespace
+{
+    // A chain of particles hanging from a particle of infinite mass, whose
+    // last particle is also attached to a fixed point beside it
+    class ChainEngine final : public elasty::Engine
+    {
+    public:
+
+        void initializeScene() override
+        {
+            m_particles.addParticle(elasty::Vector3::Zero(), elasty::Vector3::Zero(), std::numeric_limits<elasty::Scalar>::infinity());
+            for (unsigned int i = 1; i < num_particles; ++ i)
+            {
+                m_particles.addParticle(- elasty::Scalar(i) * segment_length * elasty::Vector3::UnitY(), elasty::Vector3::Zero(), 0.1);
+                addConstraint(elasty::DistanceConstraint(m_particles, i - 1, i, 1.0, segment_length));
+            }
+        }
+
+        void setExternalForces() override
+        {
+            // The particle of infinite mass is skipped, as inf * 0 is NaN
+            for (unsigned int i = 1; i < m_particles.size(); ++ i)
+            {
+                m_particles.f[i] = m_particles.m[i] * m_gravity;
+            }
+        }
+
+        void generateCollisionConstraints() override {}
+        void updateVelocities() override {}
+
+        elasty::Scalar calculateMaxStretch() const
+        {
+            elasty::Scalar max_stretch = 0.0;
+            for (const auto& constraint : m_constraints.get<elasty::DistanceConstraint>())
+            {
+                max_stretch = std::max(max_stretch, std::abs(constraint.calculateValue(m_particles)) / segment_length);
+            }
+            return max_stretch;
+        }
+
+        static constexpr unsigned int num_particles = 20;
+        static constexpr elasty::Scalar segment_length = 0.1;
+
+        elasty::Vector3 m_gravity = elasty::Vector3::Zero();
+    };
+}
+
+int main()
+{
+    ChainEngine engine;
+    engine.initializeScene();
+    engine.m_framework = elasty::Framework::ProjectiveDynamics;
+    engine.m_projective_dynamics_weight_scale = 1e+06;
+    engine.m_num_iterations = 5;
+
+    // A chain in its rest shape without gravity stays there
+    for (unsigned int i = 0; i < 10; ++ i) { engine.stepTime(); }
+    constexpr elasty::Scalar tolerance = std::is_same<elasty::Scalar, float>::value ? 1e-05 : 1e-12;
+    for (unsigned int i = 0; i < ChainEngine::num_particles; ++ i)
+    {
+        const elasty::Vector3 rest_position = - elasty::Scalar(i) * ChainEngine::segment_length * elasty::Vector3::UnitY();
+        if ((engine.m_particles.x[i] - rest_position).norm() > tolerance) { throw std::runtime_error("The chain at rest moves."); }
+    }
+
+    // Under gravity, the stiff constraints are satisfied with a few
+    // iterations of the prefactorized system
+    engine.m_gravity = elasty::Vector3(0.0, - 9.8, 0.0);
+    engine.m_constraints.add(elasty::FixedPointConstraint(engine.m_particles, ChainEngine::num_particles - 1, 1.0, elasty::Vector3(1.0, - 1.0, 0.0)));
+    for (unsigned int i = 0; i < 120; ++ i) { engine.stepTime(); }
+
+    for (const elasty::Vector3& x : engine.m_particles.x)
+    {
+        if (x.hasNaN()) { throw std::runtime_error("The solver diverges."); }
+    }
+    if (engine.m_particles.x[0] != elasty::Vector3::Zero()) { throw std::runtime_error("The particle of infinite mass moves."); }
+    if (engine.calculateMaxStretch() > 1e-03) { throw std::runtime_error("The chain is stretched too much."); }
+
+    // The chain (of the length of 1.9) is long enough to reach the fixed point
+    const elasty::Vector3& x_last = engine.m_particles.x[ChainEngine::num_particles - 1];
+    if ((x_last - elasty::Vector3(1.0, - 1.0, 0.0)).norm() > 1e-03) { throw std::runtime_error("The fixed point is not respected."); }
+
+    // The factorization is stale once any of its inputs changes
+    const elasty::Scalar dt = 1.0 / 60.0;
+    elasty::ProjectiveDynamicsSolver solver;
+    if (solver.isUpToDate(engine.m_constraints, engine.m_particles, dt, 1.0)) { throw std::runtime_error("An unbuilt solver is up to date."); }
+
+    solver.build(engine.m_constraints, engine.m_particles, dt, 1.0);
+    if (!solver.isUpToDate(engine.m_constraints, engine.m_particles, dt, 1.0)) { throw std::runtime_error("The built solver is stale."); }
+    if (solver.isUpToDate(engine.m_constraints, engine.m_particles, 0.5 * dt, 1.0) || solver.isUpToDate(engine.m_constraints, engine.m_particles, dt, 2.0))
+    {
+        throw std::runtime_error("A change of the time step or the weight scale is not detected.");
+    }
+
+    auto& last_constraint = engine.m_constraints.get<elasty::DistanceConstraint>().back();
+    last_constraint.m_stiffness = 0.5;
+    if (solver.isUpToDate(engine.m_constraints, engine.m_particles, dt, 1.0)) { throw std::runtime_error("A change of a stiffness is not detected."); }
+    last_constraint.m_stiffness = 1.0;
+
+    engine.m_particles.w[1] = 0.0;
+    if (solver.isUpToDate(engine.m_constraints, engine.m_particles, dt, 1.0)) { throw std::runtime_error("A change of an inverse mass is not detected."); }
+    engine.m_particles.w[1] = 1.0 / engine.m_particles.m[1];
+
+    if (!solver.isUpToDate(engine.m_constraints, engine.m_particles, dt, 1.0)) { throw std::runtime_error("The restored inputs are not up to date."); }
+    engine.m_constraints.add(elasty::FixedPointConstraint(engine.m_particles, 1, 1.0, elasty::Vector3::Zero()));
+    if (solver.isUpToDate(engine.m_constraints, engine.m_particles, dt, 1.0)) { throw std::runtime_error("An added constraint is not detected."); }
+
+    return 0;
+}
@@ -0,0 +1,156 @@
+#include <elasty/constraint.hpp>
+#include <elasty/constraint-set.hpp>
+#include <elasty/particle-set.hpp>
+#include <elasty/self-collision.hpp>
+#include <elasty/spatial-hash.hpp>
+#include <elasty/thread-pool.hpp>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    // The queries visit each point in the overlapping cells exactly once,
+    // and no point of the other cells that share the buckets
+    void testSpatialHash(elasty::ThreadPool* thread_pool)
+    {
+        constexpr elasty::Scalar cell_size = 0.1;
+
+        // Scattered points, so that many cells share the buckets, together
+        // with a cluster of points in the same cells
+        std::mt19937 random_engine(0);
+        std::uniform_real_distribution<double> distribution(- 20.0, 20.0);
+
+        std::vector<elasty::Vector3> positions;
+        for (unsigned int i = 0; i < 2000; ++ i) { positions.push_back(elasty::Vector3(distribution(random_engine), distribution(random_engine), distribution(random_engine))); }
+        for (unsigned int i = 0; i < 200; ++ i) { positions.push_back(elasty::Vector3::Constant(0.005 * (i % 20))); }
+
+        elasty::SpatialHash spatial_hash;
+        spatial_hash.build(positions, cell_size, thread_pool);
+
+        const auto calculate_cell = [&](const elasty::Vector3& position) { return (position / cell_size).array().floor().eval(); };
+
+        std::vector<unsigned int> num_visits(positions.size());
+        for (unsigned int q = 0; q < positions.size(); q += 7)
+        {
+            const elasty::Vector3 box_min = positions[q] - elasty::Vector3::Constant(0.03);
+            const elasty::Vector3 box_max = positions[q] + elasty::Vector3::Constant(0.17);
+
+            std::fill(num_visits.begin(), num_visits.end(), 0);
+            spatial_hash.forEachPointInBox(box_min, box_max, [&](const unsigned int index, const elasty::Vector3& position)
+            {
+                if (position != positions[index]) { throw std::runtime_error("Wrong position of a visited point."); }
+                ++ num_visits[index];
+            });
+
+            const auto cell_min = calculate_cell(box_min);
+            const auto cell_max = calculate_cell(box_max);
+            for (unsigned int i = 0; i < positions.size(); ++ i)
+            {
+                const auto cell = calculate_cell(positions[i]);
+                const bool is_in_cells = (cell >= cell_min).all() && (cell <= cell_max).all();
+
+                if (num_visits[i] > 1) { throw std::runtime_error("A point is visited more than once."); }
+                if (is_in_cells && num_visits[i] == 0) { throw std::runtime_error("A point in the box is not visited."); }
+                if (!is_in_cells && num_visits[i] != 0) { throw std::runtime_error("A point of another cell in the bucket is visited."); }
+            }
+        }
+    }
+
+    // A flat triangle on the xz-plane, and a particle above it
+    elasty::ParticleSet makeScene(const elasty::Vector3& x, const elasty::Vector3& p)
+    {
+        elasty::ParticleSet particles;
+        particles.addParticle(elasty::Vector3(- 1.0, 0.0, - 1.0), elasty::Vector3::Zero(), 1.0);
+        particles.addParticle(elasty::Vector3(1.0, 0.0, - 1.0), elasty::Vector3::Zero(), 1.0);
+        particles.addParticle(elasty::Vector3(0.0, 0.0, 1.0), elasty::Vector3::Zero(), 1.0);
+        particles.addParticle(x, elasty::Vector3::Zero(), 1.0);
+
+        // The triangle moves down a little during the step
+        particles.p = particles.x;
+        for (unsigned int i = 0; i < 3; ++ i) { particles.p[i].y() -= 0.01; }
+        particles.p[3] = p;
+
+        return particles;
+    }
+
+    // Wound so that the normal is +y
+    elasty::MeshTopology::TriangleList makeTriangleList()
+    {
+        elasty::MeshTopology::TriangleList triangle_list(1, 3);
+        triangle_list << 0, 2, 1;
+        return triangle_list;
+    }
+
+    // A particle falling through the triangle in a single step is caught, and
+    // is pushed back to the side it came from
+    void testFallingThrough(elasty::ThreadPool* thread_pool)
+    {
+        constexpr elasty::Scalar thickness = 0.02;
+
+        elasty::ParticleSet particles = makeScene(elasty::Vector3(0.1, 0.1, 0.0), elasty::Vector3(0.1, - 0.15, 0.0));
+
+        elasty::SelfCollisionDetector detector(thickness);
+        detector.addTriangles(makeTriangleList(), 0);
+
+        elasty::ConstraintSet constraints;
+        detector.generateConstraints(particles, constraints, thread_pool);
+
+        const auto& collisions = constraints.get<elasty::PointTriangleCollisionConstraint>();
+        if (collisions.size() != 1) { throw std::runtime_error("The crossing is not detected."); }
+        if (!constraints.get<elasty::ParticleCollisionConstraint>().empty()) { throw std::runtime_error("A distant pair is detected."); }
+
+        const auto& collision = collisions.front();
+        if (collision.getIndices()[0] != 3 || collision.getSide() != 1.0 || std::abs(collision.getThickness() - thickness) > 1e-06)
+        {
+            throw std::runtime_error("Wrong collision constraint.");
+        }
+
+        for (unsigned int i = 0; i < 10; ++ i) { collision.projectParticles(particles); }
+
+        const elasty::Vector3 normal = (particles.p[2] - particles.p[0]).cross(particles.p[1] - particles.p[0]).normalized();
+        if (!(normal.dot(particles.p[3] - particles.p[0]) > thickness - 1e-04)) { throw std::runtime_error("The particle is not pushed back."); }
+
+        // A particle beside the triangle is left to the adjacent triangles
+        particles = makeScene(elasty::Vector3(2.0, 0.1, 0.0), elasty::Vector3(2.0, - 0.15, 0.0));
+        constraints.clear();
+        detector.generateConstraints(particles, constraints, thread_pool);
+        if (!constraints.get<elasty::PointTriangleCollisionConstraint>().empty()) { throw std::runtime_error("A particle beside the triangle is detected."); }
+    }
+
+    // A triangle degenerate at the beginning of the step (e.g., collapsed to
+    // a line) is skipped instead of producing an invalid constraint, even for
+    // a particle close to its plane at the end of the step
+    void testDegenerateTriangle()
+    {
+        elasty::ParticleSet particles = makeScene(elasty::Vector3(0.1, 0.1, 0.0), elasty::Vector3(0.1, - 0.005, 0.0));
+        particles.x[2] = 0.5 * (particles.x[0] + particles.x[1]);
+
+        elasty::SelfCollisionDetector detector(0.02);
+        detector.addTriangles(makeTriangleList(), 0);
+
+        elasty::ConstraintSet constraints;
+        detector.generateConstraints(particles, constraints);
+
+        for (const auto& collision : constraints.get<elasty::PointTriangleCollisionConstraint>())
+        {
+            if (std::isnan(collision.getThickness()) || collision.getBarycentricCoords().hasNaN()) { throw std::runtime_error("A degenerate triangle produces an invalid constraint."); }
+        }
+        if (!constraints.get<elasty::PointTriangleCollisionConstraint>().empty()) { throw std::runtime_error("A degenerate triangle is not skipped."); }
+    }
+}
+
+int main()
+{
+    elasty::ThreadPool thread_pool(4);
+
+    testSpatialHash(nullptr);
+    testSpatialHash(&thread_pool);
+    testFallingThrough(nullptr);
+    testFallingThrough(&thread_pool);
+    testDegenerateTriangle();
+
+    return 0;
+}
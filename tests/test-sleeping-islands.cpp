@@ -0,0 +1,91 @@
+#include <elasty/constraint.hpp>
+#include <elasty/engine.hpp>
+#include <stdexcept>
+
+namespace
+{
+    // Two separate pendulums, each of which is a pair of particles hanging
+    // from a pinned one
+    class PendulumEngine final : public elasty::Engine
+    {
+    public:
+
+        void initializeScene() override
+        {
+            for (unsigned int k = 0; k < 2; ++ k)
+            {
+                const elasty::Vector3 origin(3.0 * k, 0.0, 0.0);
+
+                const unsigned int i_0 = m_particles.addParticle(origin, elasty::Vector3::Zero(), 1.0);
+                const unsigned int i_1 = m_particles.addParticle(origin - elasty::Vector3::UnitY(), elasty::Vector3::Zero(), 1.0);
+                const unsigned int i_2 = m_particles.addParticle(origin - 2.0 * elasty::Vector3::UnitY(), elasty::Vector3::Zero(), 1.0);
+
+                addConstraint(elasty::FixedPointConstraint(m_particles, i_0, 1.0, origin));
+                addConstraint(elasty::DistanceConstraint(m_particles, i_0, i_1, 1.0, 1.0));
+                addConstraint(elasty::DistanceConstraint(m_particles, i_1, i_2, 1.0, 1.0));
+            }
+        }
+
+        void setExternalForces() override
+        {
+            for (unsigned int i = 0; i < m_particles.size(); ++ i)
+            {
+                m_particles.f[i] = m_particles.m[i] * elasty::Vector3(0.0, - 9.8, 0.0);
+            }
+        }
+
+        void generateCollisionConstraints() override
+        {
+            // A floor that can be raised to hit the second pendulum
+            for (unsigned int i = 3; i < m_particles.size(); ++ i)
+            {
+                if (m_particles.p[i].y() < m_floor_height)
+                {
+                    emplaceInstantConstraint<elasty::EnvironmentalCollisionConstraint>(m_particles, i, 1.0, elasty::Vector3::UnitY(), m_floor_height);
+                }
+            }
+        }
+
+        void updateVelocities() override
+        {
+            for (auto& v : m_particles.v) { v *= 0.9; }
+        }
+
+        elasty::Scalar m_floor_height = - 10.0;
+    };
+}
+
+int main()
+{
+    PendulumEngine engine;
+    engine.initializeScene();
+    engine.m_is_sleeping_enabled = true;
+    engine.m_num_steps_to_sleep = 10;
+
+    // The pendulums start at rest in their equilibrium, so they fall asleep
+    for (unsigned int i = 0; i < 60; ++ i) { engine.stepTime(); }
+
+    const elasty::SleepingIslands& islands = engine.getSleepingIslands();
+    if (islands.getNumIslands() != 2) { throw std::runtime_error("Wrong number of islands."); }
+    if (!islands.areAllIslandsAsleep()) { throw std::runtime_error("The islands do not fall asleep."); }
+
+    // Moving the pin of the first pendulum wakes up only the first island
+    engine.m_constraints.get<elasty::FixedPointConstraint>()[0].setPoint(elasty::Vector3(0.5, 0.0, 0.0));
+    const elasty::Vector3 x_5 = engine.m_particles.x[5];
+
+    engine.stepTime();
+
+    if (islands.isParticleAsleep(0) || !islands.isParticleAsleep(3)) { throw std::runtime_error("Wrong island woken up by the pin."); }
+    if (engine.m_particles.x[0].x() <= 0.0) { throw std::runtime_error("The woken island does not move."); }
+    if (engine.m_particles.x[5] != x_5) { throw std::runtime_error("A sleeping particle moves."); }
+
+    // A floor penetrating the second pendulum wakes it up
+    engine.m_floor_height = - 1.5;
+
+    engine.stepTime();
+
+    if (islands.isParticleAsleep(3)) { throw std::runtime_error("The island is not woken up by the contact."); }
+    if (engine.m_particles.x[5].y() < - 1.5 - 1e-06) { throw std::runtime_error("The contact is not resolved."); }
+
+    return 0;
+}
@@ -0,0 +1,202 @@
+#include <elasty/cloth-sim-object.hpp>
+#include <elasty/constraint.hpp>
+#include <elasty/particle-set.hpp>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <Eigen/Geometry>
+
+namespace
+{
+    const bool is_float = std::is_same<elasty::Scalar, float>::value;
+
+    // Compare the gradient of the constraint, and the fused value and
+    // gradient, with central differences at a deformed configuration
+    template <typename Type>
+    void testGradient(const Type& constraint, elasty::ParticleSet particles)
+    {
+        using Correction = typename Type::Correction;
+
+        Correction grad;
+        constraint.calculateGrad(particles, grad.data());
+
+        Correction fused_grad;
+        const elasty::Scalar fused_value = constraint.calculateValueAndGrad(particles, fused_grad.data());
+
+        if (std::abs(fused_value - constraint.calculateValue(particles)) > 1e-06) { throw std::runtime_error("Wrong fused value."); }
+        if ((fused_grad - grad).norm() > 1e-06) { throw std::runtime_error("Wrong fused gradient."); }
+
+        const elasty::Scalar h = is_float ? 1e-03 : 1e-06;
+        const elasty::Scalar tolerance = is_float ? 1e-02 : 1e-06;
+
+        Correction numerical_grad;
+        for (unsigned int j = 0; j < Type::num_particles; ++ j)
+        {
+            for (unsigned int k = 0; k < 3; ++ k)
+            {
+                elasty::Vector3& p = particles.p[constraint.getIndices()[j]];
+                const elasty::Scalar original = p(k);
+
+                p(k) = original + h;
+                const elasty::Scalar value_plus = constraint.calculateValue(particles);
+                p(k) = original - h;
+                const elasty::Scalar value_minus = constraint.calculateValue(particles);
+                p(k) = original;
+
+                numerical_grad(3 * j + k) = (value_plus - value_minus) / (2.0 * h);
+            }
+        }
+
+        if (grad.norm() < 1e-03) { throw std::runtime_error("The gradient of the deformed configuration vanishes."); }
+        if ((grad - numerical_grad).norm() > tolerance * numerical_grad.norm()) { throw std::runtime_error("Wrong gradient."); }
+    }
+
+    // Repeated projections bring the particles back to the constraint manifold
+    template <typename Type>
+    void testProjection(const Type& constraint, elasty::ParticleSet particles)
+    {
+        for (unsigned int i = 0; i < 50; ++ i) { constraint.projectParticles(particles); }
+
+        const elasty::Scalar tolerance = is_float ? 1e-04 : 1e-08;
+        if (!(std::abs(constraint.calculateValue(particles)) < tolerance)) { throw std::runtime_error("The projections do not converge."); }
+    }
+
+    void testTriangle()
+    {
+        elasty::ParticleSet particles;
+        particles.addParticle(elasty::Vector3(0.0, 0.0, 0.0), elasty::Vector3::Zero(), 1.0);
+        particles.addParticle(elasty::Vector3(1.0, 0.0, 0.2), elasty::Vector3::Zero(), 1.0);
+        particles.addParticle(elasty::Vector3(0.3, 0.8, 0.1), elasty::Vector3::Zero(), 1.0);
+
+        const elasty::TriangleStrainConstraint strain_constraint(particles, 0, 1, 2, 1.0);
+        const elasty::Scalar rest_area = 0.5 * (particles.x[1] - particles.x[0]).cross(particles.x[2] - particles.x[0]).norm();
+        const elasty::TriangleAreaConstraint area_constraint(particles, 0, 1, 2, 1.0, rest_area);
+
+        if (std::abs(strain_constraint.getRestArea() - rest_area) > 1e-06) { throw std::runtime_error("Wrong rest area."); }
+
+        // A rigid motion does not strain the triangle
+        const elasty::Matrix3 rotation = Eigen::AngleAxis<elasty::Scalar>(0.7, elasty::Vector3(1.0, 2.0, 3.0).normalized()).toRotationMatrix();
+        for (elasty::Vector3& p : particles.p) { p = rotation * p + elasty::Vector3(3.0, - 2.0, 1.0); }
+
+        const elasty::Scalar tolerance = is_float ? 1e-03 : 1e-10;
+        if (!(strain_constraint.calculateValue(particles) < tolerance)) { throw std::runtime_error("A rigid motion strains the triangle."); }
+        if (!(std::abs(area_constraint.calculateValue(particles)) < tolerance)) { throw std::runtime_error("A rigid motion changes the area."); }
+
+        // Stretch and shear the triangle
+        particles.p[1] += elasty::Vector3(0.2, - 0.1, 0.05);
+        particles.p[2] += elasty::Vector3(- 0.1, 0.15, 0.1);
+
+        testGradient(strain_constraint, particles);
+        testGradient(area_constraint, particles);
+        testProjection(strain_constraint, particles);
+        testProjection(area_constraint, particles);
+    }
+
+    void testTetrahedron()
+    {
+        elasty::ParticleSet particles;
+        particles.addParticle(elasty::Vector3(0.0, 0.0, 0.0), elasty::Vector3::Zero(), 1.0);
+        particles.addParticle(elasty::Vector3(1.0, 0.1, 0.0), elasty::Vector3::Zero(), 1.0);
+        particles.addParticle(elasty::Vector3(0.2, 0.9, 0.1), elasty::Vector3::Zero(), 1.0);
+        particles.addParticle(elasty::Vector3(0.1, 0.2, 1.1), elasty::Vector3::Zero(), 2.0);
+
+        const elasty::Vector3 e_1 = particles.x[1] - particles.x[0];
+        const elasty::Vector3 e_2 = particles.x[2] - particles.x[0];
+        const elasty::Vector3 e_3 = particles.x[3] - particles.x[0];
+        const elasty::Scalar rest_volume = e_1.dot(e_2.cross(e_3)) / 6.0;
+
+        const elasty::TetrahedronStrainConstraint strain_constraint(particles, 0, 1, 2, 3, 1.0);
+        const elasty::VolumeConstraint volume_constraint(particles, 0, 1, 2, 3, 1.0, rest_volume);
+
+        if (std::abs(strain_constraint.getRestVolume() - rest_volume) > 1e-06) { throw std::runtime_error("Wrong rest volume."); }
+
+        const elasty::Matrix3 rotation = Eigen::AngleAxis<elasty::Scalar>(- 1.2, elasty::Vector3(0.0, 1.0, 1.0).normalized()).toRotationMatrix();
+        for (elasty::Vector3& p : particles.p) { p = rotation * p + elasty::Vector3(- 1.0, 0.5, 2.0); }
+
+        const elasty::Scalar tolerance = is_float ? 1e-03 : 1e-10;
+        if (!(strain_constraint.calculateValue(particles) < tolerance)) { throw std::runtime_error("A rigid motion strains the tetrahedron."); }
+        if (!(std::abs(volume_constraint.calculateValue(particles)) < tolerance)) { throw std::runtime_error("A rigid motion changes the volume."); }
+
+        // Squash the tetrahedron
+        particles.p[3] += elasty::Vector3(0.1, - 0.3, - 0.2);
+        particles.p[1] += elasty::Vector3(- 0.1, 0.05, 0.1);
+
+        testGradient(strain_constraint, particles);
+        testGradient(volume_constraint, particles);
+        testProjection(strain_constraint, particles);
+        testProjection(volume_constraint, particles);
+    }
+
+    // A square of two triangles
+    std::string writeSquareObj()
+    {
+        const std::string path = (std::filesystem::temp_directory_path() / "elasty-test-strain-constraints.obj").string();
+
+        std::ofstream file(path);
+        file << "v 0 0 0\nv 1 0 0\nv 1 0 1\nv 0 0 1\nvn 0 1 0\n";
+        file << "f 1//1 3//1 2//1\nf 1//1 4//1 3//1\n";
+
+        return path;
+    }
+
+    void testClothStretchStrategy()
+    {
+        using Strategy = elasty::ClothSimObject::Strategy;
+        using StretchStrategy = elasty::ClothSimObject::StretchStrategy;
+
+        const std::string obj_path = writeSquareObj();
+
+        elasty::ParticleSet particles;
+        const elasty::ClothSimObject distance_cloth(obj_path, particles, 0.9, 0.5, Eigen::Affine3d::Identity(), Strategy::IsometricBending, StretchStrategy::Distance);
+        const elasty::ClothSimObject strain_cloth(obj_path, particles, 0.9, 0.5, Eigen::Affine3d::Identity(), Strategy::IsometricBending, StretchStrategy::TriangleStrain);
+        const elasty::ClothSimObject area_cloth(obj_path, particles, 0.9, 0.5, Eigen::Affine3d::Identity(), Strategy::IsometricBending, StretchStrategy::TriangleStrainAndArea);
+
+        std::filesystem::remove(obj_path);
+
+        if (distance_cloth.m_constraints.get<elasty::DistanceConstraint>().size() != 5 || !distance_cloth.m_constraints.get<elasty::TriangleStrainConstraint>().empty())
+        {
+            throw std::runtime_error("The distance strategy does not constrain the edges.");
+        }
+        if (!strain_cloth.m_constraints.get<elasty::DistanceConstraint>().empty() || strain_cloth.m_constraints.get<elasty::TriangleStrainConstraint>().size() != 2 || !strain_cloth.m_constraints.get<elasty::TriangleAreaConstraint>().empty())
+        {
+            throw std::runtime_error("The strain strategy does not constrain the triangles.");
+        }
+        if (area_cloth.m_constraints.get<elasty::TriangleStrainConstraint>().size() != 2 || area_cloth.m_constraints.get<elasty::TriangleAreaConstraint>().size() != 2)
+        {
+            throw std::runtime_error("The area strategy does not constrain the triangles.");
+        }
+        if (area_cloth.m_constraints.get<elasty::IsometricBendingConstraint>().size() != 1) { throw std::runtime_error("The stretch strategy changes the bending constraints."); }
+
+        // The precomputed parameters survive the cache
+        const std::string cache_path = (std::filesystem::temp_directory_path() / "elasty-test-strain-constraints.cache").string();
+        area_cloth.writeCache(cache_path, particles);
+
+        elasty::ParticleSet cached_particles;
+        const auto cached_cloth = elasty::ClothSimObject::readCache(cache_path, cached_particles);
+        std::filesystem::remove(cache_path);
+
+        const auto& strain_constraints = area_cloth.m_constraints.get<elasty::TriangleStrainConstraint>();
+        const auto& cached_strain_constraints = cached_cloth->m_constraints.get<elasty::TriangleStrainConstraint>();
+        const auto& cached_area_constraints = cached_cloth->m_constraints.get<elasty::TriangleAreaConstraint>();
+        for (unsigned int i = 0; i < 2; ++ i)
+        {
+            if (!cached_strain_constraints[i].getInverseRestMatrix().isApprox(strain_constraints[i].getInverseRestMatrix()) ||
+                std::abs(cached_area_constraints[i].getRestArea() - 0.5) > 1e-06)
+            {
+                throw std::runtime_error("The cache does not restore the triangle constraints.");
+            }
+        }
+    }
+}
+
+int main()
+{
+    testTriangle();
+    testTetrahedron();
+    testClothStretchStrategy();
+
+    return 0;
+}
@@ -0,0 +1,223 @@
+#include <elasty/cloth-sim-object.hpp>
+#include <elasty/constraint.hpp>
+#include <elasty/mesh-topology.hpp>
+#include <elasty/particle-set.hpp>
+#include <elasty/vertex-ordering.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+    const bool is_float = std::is_same<elasty::Scalar, float>::value;
+
+    constexpr unsigned int resolution = 24;
+
+    // A flat grid of quads (each split into two triangles) on the xz-plane,
+    // whose vertices are stored in a shuffled order, as some exporters do
+    struct ShuffledGrid
+    {
+        ShuffledGrid()
+        {
+            const unsigned int num_vertices = (resolution + 1) * (resolution + 1);
+
+            // The shuffled index of the (i, j)-th vertex
+            std::vector<unsigned int> shuffled_indices(num_vertices);
+            std::iota(shuffled_indices.begin(), shuffled_indices.end(), 0);
+            std::shuffle(shuffled_indices.begin(), shuffled_indices.end(), std::mt19937(0));
+
+            positions.resize(num_vertices);
+            for (unsigned int i = 0; i <= resolution; ++ i)
+            {
+                for (unsigned int j = 0; j <= resolution; ++ j)
+                {
+                    positions[shuffled_indices[i * (resolution + 1) + j]] = elasty::Vector3(double(j) / double(resolution) - 0.5, 0.0, double(i) / double(resolution) - 0.5);
+                }
+            }
+
+            triangles.resize(2 * resolution * resolution, 3);
+            const auto index = [&](unsigned int i, unsigned int j) { return shuffled_indices[i * (resolution + 1) + j]; };
+            for (unsigned int i = 0; i < resolution; ++ i)
+            {
+                for (unsigned int j = 0; j < resolution; ++ j)
+                {
+                    const unsigned int t = 2 * (i * resolution + j);
+                    triangles.row(t + 0) << index(i, j), index(i + 1, j), index(i + 1, j + 1);
+                    triangles.row(t + 1) << index(i, j), index(i + 1, j + 1), index(i, j + 1);
+                }
+            }
+
+            topology.build(triangles, num_vertices);
+        }
+
+        std::string writeObj() const
+        {
+            const std::string path = (std::filesystem::temp_directory_path() / "elasty-test-vertex-ordering.obj").string();
+
+            std::ofstream file(path);
+            for (const elasty::Vector3& position : positions) { file << "v " << position.x() << " " << position.y() << " " << position.z() << "\n"; }
+
+            // The loader requires the normals
+            file << "vn 0 1 0\n";
+
+            for (unsigned int t = 0; t < triangles.rows(); ++ t)
+            {
+                file << "f " << triangles(t, 0) + 1 << "//1 " << triangles(t, 1) + 1 << "//1 " << triangles(t, 2) + 1 << "//1\n";
+            }
+
+            return path;
+        }
+
+        std::vector<elasty::Vector3> positions;
+        elasty::MeshTopology::TriangleList triangles;
+        elasty::MeshTopology topology;
+    };
+
+    void checkPermutation(const std::vector<unsigned int>& order, const std::size_t size)
+    {
+        std::vector<unsigned int> sorted_order = order;
+        std::sort(sorted_order.begin(), sorted_order.end());
+
+        std::vector<unsigned int> identity(size);
+        std::iota(identity.begin(), identity.end(), 0);
+
+        if (sorted_order != identity) { throw std::runtime_error("The order is not a permutation."); }
+
+        const std::vector<unsigned int> inverse = elasty::invertPermutation(order);
+        for (unsigned int i = 0; i < size; ++ i)
+        {
+            if (inverse[order[i]] != i) { throw std::runtime_error("The inverse is not correct."); }
+        }
+    }
+
+    // The largest and the mean index distance between the vertices of an edge
+    std::pair<unsigned int, double> calculateEdgeSpans(const elasty::MeshTopology& topology, const std::vector<unsigned int>& order)
+    {
+        const std::vector<unsigned int> new_indices = elasty::invertPermutation(order);
+
+        unsigned int max_span = 0;
+        double sum_span = 0.0;
+        for (const auto& edge : topology.getEdges())
+        {
+            const unsigned int a = new_indices[edge.vertices[0]];
+            const unsigned int b = new_indices[edge.vertices[1]];
+            const unsigned int span = a > b ? a - b : b - a;
+
+            max_span = std::max(max_span, span);
+            sum_span += span;
+        }
+        return { max_span, sum_span / double(topology.getEdges().size()) };
+    }
+
+    void testOrders(const ShuffledGrid& grid)
+    {
+        const std::size_t num_vertices = grid.positions.size();
+
+        std::vector<unsigned int> identity(num_vertices);
+        std::iota(identity.begin(), identity.end(), 0);
+
+        const std::vector<unsigned int> morton_order = elasty::calculateMortonOrder(grid.positions);
+        const std::vector<unsigned int> rcm_order = elasty::calculateReverseCuthillMcKeeOrder(grid.topology, num_vertices);
+
+        checkPermutation(morton_order, num_vertices);
+        checkPermutation(rcm_order, num_vertices);
+
+        const auto shuffled_spans = calculateEdgeSpans(grid.topology, identity);
+        const auto morton_spans = calculateEdgeSpans(grid.topology, morton_order);
+        const auto rcm_spans = calculateEdgeSpans(grid.topology, rcm_order);
+
+        // The neighbors of a vertex get close indices
+        if (!(morton_spans.second < 0.1 * shuffled_spans.second)) { throw std::runtime_error("The Morton order does not improve the locality."); }
+        if (!(rcm_spans.second < 0.1 * shuffled_spans.second)) { throw std::runtime_error("The reverse Cuthill-McKee order does not improve the locality."); }
+
+        // The bandwidth of a grid is about its width
+        if (rcm_spans.first > 2 * (resolution + 1)) { throw std::runtime_error("The reverse Cuthill-McKee order has a large bandwidth."); }
+    }
+
+    void testCloth(const ShuffledGrid& grid, const elasty::ClothSimObject::ParticleOrder particle_order)
+    {
+        using Strategy = elasty::ClothSimObject::Strategy;
+        using StretchStrategy = elasty::ClothSimObject::StretchStrategy;
+
+        const std::string obj_path = grid.writeObj();
+
+        // A particle before the cloth, so that the offset is not zero
+        elasty::ParticleSet particles;
+        particles.addParticle(elasty::Vector3::Zero(), elasty::Vector3::Zero(), 1.0);
+
+        const elasty::ClothSimObject cloth(obj_path, particles, 0.9, 0.5, Eigen::Affine3d::Identity(), Strategy::IsometricBending, StretchStrategy::Distance, particle_order);
+
+        elasty::ParticleSet obj_particles;
+        const elasty::ClothSimObject obj_cloth(obj_path, obj_particles, 0.9, 0.5, Eigen::Affine3d::Identity(), Strategy::IsometricBending);
+
+        std::filesystem::remove(obj_path);
+
+        checkPermutation(cloth.m_obj_vertex_indices, cloth.m_num_particles);
+
+        // The mapping gives back the OBJ vertices and triangles
+        const auto& obj_vertex_indices = cloth.m_obj_vertex_indices;
+        for (unsigned int i = 0; i < cloth.m_num_particles; ++ i)
+        {
+            if (particles.x[cloth.m_particle_offset + i] != obj_particles.x[obj_vertex_indices[i]]) { throw std::runtime_error("The mapping does not give the OBJ vertices."); }
+        }
+
+        std::vector<std::array<int, 3>> triangles;
+        std::vector<std::array<int, 3>> obj_triangles;
+        for (unsigned int t = 0; t < cloth.m_triangle_list.rows(); ++ t)
+        {
+            triangles.push_back({ int(obj_vertex_indices[cloth.m_triangle_list(t, 0)]), int(obj_vertex_indices[cloth.m_triangle_list(t, 1)]), int(obj_vertex_indices[cloth.m_triangle_list(t, 2)]) });
+            obj_triangles.push_back({ obj_cloth.m_triangle_list(t, 0), obj_cloth.m_triangle_list(t, 1), obj_cloth.m_triangle_list(t, 2) });
+        }
+        std::sort(triangles.begin(), triangles.end());
+        std::sort(obj_triangles.begin(), obj_triangles.end());
+        if (triangles != obj_triangles) { throw std::runtime_error("The mapping does not give the OBJ triangles."); }
+
+        // The same constraints are built, sorted by their first particles
+        if (cloth.m_constraints.getBatchSizes() != obj_cloth.m_constraints.getBatchSizes()) { throw std::runtime_error("The reordering changes the constraints."); }
+
+        elasty::Scalar rest_length_sum = 0.0;
+        elasty::Scalar obj_rest_length_sum = 0.0;
+        for (const auto& constraint : cloth.m_constraints.get<elasty::DistanceConstraint>()) { rest_length_sum += constraint.getRestLength(); }
+        for (const auto& constraint : obj_cloth.m_constraints.get<elasty::DistanceConstraint>()) { obj_rest_length_sum += constraint.getRestLength(); }
+        // The sums are accumulated in different orders
+        const elasty::Scalar tolerance = is_float ? 1e-04 : 1e-10;
+        if (std::abs(rest_length_sum - obj_rest_length_sum) > tolerance * obj_rest_length_sum) { throw std::runtime_error("The reordering changes the rest lengths."); }
+
+        cloth.m_constraints.forEachBatch([](const auto& constraints)
+        {
+            for (std::size_t i = 1; i < constraints.size(); ++ i)
+            {
+                if (constraints[i - 1].getIndices()[0] > constraints[i].getIndices()[0]) { throw std::runtime_error("The constraints are not sorted."); }
+            }
+        });
+
+        // The mapping survives the cache
+        const std::string cache_path = (std::filesystem::temp_directory_path() / "elasty-test-vertex-ordering.cache").string();
+        cloth.writeCache(cache_path, particles);
+
+        elasty::ParticleSet cached_particles;
+        const auto cached_cloth = elasty::ClothSimObject::readCache(cache_path, cached_particles);
+        std::filesystem::remove(cache_path);
+
+        if (cached_cloth->m_obj_vertex_indices != obj_vertex_indices) { throw std::runtime_error("The cache does not restore the mapping."); }
+    }
+}
+
+int main()
+{
+    const ShuffledGrid grid;
+
+    testOrders(grid);
+    testCloth(grid, elasty::ClothSimObject::ParticleOrder::Morton);
+    testCloth(grid, elasty::ClothSimObject::ParticleOrder::ReverseCuthillMcKee);
+
+    return 0;
+}